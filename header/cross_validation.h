@@ -0,0 +1,35 @@
+/*
+ * file: cross_validation.h
+ * description: header file that gives access to k-fold cross-validation over index sets
+ * author: Ryan Wagner
+ * date: October 19, 2026
+ * notes:
+ */
+
+#ifndef CROSS_VALIDATION_H
+#define CROSS_VALIDATION_H
+
+#include "../header/regression.h"
+#include "../header/eval_matrics.h"
+
+typedef struct
+{
+    int folds;            // Number of folds
+    int rows;             // Rows of the dataset
+    int *order;           // Shuffled row order written twice, fold f holds out order[bounds[f], bounds[f + 1])
+                          // and trains on the rows that follow it up to one full pass
+    int *bounds;          // First position of every fold, folds + 1 entries
+    int *status;          // 0 for every fold that trained and scored, -1 otherwise
+    EvalMetrics *metrics; // Held-out metrics of every fold
+    double *scores;       // Held-out metricScore of every fold
+    EvalMetrics mean;     // Mean of every metric over the folds that trained
+    EvalMetrics std;      // Sample standard deviation of every metric over the folds that trained
+    double mean_score;    // Mean of the fold scores
+    double std_score;     // Sample standard deviation of the fold scores
+} CrossValidation;
+
+int makeFolds(int rows, int folds, uint64_t seed, CrossValidation *cv);
+int crossValidate(const Model *base, Matrix X, Matrix y, int folds, uint64_t seed, int workers, CrossValidation *cv);
+void freeCrossValidation(CrossValidation *cv);
+
+#endif // CROSS_VALIDATION_H
@@ -0,0 +1,59 @@
+/*
+ * file: data_stream.h
+ * description: header file that gives access to the line reader used by the file loaders
+ * author: Ryan Wagner
+ * date: October 19, 2026
+ * notes: gzip needs zlib (ML_HAVE_ZLIB) and zstd needs libzstd (ML_HAVE_ZSTD) at build time
+ */
+
+#ifndef DATA_STREAM_H
+#define DATA_STREAM_H
+
+#include <sys/types.h>
+
+#include "../header/threading.h"
+
+#define STREAM_RING_SIZE (1 << 20)
+#define STREAM_CHUNK_SIZE (1 << 16)
+
+typedef enum
+{
+    STREAM_PLAIN, // Uncompressed file, read directly
+    STREAM_GZIP,  // gzip (.gz) file, decompressed by a background thread
+    STREAM_ZSTD   // Zstandard (.zst) file, decompressed by a background thread
+} StreamFormat;
+
+typedef struct
+{
+    StreamFormat format; // Detected format of the file
+    FILE *file;          // Plain file handle, or compressed input for zstd
+    void *decoder;       // gzFile or ZSTD_DCtx, NULL for plain files
+
+    // Ring buffer filled by the decompression thread
+    char *ring;
+    size_t ring_size;
+    size_t ring_head;  // Next byte the producer writes
+    size_t ring_count; // Bytes waiting to be read
+    bool eof;          // Producer reached the end of the input
+    bool failed;       // Producer hit a decompression error
+    bool closing;      // Consumer is closing early, producer should stop
+    pthread_mutex_t lock;
+    pthread_cond_t not_empty;
+    pthread_cond_t not_full;
+    pthread_t producer;
+    bool has_producer;
+
+    // Consumer side block of bytes drained from the ring
+    char *block;
+    size_t block_len;
+    size_t block_pos;
+    bool read_failed; // Consumer saw the stream end on an error, see dataStreamFailed
+} DataStream;
+
+StreamFormat detectStreamFormat(const char *filename);
+int openDataStream(DataStream *stream, const char *filename);
+ssize_t readLineDataStream(DataStream *stream, char **line, size_t *line_cap);
+bool dataStreamFailed(const DataStream *stream);
+void closeDataStream(DataStream *stream);
+
+#endif // DATA_STREAM_H
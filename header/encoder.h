@@ -0,0 +1,57 @@
+/*
+ * file: encoder.h
+ * description: header file that gives access to the categorical dictionary encoding functions
+ * author: Ryan Wagner
+ * date: October 19, 2026
+ * notes:
+ */
+
+#ifndef ENCODER_H
+#define ENCODER_H
+
+#include "../header/matrix.h"
+
+#define DEFAULT_DICT_CAPACITY 16
+
+typedef enum
+{
+    COL_NUMERIC,    // Column parsed with strtod
+    COL_CATEGORICAL // Column dictionary-encoded to integer codes
+} ColumnType;
+
+typedef enum
+{
+    ENCODE_LABEL,  // One output column of integer codes per categorical column
+    ENCODE_ONE_HOT // One output column per category of each categorical column
+} EncodingType;
+
+typedef struct
+{
+    char **labels; // Category strings indexed by their integer code
+    int *slots;    // Open-addressing hash table of codes, -1 when the slot is empty
+    int size;      // Number of categories in the dictionary
+    int capacity;  // Number of slots in the hash table, always a power of two
+} CategoryDict;
+
+typedef struct
+{
+    int cols;              // Number of raw columns in the source file
+    ColumnType *types;     // Type of every raw column
+    CategoryDict *dicts;   // Dictionary of every raw column, empty for numeric columns
+    EncodingType encoding; // How categorical columns are written to the output Matrix
+    bool frozen;           // If true, unseen categories are not added to the dictionaries
+} CategoricalEncoder;
+
+int initCategoryDict(CategoryDict *dict, int capacity);
+int lookupCategory(const CategoryDict *dict, const char *label);
+int addCategory(CategoryDict *dict, const char *label);
+void freeCategoryDict(CategoryDict *dict);
+
+CategoricalEncoder makeDefaultEncoder(void);
+int initEncoder(CategoricalEncoder *encoder, int cols, const ColumnType *types);
+int encodeCategory(CategoricalEncoder *encoder, int col, const char *label, int *code);
+int getEncodedColumnCount(const CategoricalEncoder *encoder);
+int expandOneHot(Matrix codes, const CategoricalEncoder *encoder, Matrix *out);
+void freeEncoder(CategoricalEncoder *encoder);
+
+#endif // ENCODER_H
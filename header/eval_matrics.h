@@ -47,6 +47,9 @@ int computeR2Score(Matrix y_true, Matrix y_pred, double *r2score);
 
 int calculateAllMetrics(EvalMetrics *eval_metrics, RegressionType model_type, Matrix true_labels);
 int printMetrics(EvalMetrics eval_metrics, RegressionType model_type);
+int evaluatePredictions(RegressionType model_type, Matrix y, Matrix *predicted, EvalMetrics *eval_metrics);
+int evaluateModel(Model *model, Matrix X, Matrix y, EvalMetrics *eval_metrics);
+double metricScore(EvalMetrics eval_metrics, RegressionType model_type);
 void freeEvalMetrics(EvalMetrics *em);
 
 #endif // EVAL_METRICS_H
\ No newline at end of file
@@ -10,8 +10,16 @@
 #define FILE_HANDLING_H
 
 #include "../header/math_funcs.h"
+#include "../header/encoder.h"
+#include "../header/scaler.h"
+#include "../header/data_stream.h"
+#include "../header/sparse.h"
+#include "../header/typed_table.h"
 
 int loadCSVtoMatrix(const char *filename, bool has_header, Matrix *m);
+int loadCSVtoMatrixEncoded(const char *filename, bool has_header, Matrix *m, CategoricalEncoder *encoder);
+int loadCSVtoTypedTable(const char *filename, bool has_header, const StorageType *schema, CategoricalEncoder *encoder, TypedTable *t);
+int loadLIBSVM(const char *filename, int num_features, Matrix *labels, SparseMatrix *features, Matrix *dense);
 
 int normalizeMatrix(Matrix *m);
 
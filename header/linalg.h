@@ -0,0 +1,18 @@
+/*
+ * file: linalg.h
+ * description: header file for the dense factorizations used by the direct solvers
+ * author: Ryan Wagner
+ * date: October 19, 2026
+ * notes:
+ */
+
+#ifndef LINALG_H
+#define LINALG_H
+
+#include "../header/math_funcs.h"
+
+int choleskyDecompose(Matrix *A);
+int choleskySolve(Matrix L, Matrix *B);
+int qrLeastSquares(Matrix A, Matrix B, Matrix *X);
+
+#endif // LINALG_H
@@ -68,6 +68,7 @@ int matvec_mult(Matrix A, Vector y, Vector *result);
 
 int mat_mul_matrix(Matrix A, Matrix B, Matrix *result);
 int mat_mul_double(Matrix A, double B, Matrix *result);
+int mat_mul_indexed(Matrix A, const int *row_idx, int n, Matrix B, Matrix *result);
 
 int mat_add_matrix(Matrix A, Matrix B, Matrix *result);
 int mat_add_vector(Matrix A, Vector B, Matrix *result);
@@ -102,6 +103,7 @@ int softmax(double x_i, Vector x_j, double *x_out);
 int applyToVector(Vector *v, Activation func);
 int applyToMatrix(Matrix *m, Activation func);
 
+int gatherRows(Matrix m, const int *row_idx, int n, Matrix *out);
 int makeMiniMatrix(Matrix m, Matrix *mini, int *perm_arr, int batch_idx, int size);
 int generateRandomPermutation(int *arr, int n);
 
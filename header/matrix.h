@@ -33,10 +33,16 @@ typedef struct
 #define initialized_vector(v) \
     ((v) && (v)->data != NULL && (v)->size > 0)
 
+void countAllocation(void);
+
+long getAllocationCount(void);
+
 int clearMatrix(Matrix *m);
 
 int copyMatrix(Matrix m, Matrix *mc);
 
+char *formatValues(const double *values, int n);
+
 void printMatrix(Matrix m);
 
 void printMatrixShape(Matrix m);
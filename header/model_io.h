@@ -0,0 +1,155 @@
+/*
+ * file: model_io.h
+ * description: header file that gives access to the model save, load, and map functions
+ * author: Ryan Wagner
+ * date: October 19, 2026
+ * notes:
+ */
+
+#ifndef MODEL_IO_H
+#define MODEL_IO_H
+
+#include "../header/regression.h"
+#include "../header/scaler.h"
+
+#define MODEL_FILE_MAGIC "MLLMODEL"
+#define MODEL_FILE_VERSION 2
+#define MODEL_FILE_ALIGN 64
+#define MODEL_FILE_ENDIAN 0x01020304u
+#define CHECKPOINT_FILE_MAGIC "MLLCKPNT"
+#define CHECKPOINT_FILE_VERSION 1
+
+// On-disk header, every section offset is a multiple of MODEL_FILE_ALIGN from the start of the file
+typedef struct
+{
+    char magic[8];             // MODEL_FILE_MAGIC, not null terminated
+    uint32_t version;          // MODEL_FILE_VERSION
+    uint32_t endian;           // MODEL_FILE_ENDIAN as written by the saving machine
+    uint64_t file_size;        // Total size of the file in bytes
+    uint64_t checksum;         // FNV-1a 64 of the whole file with this field set to 0
+    int32_t type;              // RegressionType enum
+    int32_t func;              // Activation enum
+    int32_t classes;           // Number of classes
+    int32_t batch_size;        // Batch size used for training
+    int32_t weight_rows;       // Rows of the weights Matrix (features)
+    int32_t weight_cols;       // Columns of the weights Matrix (classes)
+    int32_t bias_size;         // Size of the bias Vector
+    int32_t epochs;            // ModelConfig epochs
+    int32_t regularization;    // ModelConfig RegularizationType enum
+    int32_t decay_type;        // LearningRate DecayType enum
+    int32_t decay_step;        // LearningRate step decay value
+    int32_t scaler_type;       // ScalerType enum, SCALE_NONE if no statistics are stored
+    int32_t scaler_cols;       // Number of columns in the scaler statistics
+    int32_t scaler_samples;    // Rows the scaler statistics were fitted on
+    int32_t optimizer;         // OptimizerType enum, also keeps the doubles 8-byte aligned
+    double beta;               // Momentum constant
+    double lambda;             // ModelConfig regularization strength
+    double init_learning_rate; // LearningRate initial rate
+    double min_learning_rate;  // LearningRate minimum rate for Cosine Annealing
+    double curr_learning_rate; // LearningRate rate at the end of training
+    double max_epoch_cycle;    // LearningRate Cosine Annealing cycle length
+    double decay_constant;     // LearningRate exponential decay rate
+    double l1_ratio;           // ModelConfig elastic-net mix
+    double beta1;              // Optimizer first moment decay
+    double beta2;              // Optimizer second moment decay
+    double epsilon;            // Optimizer epsilon
+    double weight_decay;       // Optimizer decoupled weight decay
+    uint64_t weights_offset;   // rows x cols doubles, row-major
+    uint64_t bias_offset;      // bias_size doubles
+    uint64_t center_offset;    // scaler_cols doubles, 0 if no scaler
+    uint64_t scale_offset;     // scaler_cols doubles, 0 if no scaler
+} ModelFileHeader;
+
+typedef struct
+{
+    void *base;     // Start of the read-only mapping
+    size_t size;    // Length of the mapping
+    Model model;    // Model whose weights and bias point into the mapping
+    Matrix weights; // View of the mapped weights
+    Vector bias;    // View of the mapped bias
+    Scaler scaler;  // View of the mapped normalization statistics
+} MappedModel;
+
+// On-disk checkpoint header, laid out like ModelFileHeader with the optimizer state added
+typedef struct
+{
+    char magic[8];              // CHECKPOINT_FILE_MAGIC, not null terminated
+    uint32_t version;           // CHECKPOINT_FILE_VERSION
+    uint32_t endian;            // MODEL_FILE_ENDIAN as written by the saving machine
+    uint64_t file_size;         // Total size of the file in bytes
+    uint64_t checksum;          // FNV-1a 64 of the whole file with this field set to 0
+    int32_t type;               // RegressionType enum
+    int32_t func;               // Activation enum
+    int32_t classes;            // Number of classes
+    int32_t batch_size;         // Batch size used for training
+    int32_t weight_rows;        // Rows of the weights and velocity Matrices (features)
+    int32_t weight_cols;        // Columns of the weights and velocity Matrices (classes)
+    int32_t bias_size;          // Size of the bias and velocity Vectors
+    int32_t epochs;             // ModelConfig epochs, the horizon of the run
+    int32_t epoch;              // Epochs trained when the checkpoint was taken
+    int32_t regularization;     // ModelConfig RegularizationType enum
+    int32_t optimizer;          // OptimizerType enum
+    int32_t has_square;         // 1 if the squared gradient sections are stored
+    int32_t decay_type;         // LearningRate DecayType enum
+    int32_t decay_step;         // LearningRate step decay value
+    int32_t preallocate;        // ModelConfig preallocate
+    int32_t patience;           // ModelConfig early stopping patience
+    int32_t checkpoint_every;   // ModelConfig epochs between checkpoints
+    int32_t best_epoch;         // Epoch of the best early stopping weights, 0 without them
+    int32_t stale_epochs;       // Epochs since early stopping last saw an improvement
+    int32_t stopped;            // 1 if the run ended before its epochs ran out
+    int64_t step;               // Optimizer updates applied
+    uint64_t stream;            // Seed every epoch's shuffle is derived from
+    double beta;                // Momentum constant
+    double lambda;              // ModelConfig regularization strength
+    double l1_ratio;            // ModelConfig elastic-net mix
+    double beta1;               // Optimizer first moment decay
+    double beta2;               // Optimizer second moment decay
+    double epsilon;             // Optimizer epsilon
+    double weight_decay;        // Optimizer decoupled weight decay
+    double init_learning_rate;  // LearningRate initial rate
+    double min_learning_rate;   // LearningRate minimum rate for Cosine Annealing
+    double curr_learning_rate;  // LearningRate rate for the next epoch
+    double max_epoch_cycle;     // LearningRate Cosine Annealing cycle length
+    double decay_constant;      // LearningRate exponential decay rate
+    double min_improvement;     // ModelConfig relative improvement that resets patience
+    double grad_norm_tolerance; // ModelConfig gradient norm stopping threshold
+    double best_loss;           // Best loss monitored by early stopping
+    uint64_t weights_offset;    // weight_rows x weight_cols doubles, row-major
+    uint64_t bias_offset;       // bias_size doubles
+    uint64_t velocity_w_offset; // weight_rows x weight_cols doubles of momentum or first moment
+    uint64_t velocity_b_offset; // bias_size doubles of momentum or first moment
+    uint64_t square_w_offset;   // weight_rows x weight_cols doubles, 0 without has_square
+    uint64_t square_b_offset;   // bias_size doubles, 0 without has_square
+    uint64_t best_w_offset;     // weight_rows x weight_cols doubles of the best weights, 0 without best_epoch
+    uint64_t best_b_offset;     // bias_size doubles of the best bias, 0 without best_epoch
+} CheckpointFileHeader;
+
+// Writes checkpoints on a thread of its own so training never waits on the disk
+typedef struct
+{
+    char filename[PATH_MAX]; // Checkpoint file, replaced atomically by every write
+    unsigned char *pending;  // Image handed to the writer and not yet taken
+    size_t pending_size;     // Size of the pending image
+    bool busy;               // An image is pending or being written
+    bool stopping;           // Writer should exit once nothing is pending
+    int written;             // Checkpoints written
+    int failed;              // Checkpoints that could not be written
+    pthread_mutex_t lock;
+    pthread_cond_t wake;
+    pthread_cond_t idle;
+    pthread_t thread;
+    bool has_thread; // False when checkpoints are written by the caller
+} CheckpointWriter;
+
+int saveModel(const Model *model, const Scaler *scaler, const char *filename);
+int loadModel(Model *model, Scaler *scaler, const char *filename);
+int mapModel(MappedModel *mapped, const char *filename);
+void unmapModel(MappedModel *mapped);
+int saveCheckpoint(const Model *model, const OptimizerState *state, const char *filename);
+int loadCheckpoint(Model *model, const char *filename);
+int startCheckpointWriter(CheckpointWriter *writer, const char *filename);
+int submitCheckpoint(CheckpointWriter *writer, const Model *model, const OptimizerState *state, bool wait);
+int stopCheckpointWriter(CheckpointWriter *writer);
+
+#endif // MODEL_IO_H
@@ -0,0 +1,66 @@
+/*
+ * file: prefetch.h
+ * description: header file that gives access to the mini-batch prefetch pipeline
+ * author: Ryan Wagner
+ * date: October 19, 2026
+ * notes:
+ */
+
+#ifndef PREFETCH_H
+#define PREFETCH_H
+
+#include "../header/math_funcs.h"
+#include "../header/random.h"
+#include "../header/threading.h"
+#include "../header/typed_table.h"
+
+#define PREFETCH_DEPTH 2
+#define PREFETCH_MAX_DEPTH 8
+#define PREFETCH_EPOCH_STRIDE 0xD1B54A32D192ED03ULL
+
+typedef struct
+{
+    // Source data, read only while the pipeline runs
+    Matrix X;                // Training features, unused when table is set
+    const TypedTable *table; // Compact training features, widened to double while gathering
+    Matrix y;                // Training labels, class indices for softmax
+    const int *row_idx;      // Rows of X and y the batches are drawn from, NULL for every row
+    int rows;                // Training rows
+    int batch_size;          // Rows per mini-batch, the last batch of an epoch may be smaller
+    int batches;             // Mini-batches per epoch
+    int epochs;              // Epochs to produce
+
+    // Producer position, owned by whoever gathers the next batch
+    int *perm_arr;   // Row order of the current epoch
+    int next_epoch;  // Epoch of the next batch to gather
+    int next_batch;  // Index of the next batch to gather within its epoch
+    uint64_t stream; // Seed the shuffle of every epoch is derived from, with the epoch number
+    RandomState rng; // Stream the row order of the current epoch is drawn from
+
+    // Ring of gathered batches, slots cycle free -> ready -> in use -> free
+    int depth;                          // Number of slots
+    Matrix mini_X[PREFETCH_MAX_DEPTH];  // Gathered features per slot
+    Matrix mini_y[PREFETCH_MAX_DEPTH];  // Gathered labels per slot
+    int head;                           // Next slot the producer fills
+    int tail;                           // Next slot the consumer takes
+    int ready;                          // Slots filled and waiting for the consumer
+    int in_use;                         // Slots held by the consumer
+    bool done;                          // Producer gathered every batch of every epoch
+    bool failed;                        // Producer could not gather a batch
+    bool closing;                       // Consumer is stopping early, producer should exit
+    pthread_mutex_t lock;
+    pthread_cond_t not_empty;
+    pthread_cond_t not_full;
+    pthread_t producer;
+    bool has_producer; // False when batches are gathered inline by the consumer
+} BatchPrefetcher;
+
+int startPrefetcher(BatchPrefetcher *prefetcher, Matrix X, Matrix y, int batch_size, int epochs, int depth, uint64_t seed);
+int startIndexedPrefetcher(BatchPrefetcher *prefetcher, Matrix X, Matrix y, const int *row_idx, int n, int batch_size, int epochs, int depth,
+                           uint64_t seed);
+int startTypedPrefetcher(BatchPrefetcher *prefetcher, const TypedTable *X, Matrix y, int batch_size, int epochs, int depth, uint64_t seed);
+int acquireBatch(BatchPrefetcher *prefetcher, Matrix **mini_X, Matrix **mini_y);
+void releaseBatch(BatchPrefetcher *prefetcher);
+void stopPrefetcher(BatchPrefetcher *prefetcher);
+
+#endif // PREFETCH_H
@@ -0,0 +1,35 @@
+/*
+ * file: random.h
+ * description: header file for the seedable xoshiro256** random number generator
+ * author: Ryan Wagner
+ * date: October 19, 2026
+ * notes:
+ */
+
+#ifndef RANDOM_H
+#define RANDOM_H
+
+#include <stdint.h>
+
+#include "../header/threading.h"
+
+typedef struct
+{
+    uint64_t s[4]; // xoshiro256** state, never all zero
+} RandomState;
+
+void seedRandom(RandomState *rng, uint64_t seed);
+uint64_t nextRandom(RandomState *rng);
+uint32_t randomBounded(RandomState *rng, uint32_t bound);
+double randomUniform(RandomState *rng);
+void jumpRandom(RandomState *rng);
+void longJumpRandom(RandomState *rng);
+void forkRandom(RandomState *parent, RandomState *child);
+
+void setRandomSeed(uint64_t seed);
+RandomState *threadRandom(void);
+void initRandomStream(RandomState *rng, uint64_t seed);
+
+int shufflePermutation(int *arr, int n, RandomState *rng);
+
+#endif // RANDOM_H
@@ -10,12 +10,16 @@
 #define REGRESSION_H
 
 #include "../header/math_funcs.h"
+#include "../header/random.h"
+#include "../header/sparse.h"
+#include "../header/typed_table.h"
 
 typedef enum
 {
     REG_NONE,
     REG_L1,
-    REG_L2
+    REG_L2,
+    REG_ELASTIC_NET
 } RegularizationType;
 
 typedef enum
@@ -34,6 +38,33 @@ typedef enum
     COSINE_ANNEALING
 } DecayType;
 
+typedef enum
+{
+    SOLVER_GRADIENT_DESCENT,
+    SOLVER_CLOSED_FORM,
+    SOLVER_LBFGS,
+    SOLVER_NEWTON,
+    SOLVER_COORDINATE_DESCENT
+} SolverType;
+
+typedef enum
+{
+    OPTIMIZER_MOMENTUM,
+    OPTIMIZER_ADAM,
+    OPTIMIZER_ADAMW,
+    OPTIMIZER_RMSPROP,
+    OPTIMIZER_ADAGRAD
+} OptimizerType;
+
+typedef struct
+{
+    OptimizerType type;  // Update rule applied to every gradient
+    double beta1;        // Decay of the running gradient mean (Adam, AdamW)
+    double beta2;        // Decay of the running squared gradient (Adam, AdamW, RMSProp)
+    double epsilon;      // Keeps the adaptive step finite when the squared gradient is zero
+    double weight_decay; // Decoupled weight decay (AdamW)
+} Optimizer;
+
 typedef struct
 {
     double init_learning_rate; // Initial learning rate of the regression
@@ -50,25 +81,74 @@ typedef struct
     int epochs;                        // Number of iterations to train the model
     double lambda;                     // Effect of the regularization every iteration
     RegularizationType regularization; // Regularization type
+    double l1_ratio;                   // Share of lambda given to the L1 term of the elastic net, the rest goes to L2
     LearningRate learning_rate;        // Learning rate information
+    Optimizer optimizer;               // Update rule of gradient descent, momentum uses Model.beta
+    bool preallocate;                  // Fail rather than fall back to the allocating single threaded step
+    bool hogwild;                      // Lock-free asynchronous per-row SGD across threads, for sparse data
+    SolverType solver;                 // Algorithm used to fit the weights
+    int history;                       // Correction pairs kept by L-BFGS
+    bool shuffle_coordinates;          // Coordinate descent visits the coordinates in a fresh random order every sweep
+    double tolerance;                  // Largest gradient entry at which the full-batch solvers stop, largest
+                                       // scaled coordinate step for coordinate descent
+    uint64_t seed;                     // Seed of the training shuffles, 0 to draw one from the calling thread's stream
+    int patience;                      // Epochs without improvement of the validation loss before stopping, 0 to disable
+    double min_improvement;            // Relative loss decrease that counts as an improvement for patience
+    double grad_norm_tolerance;        // Stop once the epoch's RMS mini-batch gradient norm drops below this, 0 to disable
+    const char *checkpoint_path;       // File mini-batch training checkpoints to in the background, NULL to disable
+    int checkpoint_every;              // Epochs between checkpoints, the last epoch is always written
 } ModelConfig;
 
 typedef struct
 {
-    RegressionType type; // Type of regression to use
-    ModelConfig config;  // Configuration for the model
-    Matrix *X;           // Input matrix of NxM dimension
-    Matrix *y;           // Input matrix of 1xP dimension
-    SplitData splitdata; // Struct that holds all the split data
-    Matrix *weights;     // Learned weights matrix of Nx1 dimension
-    Vector *bias;        // Learned bias matrix of 1xM dimension
-    Matrix *logits;      // Logits vector
-    Activation func;     // Activation function
-    int batch_size;      // Batch size for regression computation
-    int classes;         // Number of classes to use for classification
-    double beta;         // Number to control momentum
+    Matrix velocity_weights; // Momentum or first moment of the weights
+    Vector velocity_bias;    // Momentum or first moment of the bias(es)
+    Matrix square_weights;   // Running squared gradient of the weights, adaptive optimizers only
+    Vector square_bias;      // Running squared gradient of the bias(es), adaptive optimizers only
+    long step;               // Optimizer updates applied so far
+    int epoch;               // Epochs trained so far, the learning rate schedule continues from it
+    uint64_t stream;         // Seed the shuffle of every epoch is derived from, 0 until training starts
+    Matrix best_weights;     // Weights at the best loss monitored by early stopping
+    Vector best_bias;        // Bias at the best loss monitored by early stopping
+    double best_loss;        // Best loss monitored by early stopping
+    int best_epoch;          // Epoch the best weights come from, 0 before early stopping saw an epoch
+    int stale_epochs;        // Epochs since early stopping last saw an improvement
+    bool stopped;            // The last run ended before its epochs ran out, on patience or a vanished gradient
+} OptimizerState;
+
+typedef struct
+{
+    RegressionType type;       // Type of regression to use
+    ModelConfig config;        // Configuration for the model
+    Matrix *X;                 // Input matrix of NxM dimension
+    Matrix *y;                 // Input matrix of 1xP dimension
+    SplitData splitdata;       // Struct that holds all the split data
+    TypedTable train_table;    // Compact training features, used instead of splitdata.train_features when set
+    SparseMatrix train_sparse; // CSR training features, used instead of splitdata.train_features when set, L-BFGS only
+    const int *train_rows;     // Rows of splitdata.train_features to train on, NULL for every row
+    int n_train_rows;          // Number of rows in train_rows
+    Matrix *weights;           // Learned weights matrix of Nx1 dimension
+    Vector *bias;              // Learned bias matrix of 1xM dimension
+    Matrix *logits;            // Logits vector
+    Activation func;           // Activation function
+    int batch_size;            // Batch size for regression computation
+    int classes;               // Number of classes to use for classification
+    double beta;               // Number to control momentum
+    OptimizerState state;      // Optimizer state left by mini-batch training, resumeModel continues from it
 } Model;
 
+typedef struct
+{
+    int count;          // Number of lambdas on the path
+    Vector lambdas;     // Lambdas from largest to smallest
+    Matrix weights;     // Weights fitted at every lambda, count x features
+    Vector bias;        // Bias fitted at every lambda
+    int *nonzero;       // Nonzero weights at every lambda
+    Vector valid_loss;  // Unpenalized validation loss at every lambda, MSE or log loss
+    Vector valid_score; // Validation R2 score for linear regression, accuracy for logistic regression
+    int best;           // Lambda with the lowest validation loss, the last one without a validation split
+} RegularizationPath;
+
 ModelConfig makeDefaultConfig();
 
 int comptueLabels(Matrix X, Matrix weights, Vector biases, Matrix *labels, Activation activation);
@@ -76,6 +156,14 @@ int comptueLabels(Matrix X, Matrix weights, Vector biases, Matrix *labels, Activ
 int initModel(Model *model);
 
 int trainModel(Model *model);
+int resumeModel(Model *model, int epochs);
+int partialFit(Model *model, Matrix X, Matrix y, int steps, double *loss);
+int resumeFromCheckpoint(Model *model, const char *filename);
+int evaluateLoss(Model *model, Matrix X, Matrix y, double *loss);
+int predictRows(Model *model, Matrix X, const int *rows, int n, Matrix *predicted);
+void freeOptimizerState(OptimizerState *state);
+int computeRegularizationPath(Model *model, const double *lambdas, int count, double min_ratio, RegularizationPath *path);
+void freeRegularizationPath(RegularizationPath *path);
 
 void freeModel(Model *model);
 
@@ -0,0 +1,37 @@
+/*
+ * file: scaler.h
+ * description: header file that gives access to the feature scaling (normalization) functions
+ * author: Ryan Wagner
+ * date: October 19, 2026
+ * notes:
+ */
+
+#ifndef SCALER_H
+#define SCALER_H
+
+#include "../header/vector.h"
+#include "../header/threading.h"
+
+typedef enum
+{
+    SCALE_NONE,     // Scaler has not been set, transform is a no-op
+    SCALE_STANDARD, // (x - mean) / standard deviation
+    SCALE_MINMAX,   // (x - min) / (max - min)
+    SCALE_ROBUST    // (x - median) / interquartile range
+} ScalerType;
+
+typedef struct
+{
+    ScalerType type; // Type of scaling to apply
+    int samples;     // Number of rows the statistics were fitted on
+    Vector center;   // Per-column value subtracted: mean, min, or median
+    Vector scale;    // Per-column value divided by: standard deviation, range, or IQR
+} Scaler;
+
+Scaler makeDefaultScaler(ScalerType type);
+int fitScaler(Scaler *scaler, Matrix m);
+int transformScaler(const Scaler *scaler, Matrix *m);
+int fitTransformScaler(Scaler *scaler, Matrix *m);
+void freeScaler(Scaler *scaler);
+
+#endif // SCALER_H
@@ -0,0 +1,32 @@
+/*
+ * file: sparse.h
+ * description: header file for the compressed sparse row (CSR) matrix and its kernels
+ * author: Ryan Wagner
+ * date: October 19, 2026
+ * notes:
+ */
+
+#ifndef SPARSE_H
+#define SPARSE_H
+
+#include "../header/math_funcs.h"
+#include "../header/threading.h"
+
+typedef struct
+{
+    int rows;
+    int cols;
+    int64_t nnz;      // Number of stored values
+    int64_t *row_ptr; // rows + 1 offsets, row r is [row_ptr[r], row_ptr[r + 1])
+    int *col_idx;     // Column of every stored value
+    double *values;   // Stored values
+} SparseMatrix;
+
+SparseMatrix makeSparseMatrixEmpty(void);
+int makeSparseMatrix(SparseMatrix *s, int rows, int cols, int64_t nnz);
+void freeSparseMatrix(SparseMatrix *s);
+int sparseToDense(SparseMatrix s, Matrix *m);
+int sparseMatMul(SparseMatrix A, Matrix B, Matrix *result);
+int sparseTransMatMul(SparseMatrix A, Matrix B, Matrix *result);
+
+#endif // SPARSE_H
@@ -0,0 +1,55 @@
+/*
+ * file: sweep.h
+ * description: header file that gives access to the in-process hyperparameter sweep
+ * author: Ryan Wagner
+ * date: October 19, 2026
+ * notes:
+ */
+
+#ifndef SWEEP_H
+#define SWEEP_H
+
+#include "../header/regression.h"
+#include "../header/eval_matrics.h"
+
+// Values to sweep for every hyperparameter, an empty list keeps the base model's value
+typedef struct
+{
+    const double *learning_rates; // Initial learning rates
+    int n_learning_rates;         // Number of learning rates
+    const DecayType *decay_types; // Learning rate decay types
+    int n_decay_types;            // Number of decay types
+    const double *lambdas;        // Regularization strengths
+    int n_lambdas;                // Number of lambdas
+    const int *batch_sizes;       // Mini-batch sizes
+    int n_batch_sizes;            // Number of batch sizes
+    const double *betas;          // Momentum constants
+    int n_betas;                  // Number of betas
+} SweepSpace;
+
+typedef struct
+{
+    int index;            // Position of the trial in the generated set
+    ModelConfig config;   // Configuration of the trial
+    int batch_size;       // Mini-batch size of the trial
+    double beta;          // Momentum constant of the trial
+    int status;           // 0 once trained and scored, -1 if that failed
+    EvalMetrics metrics;  // Metrics on the validation split
+    double score;         // Ranking score from metricScore, higher is better
+    double loss;          // Unpenalized validation loss from evaluateLoss, lower is better
+    int epochs;           // Epochs trained so far, fewer than budget when training stopped early
+    int budget;           // Epoch budget of the last successive halving round the trial took part in
+    Matrix weights;       // Trained weights
+    Vector bias;          // Trained bias
+    OptimizerState state; // Optimizer state of the trained weights, successive halving resumes from it
+} SweepTrial;
+
+int makeGridTrials(const Model *base, const SweepSpace *space, SweepTrial **trials, int *count);
+int makeRandomTrials(const Model *base, const SweepSpace *space, int count, uint64_t seed, SweepTrial **trials);
+int runSweep(const Model *base, SweepTrial *trials, int count, int workers);
+int runSuccessiveHalving(const Model *base, SweepTrial *trials, int count, int min_epochs, int max_epochs, int eta, int workers);
+int runHyperband(const Model *base, const SweepSpace *space, int min_epochs, int max_epochs, int eta, uint64_t seed, int workers,
+                 SweepTrial **trials, int *count);
+void freeSweepTrials(SweepTrial *trials, int count);
+
+#endif // SWEEP_H
@@ -0,0 +1,29 @@
+/*
+ * file: threading.h
+ * description: header file that gives access to the parallel-for helper functions
+ * author: Ryan Wagner
+ * date: October 19, 2026
+ * notes:
+ */
+
+#ifndef THREADING_H
+#define THREADING_H
+
+#include <pthread.h>
+
+#include "../header/logging.h"
+
+#define MAX_THREADS 256
+
+// Task run by every thread on its own contiguous [start, end) range
+typedef void (*ParallelTask)(void *args, int thread_id, int start, int end);
+
+int getThreadCount(void);
+void setThreadCount(int threads);
+int getLocalThreadCount(void);
+void setLocalThreadCount(int threads);
+int planThreads(int n, int min_chunk);
+int getChunkStart(int n, int threads, int thread_id);
+int parallelFor(int threads, int n, ParallelTask task, void *args);
+
+#endif // THREADING_H
@@ -0,0 +1,55 @@
+/*
+ * file: typed_table.h
+ * description: header file for the column-typed table used to hold loaded datasets compactly
+ * author: Ryan Wagner
+ * date: October 19, 2026
+ * notes:
+ */
+
+#ifndef TYPED_TABLE_H
+#define TYPED_TABLE_H
+
+#include "../header/math_funcs.h"
+#include "../header/threading.h"
+
+typedef enum
+{
+    STORE_UINT8,   // Flags and small codes in [0, 255]
+    STORE_INT16,   // Integers in [-32768, 32767]
+    STORE_INT32,   // Integers in the int32 range
+    STORE_FLOAT32, // Values that survive a round trip through float exactly
+    STORE_FLOAT64  // Everything else
+} StorageType;
+
+typedef struct
+{
+    bool integral;    // Every value is a whole number
+    bool float_exact; // Every value converts to float and back unchanged
+    double min;       // Smallest value seen
+    double max;       // Largest value seen
+} ColumnProfile;
+
+typedef struct
+{
+    int rows;
+    int cols;
+    StorageType *types; // Storage type of every column
+    void **columns;     // One contiguous array per column, element size set by its type
+} TypedTable;
+
+size_t storageTypeSize(StorageType type);
+ColumnProfile makeColumnProfile(void);
+void updateColumnProfile(ColumnProfile *profile, double value);
+StorageType narrowestStorageType(ColumnProfile profile);
+
+TypedTable makeTypedTableEmpty(void);
+int makeTypedTable(TypedTable *t, int rows, int cols, const StorageType *types);
+void setTypedValue(TypedTable *t, int row, int col, double value);
+double getTypedValue(const TypedTable *t, int row, int col);
+int typedTableFromMatrix(Matrix m, const StorageType *types, TypedTable *t);
+int typedTableToMatrix(const TypedTable *t, Matrix *m);
+int gatherTypedRows(const TypedTable *t, const int *row_idx, int n, Matrix *out);
+size_t typedTableBytes(const TypedTable *t);
+void freeTypedTable(TypedTable *t);
+
+#endif // TYPED_TABLE_H
@@ -0,0 +1,316 @@
+/*
+ * file: cross_validation.c
+ * description: k-fold cross-validation that trains the fold models concurrently
+ * author: Ryan Wagner
+ * date: October 19, 2026
+ * notes: folds are index sets over the caller's features and labels, which every fold model
+ *        reads in place. The shuffled row order is stored twice so the training rows of every
+ *        fold are one contiguous run of it, and k folds cost two integer arrays of the row
+ *        count rather than k copies of the dataset.
+ */
+
+#include <stddef.h>
+#include <stdatomic.h>
+
+#include "../header/cross_validation.h"
+#include "../header/threading.h"
+
+// Metrics that are averaged across folds
+static const size_t METRIC_FIELDS[] = {offsetof(EvalMetrics, accuracy), offsetof(EvalMetrics, precision), offsetof(EvalMetrics, recall),
+                                       offsetof(EvalMetrics, f1),       offsetof(EvalMetrics, mse),       offsetof(EvalMetrics, rmse),
+                                       offsetof(EvalMetrics, mae),      offsetof(EvalMetrics, r2score)};
+#define N_METRIC_FIELDS (int)(sizeof(METRIC_FIELDS) / sizeof(METRIC_FIELDS[0]))
+
+typedef struct
+{
+    const Model *base;   // Template model with the type, activation, classes and configuration
+    Matrix X;            // Features of the whole dataset
+    Matrix y;            // Labels of the whole dataset
+    CrossValidation *cv; // Folds and the results to fill
+    int inner_threads;   // Threads every fold may use inside trainModel
+    atomic_int next;     // Next fold to hand out
+} FoldTask;
+
+/**
+ * @brief Shuffle the rows into folds whose sizes differ by at most one
+ *
+ * @param rows Number of rows in the dataset
+ * @param folds Number of folds, between 2 and rows
+ * @param seed Seed of the shuffle, 0 to draw one from the calling thread's stream
+ * @param cv CrossValidation object to fill, free with freeCrossValidation
+ *
+ * @return 0 if successful, -1 if failure
+ */
+int makeFolds(int rows, int folds, uint64_t seed, CrossValidation *cv)
+{
+    if (!cv || folds < 2 || rows < folds)
+    {
+        LOG_ERROR("Input variables to make %d folds of %d rows were not correct.\n", folds, rows);
+        return -1;
+    }
+
+    memset(cv, 0, sizeof(CrossValidation));
+    cv->folds = folds;
+    cv->rows = rows;
+    cv->order = (int *)malloc(2 * (size_t)rows * sizeof(int));
+    cv->bounds = (int *)malloc((folds + 1) * sizeof(int));
+    cv->status = (int *)malloc(folds * sizeof(int));
+    cv->metrics = (EvalMetrics *)calloc(folds, sizeof(EvalMetrics));
+    cv->scores = (double *)calloc(folds, sizeof(double));
+    if (!cv->order || !cv->bounds || !cv->status || !cv->metrics || !cv->scores)
+    {
+        LOG_ERROR("Allocating %d folds was unsuccessful.\n", folds);
+        freeCrossValidation(cv);
+        return -1;
+    }
+
+    RandomState rng;
+    initRandomStream(&rng, seed);
+    if (shufflePermutation(cv->order, rows, &rng) < 0)
+    {
+        freeCrossValidation(cv);
+        return -1;
+    }
+    memcpy(cv->order + rows, cv->order, rows * sizeof(int));
+
+    for (int f = 0; f <= folds; ++f)
+    {
+        cv->bounds[f] = (int)((long)f * rows / folds);
+    }
+    for (int f = 0; f < folds; ++f)
+    {
+        cv->status[f] = -1;
+    }
+
+    return 0;
+}
+
+/**
+ * @brief Train the model of one fold on the rows it does not hold out and score it on the
+ *        rows it does. Both sets are read from the dataset in place.
+ *
+ * @param task FoldTask object
+ * @param f Fold to train
+ *
+ * @return 0 if successful, -1 if failure
+ */
+static int trainFold(FoldTask *task, int f)
+{
+    CrossValidation *cv = task->cv;
+    const int *held_out = &cv->order[cv->bounds[f]];
+    int n_held_out = cv->bounds[f + 1] - cv->bounds[f];
+
+    Model model;
+    if (initModel(&model) < 0)
+    {
+        return -1;
+    }
+    freeSplitData(&model.splitdata);
+    memset(&model.splitdata, 0, sizeof(SplitData));
+    model.splitdata.train_features = task->X;
+    model.splitdata.train_labels = task->y;
+    model.train_rows = &cv->order[cv->bounds[f + 1]];
+    model.n_train_rows = cv->rows - n_held_out;
+    model.type = task->base->type;
+    model.func = task->base->func;
+    model.classes = task->base->classes;
+    model.config = task->base->config;
+    model.config.checkpoint_path = NULL; // Concurrent models would overwrite one checkpoint
+    model.batch_size = task->base->batch_size;
+    model.beta = task->base->beta;
+
+    // Only the predictions and labels of the held-out rows are materialized
+    Matrix predicted = {0};
+    Matrix labels = {0};
+    int status = trainModel(&model);
+    if (status == 0)
+    {
+        status = predictRows(&model, task->X, held_out, n_held_out, &predicted);
+    }
+    if (status == 0)
+    {
+        status = (makeMatrixZeros(&labels, n_held_out, 1) < 0 || gatherRows(task->y, held_out, n_held_out, &labels) < 0) ? -1 : 0;
+    }
+    if (status == 0)
+    {
+        status = evaluatePredictions(model.type, labels, &predicted, &cv->metrics[f]);
+    }
+    if (status == 0)
+    {
+        cv->scores[f] = metricScore(cv->metrics[f], model.type);
+    }
+    freeMatrix(&predicted);
+    freeMatrix(&labels);
+
+    // The dataset and the folds belong to the caller
+    memset(&model.splitdata, 0, sizeof(SplitData));
+    model.train_rows = NULL;
+    freeModel(&model);
+    return status;
+}
+
+/**
+ * @brief Worker loop that trains folds until none are left
+ *
+ * @param args FoldTask object
+ * @param thread_id Worker index
+ * @param start Unused, folds are handed out dynamically
+ * @param end Unused, folds are handed out dynamically
+ *
+ * @return None
+ */
+static void foldWorker(void *args, int thread_id, int start, int end)
+{
+    (void)thread_id;
+    (void)start;
+    (void)end;
+    FoldTask *task = (FoldTask *)args;
+
+    // parallelFor runs the first worker on the caller, whose own count must survive the folds
+    int previous_threads = getLocalThreadCount();
+    setLocalThreadCount(task->inner_threads);
+
+    int f = atomic_fetch_add(&task->next, 1);
+    while (f < task->cv->folds)
+    {
+        task->cv->status[f] = trainFold(task, f);
+        if (task->cv->status[f] < 0)
+        {
+            LOG_WARN("Cross-validation fold %d failed to train or score.\n", f);
+        }
+        f = atomic_fetch_add(&task->next, 1);
+    }
+
+    setLocalThreadCount(previous_threads);
+}
+
+/**
+ * @brief Mean and sample standard deviation of one value over the folds that trained
+ *
+ * @param cv CrossValidation object with the fold results
+ * @param values Value of every fold, read at stride bytes apart
+ * @param stride Bytes between the values of consecutive folds
+ * @param mean Resulting mean
+ * @param std Resulting sample standard deviation, 0 with a single fold
+ *
+ * @return None
+ */
+static void foldMoments(const CrossValidation *cv, const char *values, size_t stride, double *mean, double *std)
+{
+    int n = 0;
+    double sum = 0.0;
+    for (int f = 0; f < cv->folds; ++f)
+    {
+        if (cv->status[f] == 0)
+        {
+            sum += *(const double *)(values + f * stride);
+            ++n;
+        }
+    }
+    *mean = sum / n;
+
+    double squares = 0.0;
+    for (int f = 0; f < cv->folds; ++f)
+    {
+        if (cv->status[f] == 0)
+        {
+            double diff = *(const double *)(values + f * stride) - *mean;
+            squares += diff * diff;
+        }
+    }
+    *std = (n > 1) ? sqrt(squares / (n - 1)) : 0.0;
+}
+
+/**
+ * @brief k-fold cross-validation. The rows are shuffled into folds held as index sets over X
+ *        and y, the fold models train concurrently with an equal share of the cores each, and
+ *        the held-out metrics are averaged with their standard deviation. Memory stays at the
+ *        caller's single copy of the dataset whatever the number of folds.
+ *
+ * @param base Template Model object with the type, activation, classes, batch size, beta and
+ *        a mini-batch gradient descent configuration
+ * @param X Features of the whole dataset
+ * @param y Labels of the whole dataset, class indices for softmax
+ * @param folds Number of folds, between 2 and the number of rows
+ * @param seed Seed of the fold shuffle, 0 to draw one from the calling thread's stream
+ * @param workers Folds trained at once, <= 0 for one per core
+ * @param cv CrossValidation object to fill, free with freeCrossValidation
+ *
+ * @return 0 if successful, -1 if failure
+ */
+int crossValidate(const Model *base, Matrix X, Matrix y, int folds, uint64_t seed, int workers, CrossValidation *cv)
+{
+    if (!base || !cv || !X.data || !y.data || X.rows != y.rows || y.cols != 1)
+    {
+        LOG_ERROR("Input variables to cross-validate were not correct.\n");
+        return -1;
+    }
+    if (makeFolds(X.rows, folds, seed, cv) < 0)
+    {
+        return -1;
+    }
+
+    int cores = getThreadCount();
+    workers = (workers <= 0) ? cores : workers;
+    workers = MIN(MIN(workers, folds), MAX_THREADS);
+
+    FoldTask task;
+    task.base = base;
+    task.X = X;
+    task.y = y;
+    task.cv = cv;
+    task.inner_threads = MAX(1, cores / workers);
+    atomic_init(&task.next, 0);
+    if (parallelFor(workers, workers, foldWorker, &task) < 0)
+    {
+        LOG_ERROR("Running the cross-validation workers was unsuccessful.\n");
+        return -1;
+    }
+
+    int trained = 0;
+    for (int f = 0; f < folds; ++f)
+    {
+        trained += cv->status[f] == 0;
+    }
+    if (trained == 0)
+    {
+        LOG_ERROR("No cross-validation fold trained successfully.\n");
+        return -1;
+    }
+
+    for (int i = 0; i < N_METRIC_FIELDS; ++i)
+    {
+        double *mean = (double *)((char *)&cv->mean + METRIC_FIELDS[i]);
+        double *std = (double *)((char *)&cv->std + METRIC_FIELDS[i]);
+        foldMoments(cv, (const char *)cv->metrics + METRIC_FIELDS[i], sizeof(EvalMetrics), mean, std);
+    }
+    foldMoments(cv, (const char *)cv->scores, sizeof(double), &cv->mean_score, &cv->std_score);
+    LOG_DEBUG("Cross-validation trained %d of %d folds, score %f +/- %f.\n", trained, folds, cv->mean_score, cv->std_score);
+
+    return 0;
+}
+
+/**
+ * @brief Free the folds and the results of every fold
+ *
+ * @param cv CrossValidation object
+ *
+ * @return None
+ */
+void freeCrossValidation(CrossValidation *cv)
+{
+    if (!cv)
+    {
+        return;
+    }
+    free(cv->order);
+    free(cv->bounds);
+    free(cv->status);
+    free(cv->metrics);
+    free(cv->scores);
+    cv->order = NULL;
+    cv->bounds = NULL;
+    cv->status = NULL;
+    cv->metrics = NULL;
+    cv->scores = NULL;
+}
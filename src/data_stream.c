@@ -0,0 +1,509 @@
+/*
+ * file: data_stream.c
+ * description: line reader over plain, gzip, or zstd compressed files
+ * author: Ryan Wagner
+ * date: October 19, 2026
+ * notes: compressed input is decompressed by a producer thread into a ring buffer while the
+ *        caller parses, so decompression and parsing overlap and no temp file is written
+ */
+
+#include "../header/data_stream.h"
+
+#define MIN_SIZE(a, b) ((a) < (b) ? (a) : (b))
+
+#ifdef ML_HAVE_ZLIB
+#include <zlib.h>
+#endif
+#ifdef ML_HAVE_ZSTD
+#include <zstd.h>
+#endif
+
+#ifdef ML_HAVE_ZSTD
+typedef struct
+{
+    ZSTD_DCtx *dctx;     // Decompression context
+    char *in;            // Compressed input buffer
+    ZSTD_inBuffer input; // Unconsumed part of the input buffer
+    size_t last_ret;     // Last ZSTD_decompressStream result, 0 at a frame boundary
+} ZstdDecoder;
+#endif
+
+/**
+ * @brief Detect the compression format of a file from its magic bytes
+ *
+ * @param filename relative or abolsute path to the file
+ *
+ * @return StreamFormat enum, STREAM_PLAIN if the file is not compressed or cannot be read
+ */
+StreamFormat detectStreamFormat(const char *filename)
+{
+    FILE *file = fopen(filename, "rb");
+    if (!file)
+    {
+        return STREAM_PLAIN;
+    }
+
+    unsigned char magic[4] = {0};
+    size_t n = fread(magic, 1, sizeof(magic), file);
+    fclose(file);
+
+    if (n >= 2 && magic[0] == 0x1f && magic[1] == 0x8b)
+    {
+        return STREAM_GZIP;
+    }
+    if (n == 4 && magic[0] == 0x28 && magic[1] == 0xb5 && magic[2] == 0x2f && magic[3] == 0xfd)
+    {
+        return STREAM_ZSTD;
+    }
+
+    return STREAM_PLAIN;
+}
+
+/**
+ * @brief Decompress the next chunk of a compressed stream
+ *
+ * @param stream DataStream object
+ * @param chunk Output buffer
+ * @param size Length of the output buffer
+ * @param done Set when the end of the input is reached
+ * @param failed Set on a decompression error
+ *
+ * @return Number of bytes written to chunk
+ */
+static size_t decompressChunk(DataStream *stream, char *chunk, size_t size, bool *done, bool *failed)
+{
+    switch (stream->format)
+    {
+#ifdef ML_HAVE_ZLIB
+    case STREAM_GZIP:
+    {
+        int n = gzread((gzFile)stream->decoder, chunk, (unsigned)size);
+        if (n < 0)
+        {
+            *failed = true;
+            return 0;
+        }
+        if (n == 0)
+        {
+            // zlib reports input that ends inside a member as an end of file with Z_BUF_ERROR
+            int err = Z_OK;
+            gzerror((gzFile)stream->decoder, &err);
+            if (err != Z_OK)
+            {
+                LOG_ERROR("gzip input ended before the end of the compressed data.\n");
+                *failed = true;
+            }
+            *done = true;
+        }
+        return (size_t)n;
+    }
+#endif
+#ifdef ML_HAVE_ZSTD
+    case STREAM_ZSTD:
+    {
+        ZstdDecoder *zd = (ZstdDecoder *)stream->decoder;
+        ZSTD_outBuffer output = {chunk, size, 0};
+        while (output.pos == 0)
+        {
+            if (zd->input.pos == zd->input.size)
+            {
+                size_t read = fread(zd->in, 1, ZSTD_DStreamInSize(), stream->file);
+                if (read == 0)
+                {
+                    // Input ended, it is only complete if the last frame was finished
+                    *done = true;
+                    *failed = zd->last_ret != 0;
+                    break;
+                }
+                zd->input.src = zd->in;
+                zd->input.size = read;
+                zd->input.pos = 0;
+            }
+
+            zd->last_ret = ZSTD_decompressStream(zd->dctx, &output, &zd->input);
+            if (ZSTD_isError(zd->last_ret))
+            {
+                LOG_ERROR("zstd decompression failed: %s\n", ZSTD_getErrorName(zd->last_ret));
+                *failed = true;
+                break;
+            }
+        }
+        return output.pos;
+    }
+#endif
+    default:
+    {
+        *failed = true;
+        return 0;
+    }
+    }
+}
+
+/**
+ * @brief Producer thread, decompresses chunks and pushes them into the ring buffer
+ *
+ * @param arg Pointer to DataStream
+ *
+ * @return NULL
+ */
+static void *producerMain(void *arg)
+{
+    DataStream *stream = (DataStream *)arg;
+    char *chunk = malloc(STREAM_CHUNK_SIZE);
+    bool done = (chunk == NULL);
+    bool failed = (chunk == NULL);
+
+    while (!done && !failed)
+    {
+        size_t n = decompressChunk(stream, chunk, STREAM_CHUNK_SIZE, &done, &failed);
+        size_t offset = 0;
+
+        pthread_mutex_lock(&stream->lock);
+        while (offset < n && !stream->closing)
+        {
+            while (stream->ring_count == stream->ring_size && !stream->closing)
+            {
+                pthread_cond_wait(&stream->not_full, &stream->lock);
+            }
+            if (stream->closing)
+            {
+                break;
+            }
+
+            size_t todo = MIN_SIZE(n - offset, stream->ring_size - stream->ring_count);
+            size_t first = MIN_SIZE(todo, stream->ring_size - stream->ring_head);
+            memcpy(stream->ring + stream->ring_head, chunk + offset, first);
+            memcpy(stream->ring, chunk + offset + first, todo - first);
+            stream->ring_head = (stream->ring_head + todo) % stream->ring_size;
+            stream->ring_count += todo;
+            offset += todo;
+            pthread_cond_signal(&stream->not_empty);
+        }
+        if (stream->closing)
+        {
+            done = true;
+        }
+        pthread_mutex_unlock(&stream->lock);
+    }
+
+    pthread_mutex_lock(&stream->lock);
+    stream->eof = true;
+    stream->failed = failed;
+    pthread_cond_signal(&stream->not_empty);
+    pthread_mutex_unlock(&stream->lock);
+
+    free(chunk);
+
+    return NULL;
+}
+
+/**
+ * @brief Open a file for line reading, starting the decompression thread if it is compressed
+ *
+ * @param stream Pointer to DataStream object to initialize
+ * @param filename relative or abolsute path to the file
+ *
+ * @return 0 if successful, -1 if failure
+ */
+int openDataStream(DataStream *stream, const char *filename)
+{
+    if (!stream || !filename)
+    {
+        LOG_ERROR("Input variables to open a data stream were not correct.\n");
+        return -1;
+    }
+
+    memset(stream, 0, sizeof(DataStream));
+    stream->format = detectStreamFormat(filename);
+    stream->ring_size = STREAM_RING_SIZE;
+    stream->block = malloc(stream->ring_size);
+    if (!stream->block)
+    {
+        LOG_ERROR("Failed to allocate data stream buffer.\n");
+        return -1;
+    }
+
+    switch (stream->format)
+    {
+    case STREAM_PLAIN:
+    {
+        stream->file = fopen(filename, "rb");
+        if (!stream->file)
+        {
+            LOG_ERROR("Error opening file %s\n", filename);
+            free(stream->block);
+            stream->block = NULL;
+            return -1;
+        }
+        return 0;
+    }
+    case STREAM_GZIP:
+    {
+#ifdef ML_HAVE_ZLIB
+        gzFile gz = gzopen(filename, "rb");
+        if (!gz)
+        {
+            LOG_ERROR("Error opening gzip file %s\n", filename);
+            free(stream->block);
+            stream->block = NULL;
+            return -1;
+        }
+        gzbuffer(gz, STREAM_CHUNK_SIZE * 2);
+        stream->decoder = gz;
+        break;
+#else
+        LOG_ERROR("%s is gzip compressed but the library was built without zlib.\n", filename);
+        free(stream->block);
+        stream->block = NULL;
+        return -1;
+#endif
+    }
+    case STREAM_ZSTD:
+    {
+#ifdef ML_HAVE_ZSTD
+        ZstdDecoder *zd = calloc(1, sizeof(ZstdDecoder));
+        stream->file = fopen(filename, "rb");
+        if (zd)
+        {
+            zd->dctx = ZSTD_createDCtx();
+            zd->in = malloc(ZSTD_DStreamInSize());
+        }
+        if (!zd || !stream->file || !zd->dctx || !zd->in)
+        {
+            LOG_ERROR("Error opening zstd file %s\n", filename);
+            if (zd)
+            {
+                ZSTD_freeDCtx(zd->dctx);
+                free(zd->in);
+                free(zd);
+            }
+            if (stream->file)
+            {
+                fclose(stream->file);
+            }
+            free(stream->block);
+            stream->block = NULL;
+            return -1;
+        }
+        stream->decoder = zd;
+        break;
+#else
+        LOG_ERROR("%s is zstd compressed but the library was built without libzstd.\n", filename);
+        free(stream->block);
+        stream->block = NULL;
+        return -1;
+#endif
+    }
+    default:
+        break;
+    }
+
+    stream->ring = malloc(stream->ring_size);
+    if (!stream->ring)
+    {
+        LOG_ERROR("Failed to allocate data stream ring buffer.\n");
+        closeDataStream(stream);
+        return -1;
+    }
+
+    pthread_mutex_init(&stream->lock, NULL);
+    pthread_cond_init(&stream->not_empty, NULL);
+    pthread_cond_init(&stream->not_full, NULL);
+    if (pthread_create(&stream->producer, NULL, producerMain, stream) != 0)
+    {
+        LOG_ERROR("Could not start decompression thread.\n");
+        closeDataStream(stream);
+        return -1;
+    }
+    stream->has_producer = true;
+
+    return 0;
+}
+
+/**
+ * @brief Refill the consumer block, from the file for plain streams or by draining the ring
+ *
+ * @param stream DataStream object
+ *
+ * @return Number of bytes in the new block, 0 at the end of the stream
+ */
+static size_t refillBlock(DataStream *stream)
+{
+    stream->block_pos = 0;
+    stream->block_len = 0;
+
+    if (stream->format == STREAM_PLAIN)
+    {
+        stream->block_len = fread(stream->block, 1, stream->ring_size, stream->file);
+        if (stream->block_len == 0 && ferror(stream->file))
+        {
+            LOG_ERROR("Reading the input stream failed, data is truncated.\n");
+            stream->read_failed = true;
+        }
+        return stream->block_len;
+    }
+
+    pthread_mutex_lock(&stream->lock);
+    while (stream->ring_count == 0 && !stream->eof)
+    {
+        pthread_cond_wait(&stream->not_empty, &stream->lock);
+    }
+
+    // Take everything available in one go so the lock is held once per block, not per line
+    size_t count = stream->ring_count;
+    size_t tail = (stream->ring_head + stream->ring_size - count) % stream->ring_size;
+    size_t first = MIN_SIZE(count, stream->ring_size - tail);
+    memcpy(stream->block, stream->ring + tail, first);
+    memcpy(stream->block + first, stream->ring, count - first);
+    stream->ring_count = 0;
+    stream->block_len = count;
+
+    if (count == 0 && stream->failed)
+    {
+        LOG_ERROR("Decompression of the input stream failed, data is truncated.\n");
+        stream->read_failed = true;
+    }
+
+    pthread_cond_signal(&stream->not_full);
+    pthread_mutex_unlock(&stream->lock);
+
+    return count;
+}
+
+/**
+ * @brief Read the next line of the stream, same contract as getline
+ *
+ * @param stream DataStream object
+ * @param line Pointer to a malloc'd line buffer (or NULL), grown as needed
+ * @param line_cap Pointer to the capacity of the line buffer
+ *
+ * @return Length of the line including the newline, -1 at the end of the stream or on failure
+ */
+ssize_t readLineDataStream(DataStream *stream, char **line, size_t *line_cap)
+{
+    if (!stream || !stream->block || !line || !line_cap)
+    {
+        return -1;
+    }
+
+    size_t len = 0;
+    while (true)
+    {
+        if (stream->block_pos == stream->block_len && refillBlock(stream) == 0)
+        {
+            break;
+        }
+
+        const char *start = stream->block + stream->block_pos;
+        size_t avail = stream->block_len - stream->block_pos;
+        const char *newline = memchr(start, '\n', avail);
+        size_t take = newline ? (size_t)(newline - start) + 1 : avail;
+
+        if (len + take + 1 > *line_cap)
+        {
+            size_t new_cap = (*line_cap > 0) ? *line_cap : 256;
+            while (new_cap < len + take + 1)
+            {
+                new_cap *= 2;
+            }
+            char *grown = realloc(*line, new_cap);
+            if (!grown)
+            {
+                LOG_ERROR("Failed to grow line buffer.\n");
+                stream->read_failed = true;
+                return -1;
+            }
+            *line = grown;
+            *line_cap = new_cap;
+        }
+
+        memcpy(*line + len, start, take);
+        len += take;
+        stream->block_pos += take;
+
+        if (newline)
+        {
+            break;
+        }
+    }
+
+    if (len == 0)
+    {
+        return -1;
+    }
+
+    (*line)[len] = '\0';
+
+    return (ssize_t)len;
+}
+
+/**
+ * @brief Check whether the stream ended on a read or decompression error rather than at the
+ *        end of the input. readLineDataStream returns -1 in both cases, so loaders check this
+ *        once it does.
+ *
+ * @param stream DataStream object
+ *
+ * @return true if the data read so far is truncated
+ */
+bool dataStreamFailed(const DataStream *stream)
+{
+    return !stream || stream->read_failed;
+}
+
+/**
+ * @brief Stop the decompression thread and free a DataStream object
+ *
+ * @param stream DataStream to close
+ *
+ * @return None
+ */
+void closeDataStream(DataStream *stream)
+{
+    if (!stream)
+    {
+        return;
+    }
+
+    if (stream->has_producer)
+    {
+        pthread_mutex_lock(&stream->lock);
+        stream->closing = true;
+        pthread_cond_signal(&stream->not_full);
+        pthread_mutex_unlock(&stream->lock);
+        pthread_join(stream->producer, NULL);
+        stream->has_producer = false;
+
+        pthread_mutex_destroy(&stream->lock);
+        pthread_cond_destroy(&stream->not_empty);
+        pthread_cond_destroy(&stream->not_full);
+    }
+
+#ifdef ML_HAVE_ZLIB
+    if (stream->format == STREAM_GZIP && stream->decoder)
+    {
+        gzclose((gzFile)stream->decoder);
+    }
+#endif
+#ifdef ML_HAVE_ZSTD
+    if (stream->format == STREAM_ZSTD && stream->decoder)
+    {
+        ZstdDecoder *zd = (ZstdDecoder *)stream->decoder;
+        ZSTD_freeDCtx(zd->dctx);
+        free(zd->in);
+        free(zd);
+    }
+#endif
+    stream->decoder = NULL;
+
+    if (stream->file)
+    {
+        fclose(stream->file);
+        stream->file = NULL;
+    }
+
+    free(stream->ring);
+    free(stream->block);
+    stream->ring = NULL;
+    stream->block = NULL;
+}
@@ -0,0 +1,429 @@
+/*
+ * file: encoder.c
+ * description: hash-based dictionary encoding of categorical (string) columns
+ * author: Ryan Wagner
+ * date: October 19, 2026
+ * notes: codes are handed out in order of first appearance, so a dictionary built
+ *        while loading the training file can be frozen and reused at inference
+ */
+
+#include "../header/encoder.h"
+
+/**
+ * @brief FNV-1a hash of a null terminated string
+ *
+ * @param label String to hash
+ *
+ * @return 32-bit hash value
+ */
+static uint32_t hashLabel(const char *label)
+{
+    uint32_t hash = 2166136261u;
+    for (const unsigned char *p = (const unsigned char *)label; *p != '\0'; ++p)
+    {
+        hash ^= *p;
+        hash *= 16777619u;
+    }
+
+    return hash;
+}
+
+/**
+ * @brief Find the hash table slot that holds a label, or the empty slot where it belongs
+ *
+ * @param dict CategoryDict object
+ * @param label Category string to find
+ *
+ * @return Slot index
+ */
+static int findSlot(const CategoryDict *dict, const char *label)
+{
+    int mask = dict->capacity - 1;
+    int slot = (int)(hashLabel(label) & (uint32_t)mask);
+
+    // Linear probing, the table is never more than half full
+    while (dict->slots[slot] >= 0 && strcmp(dict->labels[dict->slots[slot]], label) != 0)
+    {
+        slot = (slot + 1) & mask;
+    }
+
+    return slot;
+}
+
+/**
+ * @brief Initialize an empty CategoryDict object
+ *
+ * @param dict Pointer to CategoryDict object
+ * @param capacity Starting number of hash slots, rounded up to a power of two
+ *
+ * @return 0 if successful, -1 if failure
+ */
+int initCategoryDict(CategoryDict *dict, int capacity)
+{
+    if (!dict)
+    {
+        LOG_ERROR("Input dictionary for initialization was NULL.\n");
+        return -1;
+    }
+
+    int slots = DEFAULT_DICT_CAPACITY;
+    while (slots < capacity)
+    {
+        slots *= 2;
+    }
+
+    dict->slots = malloc(slots * sizeof(int));
+    dict->labels = calloc(slots / 2, sizeof(char *));
+    if (!dict->slots || !dict->labels)
+    {
+        LOG_ERROR("Failed to allocate category dictionary.\n");
+        free(dict->slots);
+        free(dict->labels);
+        dict->slots = NULL;
+        dict->labels = NULL;
+        return -1;
+    }
+
+    for (int i = 0; i < slots; ++i)
+    {
+        dict->slots[i] = -1;
+    }
+    dict->size = 0;
+    dict->capacity = slots;
+
+    return 0;
+}
+
+/**
+ * @brief Double the number of hash slots in a CategoryDict and rehash every label
+ *
+ * @param dict Pointer to CategoryDict object
+ *
+ * @return 0 if successful, -1 if failure
+ */
+static int growCategoryDict(CategoryDict *dict)
+{
+    int new_capacity = dict->capacity * 2;
+    int *new_slots = malloc(new_capacity * sizeof(int));
+    char **new_labels = realloc(dict->labels, (new_capacity / 2) * sizeof(char *));
+    if (!new_slots || !new_labels)
+    {
+        LOG_ERROR("Failed to grow category dictionary to %d slots.\n", new_capacity);
+        free(new_slots);
+        if (new_labels)
+        {
+            dict->labels = new_labels;
+        }
+        return -1;
+    }
+
+    for (int i = 0; i < new_capacity; ++i)
+    {
+        new_slots[i] = -1;
+    }
+
+    free(dict->slots);
+    dict->slots = new_slots;
+    dict->labels = new_labels;
+    dict->capacity = new_capacity;
+
+    for (int code = 0; code < dict->size; ++code)
+    {
+        dict->slots[findSlot(dict, dict->labels[code])] = code;
+    }
+
+    return 0;
+}
+
+/**
+ * @brief Look up the integer code of a category
+ *
+ * @param dict CategoryDict object
+ * @param label Category string
+ *
+ * @return Code of the category, -1 if the category is not in the dictionary
+ */
+int lookupCategory(const CategoryDict *dict, const char *label)
+{
+    if (!dict || !dict->slots || !label)
+    {
+        return -1;
+    }
+
+    return dict->slots[findSlot(dict, label)];
+}
+
+/**
+ * @brief Get the integer code of a category, adding it to the dictionary if it is new
+ *
+ * @param dict Pointer to CategoryDict object
+ * @param label Category string
+ *
+ * @return Code of the category, -1 if failure
+ */
+int addCategory(CategoryDict *dict, const char *label)
+{
+    if (!dict || !dict->slots || !label)
+    {
+        LOG_ERROR("Input variables to add a category were not correct.\n");
+        return -1;
+    }
+
+    int slot = findSlot(dict, label);
+    if (dict->slots[slot] >= 0)
+    {
+        return dict->slots[slot];
+    }
+
+    // Keep the load factor at or below one half
+    if ((dict->size + 1) * 2 > dict->capacity)
+    {
+        if (growCategoryDict(dict) < 0)
+        {
+            return -1;
+        }
+        slot = findSlot(dict, label);
+    }
+
+    char *copy = strdup(label);
+    if (!copy)
+    {
+        LOG_ERROR("Failed to copy category label.\n");
+        return -1;
+    }
+
+    dict->labels[dict->size] = copy;
+    dict->slots[slot] = dict->size;
+
+    return dict->size++;
+}
+
+/**
+ * @brief Free a CategoryDict object and every label it owns
+ *
+ * @param dict CategoryDict to free
+ *
+ * @return None
+ */
+void freeCategoryDict(CategoryDict *dict)
+{
+    if (!dict)
+    {
+        return;
+    }
+
+    if (dict->labels)
+    {
+        for (int i = 0; i < dict->size; ++i)
+        {
+            free(dict->labels[i]);
+        }
+        free(dict->labels);
+        dict->labels = NULL;
+    }
+
+    free(dict->slots);
+    dict->slots = NULL;
+    dict->size = 0;
+    dict->capacity = 0;
+}
+
+/**
+ * @brief Make an unfitted CategoricalEncoder that writes integer codes
+ *
+ * @return CategoricalEncoder object
+ */
+CategoricalEncoder makeDefaultEncoder(void)
+{
+    CategoricalEncoder encoder;
+    encoder.cols = 0;
+    encoder.types = NULL;
+    encoder.dicts = NULL;
+    encoder.encoding = ENCODE_LABEL;
+    encoder.frozen = false;
+
+    return encoder;
+}
+
+/**
+ * @brief Allocate the per-column types and dictionaries of a CategoricalEncoder
+ *
+ * @param encoder Pointer to CategoricalEncoder object
+ * @param cols Number of raw columns
+ * @param types Type of every raw column
+ *
+ * @return 0 if successful, -1 if failure
+ */
+int initEncoder(CategoricalEncoder *encoder, int cols, const ColumnType *types)
+{
+    if (!encoder || cols <= 0 || !types)
+    {
+        LOG_ERROR("Input variables to initialize the encoder were not correct.\n");
+        return -1;
+    }
+
+    encoder->types = malloc(cols * sizeof(ColumnType));
+    encoder->dicts = calloc(cols, sizeof(CategoryDict));
+    if (!encoder->types || !encoder->dicts)
+    {
+        LOG_ERROR("Failed to allocate encoder columns.\n");
+        free(encoder->types);
+        free(encoder->dicts);
+        encoder->types = NULL;
+        encoder->dicts = NULL;
+        return -1;
+    }
+    encoder->cols = cols;
+
+    for (int c = 0; c < cols; ++c)
+    {
+        encoder->types[c] = types[c];
+        if (types[c] == COL_CATEGORICAL && initCategoryDict(&encoder->dicts[c], DEFAULT_DICT_CAPACITY) < 0)
+        {
+            LOG_ERROR("Failed to initialize dictionary of column %d.\n", c);
+            freeEncoder(encoder);
+            return -1;
+        }
+    }
+
+    return 0;
+}
+
+/**
+ * @brief Encode one categorical value of a column
+ *
+ * @param encoder Pointer to CategoricalEncoder object
+ * @param col Raw column index
+ * @param label Category string
+ * @param code Output code, -1 if the encoder is frozen and the category is unseen
+ *
+ * @return 0 if successful, -1 if failure
+ */
+int encodeCategory(CategoricalEncoder *encoder, int col, const char *label, int *code)
+{
+    if (!encoder || col < 0 || col >= encoder->cols || encoder->types[col] != COL_CATEGORICAL)
+    {
+        LOG_ERROR("Column %d is not a categorical column of the encoder.\n", col);
+        return -1;
+    }
+
+    if (encoder->frozen)
+    {
+        *code = lookupCategory(&encoder->dicts[col], label);
+        return 0;
+    }
+
+    *code = addCategory(&encoder->dicts[col], label);
+
+    return (*code < 0) ? -1 : 0;
+}
+
+/**
+ * @brief Number of output columns the encoder produces
+ *
+ * @param encoder CategoricalEncoder object
+ *
+ * @return Number of encoded columns
+ */
+int getEncodedColumnCount(const CategoricalEncoder *encoder)
+{
+    if (encoder->encoding == ENCODE_LABEL)
+    {
+        return encoder->cols;
+    }
+
+    int cols = 0;
+    for (int c = 0; c < encoder->cols; ++c)
+    {
+        cols += (encoder->types[c] == COL_CATEGORICAL) ? encoder->dicts[c].size : 1;
+    }
+
+    return cols;
+}
+
+/**
+ * @brief Expand a Matrix of integer codes into one-hot columns
+ *
+ * @param codes Matrix of raw columns, categorical columns hold integer codes
+ * @param encoder CategoricalEncoder that produced the codes
+ * @param out Matrix to receive the expanded columns, (re)allocated here
+ *
+ * @return 0 if successful, -1 if failure
+ */
+int expandOneHot(Matrix codes, const CategoricalEncoder *encoder, Matrix *out)
+{
+    if (!codes.data || !encoder || !out || codes.cols != encoder->cols)
+    {
+        LOG_ERROR("Input variables to one-hot expansion were not correct.\n");
+        return -1;
+    }
+
+    int out_cols = 0;
+    for (int c = 0; c < encoder->cols; ++c)
+    {
+        out_cols += (encoder->types[c] == COL_CATEGORICAL) ? encoder->dicts[c].size : 1;
+    }
+
+    if (makeMatrixZeros(out, codes.rows, out_cols) < 0)
+    {
+        LOG_ERROR("Failed to allocate one-hot expanded Matrix.\n");
+        return -1;
+    }
+
+    for (int r = 0; r < codes.rows; ++r)
+    {
+        const double *src = &codes.data[r * codes.cols];
+        double *dst = &out->data[r * out_cols];
+        int offset = 0;
+
+        for (int c = 0; c < codes.cols; ++c)
+        {
+            if (encoder->types[c] == COL_CATEGORICAL)
+            {
+                // Unseen categories (code -1) leave every indicator at zero
+                int code = (int)src[c];
+                if (code >= 0 && code < encoder->dicts[c].size)
+                {
+                    dst[offset + code] = 1.0;
+                }
+                offset += encoder->dicts[c].size;
+            }
+            else
+            {
+                dst[offset] = src[c];
+                ++offset;
+            }
+        }
+    }
+
+    return 0;
+}
+
+/**
+ * @brief Free a CategoricalEncoder object and all of its dictionaries
+ *
+ * @param encoder CategoricalEncoder to free
+ *
+ * @return None
+ */
+void freeEncoder(CategoricalEncoder *encoder)
+{
+    if (!encoder)
+    {
+        return;
+    }
+
+    if (encoder->dicts)
+    {
+        for (int c = 0; c < encoder->cols; ++c)
+        {
+            freeCategoryDict(&encoder->dicts[c]);
+        }
+        free(encoder->dicts);
+        encoder->dicts = NULL;
+    }
+
+    free(encoder->types);
+    encoder->types = NULL;
+    encoder->cols = 0;
+}
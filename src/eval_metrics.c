@@ -126,7 +126,7 @@ int computeConfusionMatrix(Matrix y_true, Matrix y_pred, int *TP, int *FP, int *
     {
         for (int c = 0; c < y_pred.cols; ++c)
         {
-            int idx = r + y_true.cols + c;
+            int idx = r * y_true.cols + c;
             if ((int)y_true.data[idx] == 0 && (int)y_pred.data[idx] == 0)
             {
                 ++*TN;
@@ -199,6 +199,7 @@ int computePrecision(int TP, int FP, double *precision)
     {
         LOG_WARN("Denominator value is too close to 0; would result in error. Setting Precision to 0.\n");
         *precision = 0.0;
+        return 0;
     }
 
     *precision = (double)TP / (TP + FP);
@@ -276,7 +277,7 @@ int computeMSE(Matrix y_true, Matrix y_pred, double *mse)
     {
         for (int c = 0; c < y_pred.cols; ++c)
         {
-            int idx = r + y_pred.cols + c;
+            int idx = r * y_pred.cols + c;
             sum_square += (y_true.data[idx] - y_pred.data[idx]) * (y_true.data[idx] - y_pred.data[idx]);
         }
     }
@@ -501,6 +502,119 @@ int calculateAllMetrics(EvalMetrics *eval_metrics, RegressionType model_type, Ma
     return 0;
 }
 
+/**
+ * @brief Metrics of predictions against their labels. Linear models get MSE, RMSE, MAE and R2
+ *        score, logistic models the confusion matrix, accuracy, precision, recall and F1 at a
+ *        0.5 threshold, and softmax models the accuracy of the most likely class.
+ *
+ * @param model_type RegressionType enum of the model type
+ * @param y Labels, class indices for softmax
+ * @param predicted Predictions with one row per label, thresholded in place for logistic models
+ * @param eval_metrics EvalMetrics object to fill, its y_lables stays NULL
+ *
+ * @return 0 if successful, -1 if failure
+ */
+int evaluatePredictions(RegressionType model_type, Matrix y, Matrix *predicted, EvalMetrics *eval_metrics)
+{
+    if (!predicted || !predicted->data || !eval_metrics || !y.data || predicted->rows != y.rows || y.cols != 1)
+    {
+        LOG_ERROR("Input variables to evaluate predictions were not correct.\n");
+        return -1;
+    }
+    memset(eval_metrics, 0, sizeof(EvalMetrics));
+
+    int status = 0;
+    if (model_type == LINEAR_REGRESSION)
+    {
+        if (computeMSE(y, *predicted, &eval_metrics->mse) < 0 || computeRMSE(y, *predicted, &eval_metrics->rmse) < 0 ||
+            computeMAE(y, *predicted, &eval_metrics->mae) < 0 || computeR2Score(y, *predicted, &eval_metrics->r2score) < 0)
+        {
+            status = -1;
+        }
+    }
+    else if (model_type == LOGISTIC_REGRESSION)
+    {
+        eval_metrics->threshold = 0.5;
+        if (applyLabelThreshold(*predicted, predicted, eval_metrics->threshold) < 0 ||
+            computeConfusionMatrix(y, *predicted, &eval_metrics->TP, &eval_metrics->FP, &eval_metrics->TN, &eval_metrics->FN) < 0 ||
+            computeAccuracy(eval_metrics->TP, eval_metrics->FP, eval_metrics->TN, eval_metrics->FN, &eval_metrics->accuracy) < 0 ||
+            computePrecision(eval_metrics->TP, eval_metrics->FP, &eval_metrics->precision) < 0 ||
+            computeRecall(eval_metrics->TP, eval_metrics->FN, &eval_metrics->recall) < 0 ||
+            computeF1(eval_metrics->precision, eval_metrics->recall, &eval_metrics->f1) < 0)
+        {
+            status = -1;
+        }
+    }
+    else
+    {
+        int correct = 0;
+        for (int r = 0; r < predicted->rows; ++r)
+        {
+            const double *row = &predicted->data[r * predicted->cols];
+            int best = 0;
+            for (int c = 1; c < predicted->cols; ++c)
+            {
+                best = (row[c] > row[best]) ? c : best;
+            }
+            correct += best == (int)y.data[r];
+        }
+        eval_metrics->accuracy = (double)correct / predicted->rows;
+    }
+
+    if (status < 0)
+    {
+        LOG_ERROR("Computing the metrics of the evaluated split was unsuccessful.\n");
+    }
+    return status;
+}
+
+/**
+ * @brief Score a trained model on a labelled split without printing, with the metrics of
+ *        evaluatePredictions
+ *
+ * @param model Trained Model object
+ * @param X Features of the split
+ * @param y Labels of the split, class indices for softmax
+ * @param eval_metrics EvalMetrics object to fill, its y_lables stays NULL
+ *
+ * @return 0 if successful, -1 if failure
+ */
+int evaluateModel(Model *model, Matrix X, Matrix y, EvalMetrics *eval_metrics)
+{
+    if (!model || !eval_metrics || !X.data || !y.data || X.rows != y.rows || y.cols != 1)
+    {
+        LOG_ERROR("Input variables to evaluate a model were not correct.\n");
+        return -1;
+    }
+
+    Matrix predicted = {0};
+    if (makeMatrixZeros(&predicted, X.rows, model->classes) < 0 ||
+        comptueLabels(X, *model->weights, *model->bias, &predicted, model->func) < 0)
+    {
+        LOG_ERROR("Predicting the split to evaluate was unsuccessful.\n");
+        freeMatrix(&predicted);
+        return -1;
+    }
+
+    int status = evaluatePredictions(model->type, y, &predicted, eval_metrics);
+    freeMatrix(&predicted);
+    return status;
+}
+
+/**
+ * @brief Single score to rank models by, higher is better. R2 score for linear models,
+ *        accuracy for logistic and softmax models.
+ *
+ * @param eval_metrics EvalMetrics object filled by evaluateModel
+ * @param model_type RegressionType enum of the model type
+ *
+ * @return Ranking score
+ */
+double metricScore(EvalMetrics eval_metrics, RegressionType model_type)
+{
+    return (model_type == LINEAR_REGRESSION) ? eval_metrics.r2score : eval_metrics.accuracy;
+}
+
 /**
  * @brief Function to print all metrics for a model
  *
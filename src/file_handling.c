@@ -6,8 +6,15 @@
  * notes: only focuses on CSV and TXT file right now
  *        CSV files need to adhere to typical CSV filetype formatting
  *        TXT files need to be comma separated as well, in
+ *        Files may be gzip or zstd compressed, they are decompressed while parsing
+ *        LIBSVM/SVMlight sparse text files load into a CSR SparseMatrix or a dense Matrix
  */
 
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
 #include "../header/file_handling.h"
 
 /**
@@ -23,8 +30,8 @@
 int getColandRowNum(const char *filename, bool has_header, int *rows, int *cols)
 {
     // Open file and check for success
-    FILE *file = fopen(filename, "r");
-    if (file == NULL)
+    DataStream stream;
+    if (openDataStream(&stream, filename) < 0)
     {
         LOG_ERROR("Error opening CSV file");
         return -1;
@@ -36,9 +43,10 @@ int getColandRowNum(const char *filename, bool has_header, int *rows, int *cols)
     }
 
     // Buffer to hold line
-    char line[2048];
+    char *line = NULL;
+    size_t line_cap = 0;
 
-    while (fgets(line, sizeof(line), file) != NULL)
+    while (readLineDataStream(&stream, &line, &line_cap) >= 0)
     {
         if (*rows == 0)
         {
@@ -55,7 +63,14 @@ int getColandRowNum(const char *filename, bool has_header, int *rows, int *cols)
         ++*rows;
     }
 
-    fclose(file);
+    bool failed = dataStreamFailed(&stream);
+    free(line);
+    closeDataStream(&stream);
+    if (failed)
+    {
+        LOG_ERROR("CSV file %s is truncated or corrupt.\n", filename);
+        return -1;
+    }
 
     return 0;
 }
@@ -73,35 +88,38 @@ int loadCSVtoMatrix(const char *filename, bool has_header, Matrix *m)
 {
     int rows = 0;
     int cols = 0;
-    getColandRowNum(filename, has_header, &rows, &cols);
+    if (getColandRowNum(filename, has_header, &rows, &cols) < 0)
+    {
+        return -1;
+    }
 
     m->rows = rows;
     m->cols = cols;
     m->data = calloc(rows * cols, sizeof(double));
 
     // Open file and check for success
-    FILE *file = fopen(filename, "r");
-    if (file == NULL)
+    DataStream stream;
+    if (openDataStream(&stream, filename) < 0)
     {
         LOG_ERROR("Error opening CSV file");
         return -1;
     }
 
     // Buffer to hold line
-    char line[4096];
-    int counter = 0;
+    char *line = NULL;
+    size_t line_cap = 0;
 
     if (has_header == 1)
     {
-        fgets(line, sizeof(line), file);
+        readLineDataStream(&stream, &line, &line_cap);
     }
 
     rows = 0;
     cols = 0;
-    while (fgets(line, sizeof(line), file) != NULL)
+    while (rows < m->rows && readLineDataStream(&stream, &line, &line_cap) >= 0)
     {
         char *token = strtok(line, ",");
-        while (token != NULL)
+        while (token != NULL && cols < m->cols)
         {
             // Process each token
             char *endptr;
@@ -114,13 +132,22 @@ int loadCSVtoMatrix(const char *filename, bool has_header, Matrix *m)
         cols = 0;
     }
 
-    fclose(file);
+    bool failed = dataStreamFailed(&stream) || rows < m->rows;
+    free(line);
+    closeDataStream(&stream);
+    if (failed)
+    {
+        LOG_ERROR("CSV file %s is truncated or corrupt.\n", filename);
+        freeMatrix(m);
+        return -1;
+    }
 
     return 1;
 }
 
 /**
- * @brief Function to normalize the data in a Matrix object column-wise
+ * @brief Function to z-score normalize the data in a Matrix object column-wise. The statistics
+ *        are discarded, use a Scaler to keep them for test or inference data.
  *
  * @param m Matrix object
  *
@@ -134,62 +161,1106 @@ int normalizeMatrix(Matrix *m)
         return -1;
     }
 
-    double sum = 0.0;
-    double mean = 0.0;
-    double sum_squares = 0.0;
-    double std_dev = 0.0;
-    double element = 0.0;
-    int loop_idx = 0;
+    Scaler scaler = makeDefaultScaler(SCALE_STANDARD);
+    int status = fitTransformScaler(&scaler, m);
+    freeScaler(&scaler);
+
+    return status;
+}
+
+/**
+ * @brief Split a CSV line in place into fields, keeping empty fields and trimming
+ *        whitespace, line endings, and surrounding double quotes
+ *
+ * @param line Line to split, modified in place
+ * @param fields Array to receive pointers to each field
+ * @param max_fields Length of the fields array
+ *
+ * @return Number of fields found
+ */
+static int splitCSVLine(char *line, char **fields, int max_fields)
+{
+    int count = 0;
+    char *cursor = line;
+
+    while (count < max_fields)
+    {
+        char *end = strchr(cursor, ',');
+        if (end)
+        {
+            *end = '\0';
+        }
+
+        // Trim leading and trailing whitespace and quotes
+        while (*cursor == ' ' || *cursor == '\t' || *cursor == '"')
+        {
+            ++cursor;
+        }
+        size_t len = strlen(cursor);
+        while (len > 0 && (cursor[len - 1] == '\n' || cursor[len - 1] == '\r' || cursor[len - 1] == ' ' || cursor[len - 1] == '\t' || cursor[len - 1] == '"'))
+        {
+            cursor[--len] = '\0';
+        }
+
+        fields[count++] = cursor;
+
+        if (!end)
+        {
+            break;
+        }
+        cursor = end + 1;
+    }
+
+    return count;
+}
+
+/**
+ * @brief Count the fields of a CSV line without modifying it
+ *
+ * @param line Line to count
+ *
+ * @return Number of fields
+ */
+static int countCSVFields(const char *line)
+{
+    int count = 1;
+    for (const char *p = line; *p != '\0'; ++p)
+    {
+        if (*p == ',')
+        {
+            ++count;
+        }
+    }
+
+    return count;
+}
+
+/**
+ * @brief Parse a field as a number, the whole field must be consumed
+ *
+ * @param field Field string, already trimmed
+ * @param value Parsed value
+ *
+ * @return true if the field is numeric, false otherwise
+ */
+static bool parseNumericField(const char *field, double *value)
+{
+    char *endptr;
+    *value = strtod(field, &endptr);
+
+    return endptr != field && *endptr == '\0';
+}
+
+/**
+ * @brief Single pass over a CSV file that counts rows and columns and infers whether each
+ *        column is numeric or categorical. A column is categorical if any non-empty field
+ *        in it cannot be parsed as a number.
+ *
+ * @param filename relative or abolsute path to the file
+ * @param has_header if the file has a header or not
+ * @param rows number of data rows in the file
+ * @param cols number of columns in the file
+ * @param types Output array of column types, allocated here, NULL to skip inference
+ *
+ * @return 0 if successful, -1 if failure
+ */
+static int scanCSV(const char *filename, bool has_header, int *rows, int *cols, ColumnType **types)
+{
+    DataStream stream;
+    if (openDataStream(&stream, filename) < 0)
+    {
+        LOG_ERROR("Error opening CSV file %s\n", filename);
+        return -1;
+    }
+
+    char *line = NULL;
+    size_t line_cap = 0;
+    char **fields = NULL;
+    *rows = 0;
+    *cols = 0;
 
-    int idx = 0;
-    // Calculate mean
-    for (int c = 0; c < m->cols; ++c)
+    if (has_header && readLineDataStream(&stream, &line, &line_cap) < 0)
     {
+        LOG_ERROR("CSV file %s is empty.\n", filename);
+        closeDataStream(&stream);
+        return -1;
+    }
 
-        for (int r = 0; r < m->rows; ++r)
+    while (readLineDataStream(&stream, &line, &line_cap) >= 0)
+    {
+        if (line[0] == '\n' || line[0] == '\r')
         {
-            idx = r * m->cols + c;
-            element = m->data[idx];
+            continue;
+        }
 
-            if (loop_idx == 0)
+        if (*cols == 0)
+        {
+            *cols = countCSVFields(line);
+            fields = malloc(*cols * sizeof(char *));
+            if (types)
+            {
+                *types = malloc(*cols * sizeof(ColumnType));
+            }
+            if (!fields || (types && !*types))
+            {
+                LOG_ERROR("Failed to allocate CSV column buffers.\n");
+                free(fields);
+                free(line);
+                closeDataStream(&stream);
+                return -1;
+            }
+            for (int c = 0; types && c < *cols; ++c)
             {
-                // Update Mean values
-                sum += element;
+                (*types)[c] = COL_NUMERIC;
             }
-            else if (loop_idx == 1)
+        }
+
+        if (types)
+        {
+            int count = splitCSVLine(line, fields, *cols);
+            for (int c = 0; c < count; ++c)
             {
-                // Calculate standard deviation
-                sum_squares += ((element - mean) * (element - mean));
+                double value;
+                if ((*types)[c] == COL_NUMERIC && fields[c][0] != '\0' && !parseNumericField(fields[c], &value))
+                {
+                    (*types)[c] = COL_CATEGORICAL;
+                }
+            }
+        }
+
+        ++*rows;
+    }
+
+    bool failed = dataStreamFailed(&stream);
+    free(fields);
+    free(line);
+    closeDataStream(&stream);
+
+    if (failed)
+    {
+        LOG_ERROR("CSV file %s is truncated or corrupt.\n", filename);
+        if (types)
+        {
+            free(*types);
+            *types = NULL;
+        }
+        return -1;
+    }
+    if (*rows == 0 || *cols == 0)
+    {
+        LOG_ERROR("CSV file %s has no data rows.\n", filename);
+        if (types)
+        {
+            free(*types);
+            *types = NULL;
+        }
+        return -1;
+    }
+
+    return 0;
+}
+
+/**
+ * @brief Function to put the data in a CSV file into a Matrix object, dictionary-encoding
+ *        categorical columns while parsing. If the encoder has no columns yet, the column
+ *        types are inferred and the dictionaries are built from this file. Otherwise the
+ *        encoder's types and dictionaries are reused, so the same encoding can be applied
+ *        to test or inference data (set encoder->frozen to stop new categories being added).
+ *
+ * @param filename relative or abolsute path to the file
+ * @param has_header if the file has a header or not
+ * @param m Matrix object, allocated here
+ * @param encoder Pointer to CategoricalEncoder object
+ *
+ * @return 0 if successful, -1 if failure
+ */
+int loadCSVtoMatrixEncoded(const char *filename, bool has_header, Matrix *m, CategoricalEncoder *encoder)
+{
+    if (!filename || !m || !encoder)
+    {
+        LOG_ERROR("Input variables to load an encoded CSV file were not correct.\n");
+        return -1;
+    }
+
+    int rows = 0;
+    int cols = 0;
+    ColumnType *types = NULL;
+    bool fitted = encoder->types != NULL;
+
+    if (scanCSV(filename, has_header, &rows, &cols, fitted ? NULL : &types) < 0)
+    {
+        LOG_ERROR("Scanning CSV file %s was unsuccessful.\n", filename);
+        return -1;
+    }
+
+    if (fitted && encoder->cols != cols)
+    {
+        LOG_ERROR("CSV file has %d columns but the encoder was fitted on %d.\n", cols, encoder->cols);
+        return -1;
+    }
+    if (!fitted)
+    {
+        int status = initEncoder(encoder, cols, types);
+        free(types);
+        if (status < 0)
+        {
+            LOG_ERROR("Initializing the categorical encoder was unsuccessful.\n");
+            return -1;
+        }
+    }
+
+    // Parse into one column per raw column, categorical columns hold integer codes
+    Matrix codes = {0};
+    if (makeMatrixZeros(&codes, rows, cols) < 0)
+    {
+        LOG_ERROR("Failed to allocate Matrix for CSV file.\n");
+        return -1;
+    }
+
+    DataStream stream;
+    if (openDataStream(&stream, filename) < 0)
+    {
+        LOG_ERROR("Error opening CSV file %s\n", filename);
+        freeMatrix(&codes);
+        return -1;
+    }
+
+    char *line = NULL;
+    size_t line_cap = 0;
+    char **fields = malloc(cols * sizeof(char *));
+    if (!fields)
+    {
+        LOG_ERROR("Failed to allocate CSV field buffer.\n");
+        closeDataStream(&stream);
+        freeMatrix(&codes);
+        return -1;
+    }
+
+    if (has_header && readLineDataStream(&stream, &line, &line_cap) < 0)
+    {
+        LOG_ERROR("CSV file %s is empty.\n", filename);
+    }
+
+    int r = 0;
+    while (r < rows && readLineDataStream(&stream, &line, &line_cap) >= 0)
+    {
+        if (line[0] == '\n' || line[0] == '\r')
+        {
+            continue;
+        }
+
+        double *row = &codes.data[r * cols];
+        int count = splitCSVLine(line, fields, cols);
+        for (int c = 0; c < count; ++c)
+        {
+            if (encoder->types[c] == COL_CATEGORICAL)
+            {
+                int code = -1;
+                if (encodeCategory(encoder, c, fields[c], &code) < 0)
+                {
+                    LOG_ERROR("Encoding field '%s' of row %d was unsuccessful.\n", fields[c], r);
+                    free(fields);
+                    free(line);
+                    closeDataStream(&stream);
+                    freeMatrix(&codes);
+                    return -1;
+                }
+                row[c] = (double)code;
             }
             else
             {
-                // Apply normalization
-                m->data[idx] = (m->data[idx] - mean) / std_dev;
+                // Non-numeric fields in a numeric column of a reused encoder become 0
+                double value = 0.0;
+                parseNumericField(fields[c], &value);
+                row[c] = value;
+            }
+        }
+        ++r;
+    }
+
+    bool failed = dataStreamFailed(&stream) || r < rows;
+    free(fields);
+    free(line);
+    closeDataStream(&stream);
+    if (failed)
+    {
+        LOG_ERROR("CSV file %s is truncated or corrupt.\n", filename);
+        freeMatrix(&codes);
+        return -1;
+    }
+
+    if (encoder->encoding == ENCODE_LABEL)
+    {
+        *m = codes;
+        return 0;
+    }
+
+    int status = expandOneHot(codes, encoder, m);
+    freeMatrix(&codes);
+    if (status < 0)
+    {
+        LOG_ERROR("One-hot expansion of CSV file %s was unsuccessful.\n", filename);
+        return -1;
+    }
+
+    return 0;
+}
+
+// Called with the parsed values of every data row of a CSV file
+typedef int (*CSVRowHandler)(void *ctx, int row, const double *values);
+
+typedef struct
+{
+    ColumnProfile *profiles; // Running value profile of every column
+    TypedTable *table;       // Output table, NULL while profiling
+} TypedCSVContext;
+
+/**
+ * @brief Stream the data rows of a CSV file, turning every field into a number. Categorical
+ *        fields become their encoder code, missing or unparsable numeric fields become 0.
+ *
+ * @param filename relative or abolsute path to the file
+ * @param has_header if the file has a header or not
+ * @param rows Number of data rows to read
+ * @param cols Number of columns
+ * @param encoder CategoricalEncoder holding the column types and dictionaries
+ * @param handler Function called once per data row
+ * @param ctx Passed through to the handler
+ *
+ * @return 0 if successful, -1 if failure
+ */
+static int parseCSVRows(const char *filename, bool has_header, int rows, int cols, CategoricalEncoder *encoder,
+                        CSVRowHandler handler, void *ctx)
+{
+    DataStream stream;
+    if (openDataStream(&stream, filename) < 0)
+    {
+        LOG_ERROR("Error opening CSV file %s\n", filename);
+        return -1;
+    }
+
+    char *line = NULL;
+    size_t line_cap = 0;
+    char **fields = malloc(cols * sizeof(char *));
+    double *values = malloc(cols * sizeof(double));
+    if (!fields || !values)
+    {
+        LOG_ERROR("Failed to allocate CSV field buffers.\n");
+        free(fields);
+        free(values);
+        closeDataStream(&stream);
+        return -1;
+    }
+
+    if (has_header)
+    {
+        readLineDataStream(&stream, &line, &line_cap);
+    }
+
+    int status = 0;
+    int r = 0;
+    while (status == 0 && r < rows && readLineDataStream(&stream, &line, &line_cap) >= 0)
+    {
+        if (line[0] == '\n' || line[0] == '\r')
+        {
+            continue;
+        }
+
+        int count = splitCSVLine(line, fields, cols);
+        for (int c = 0; c < cols; ++c)
+        {
+            values[c] = 0.0;
+            if (c >= count)
+            {
+                continue;
+            }
+            if (encoder->types[c] == COL_CATEGORICAL)
+            {
+                int code = -1;
+                if (encodeCategory(encoder, c, fields[c], &code) < 0)
+                {
+                    LOG_ERROR("Encoding field '%s' of row %d was unsuccessful.\n", fields[c], r);
+                    status = -1;
+                    break;
+                }
+                values[c] = (double)code;
+            }
+            else
+            {
+                parseNumericField(fields[c], &values[c]);
+            }
+        }
+
+        if (status == 0)
+        {
+            status = handler(ctx, r, values);
+        }
+        ++r;
+    }
+    if (status == 0 && (dataStreamFailed(&stream) || r < rows))
+    {
+        LOG_ERROR("CSV file %s is truncated or corrupt.\n", filename);
+        status = -1;
+    }
+
+    free(fields);
+    free(values);
+    free(line);
+    closeDataStream(&stream);
+
+    return status;
+}
+
+/**
+ * @brief Row handler that widens the value profile of every column
+ *
+ * @param ctx TypedCSVContext object
+ * @param row Row index
+ * @param values Parsed values of the row
+ *
+ * @return 0
+ */
+static int profileCSVRow(void *ctx, int row, const double *values)
+{
+    (void)row;
+    TypedCSVContext *context = (TypedCSVContext *)ctx;
+    for (int c = 0; c < context->table->cols; ++c)
+    {
+        updateColumnProfile(&context->profiles[c], values[c]);
+    }
+
+    return 0;
+}
+
+/**
+ * @brief Row handler that stores a row into the typed table
+ *
+ * @param ctx TypedCSVContext object
+ * @param row Row index
+ * @param values Parsed values of the row
+ *
+ * @return 0
+ */
+static int fillTypedCSVRow(void *ctx, int row, const double *values)
+{
+    TypedCSVContext *context = (TypedCSVContext *)ctx;
+    for (int c = 0; c < context->table->cols; ++c)
+    {
+        setTypedValue(context->table, row, c, values[c]);
+    }
+
+    return 0;
+}
+
+/**
+ * @brief Function to put the data in a CSV file into a compact TypedTable. Every column is
+ *        stored as uint8, int16, int32, float32, or float64, either from the given schema or
+ *        inferred as the narrowest type that holds the whole column exactly. Categorical columns
+ *        are label encoded with the encoder like loadCSVtoMatrixEncoded. The file is never held
+ *        as doubles, so flag-heavy tables take a fraction of the memory of a Matrix.
+ *
+ * @param filename relative or abolsute path to the file
+ * @param has_header if the file has a header or not
+ * @param schema Storage type of every column, NULL to infer
+ * @param encoder Pointer to CategoricalEncoder object, must use ENCODE_LABEL
+ * @param t Pointer to TypedTable object, allocated here
+ *
+ * @return 0 if successful, -1 if failure
+ */
+int loadCSVtoTypedTable(const char *filename, bool has_header, const StorageType *schema, CategoricalEncoder *encoder, TypedTable *t)
+{
+    if (!filename || !t || !encoder || encoder->encoding != ENCODE_LABEL)
+    {
+        LOG_ERROR("Input variables to load a typed CSV file were not correct.\n");
+        return -1;
+    }
+
+    int rows = 0;
+    int cols = 0;
+    ColumnType *types = NULL;
+    bool fitted = encoder->types != NULL;
+
+    if (scanCSV(filename, has_header, &rows, &cols, fitted ? NULL : &types) < 0)
+    {
+        LOG_ERROR("Scanning CSV file %s was unsuccessful.\n", filename);
+        return -1;
+    }
+
+    if (fitted && encoder->cols != cols)
+    {
+        LOG_ERROR("CSV file has %d columns but the encoder was fitted on %d.\n", cols, encoder->cols);
+        return -1;
+    }
+    if (!fitted)
+    {
+        int status = initEncoder(encoder, cols, types);
+        free(types);
+        if (status < 0)
+        {
+            LOG_ERROR("Initializing the categorical encoder was unsuccessful.\n");
+            return -1;
+        }
+    }
+
+    // Profile every column to pick its storage type, this pass also builds the dictionaries
+    TypedTable shape = makeTypedTableEmpty();
+    shape.cols = cols;
+    TypedCSVContext context = {NULL, &shape};
+    StorageType *inferred = NULL;
+    if (!schema)
+    {
+        context.profiles = malloc(cols * sizeof(ColumnProfile));
+        inferred = malloc(cols * sizeof(StorageType));
+        if (!context.profiles || !inferred)
+        {
+            LOG_ERROR("Failed to allocate CSV column profiles.\n");
+            free(context.profiles);
+            free(inferred);
+            return -1;
+        }
+        for (int c = 0; c < cols; ++c)
+        {
+            context.profiles[c] = makeColumnProfile();
+        }
+
+        if (parseCSVRows(filename, has_header, rows, cols, encoder, profileCSVRow, &context) < 0)
+        {
+            LOG_ERROR("Profiling CSV file %s was unsuccessful.\n", filename);
+            free(context.profiles);
+            free(inferred);
+            return -1;
+        }
+
+        for (int c = 0; c < cols; ++c)
+        {
+            inferred[c] = narrowestStorageType(context.profiles[c]);
+        }
+        free(context.profiles);
+        context.profiles = NULL;
+        schema = inferred;
+    }
+
+    freeTypedTable(t);
+    int status = makeTypedTable(t, rows, cols, schema);
+    free(inferred);
+    if (status < 0)
+    {
+        LOG_ERROR("Failed to allocate typed table for CSV file %s.\n", filename);
+        return -1;
+    }
+
+    context.table = t;
+    if (parseCSVRows(filename, has_header, rows, cols, encoder, fillTypedCSVRow, &context) < 0)
+    {
+        LOG_ERROR("Reading CSV file %s into a typed table was unsuccessful.\n", filename);
+        freeTypedTable(t);
+        return -1;
+    }
+
+    return 0;
+}
+
+typedef struct
+{
+    const char *data;     // Whole file, mapped or decompressed into memory
+    size_t *bounds;       // threads + 1 byte offsets, every chunk starts at the beginning of a line
+    int threads;          // Number of chunks
+    int *rows;            // Rows found in each chunk
+    int64_t *nnz;         // Stored values found in each chunk
+    int *min_idx;         // Smallest feature index of each chunk
+    int *max_idx;         // Largest feature index of each chunk
+    int *status;          // 0 or -1 per chunk
+    int base;             // Index of the first feature, 0 or 1
+    Matrix *labels;       // Output labels, filled by the second pass
+    SparseMatrix *sparse; // Output features, filled by the second pass
+} LIBSVMTask;
+
+/**
+ * @brief Parse a number from a token that is not null terminated
+ *
+ * @param start First character of the token
+ * @param end One past the last character of the token
+ * @param value Parsed value
+ *
+ * @return true if the whole token is a number
+ */
+static bool parseLIBSVMNumber(const char *start, const char *end, double *value)
+{
+    char buffer[64];
+    size_t len = (size_t)(end - start);
+    if (len == 0 || len >= sizeof(buffer))
+    {
+        return false;
+    }
+
+    memcpy(buffer, start, len);
+    buffer[len] = '\0';
+    char *endptr = NULL;
+    *value = strtod(buffer, &endptr);
+
+    return endptr == buffer + len;
+}
+
+/**
+ * @brief Parse one line of LIBSVM "label idx:val idx:val ... # comment" text. With NULL
+ *        outputs it only counts, so both passes agree on rows and values exactly.
+ *
+ * @param p First character of the line
+ * @param end End of the line, excluding the newline
+ * @param base Index of the first feature, subtracted from every index when writing
+ * @param label Parsed label, NULL to skip
+ * @param col_idx Output columns, NULL to only count
+ * @param values Output values, NULL to only count
+ * @param nnz Number of index:value pairs on the line
+ * @param min_idx Updated with the smallest index seen
+ * @param max_idx Updated with the largest index seen
+ *
+ * @return 1 for a data row, 0 for a blank or comment line, -1 if malformed
+ */
+static int parseLIBSVMLine(const char *p, const char *end, int base, double *label, int *col_idx, double *values,
+                           int64_t *nnz, int *min_idx, int *max_idx)
+{
+    *nnz = 0;
+    while (p < end && (*p == ' ' || *p == '\t' || *p == '\r'))
+    {
+        ++p;
+    }
+    if (p == end || *p == '#')
+    {
+        return 0;
+    }
+
+    // Label token
+    const char *token = p;
+    while (p < end && *p != ' ' && *p != '\t' && *p != '\r')
+    {
+        ++p;
+    }
+    double parsed = 0.0;
+    if (!parseLIBSVMNumber(token, p, &parsed))
+    {
+        return -1;
+    }
+    if (label)
+    {
+        *label = parsed;
+    }
+
+    while (p < end)
+    {
+        while (p < end && (*p == ' ' || *p == '\t' || *p == '\r'))
+        {
+            ++p;
+        }
+        if (p == end || *p == '#')
+        {
+            break;
+        }
+
+        token = p;
+        while (p < end && *p != ' ' && *p != '\t' && *p != '\r')
+        {
+            ++p;
+        }
+
+        // Ranking query ids are not features
+        if (p - token > 4 && strncmp(token, "qid:", 4) == 0)
+        {
+            continue;
+        }
+
+        const char *q = token;
+        long idx = 0;
+        while (q < p && *q >= '0' && *q <= '9')
+        {
+            idx = idx * 10 + (*q - '0');
+            if (idx > INT32_MAX)
+            {
+                return -1;
             }
+            ++q;
+        }
+        if (q == token || q == p || *q != ':' || !parseLIBSVMNumber(q + 1, p, &parsed))
+        {
+            return -1;
+        }
+
+        if (col_idx)
+        {
+            col_idx[*nnz] = (int)idx - base;
+            values[*nnz] = parsed;
         }
+        *min_idx = MIN(*min_idx, (int)idx);
+        *max_idx = MAX(*max_idx, (int)idx);
+        ++*nnz;
+    }
+
+    return 1;
+}
+
+/**
+ * @brief First pass over a block of chunks, counts rows, values, and the index range
+ *
+ * @param args LIBSVMTask object
+ * @param thread_id Thread index
+ * @param start First chunk
+ * @param end One past the last chunk
+ *
+ * @return None
+ */
+static void countLIBSVMTask(void *args, int thread_id, int start, int end)
+{
+    (void)thread_id;
+    LIBSVMTask *task = (LIBSVMTask *)args;
 
-        loop_idx++;
+    for (int t = start; t < end; ++t)
+    {
+        const char *p = task->data + task->bounds[t];
+        const char *chunk_end = task->data + task->bounds[t + 1];
+        task->rows[t] = 0;
+        task->nnz[t] = 0;
+        task->min_idx[t] = INT32_MAX;
+        task->max_idx[t] = -1;
+        task->status[t] = 0;
 
-        if (loop_idx == 1)
+        while (p < chunk_end)
         {
-            // Calculate Mean
-            mean = sum / m->rows;
-            --c;
+            const char *line_end = memchr(p, '\n', (size_t)(chunk_end - p));
+            if (!line_end)
+            {
+                line_end = chunk_end;
+            }
+
+            int64_t nnz = 0;
+            int kind = parseLIBSVMLine(p, line_end, 0, NULL, NULL, NULL, &nnz, &task->min_idx[t], &task->max_idx[t]);
+            if (kind < 0)
+            {
+                task->status[t] = -1;
+                return;
+            }
+            task->rows[t] += kind;
+            task->nnz[t] += nnz;
+            p = line_end + 1;
         }
-        else if (loop_idx == 2)
+    }
+}
+
+/**
+ * @brief Second pass over a block of chunks, writes labels and CSR rows at exact offsets
+ *
+ * @param args LIBSVMTask object, rows and nnz hold each chunk's starting offsets
+ * @param thread_id Thread index
+ * @param start First chunk
+ * @param end One past the last chunk
+ *
+ * @return None
+ */
+static void fillLIBSVMTask(void *args, int thread_id, int start, int end)
+{
+    (void)thread_id;
+    LIBSVMTask *task = (LIBSVMTask *)args;
+    SparseMatrix *s = task->sparse;
+
+    for (int t = start; t < end; ++t)
+    {
+        const char *p = task->data + task->bounds[t];
+        const char *chunk_end = task->data + task->bounds[t + 1];
+        int row = task->rows[t];
+        int64_t offset = task->nnz[t];
+        int min_idx = INT32_MAX;
+        int max_idx = -1;
+
+        while (p < chunk_end)
+        {
+            const char *line_end = memchr(p, '\n', (size_t)(chunk_end - p));
+            if (!line_end)
+            {
+                line_end = chunk_end;
+            }
+
+            int64_t nnz = 0;
+            double label = 0.0;
+            int kind = parseLIBSVMLine(p, line_end, task->base, &label, &s->col_idx[offset], &s->values[offset],
+                                       &nnz, &min_idx, &max_idx);
+            if (kind > 0)
+            {
+                task->labels->data[row] = label;
+                offset += nnz;
+                s->row_ptr[++row] = offset;
+            }
+            p = line_end + 1;
+        }
+    }
+}
+
+/**
+ * @brief Read a whole compressed file into memory through a DataStream
+ *
+ * @param filename relative or abolsute path to the file
+ * @param size Number of bytes read
+ *
+ * @return malloc'd buffer, NULL on failure
+ */
+static char *readStreamToBuffer(const char *filename, size_t *size)
+{
+    DataStream stream;
+    if (openDataStream(&stream, filename) < 0)
+    {
+        return NULL;
+    }
+
+    size_t cap = STREAM_RING_SIZE;
+    char *buffer = malloc(cap);
+    char *line = NULL;
+    size_t line_cap = 0;
+    ssize_t len = 0;
+    *size = 0;
+    while (buffer && (len = readLineDataStream(&stream, &line, &line_cap)) >= 0)
+    {
+        if (*size + (size_t)len + 1 > cap)
         {
-            // Calculate standard deviation
-            std_dev = sqrt(sum_squares / m->rows);
-            --c;
+            while (*size + (size_t)len + 1 > cap)
+            {
+                cap *= 2;
+            }
+            char *grown = realloc(buffer, cap);
+            if (!grown)
+            {
+                free(buffer);
+                buffer = NULL;
+                break;
+            }
+            buffer = grown;
         }
-        else
+        memcpy(buffer + *size, line, (size_t)len);
+        *size += (size_t)len;
+    }
+    if (buffer && dataStreamFailed(&stream))
+    {
+        LOG_ERROR("File %s is truncated or corrupt.\n", filename);
+        free(buffer);
+        buffer = NULL;
+    }
+
+    free(line);
+    closeDataStream(&stream);
+
+    return buffer;
+}
+
+/**
+ * @brief Free the work buffers of a LIBSVMTask
+ *
+ * @param task LIBSVMTask object
+ *
+ * @return None
+ */
+static void freeLIBSVMTask(LIBSVMTask *task)
+{
+    free(task->bounds);
+    free(task->rows);
+    free(task->nnz);
+    free(task->min_idx);
+    free(task->max_idx);
+    free(task->status);
+}
+
+/**
+ * @brief Parse LIBSVM text held in memory into labels and a CSR matrix
+ *
+ * @param data LIBSVM text
+ * @param size Length of the text
+ * @param filename Name used in error messages
+ * @param num_features Number of feature columns, <= 0 to use the largest index in the text
+ * @param labels Matrix to get the rows x 1 labels
+ * @param sparse SparseMatrix to get the features
+ *
+ * @return 0 if successful, -1 if failure
+ */
+static int parseLIBSVMBuffer(const char *data, size_t size, const char *filename, int num_features, Matrix *labels, SparseMatrix *sparse)
+{
+    // One chunk per thread with at least a megabyte each, boundaries moved to the next line start
+    LIBSVMTask task = {0};
+    task.data = data;
+    task.threads = planThreads((int)MIN(size >> 20, (size_t)INT32_MAX), 1);
+    task.bounds = malloc((task.threads + 1) * sizeof(size_t));
+    task.rows = malloc(task.threads * sizeof(int));
+    task.nnz = malloc(task.threads * sizeof(int64_t));
+    task.min_idx = malloc(task.threads * sizeof(int));
+    task.max_idx = malloc(task.threads * sizeof(int));
+    task.status = malloc(task.threads * sizeof(int));
+    if (!task.bounds || !task.rows || !task.nnz || !task.min_idx || !task.max_idx || !task.status)
+    {
+        LOG_ERROR("Failed to allocate LIBSVM work buffers.\n");
+        freeLIBSVMTask(&task);
+        return -1;
+    }
+
+    task.bounds[0] = 0;
+    task.bounds[task.threads] = size;
+    for (int t = 1; t < task.threads; ++t)
+    {
+        size_t pos = MAX((size * t) / task.threads, task.bounds[t - 1]);
+        const char *newline = memchr(data + pos, '\n', size - pos);
+        task.bounds[t] = newline ? (size_t)(newline - data) + 1 : size;
+    }
+
+    parallelFor(task.threads, task.threads, countLIBSVMTask, &task);
+
+    // Turn the per-chunk counts into starting offsets
+    int rows = 0;
+    int64_t nnz = 0;
+    int min_idx = INT32_MAX;
+    int max_idx = -1;
+    for (int t = 0; t < task.threads; ++t)
+    {
+        if (task.status[t] < 0)
         {
-            loop_idx = 0;
-            sum = 0.0;
-            mean = 0.0;
-            sum_squares = 0.0;
-            std_dev = 0.0;
+            LOG_ERROR("LIBSVM file %s has a malformed line after byte %zu.\n", filename, task.bounds[t]);
+            freeLIBSVMTask(&task);
+            return -1;
         }
+        int chunk_rows = task.rows[t];
+        int64_t chunk_nnz = task.nnz[t];
+        task.rows[t] = rows;
+        task.nnz[t] = nnz;
+        rows += chunk_rows;
+        nnz += chunk_nnz;
+        min_idx = MIN(min_idx, task.min_idx[t]);
+        max_idx = MAX(max_idx, task.max_idx[t]);
+    }
+    if (rows == 0)
+    {
+        LOG_ERROR("LIBSVM file %s has no data rows.\n", filename);
+        freeLIBSVMTask(&task);
+        return -1;
+    }
+
+    // LIBSVM indices start at 1, files that use index 0 are treated as 0-based
+    task.base = (min_idx == 0) ? 0 : 1;
+    int cols = (max_idx < 0) ? 1 : max_idx + 1 - task.base;
+    if (num_features > 0)
+    {
+        if (num_features < cols)
+        {
+            LOG_ERROR("LIBSVM file %s has feature index %d beyond the %d requested features.\n", filename, max_idx, num_features);
+            freeLIBSVMTask(&task);
+            return -1;
+        }
+        cols = num_features;
+    }
+
+    freeMatrix(labels);
+    if (makeSparseMatrix(sparse, rows, cols, nnz) < 0 || makeMatrixZeros(labels, rows, 1) < 0)
+    {
+        LOG_ERROR("Failed to allocate LIBSVM file %s with %d rows and %lld values.\n", filename, rows, (long long)nnz);
+        freeSparseMatrix(sparse);
+        freeLIBSVMTask(&task);
+        return -1;
+    }
+    task.labels = labels;
+    task.sparse = sparse;
+
+    parallelFor(task.threads, task.threads, fillLIBSVMTask, &task);
+
+    freeLIBSVMTask(&task);
+    return 0;
+}
+
+/**
+ * @brief Load a LIBSVM/SVMlight "label idx:val ..." file. The file is memory mapped (or
+ *        decompressed into memory), split into line-aligned chunks, counted in parallel to size
+ *        every allocation exactly, then parsed in parallel straight into its final position.
+ *
+ * @param filename relative or abolsute path to the file, may be gzip or zstd compressed
+ * @param num_features Number of feature columns, <= 0 to use the largest index in the file
+ * @param labels Matrix to get the rows x 1 labels
+ * @param features SparseMatrix to get the CSR features, NULL to skip
+ * @param dense Matrix to get the dense features, NULL to skip
+ *
+ * @return 0 if successful, -1 if failure
+ */
+int loadLIBSVM(const char *filename, int num_features, Matrix *labels, SparseMatrix *features, Matrix *dense)
+{
+    if (!filename || !labels || (!features && !dense))
+    {
+        LOG_ERROR("Input variables to load a LIBSVM file were not correct.\n");
+        return -1;
+    }
+
+    // Get the whole file in memory, mapped when it is plain text
+    char *data = NULL;
+    size_t size = 0;
+    bool mapped = false;
+    if (detectStreamFormat(filename) == STREAM_PLAIN)
+    {
+        int fd = open(filename, O_RDONLY);
+        struct stat st;
+        if (fd < 0 || fstat(fd, &st) != 0)
+        {
+            LOG_ERROR("Error opening LIBSVM file %s\n", filename);
+            if (fd >= 0)
+            {
+                close(fd);
+            }
+            return -1;
+        }
+        size = (size_t)st.st_size;
+        if (size > 0)
+        {
+            data = mmap(NULL, size, PROT_READ, MAP_PRIVATE, fd, 0);
+            if (data == MAP_FAILED)
+            {
+                data = NULL;
+            }
+            else
+            {
+                madvise(data, size, MADV_SEQUENTIAL);
+                mapped = true;
+            }
+        }
+        close(fd);
+    }
+    else
+    {
+        data = readStreamToBuffer(filename, &size);
+    }
+    if (!data)
+    {
+        LOG_ERROR("Could not read LIBSVM file %s\n", filename);
+        return -1;
+    }
+
+    SparseMatrix sparse = makeSparseMatrixEmpty();
+    int status = parseLIBSVMBuffer(data, size, filename, num_features, labels, &sparse);
+    if (mapped)
+    {
+        munmap(data, size);
+    }
+    else
+    {
+        free(data);
+    }
+    if (status < 0)
+    {
+        return -1;
+    }
+
+    if (dense && sparseToDense(sparse, dense) < 0)
+    {
+        LOG_ERROR("Densifying LIBSVM file %s was unsuccessful.\n", filename);
+        freeSparseMatrix(&sparse);
+        return -1;
+    }
+
+    if (features)
+    {
+        freeSparseMatrix(features);
+        *features = sparse;
+    }
+    else
+    {
+        freeSparseMatrix(&sparse);
     }
 
     return 0;
@@ -0,0 +1,257 @@
+/*
+ * file: linalg.c
+ * description: Cholesky and Householder QR factorizations for small dense systems
+ * author: Ryan Wagner
+ * date: October 19, 2026
+ * notes: sized for normal equations with tens of unknowns, everything is row-major and serial
+ */
+
+#include "../header/linalg.h"
+
+// Pivots below this fraction of the largest one are treated as singular
+#define LINALG_RELATIVE_TOLERANCE 1e-12
+
+/**
+ * @brief Cholesky factorization A = L * L^T of a symmetric positive definite matrix, in place.
+ *        Only the lower triangle of A is read, L is written to the lower triangle and the
+ *        upper triangle is zeroed.
+ *
+ * @param A Square Matrix to factor
+ *
+ * @return 0 if successful, -1 if A is not numerically positive definite
+ */
+int choleskyDecompose(Matrix *A)
+{
+    if (!initialized_matrix(A) || A->rows != A->cols)
+    {
+        LOG_ERROR("Input matrix to the Cholesky factorization must be square.\n");
+        return -1;
+    }
+
+    int n = A->rows;
+    double max_diag = 0.0;
+    for (int i = 0; i < n; ++i)
+    {
+        max_diag = MAX(max_diag, fabs(A->data[i * n + i]));
+    }
+
+    for (int j = 0; j < n; ++j)
+    {
+        double *row_j = &A->data[j * n];
+        double diag = row_j[j];
+        for (int k = 0; k < j; ++k)
+        {
+            diag -= row_j[k] * row_j[k];
+        }
+        if (diag <= LINALG_RELATIVE_TOLERANCE * max_diag)
+        {
+            LOG_WARN("Matrix is not numerically positive definite at pivot %d.\n", j);
+            return -1;
+        }
+        row_j[j] = sqrt(diag);
+
+        for (int i = j + 1; i < n; ++i)
+        {
+            double *row_i = &A->data[i * n];
+            double sum = row_i[j];
+            for (int k = 0; k < j; ++k)
+            {
+                sum -= row_i[k] * row_j[k];
+            }
+            row_i[j] = sum / row_j[j];
+        }
+        for (int k = j + 1; k < n; ++k)
+        {
+            row_j[k] = 0.0;
+        }
+    }
+
+    return 0;
+}
+
+/**
+ * @brief Solve L * L^T * X = B in place with a Cholesky factor from choleskyDecompose
+ *
+ * @param L Lower triangular factor of size NxN
+ * @param B Right hand side of size NxK, overwritten with X
+ *
+ * @return 0 if successful, -1 if failure
+ */
+int choleskySolve(Matrix L, Matrix *B)
+{
+    if (!L.data || !initialized_matrix(B) || L.rows != L.cols || L.rows != B->rows)
+    {
+        LOG_ERROR("Input variables to the Cholesky solve were not correct.\n");
+        return -1;
+    }
+
+    int n = L.rows;
+    int k = B->cols;
+
+    // Forward substitution, L * Z = B
+    for (int i = 0; i < n; ++i)
+    {
+        for (int c = 0; c < k; ++c)
+        {
+            double sum = B->data[i * k + c];
+            for (int j = 0; j < i; ++j)
+            {
+                sum -= L.data[i * n + j] * B->data[j * k + c];
+            }
+            B->data[i * k + c] = sum / L.data[i * n + i];
+        }
+    }
+
+    // Back substitution, L^T * X = Z
+    for (int i = n - 1; i >= 0; --i)
+    {
+        for (int c = 0; c < k; ++c)
+        {
+            double sum = B->data[i * k + c];
+            for (int j = i + 1; j < n; ++j)
+            {
+                sum -= L.data[j * n + i] * B->data[j * k + c];
+            }
+            B->data[i * k + c] = sum / L.data[i * n + i];
+        }
+    }
+
+    return 0;
+}
+
+/**
+ * @brief Least squares solve of min ||A * X - B|| with Householder QR. Works on the data
+ *        instead of the normal equations, so it keeps its accuracy when A^T * A is badly
+ *        conditioned. Unknowns whose pivot vanishes are set to 0.
+ *
+ * @param A Matrix of size MxN with M >= N, left unchanged
+ * @param B Matrix of size MxK, left unchanged
+ * @param X Resulting Matrix of size NxK, resized if its shape does not match
+ *
+ * @return 0 if successful, -1 if failure
+ */
+int qrLeastSquares(Matrix A, Matrix B, Matrix *X)
+{
+    if (!A.data || !B.data || !X || A.rows < A.cols || A.rows != B.rows)
+    {
+        LOG_ERROR("Input variables to the QR least squares solve were not correct.\n");
+        return -1;
+    }
+
+    int m = A.rows;
+    int n = A.cols;
+    int k = B.cols;
+
+    // Factor copies, R ends up in the top of R_work and Q^T * B in the top of QtB
+    Matrix R_work = {0};
+    Matrix QtB = {0};
+    Vector v = {0};
+    if (makeMatrix(&R_work, m, n, A.data, TYPE_DOUBLE) < 0 || makeMatrix(&QtB, m, k, B.data, TYPE_DOUBLE) < 0 ||
+        makeVectorZeros(&v, m) < 0)
+    {
+        LOG_ERROR("Could not allocate the QR workspace.\n");
+        freeMatrix(&R_work);
+        freeMatrix(&QtB);
+        freeVector(&v);
+        return -1;
+    }
+
+    for (int j = 0; j < n; ++j)
+    {
+        // Householder vector that zeroes column j below the diagonal
+        double norm = 0.0;
+        for (int i = j; i < m; ++i)
+        {
+            norm += R_work.data[i * n + j] * R_work.data[i * n + j];
+        }
+        norm = sqrt(norm);
+        if (norm == 0.0)
+        {
+            continue;
+        }
+
+        double alpha = (R_work.data[j * n + j] > 0) ? -norm : norm;
+        double v_norm = 0.0;
+        for (int i = j; i < m; ++i)
+        {
+            v.data[i] = R_work.data[i * n + j] - ((i == j) ? alpha : 0.0);
+            v_norm += v.data[i] * v.data[i];
+        }
+        if (v_norm == 0.0)
+        {
+            continue;
+        }
+
+        // Reflect the remaining columns of R and every column of B
+        for (int c = j; c < n; ++c)
+        {
+            double dot = 0.0;
+            for (int i = j; i < m; ++i)
+            {
+                dot += v.data[i] * R_work.data[i * n + c];
+            }
+            double f = 2.0 * dot / v_norm;
+            for (int i = j; i < m; ++i)
+            {
+                R_work.data[i * n + c] -= f * v.data[i];
+            }
+        }
+        for (int c = 0; c < k; ++c)
+        {
+            double dot = 0.0;
+            for (int i = j; i < m; ++i)
+            {
+                dot += v.data[i] * QtB.data[i * k + c];
+            }
+            double f = 2.0 * dot / v_norm;
+            for (int i = j; i < m; ++i)
+            {
+                QtB.data[i * k + c] -= f * v.data[i];
+            }
+        }
+    }
+
+    if (!initialized_matrix(X) || X->rows != n || X->cols != k)
+    {
+        freeMatrix(X);
+        if (makeMatrixZeros(X, n, k) < 0)
+        {
+            LOG_ERROR("Error initializing the QR solution matrix.\n");
+            freeMatrix(&R_work);
+            freeMatrix(&QtB);
+            freeVector(&v);
+            return -1;
+        }
+    }
+
+    double max_pivot = 0.0;
+    for (int j = 0; j < n; ++j)
+    {
+        max_pivot = MAX(max_pivot, fabs(R_work.data[j * n + j]));
+    }
+
+    // Back substitution, R * X = Q^T * B
+    for (int i = n - 1; i >= 0; --i)
+    {
+        double pivot = R_work.data[i * n + i];
+        for (int c = 0; c < k; ++c)
+        {
+            if (fabs(pivot) <= LINALG_RELATIVE_TOLERANCE * max_pivot)
+            {
+                X->data[i * k + c] = 0.0;
+                continue;
+            }
+            double sum = QtB.data[i * k + c];
+            for (int j = i + 1; j < n; ++j)
+            {
+                sum -= R_work.data[i * n + j] * X->data[j * k + c];
+            }
+            X->data[i * k + c] = sum / pivot;
+        }
+    }
+
+    freeMatrix(&R_work);
+    freeMatrix(&QtB);
+    freeVector(&v);
+    return 0;
+}
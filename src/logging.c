@@ -23,8 +23,10 @@ int getCurrentTime(bool include_date, bool include_time, char *buffer)
 {
     // Source: https://stackoverflow.com/questions/25030055/add-date-and-time-to-a-file-name-in-c
 
+    // gmtime_r fills a caller buffer, so threads logging at once do not share gmtime's static one
     time_t now = time(NULL);
-    struct tm *timenow = gmtime(&now);
+    struct tm parts;
+    struct tm *timenow = gmtime_r(&now, &parts);
 
     if (include_date && !include_time)
     {
@@ -8,6 +8,7 @@
 #include "../header/regression.h"
 #include "../header/file_handling.h"
 #include "../header/eval_matrics.h"
+#include "../header/model_io.h"
 
 int run_salary_dataset()
 {
@@ -72,6 +73,7 @@ int run_salary_dataset()
     linear_model.config.epochs = 2000;
     linear_model.config.lambda = 0.01;
     linear_model.config.regularization = REG_L2;
+    linear_model.config.solver = SOLVER_CLOSED_FORM;
 
     if (trainModel(&linear_model) < 0)
     {
@@ -174,6 +176,7 @@ int run_wine_quality_dataset()
     linear_model.config.epochs = 20000;
     linear_model.config.lambda = 0.0001;
     linear_model.config.regularization = REG_L2;
+    linear_model.config.solver = SOLVER_CLOSED_FORM;
 
     if (trainModel(&linear_model) < 0)
     {
@@ -241,8 +244,9 @@ int run_heart_disease_dataset()
         return -1;
     }
 
-    // Load the table in a CSV file into a Matrix object
-    if (loadCSVtoMatrix(filename, 1, logistic_model.X) < 0)
+    // Load the table in a CSV file into a Matrix object, Yes/No and other string columns get integer codes
+    CategoricalEncoder encoder = makeDefaultEncoder();
+    if (loadCSVtoMatrixEncoded(filename, 1, logistic_model.X, &encoder) < 0)
     {
         LOG_ERROR("Reading CSV to Matrix was unsuccessful.\n");
         return -1;
@@ -267,10 +271,11 @@ int run_heart_disease_dataset()
         return -1;
     }
 
-    // Z-Score Normalize the input data for better results
-    if (normalizeMatrix(logistic_model.X) < 0)
+    // Z-Score Normalize the input data for better results, keeping the statistics for new data
+    Scaler scaler = makeDefaultScaler(SCALE_STANDARD);
+    if (fitTransformScaler(&scaler, logistic_model.X) < 0)
     {
-        LOG_ERROR("Reading CSV to Matrix was unsuccessful.\n");
+        LOG_ERROR("Normalizing input Matrix was unsuccessful.\n");
         return -1;
     }
 
@@ -289,6 +294,7 @@ int run_heart_disease_dataset()
     logistic_model.config.epochs = 300;
     logistic_model.config.lambda = 0.1;
     logistic_model.config.regularization = REG_L2;
+    logistic_model.config.preallocate = true;
     logistic_model.config.learning_rate.init_learning_rate = 0.0003;
     logistic_model.config.learning_rate.decay_type = LINEAR_DECAY;
     // logistic_model.config.learning_rate.decay_constant = 0.0001;
@@ -301,6 +307,12 @@ int run_heart_disease_dataset()
         return -1;
     }
 
+    // Store the trained weights with the normalization statistics used to produce them
+    if (saveModel(&logistic_model, &scaler, "heart_disease_model.bin") < 0)
+    {
+        LOG_ERROR("Saving the trained model was unsuccessful.\n");
+    }
+
     // Calculate the predicted labels
     Matrix computed_labels = makeMatrixEmpty();
     if (comptueLabels(logistic_model.splitdata.test_features, *logistic_model.weights, *logistic_model.bias, &computed_labels, logistic_model.func) < 0)
@@ -328,6 +340,8 @@ int run_heart_disease_dataset()
 
     freeModel(&logistic_model);
     freeEvalMetrics(&eval_metrics);
+    freeEncoder(&encoder);
+    freeScaler(&scaler);
 
     return 0;
 }
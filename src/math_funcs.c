@@ -7,6 +7,21 @@
  */
 
 #include "../header/math_funcs.h"
+#include "../header/threading.h"
+#include "../header/random.h"
+
+#define GATHER_MIN_ROWS_PER_THREAD 1024
+#define GATHER_PREFETCH_DISTANCE 4
+#define INDEXED_GEMM_MIN_ROWS_PER_THREAD 64
+#define TRANSPOSE_BLOCK 32
+
+typedef struct
+{
+    Matrix A;           // Source matrix, rows are read in place
+    const int *row_idx; // Rows of A to use, in output order
+    Matrix B;           // Right hand side of the indexed GEMM, unused by the gather
+    Matrix *result;     // Output matrix
+} RowIndexTask;
 
 /**
  * @brief Performs the dot product of two vectors
@@ -182,6 +197,98 @@ int mat_mul_matrix(Matrix A, Matrix B, Matrix *result)
     return 0;
 }
 
+/**
+ * @brief result rows = A[row_idx] rows * B over a block of output rows
+ *
+ * @param args RowIndexTask object
+ * @param thread_id Thread index
+ * @param start First output row
+ * @param end One past the last output row
+ *
+ * @return None
+ */
+static void matMulIndexedTask(void *args, int thread_id, int start, int end)
+{
+    (void)thread_id;
+    RowIndexTask *task = (RowIndexTask *)args;
+    int inner = task->A.cols;
+    int cols = task->B.cols;
+
+    for (int r = start; r < end; ++r)
+    {
+        if (r + 1 < end)
+        {
+            __builtin_prefetch(&task->A.data[(size_t)task->row_idx[r + 1] * inner], 0, 0);
+        }
+
+        const double *a = &task->A.data[(size_t)task->row_idx[r] * inner];
+        double *out = &task->result->data[(size_t)r * cols];
+        for (int c = 0; c < cols; ++c)
+        {
+            out[c] = 0.0;
+        }
+        for (int k = 0; k < inner; ++k)
+        {
+            const double *b = &task->B.data[(size_t)k * cols];
+            double a_k = a[k];
+            for (int c = 0; c < cols; ++c)
+            {
+                out[c] += a_k * b[c];
+            }
+        }
+    }
+}
+
+/**
+ * @brief Indexed matrix multiplication: A[row_idx] * B. Rows of A are read in place,
+ *        so a shuffled mini-batch product needs no gathered copy of the batch.
+ *
+ * @param A Matrix of size MxN of Matrix type
+ * @param row_idx Integer array of n row indices into A
+ * @param n Number of rows in the product
+ * @param B Matrix of size NxP of Matrix type
+ * @param result Calculated Matrix of size nxP, resized if its shape does not match
+ *
+ * @return 0 on success and -1 on failure
+ */
+int mat_mul_indexed(Matrix A, const int *row_idx, int n, Matrix B, Matrix *result)
+{
+    if (!A.data || !B.data || !row_idx || !result || n <= 0)
+    {
+        LOG_ERROR("Input variables could not pass inital tests for indexed matrix multiplication.\n");
+        return -1;
+    }
+
+    if (A.cols != B.rows)
+    {
+        LOG_ERROR("Matrix shapes do not match. Cannot perform indexed matrix multiplication.\n");
+        return -1;
+    }
+
+    for (int r = 0; r < n; ++r)
+    {
+        if (row_idx[r] < 0 || row_idx[r] >= A.rows)
+        {
+            LOG_ERROR("Row index %d is outside of the matrix.\n", row_idx[r]);
+            return -1;
+        }
+    }
+
+    if (!initialized_matrix(result) || result->rows != n || result->cols != B.cols)
+    {
+        freeMatrix(result);
+        if (makeMatrixZeros(result, n, B.cols) < 0)
+        {
+            LOG_ERROR("Error initializing zero output matrix.\n");
+            return -1;
+        }
+    }
+
+    // Output rows are disjoint, so they split across threads without reduction
+    RowIndexTask task = {A, row_idx, B, result};
+    return parallelFor(planThreads(n, INDEXED_GEMM_MIN_ROWS_PER_THREAD), n, matMulIndexedTask, &task);
+}
+
 /**
  * @brief Matrix multiplication: A * B
  *
@@ -963,12 +1070,20 @@ int transpose(Matrix A, Matrix *A_t)
     A_t->rows = A.cols;
     A_t->cols = A.rows;
 
-    // Iterate COLUMN-wise through row-matrix to transpose it
-    for (int r = 0; r < A.rows; ++r)
+    // Copy square tiles so the strided writes of a tile stay in cache until it is done
+    for (int r0 = 0; r0 < A.rows; r0 += TRANSPOSE_BLOCK)
     {
-        for (int c = 0; c < A.cols; ++c)
+        int r1 = (r0 + TRANSPOSE_BLOCK < A.rows) ? r0 + TRANSPOSE_BLOCK : A.rows;
+        for (int c0 = 0; c0 < A.cols; c0 += TRANSPOSE_BLOCK)
         {
-            A_t->data[c * A_t->cols + r] = A.data[r * A.cols + c];
+            int c1 = (c0 + TRANSPOSE_BLOCK < A.cols) ? c0 + TRANSPOSE_BLOCK : A.cols;
+            for (int r = r0; r < r1; ++r)
+            {
+                for (int c = c0; c < c1; ++c)
+                {
+                    A_t->data[c * A_t->cols + r] = A.data[r * A.cols + c];
+                }
+            }
         }
     }
 
@@ -1354,59 +1469,90 @@ int applyToMatrix(Matrix *m, Activation func)
 }
 
 /**
- * @brief
+ * @brief Copy a block of indexed rows into the output with one memcpy per row,
+ *        the source row a few iterations ahead is prefetched while the current one copies
  *
- * @param m Original matrix
- * @param mini Matrix to receive mini-batch
- * @param perm_arr Integer array of random permutation
- * @param batch_idx Batch number
- * @param size Size of the batch
+ * @param args RowIndexTask object
+ * @param thread_id Thread index
+ * @param start First output row
+ * @param end One past the last output row
  *
- * @return 0 if successful, -1 if failure
+ * @return None
  */
-int makeMiniMatrix(Matrix m, Matrix *mini, int *perm_arr, int batch_idx, int size)
+static void gatherRowsTask(void *args, int thread_id, int start, int end)
 {
-    if (!m.data || !mini->data || !perm_arr || batch_idx < 0)
+    (void)thread_id;
+    RowIndexTask *task = (RowIndexTask *)args;
+    int cols = task->A.cols;
+    size_t row_bytes = (size_t)cols * sizeof(double);
+
+    for (int r = start; r < end; ++r)
     {
-        LOG_ERROR("Parameters input into mini batch function were not correct.\n");
-        return -1;
+        if (r + GATHER_PREFETCH_DISTANCE < end)
+        {
+            __builtin_prefetch(&task->A.data[(size_t)task->row_idx[r + GATHER_PREFETCH_DISTANCE] * cols], 0, 0);
+        }
+        memcpy(&task->result->data[(size_t)r * cols], &task->A.data[(size_t)task->row_idx[r] * cols], row_bytes);
     }
+}
 
-    int start_idx = batch_idx * mini->rows;
-    int row = 0;
-    Vector v = {0};
-    if (makeVectorZeros(&v, m.cols) < 0)
+/**
+ * @brief Gather rows of m into the first n rows of out, out[r] = m[row_idx[r]].
+ *        Large batches are split across threads, out is never reallocated.
+ *
+ * @param m Source Matrix
+ * @param row_idx Integer array of n row indices into m
+ * @param n Number of rows to gather
+ * @param out Matrix with the same columns as m and at least n rows
+ *
+ * @return 0 if successful, -1 if failure
+ */
+int gatherRows(Matrix m, const int *row_idx, int n, Matrix *out)
+{
+    if (!m.data || !row_idx || !out || !out->data || n < 0 || n > out->rows || m.cols != out->cols)
     {
-        LOG_ERROR("Making of default row vector was unsuccessful.\n");
+        LOG_ERROR("Input variables to gather matrix rows were not correct.\n");
         return -1;
     }
 
-    for (int r = 0; r < size; ++r)
+    // Check every index up front so the copy threads cannot fail part way
+    for (int r = 0; r < n; ++r)
     {
-        // Get random row number from permutation array
-        row = perm_arr[start_idx + r];
-
-        // Get row from original matrix
-        if (getRowMatrix_v(m, row, &v) < 0)
+        if (row_idx[r] < 0 || row_idx[r] >= m.rows)
         {
-            LOG_ERROR("Getting row vector from X matrix was unsuccessful.\n");
+            LOG_ERROR("Row index %d is outside of the matrix.\n", row_idx[r]);
             return -1;
         }
+    }
 
-        // Set the row in the new matrix
-        if (setRowMatrix(mini, r, v) < 0)
-        {
-            LOG_ERROR("Setting row vector in mini matrix was unsuccessful.\n");
-            return -1;
-        }
+    RowIndexTask task = {m, row_idx, {0}, out};
+    return parallelFor(planThreads(n, GATHER_MIN_ROWS_PER_THREAD), n, gatherRowsTask, &task);
+}
+
+/**
+ * @brief Function to make a mini-batch from the rows of a random permutation
+ *
+ * @param m Original matrix
+ * @param mini Matrix to receive mini-batch
+ * @param perm_arr Integer array of random permutation
+ * @param batch_idx Batch number
+ * @param size Size of the batch
+ *
+ * @return 0 if successful, -1 if failure
+ */
+int makeMiniMatrix(Matrix m, Matrix *mini, int *perm_arr, int batch_idx, int size)
+{
+    if (!m.data || !mini || !mini->data || !perm_arr || batch_idx < 0)
+    {
+        LOG_ERROR("Parameters input into mini batch function were not correct.\n");
+        return -1;
     }
-    freeVector(&v);
 
-    return 0;
+    return gatherRows(m, perm_arr + batch_idx * mini->rows, size, mini);
 }
 
 /**
- * @brief Function to generate a random permutation of an array
+ * @brief Function to generate a random permutation of an array, seeded by setRandomSeed
  *
  * @param arr Integer array to be randomized
  * @param n Length of array arr
@@ -1415,8 +1561,6 @@ int makeMiniMatrix(Matrix m, Matrix *mini, int *perm_arr, int batch_idx, int siz
  */
 int generateRandomPermutation(int *arr, int n)
 {
-    int j = 0;
-    int temp = 0;
     // Check input variables
     if (!arr || n <= 0)
     {
@@ -1424,28 +1568,8 @@ int generateRandomPermutation(int *arr, int n)
         return -1;
     }
 
-    // Fill the input arr with values from 0 to n-1
-    for (int i = 0; i < n; ++i)
-    {
-        arr[i] = i;
-    }
-
-    // Seed the random number generator
-    srand(time(NULL));
-
-    // Fisher-Yates shuffle
-    for (int i = n - 1; i > 0; i--)
-    {
-        // Generate a random index j between 0 and i (inclusive)
-        j = rand() % (i + 1);
-
-        // Swap arr[i] with arr[j]
-        temp = arr[j];
-        arr[j] = arr[i];
-        arr[i] = temp;
-    }
-
-    return 0;
+    // Draw from the calling thread's own stream so concurrent callers never share state
+    return shufflePermutation(arr, n, threadRandom());
 }
 
 /**
@@ -1479,12 +1603,12 @@ void freeSplitData(SplitData *splitdata)
     splitdata->train_labels.data = NULL;
     free(splitdata->test_features.data);
     splitdata->test_features.data = NULL;
-    free(splitdata->test_features.data);
-    splitdata->test_features.data = NULL;
-    free(splitdata->valid_features.data);
-    splitdata->valid_features.data = NULL;
+    free(splitdata->test_labels.data);
+    splitdata->test_labels.data = NULL;
     free(splitdata->valid_features.data);
     splitdata->valid_features.data = NULL;
+    free(splitdata->valid_labels.data);
+    splitdata->valid_labels.data = NULL;
 
     return;
 }
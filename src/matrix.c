@@ -6,8 +6,33 @@
  * notes:
  */
 
+#include <stdatomic.h>
+
 #include "../header/matrix.h"
 
+// Number of Matrix and Vector buffers allocated so far, used to check the training steady state
+static atomic_long allocation_count = 0;
+
+/**
+ * @brief Record one Matrix or Vector buffer allocation
+ *
+ * @return None
+ */
+void countAllocation(void)
+{
+    atomic_fetch_add_explicit(&allocation_count, 1, memory_order_relaxed);
+}
+
+/**
+ * @brief Get the number of Matrix and Vector buffers allocated since the program started
+ *
+ * @return Allocation count
+ */
+long getAllocationCount(void)
+{
+    return atomic_load_explicit(&allocation_count, memory_order_relaxed);
+}
+
 /**
  * @brief Clears a Matrix by making all values 0
  *
@@ -67,7 +92,51 @@ int copyMatrix(Matrix m, Matrix *mc)
 }
 
 /**
- * @brief Basic printing of a Matrix object
+ * @brief Format an array of values as one "[a, b, c]" line
+ *
+ * @param values Array of values
+ * @param n Number of values
+ *
+ * @return malloc'd string that the caller frees, NULL on failure
+ */
+char *formatValues(const double *values, int n)
+{
+    // Each value is printed with %.6lf, leave room for large magnitudes and separators
+    size_t cap = 32 * (size_t)(n > 0 ? n : 1) + 4;
+    char *line = malloc(cap);
+    if (!line)
+    {
+        return NULL;
+    }
+
+    size_t len = 0;
+    line[len++] = '[';
+    for (int i = 0; i < n; ++i)
+    {
+        int written = snprintf(line + len, cap - len, (i < n - 1) ? "%.6lf, " : "%.6lf", values[i]);
+        if (written < 0 || (size_t)written >= cap - len)
+        {
+            // Value too wide for the estimate, grow and retry
+            cap *= 2;
+            char *grown = realloc(line, cap);
+            if (!grown)
+            {
+                free(line);
+                return NULL;
+            }
+            line = grown;
+            --i;
+            continue;
+        }
+        len += written;
+    }
+    snprintf(line + len, cap - len, "]\n");
+
+    return line;
+}
+
+/**
+ * @brief Basic printing of a Matrix object, one log call per row
  *
  * @param m Matrix object to print
  *
@@ -81,20 +150,7 @@ void printMatrix(Matrix m)
         return;
     }
 
-    for (int r = 0; r < m.rows; ++r)
-    {
-        LOG_INFO("[");
-        for (int c = 0; c < m.cols; ++c)
-        {
-            int idx = r * m.cols + c;
-
-            LOG_INFO("%.6lf", m.data[idx]);
-
-            if (c < m.cols - 1)
-                LOG_INFO(", ");
-        }
-        LOG_INFO("]\n");
-    }
+    printMatrixHead(m, m.rows);
 }
 
 /**
@@ -125,19 +181,16 @@ void printMatrixHead(Matrix m, int rows)
         return;
     }
 
-    for (int r = 0; r < rows; ++r)
+    for (int r = 0; r < rows && r < m.rows; ++r)
     {
-        LOG_INFO("[");
-        for (int c = 0; c < m.cols; ++c)
+        char *line = formatValues(&m.data[r * m.cols], m.cols);
+        if (!line)
         {
-            int idx = r * m.cols + c;
-
-            LOG_INFO("%.6lf", m.data[idx]);
-
-            if (c < m.cols - 1)
-                LOG_INFO(", ");
+            LOG_ERROR("Formatting row %d of Matrix m was unsuccessful.\n", r);
+            return;
         }
-        LOG_INFO("]\n");
+        LOG_INFO("%s", line);
+        free(line);
     }
 }
 
@@ -180,6 +233,7 @@ int makeMatrix(Matrix *m, int rows, int cols, void *data, DataType type)
         LOG_ERROR("Failed to allocate matrix\n");
         return -1;
     }
+    countAllocation();
 
     // Assign values to matrix if given
     int idx = 0;
@@ -258,6 +312,7 @@ int makeMatrixZeros(Matrix *m, int rows, int cols)
         LOG_ERROR("Failed to allocate matrix\n");
         return -1;
     }
+    countAllocation();
 
     return 0;
 }
@@ -282,6 +337,7 @@ Matrix makeMatrixEmpty()
     else
     {
         m.data[0] = 0.0;
+        countAllocation();
     }
 
     return m;
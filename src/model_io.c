@@ -0,0 +1,1041 @@
+/*
+ * file: model_io.c
+ * description: binary save and load of trained models
+ * author: Ryan Wagner
+ * date: October 19, 2026
+ * notes: the file is a fixed header followed by 64-byte aligned arrays of doubles, so a
+ *        scoring process can mmap it and use the weights in place without parsing. Training
+ *        checkpoints use the same layout with the optimizer and early stopping state appended.
+ */
+
+#include <fcntl.h>
+#include <limits.h>
+#include <stddef.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include "../header/model_io.h"
+
+/**
+ * @brief FNV-1a 64-bit hash, continued from a previous hash value
+ *
+ * @param hash Running hash, start with 14695981039346656037
+ * @param data Bytes to hash
+ * @param len Number of bytes
+ *
+ * @return Updated hash value
+ */
+static uint64_t fnv1a64(uint64_t hash, const void *data, size_t len)
+{
+    const unsigned char *bytes = (const unsigned char *)data;
+    for (size_t i = 0; i < len; ++i)
+    {
+        hash ^= bytes[i];
+        hash *= 1099511628211ull;
+    }
+
+    return hash;
+}
+
+/**
+ * @brief Checksum of a model or checkpoint file image, computed as if the checksum field were 0
+ *
+ * @param base Start of the file image
+ * @param size Size of the file image
+ * @param checksum_offset Byte offset of the 8 byte checksum field in the header
+ *
+ * @return Checksum value
+ */
+static uint64_t computeFileChecksum(const unsigned char *base, size_t size, size_t checksum_offset)
+{
+    uint64_t zero = 0;
+    uint64_t hash = fnv1a64(14695981039346656037ull, base, checksum_offset);
+    hash = fnv1a64(hash, &zero, sizeof(zero));
+
+    return fnv1a64(hash, base + checksum_offset + sizeof(zero), size - checksum_offset - sizeof(zero));
+}
+
+/**
+ * @brief Round an offset up to the section alignment
+ *
+ * @param offset Byte offset
+ *
+ * @return Aligned offset
+ */
+static uint64_t alignOffset(uint64_t offset)
+{
+    return (offset + MODEL_FILE_ALIGN - 1) & ~(uint64_t)(MODEL_FILE_ALIGN - 1);
+}
+
+/**
+ * @brief Check that a section of doubles lies inside the file and is aligned. Compares against
+ *        the bytes left after the offset so neither side can wrap around.
+ *
+ * @param offset Byte offset of the section
+ * @param count Number of doubles in the section
+ * @param size Size of the file
+ *
+ * @return true if the section is valid
+ */
+static bool validSection(uint64_t offset, uint64_t count, size_t size)
+{
+    return offset % MODEL_FILE_ALIGN == 0 && offset >= sizeof(ModelFileHeader) && offset <= size &&
+           count <= (size - offset) / sizeof(double);
+}
+
+/**
+ * @brief Number of weights of a header's dimensions, computed without overflow
+ *
+ * @param rows Weight rows from the header
+ * @param cols Weight columns from the header
+ * @param count Resulting number of weights
+ *
+ * @return true if both dimensions are positive and the Matrix is addressable with int indices
+ */
+static bool weightCount(int32_t rows, int32_t cols, uint64_t *count)
+{
+    if (rows <= 0 || cols <= 0)
+    {
+        return false;
+    }
+    *count = (uint64_t)rows * (uint64_t)cols;
+    return *count <= INT_MAX;
+}
+
+/**
+ * @brief Validate a model file image: magic, version, byte order, sizes, and checksum
+ *
+ * @param base Start of the file image
+ * @param size Size of the file image
+ *
+ * @return 0 if valid, -1 otherwise
+ */
+static int validateModelImage(const unsigned char *base, size_t size)
+{
+    if (size < sizeof(ModelFileHeader))
+    {
+        LOG_ERROR("Model file is too small to hold a header.\n");
+        return -1;
+    }
+
+    const ModelFileHeader *header = (const ModelFileHeader *)base;
+    if (memcmp(header->magic, MODEL_FILE_MAGIC, sizeof(header->magic)) != 0)
+    {
+        LOG_ERROR("File is not a model file.\n");
+        return -1;
+    }
+    if (header->version != MODEL_FILE_VERSION)
+    {
+        LOG_ERROR("Model file version %u is not supported, expected %d.\n", header->version, MODEL_FILE_VERSION);
+        return -1;
+    }
+    if (header->endian != MODEL_FILE_ENDIAN)
+    {
+        LOG_ERROR("Model file was written on a machine with a different byte order.\n");
+        return -1;
+    }
+    if (header->file_size != size)
+    {
+        LOG_ERROR("Model file is %zu bytes, header says %llu. File is truncated.\n", size, (unsigned long long)header->file_size);
+        return -1;
+    }
+    uint64_t weights = 0;
+    if (!weightCount(header->weight_rows, header->weight_cols, &weights) || header->bias_size <= 0 ||
+        !validSection(header->weights_offset, weights, size) || !validSection(header->bias_offset, (uint64_t)header->bias_size, size))
+    {
+        LOG_ERROR("Model file weight or bias sections are invalid.\n");
+        return -1;
+    }
+    if (header->scaler_type != SCALE_NONE &&
+        (header->scaler_cols < 0 || !validSection(header->center_offset, (uint64_t)header->scaler_cols, size) ||
+         !validSection(header->scale_offset, (uint64_t)header->scaler_cols, size)))
+    {
+        LOG_ERROR("Model file normalization sections are invalid.\n");
+        return -1;
+    }
+    if (computeFileChecksum(base, size, offsetof(ModelFileHeader, checksum)) != header->checksum)
+    {
+        LOG_ERROR("Model file checksum does not match, file is corrupt.\n");
+        return -1;
+    }
+
+    return 0;
+}
+
+/**
+ * @brief Copy the scalar fields of a model file header into a Model object
+ *
+ * @param header Model file header
+ * @param model Pointer to Model object
+ *
+ * @return None
+ */
+static void applyModelHeader(const ModelFileHeader *header, Model *model)
+{
+    model->type = (RegressionType)header->type;
+    model->func = (Activation)header->func;
+    model->classes = header->classes;
+    model->batch_size = header->batch_size;
+    model->beta = header->beta;
+
+    model->config.epochs = header->epochs;
+    model->config.lambda = header->lambda;
+    model->config.regularization = (RegularizationType)header->regularization;
+    model->config.l1_ratio = header->l1_ratio;
+    model->config.optimizer.type = (OptimizerType)header->optimizer;
+    model->config.optimizer.beta1 = header->beta1;
+    model->config.optimizer.beta2 = header->beta2;
+    model->config.optimizer.epsilon = header->epsilon;
+    model->config.optimizer.weight_decay = header->weight_decay;
+    model->config.learning_rate.init_learning_rate = header->init_learning_rate;
+    model->config.learning_rate.min_learning_rate = header->min_learning_rate;
+    model->config.learning_rate.curr_learning_rate = header->curr_learning_rate;
+    model->config.learning_rate.max_epoch_cycle = header->max_epoch_cycle;
+    model->config.learning_rate.decay_type = (DecayType)header->decay_type;
+    model->config.learning_rate.decay_step = header->decay_step;
+    model->config.learning_rate.decay_constant = (float)header->decay_constant;
+}
+
+/**
+ * @brief Write a file image next to the target, flush it to disk, and rename it into place,
+ *        so readers see either the previous file or the whole new one
+ *
+ * @param filename relative or abolsute path of the file to write
+ * @param image Bytes of the file
+ * @param size Number of bytes
+ *
+ * @return 0 if successful, -1 if failure
+ */
+static int writeFileAtomic(const char *filename, const unsigned char *image, size_t size)
+{
+    char temp_filename[PATH_MAX];
+    if (snprintf(temp_filename, sizeof(temp_filename), "%s.tmp", filename) >= (int)sizeof(temp_filename))
+    {
+        LOG_ERROR("Filename %s is too long.\n", filename);
+        return -1;
+    }
+
+    FILE *file = fopen(temp_filename, "wb");
+    if (!file)
+    {
+        LOG_ERROR("Error opening %s for writing.\n", temp_filename);
+        return -1;
+    }
+
+    bool written = fwrite(image, 1, size, file) == size;
+    written = written && fflush(file) == 0 && fsync(fileno(file)) == 0;
+    written = (fclose(file) == 0) && written;
+    if (!written || rename(temp_filename, filename) != 0)
+    {
+        remove(temp_filename);
+        return -1;
+    }
+
+    return 0;
+}
+
+/**
+ * @brief Save a trained model, and optionally its normalization statistics, to a binary file.
+ *        The file is written next to the target and renamed into place, so readers never see
+ *        a partially written model.
+ *
+ * @param model Trained Model object
+ * @param scaler Fitted Scaler used on the training features, NULL if none
+ * @param filename relative or abolsute path of the file to write
+ *
+ * @return 0 if successful, -1 if failure
+ */
+int saveModel(const Model *model, const Scaler *scaler, const char *filename)
+{
+    if (!model || !filename || !model->weights || !initialized_matrix(model->weights) || !model->bias || !initialized_vector(model->bias))
+    {
+        LOG_ERROR("Input model to save was not trained or the filename was NULL.\n");
+        return -1;
+    }
+
+    bool has_scaler = scaler && scaler->type != SCALE_NONE && scaler->center.data && scaler->scale.data;
+
+    ModelFileHeader header;
+    memset(&header, 0, sizeof(header));
+    memcpy(header.magic, MODEL_FILE_MAGIC, sizeof(header.magic));
+    header.version = MODEL_FILE_VERSION;
+    header.endian = MODEL_FILE_ENDIAN;
+    header.type = model->type;
+    header.func = model->func;
+    header.classes = model->classes;
+    header.batch_size = model->batch_size;
+    header.weight_rows = model->weights->rows;
+    header.weight_cols = model->weights->cols;
+    header.bias_size = model->bias->size;
+    header.epochs = model->config.epochs;
+    header.regularization = model->config.regularization;
+    header.decay_type = model->config.learning_rate.decay_type;
+    header.decay_step = model->config.learning_rate.decay_step;
+    header.optimizer = model->config.optimizer.type;
+    header.scaler_type = has_scaler ? scaler->type : SCALE_NONE;
+    header.scaler_cols = has_scaler ? scaler->center.size : 0;
+    header.scaler_samples = has_scaler ? scaler->samples : 0;
+    header.beta = model->beta;
+    header.lambda = model->config.lambda;
+    header.init_learning_rate = model->config.learning_rate.init_learning_rate;
+    header.min_learning_rate = model->config.learning_rate.min_learning_rate;
+    header.curr_learning_rate = model->config.learning_rate.curr_learning_rate;
+    header.max_epoch_cycle = model->config.learning_rate.max_epoch_cycle;
+    header.decay_constant = model->config.learning_rate.decay_constant;
+    header.l1_ratio = model->config.l1_ratio;
+    header.beta1 = model->config.optimizer.beta1;
+    header.beta2 = model->config.optimizer.beta2;
+    header.epsilon = model->config.optimizer.epsilon;
+    header.weight_decay = model->config.optimizer.weight_decay;
+
+    // Lay out the aligned sections
+    uint64_t offset = alignOffset(sizeof(header));
+    header.weights_offset = offset;
+    offset = alignOffset(offset + (uint64_t)header.weight_rows * header.weight_cols * sizeof(double));
+    header.bias_offset = offset;
+    offset = alignOffset(offset + (uint64_t)header.bias_size * sizeof(double));
+    if (has_scaler)
+    {
+        header.center_offset = offset;
+        offset = alignOffset(offset + (uint64_t)header.scaler_cols * sizeof(double));
+        header.scale_offset = offset;
+        offset = alignOffset(offset + (uint64_t)header.scaler_cols * sizeof(double));
+    }
+    header.file_size = offset;
+
+    // Build the whole image so the checksum can be computed before anything is written
+    unsigned char *image = calloc(header.file_size, 1);
+    if (!image)
+    {
+        LOG_ERROR("Failed to allocate %llu bytes for the model file.\n", (unsigned long long)header.file_size);
+        return -1;
+    }
+    memcpy(image + header.weights_offset, model->weights->data, (size_t)header.weight_rows * header.weight_cols * sizeof(double));
+    memcpy(image + header.bias_offset, model->bias->data, (size_t)header.bias_size * sizeof(double));
+    if (has_scaler)
+    {
+        memcpy(image + header.center_offset, scaler->center.data, (size_t)header.scaler_cols * sizeof(double));
+        memcpy(image + header.scale_offset, scaler->scale.data, (size_t)header.scaler_cols * sizeof(double));
+    }
+    memcpy(image, &header, sizeof(header));
+    header.checksum = computeFileChecksum(image, header.file_size, offsetof(ModelFileHeader, checksum));
+    memcpy(image, &header, sizeof(header));
+
+    int status = writeFileAtomic(filename, image, header.file_size);
+    free(image);
+    if (status < 0)
+    {
+        LOG_ERROR("Writing model file %s was unsuccessful.\n", filename);
+        return -1;
+    }
+
+    return 0;
+}
+
+/**
+ * @brief Map a model file read-only and point a Model at the mapped weights without copying.
+ *        The mapped Model must not be passed to freeModel, release it with unmapModel.
+ *
+ * @param mapped Pointer to MappedModel object to fill
+ * @param filename relative or abolsute path of the model file
+ *
+ * @return 0 if successful, -1 if failure
+ */
+int mapModel(MappedModel *mapped, const char *filename)
+{
+    if (!mapped || !filename)
+    {
+        LOG_ERROR("Input variables to map a model were not correct.\n");
+        return -1;
+    }
+
+    memset(mapped, 0, sizeof(MappedModel));
+
+    int fd = open(filename, O_RDONLY);
+    if (fd < 0)
+    {
+        LOG_ERROR("Error opening model file %s\n", filename);
+        return -1;
+    }
+
+    struct stat st;
+    if (fstat(fd, &st) != 0 || st.st_size <= 0)
+    {
+        LOG_ERROR("Could not get the size of model file %s\n", filename);
+        close(fd);
+        return -1;
+    }
+
+    void *base = mmap(NULL, (size_t)st.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+    close(fd);
+    if (base == MAP_FAILED)
+    {
+        LOG_ERROR("Could not map model file %s\n", filename);
+        return -1;
+    }
+
+    if (validateModelImage((const unsigned char *)base, (size_t)st.st_size) < 0)
+    {
+        LOG_ERROR("Model file %s failed validation.\n", filename);
+        munmap(base, (size_t)st.st_size);
+        return -1;
+    }
+
+    const ModelFileHeader *header = (const ModelFileHeader *)base;
+    unsigned char *bytes = (unsigned char *)base;
+
+    mapped->base = base;
+    mapped->size = (size_t)st.st_size;
+
+    mapped->weights.rows = header->weight_rows;
+    mapped->weights.cols = header->weight_cols;
+    mapped->weights.data = (double *)(bytes + header->weights_offset);
+    mapped->bias.size = header->bias_size;
+    mapped->bias.data = (double *)(bytes + header->bias_offset);
+
+    mapped->scaler = makeDefaultScaler((ScalerType)header->scaler_type);
+    if (header->scaler_type != SCALE_NONE)
+    {
+        mapped->scaler.samples = header->scaler_samples;
+        mapped->scaler.center.size = header->scaler_cols;
+        mapped->scaler.center.data = (double *)(bytes + header->center_offset);
+        mapped->scaler.scale.size = header->scaler_cols;
+        mapped->scaler.scale.data = (double *)(bytes + header->scale_offset);
+    }
+
+    mapped->model.config = makeDefaultConfig();
+    applyModelHeader(header, &mapped->model);
+    mapped->model.weights = &mapped->weights;
+    mapped->model.bias = &mapped->bias;
+
+    return 0;
+}
+
+/**
+ * @brief Release a mapped model
+ *
+ * @param mapped MappedModel to unmap
+ *
+ * @return None
+ */
+void unmapModel(MappedModel *mapped)
+{
+    if (mapped && mapped->base)
+    {
+        munmap(mapped->base, mapped->size);
+        memset(mapped, 0, sizeof(MappedModel));
+    }
+}
+
+/**
+ * @brief Load a model file into a Model object that owns its weights and bias
+ *
+ * @param model Pointer to Model object, initialized with initModel
+ * @param scaler Pointer to Scaler to receive the normalization statistics, NULL to skip
+ * @param filename relative or abolsute path of the model file
+ *
+ * @return 0 if successful, -1 if failure
+ */
+int loadModel(Model *model, Scaler *scaler, const char *filename)
+{
+    if (!model || !model->weights || !model->bias)
+    {
+        LOG_ERROR("Input model to load into was not initialized.\n");
+        return -1;
+    }
+
+    MappedModel mapped;
+    if (mapModel(&mapped, filename) < 0)
+    {
+        return -1;
+    }
+
+    const ModelFileHeader *header = (const ModelFileHeader *)mapped.base;
+    applyModelHeader(header, model);
+
+    freeMatrix(model->weights);
+    freeVector(model->bias);
+    if (makeMatrix(model->weights, mapped.weights.rows, mapped.weights.cols, mapped.weights.data, TYPE_DOUBLE) < 0 ||
+        makeVector(model->bias, mapped.bias.size, mapped.bias.data, TYPE_DOUBLE) < 0)
+    {
+        LOG_ERROR("Failed to allocate loaded model weights.\n");
+        unmapModel(&mapped);
+        return -1;
+    }
+
+    if (scaler)
+    {
+        freeScaler(scaler);
+        scaler->type = mapped.scaler.type;
+        scaler->samples = mapped.scaler.samples;
+        if (scaler->type != SCALE_NONE &&
+            (makeVector(&scaler->center, mapped.scaler.center.size, mapped.scaler.center.data, TYPE_DOUBLE) < 0 ||
+             makeVector(&scaler->scale, mapped.scaler.scale.size, mapped.scaler.scale.data, TYPE_DOUBLE) < 0))
+        {
+            LOG_ERROR("Failed to allocate loaded normalization statistics.\n");
+            unmapModel(&mapped);
+            return -1;
+        }
+    }
+
+    unmapModel(&mapped);
+
+    return 0;
+}
+
+/**
+ * @brief Lay out a checkpoint of a model and its optimizer state in one file image. The
+ *        checksum is left for the writer so the training thread only copies.
+ *
+ * @param model Model object being trained
+ * @param state Optimizer state that goes with the model's weights
+ * @param size Resulting size of the image
+ *
+ * @return Image to free with free(), NULL if failure
+ */
+static unsigned char *buildCheckpointImage(const Model *model, const OptimizerState *state, size_t *size)
+{
+    if (!model || !state || !model->weights || !initialized_matrix(model->weights) || !model->bias || !initialized_vector(model->bias) ||
+        !state->velocity_weights.data || !state->velocity_bias.data)
+    {
+        LOG_ERROR("Input model to checkpoint had no weights or optimizer state.\n");
+        return NULL;
+    }
+
+    bool has_square = state->square_weights.data && state->square_bias.data;
+    bool has_best = state->best_epoch > 0 && state->best_weights.data && state->best_bias.data;
+    const ModelConfig *config = &model->config;
+
+    CheckpointFileHeader header;
+    memset(&header, 0, sizeof(header));
+    memcpy(header.magic, CHECKPOINT_FILE_MAGIC, sizeof(header.magic));
+    header.version = CHECKPOINT_FILE_VERSION;
+    header.endian = MODEL_FILE_ENDIAN;
+    header.type = model->type;
+    header.func = model->func;
+    header.classes = model->classes;
+    header.batch_size = model->batch_size;
+    header.weight_rows = model->weights->rows;
+    header.weight_cols = model->weights->cols;
+    header.bias_size = model->bias->size;
+    header.epochs = config->epochs;
+    header.epoch = state->epoch;
+    header.regularization = config->regularization;
+    header.optimizer = config->optimizer.type;
+    header.has_square = has_square;
+    header.decay_type = config->learning_rate.decay_type;
+    header.decay_step = config->learning_rate.decay_step;
+    header.preallocate = config->preallocate;
+    header.patience = config->patience;
+    header.checkpoint_every = config->checkpoint_every;
+    header.best_epoch = has_best ? state->best_epoch : 0;
+    header.stale_epochs = state->stale_epochs;
+    header.stopped = state->stopped;
+    header.step = state->step;
+    header.stream = state->stream;
+    header.beta = model->beta;
+    header.lambda = config->lambda;
+    header.l1_ratio = config->l1_ratio;
+    header.beta1 = config->optimizer.beta1;
+    header.beta2 = config->optimizer.beta2;
+    header.epsilon = config->optimizer.epsilon;
+    header.weight_decay = config->optimizer.weight_decay;
+    header.init_learning_rate = config->learning_rate.init_learning_rate;
+    header.min_learning_rate = config->learning_rate.min_learning_rate;
+    header.curr_learning_rate = config->learning_rate.curr_learning_rate;
+    header.max_epoch_cycle = config->learning_rate.max_epoch_cycle;
+    header.decay_constant = config->learning_rate.decay_constant;
+    header.min_improvement = config->min_improvement;
+    header.grad_norm_tolerance = config->grad_norm_tolerance;
+    header.best_loss = state->best_loss;
+
+    // Lay out the aligned sections
+    uint64_t weight_bytes = (uint64_t)header.weight_rows * header.weight_cols * sizeof(double);
+    uint64_t bias_bytes = (uint64_t)header.bias_size * sizeof(double);
+    uint64_t offset = alignOffset(sizeof(header));
+    header.weights_offset = offset;
+    offset = alignOffset(offset + weight_bytes);
+    header.bias_offset = offset;
+    offset = alignOffset(offset + bias_bytes);
+    header.velocity_w_offset = offset;
+    offset = alignOffset(offset + weight_bytes);
+    header.velocity_b_offset = offset;
+    offset = alignOffset(offset + bias_bytes);
+    if (has_square)
+    {
+        header.square_w_offset = offset;
+        offset = alignOffset(offset + weight_bytes);
+        header.square_b_offset = offset;
+        offset = alignOffset(offset + bias_bytes);
+    }
+    if (has_best)
+    {
+        header.best_w_offset = offset;
+        offset = alignOffset(offset + weight_bytes);
+        header.best_b_offset = offset;
+        offset = alignOffset(offset + bias_bytes);
+    }
+    header.file_size = offset;
+
+    unsigned char *image = calloc(header.file_size, 1);
+    if (!image)
+    {
+        LOG_ERROR("Failed to allocate %llu bytes for the checkpoint.\n", (unsigned long long)header.file_size);
+        return NULL;
+    }
+    memcpy(image, &header, sizeof(header));
+    memcpy(image + header.weights_offset, model->weights->data, weight_bytes);
+    memcpy(image + header.bias_offset, model->bias->data, bias_bytes);
+    memcpy(image + header.velocity_w_offset, state->velocity_weights.data, weight_bytes);
+    memcpy(image + header.velocity_b_offset, state->velocity_bias.data, bias_bytes);
+    if (has_square)
+    {
+        memcpy(image + header.square_w_offset, state->square_weights.data, weight_bytes);
+        memcpy(image + header.square_b_offset, state->square_bias.data, bias_bytes);
+    }
+    if (has_best)
+    {
+        memcpy(image + header.best_w_offset, state->best_weights.data, weight_bytes);
+        memcpy(image + header.best_b_offset, state->best_bias.data, bias_bytes);
+    }
+
+    *size = header.file_size;
+    return image;
+}
+
+/**
+ * @brief Checksum a checkpoint image and write it atomically
+ *
+ * @param image Image from buildCheckpointImage
+ * @param size Size of the image
+ * @param filename relative or abolsute path of the checkpoint file
+ *
+ * @return 0 if successful, -1 if failure
+ */
+static int writeCheckpointImage(unsigned char *image, size_t size, const char *filename)
+{
+    uint64_t checksum = computeFileChecksum(image, size, offsetof(CheckpointFileHeader, checksum));
+    memcpy(image + offsetof(CheckpointFileHeader, checksum), &checksum, sizeof(checksum));
+
+    if (writeFileAtomic(filename, image, size) < 0)
+    {
+        LOG_ERROR("Writing checkpoint %s was unsuccessful.\n", filename);
+        return -1;
+    }
+
+    return 0;
+}
+
+/**
+ * @brief Save a model and its optimizer state to a checkpoint file, replaced atomically
+ *
+ * @param model Model object being trained
+ * @param state Optimizer state that goes with the model's weights
+ * @param filename relative or abolsute path of the checkpoint file
+ *
+ * @return 0 if successful, -1 if failure
+ */
+int saveCheckpoint(const Model *model, const OptimizerState *state, const char *filename)
+{
+    if (!filename)
+    {
+        LOG_ERROR("Checkpoint filename was NULL.\n");
+        return -1;
+    }
+
+    size_t size = 0;
+    unsigned char *image = buildCheckpointImage(model, state, &size);
+    if (!image)
+    {
+        return -1;
+    }
+    int status = writeCheckpointImage(image, size, filename);
+    free(image);
+
+    return status;
+}
+
+/**
+ * @brief Validate a checkpoint image: magic, version, byte order, sizes, and checksum
+ *
+ * @param base Start of the file image
+ * @param size Size of the file image
+ *
+ * @return 0 if valid, -1 otherwise
+ */
+static int validateCheckpointImage(const unsigned char *base, size_t size)
+{
+    if (size < sizeof(CheckpointFileHeader))
+    {
+        LOG_ERROR("Checkpoint is too small to hold a header.\n");
+        return -1;
+    }
+
+    CheckpointFileHeader header;
+    memcpy(&header, base, sizeof(header));
+    if (memcmp(header.magic, CHECKPOINT_FILE_MAGIC, sizeof(header.magic)) != 0)
+    {
+        LOG_ERROR("File is not a checkpoint.\n");
+        return -1;
+    }
+    if (header.version != CHECKPOINT_FILE_VERSION)
+    {
+        LOG_ERROR("Checkpoint version %u is not supported, expected %d.\n", header.version, CHECKPOINT_FILE_VERSION);
+        return -1;
+    }
+    if (header.endian != MODEL_FILE_ENDIAN)
+    {
+        LOG_ERROR("Checkpoint was written on a machine with a different byte order.\n");
+        return -1;
+    }
+    if (header.file_size != size)
+    {
+        LOG_ERROR("Checkpoint is %zu bytes, header says %llu. File is truncated.\n", size, (unsigned long long)header.file_size);
+        return -1;
+    }
+
+    uint64_t weights = 0;
+    uint64_t bias = (uint64_t)header.bias_size;
+    if (!weightCount(header.weight_rows, header.weight_cols, &weights) || header.bias_size <= 0 || header.epoch < 0 ||
+        header.best_epoch < 0 || header.stale_epochs < 0 || header.weights_offset < sizeof(CheckpointFileHeader) ||
+        !validSection(header.weights_offset, weights, size) || !validSection(header.bias_offset, bias, size) ||
+        !validSection(header.velocity_w_offset, weights, size) || !validSection(header.velocity_b_offset, bias, size) ||
+        (header.has_square && (!validSection(header.square_w_offset, weights, size) || !validSection(header.square_b_offset, bias, size))) ||
+        (header.best_epoch > 0 && (!validSection(header.best_w_offset, weights, size) || !validSection(header.best_b_offset, bias, size))))
+    {
+        LOG_ERROR("Checkpoint sections are invalid.\n");
+        return -1;
+    }
+    if (computeFileChecksum(base, size, offsetof(CheckpointFileHeader, checksum)) != header.checksum)
+    {
+        LOG_ERROR("Checkpoint checksum does not match, file is corrupt.\n");
+        return -1;
+    }
+
+    return 0;
+}
+
+/**
+ * @brief Copy a section of doubles out of a checkpoint into a new Matrix
+ *
+ * @param base Start of the file image
+ * @param offset Byte offset of the section
+ * @param rows Rows of the Matrix
+ * @param cols Columns of the Matrix
+ * @param m Matrix to fill, any previous data is freed
+ *
+ * @return 0 if successful, -1 if failure
+ */
+static int readCheckpointMatrix(const unsigned char *base, uint64_t offset, int rows, int cols, Matrix *m)
+{
+    freeMatrix(m);
+    return makeMatrix(m, rows, cols, (void *)(base + offset), TYPE_DOUBLE);
+}
+
+/**
+ * @brief Copy a section of doubles out of a checkpoint into a new Vector
+ *
+ * @param base Start of the file image
+ * @param offset Byte offset of the section
+ * @param size Size of the Vector
+ * @param v Vector to fill, any previous data is freed
+ *
+ * @return 0 if successful, -1 if failure
+ */
+static int readCheckpointVector(const unsigned char *base, uint64_t offset, int size, Vector *v)
+{
+    freeVector(v);
+    return makeVector(v, size, (void *)(base + offset), TYPE_DOUBLE);
+}
+
+/**
+ * @brief Load a checkpoint into a Model object: its weights, bias, optimizer state, early
+ *        stopping state, learning rate schedule and shuffle stream, and the configuration that
+ *        shapes the updates and when training stops. config.checkpoint_path is left as it was.
+ *        Set the training data and call resumeModel to carry on exactly where it stopped.
+ *
+ * @param model Pointer to Model object, initialized with initModel
+ * @param filename relative or abolsute path of the checkpoint file
+ *
+ * @return 0 if successful, -1 if failure
+ */
+int loadCheckpoint(Model *model, const char *filename)
+{
+    if (!model || !model->weights || !model->bias || !filename)
+    {
+        LOG_ERROR("Input model to load a checkpoint into was not initialized.\n");
+        return -1;
+    }
+
+    int fd = open(filename, O_RDONLY);
+    if (fd < 0)
+    {
+        LOG_ERROR("Error opening checkpoint %s\n", filename);
+        return -1;
+    }
+    struct stat st;
+    if (fstat(fd, &st) != 0 || st.st_size <= 0)
+    {
+        LOG_ERROR("Could not get the size of checkpoint %s\n", filename);
+        close(fd);
+        return -1;
+    }
+    void *base = mmap(NULL, (size_t)st.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+    close(fd);
+    if (base == MAP_FAILED)
+    {
+        LOG_ERROR("Could not map checkpoint %s\n", filename);
+        return -1;
+    }
+    const unsigned char *bytes = (const unsigned char *)base;
+    if (validateCheckpointImage(bytes, (size_t)st.st_size) < 0)
+    {
+        LOG_ERROR("Checkpoint %s failed validation.\n", filename);
+        munmap(base, (size_t)st.st_size);
+        return -1;
+    }
+
+    CheckpointFileHeader header;
+    memcpy(&header, bytes, sizeof(header));
+    model->type = (RegressionType)header.type;
+    model->func = (Activation)header.func;
+    model->classes = header.classes;
+    model->batch_size = header.batch_size;
+    model->beta = header.beta;
+
+    ModelConfig *config = &model->config;
+    config->epochs = header.epochs;
+    config->lambda = header.lambda;
+    config->regularization = (RegularizationType)header.regularization;
+    config->l1_ratio = header.l1_ratio;
+    config->preallocate = header.preallocate;
+    config->solver = SOLVER_GRADIENT_DESCENT;
+    config->hogwild = false;
+    config->patience = header.patience;
+    config->min_improvement = header.min_improvement;
+    config->grad_norm_tolerance = header.grad_norm_tolerance;
+    config->checkpoint_every = header.checkpoint_every;
+    config->optimizer.type = (OptimizerType)header.optimizer;
+    config->optimizer.beta1 = header.beta1;
+    config->optimizer.beta2 = header.beta2;
+    config->optimizer.epsilon = header.epsilon;
+    config->optimizer.weight_decay = header.weight_decay;
+    config->learning_rate.init_learning_rate = header.init_learning_rate;
+    config->learning_rate.min_learning_rate = header.min_learning_rate;
+    config->learning_rate.curr_learning_rate = header.curr_learning_rate;
+    config->learning_rate.max_epoch_cycle = header.max_epoch_cycle;
+    config->learning_rate.decay_type = (DecayType)header.decay_type;
+    config->learning_rate.decay_step = header.decay_step;
+    config->learning_rate.decay_constant = (float)header.decay_constant;
+
+    OptimizerState *state = &model->state;
+    freeOptimizerState(state);
+    int rows = header.weight_rows;
+    int cols = header.weight_cols;
+    int status = 0;
+    if (readCheckpointMatrix(bytes, header.weights_offset, rows, cols, model->weights) < 0 ||
+        readCheckpointVector(bytes, header.bias_offset, header.bias_size, model->bias) < 0 ||
+        readCheckpointMatrix(bytes, header.velocity_w_offset, rows, cols, &state->velocity_weights) < 0 ||
+        readCheckpointVector(bytes, header.velocity_b_offset, header.bias_size, &state->velocity_bias) < 0 ||
+        (header.has_square && (readCheckpointMatrix(bytes, header.square_w_offset, rows, cols, &state->square_weights) < 0 ||
+                               readCheckpointVector(bytes, header.square_b_offset, header.bias_size, &state->square_bias) < 0)) ||
+        (header.best_epoch > 0 && (readCheckpointMatrix(bytes, header.best_w_offset, rows, cols, &state->best_weights) < 0 ||
+                                   readCheckpointVector(bytes, header.best_b_offset, header.bias_size, &state->best_bias) < 0)))
+    {
+        LOG_ERROR("Failed to allocate the state of checkpoint %s.\n", filename);
+        freeOptimizerState(state);
+        status = -1;
+    }
+    else
+    {
+        state->step = header.step;
+        state->epoch = header.epoch;
+        state->stream = header.stream;
+        state->best_loss = header.best_loss;
+        state->best_epoch = header.best_epoch;
+        state->stale_epochs = header.stale_epochs;
+        state->stopped = header.stopped;
+    }
+
+    munmap(base, (size_t)st.st_size);
+    return status;
+}
+
+/**
+ * @brief Writer thread, writes every image handed to it until asked to stop
+ *
+ * @param args CheckpointWriter object
+ *
+ * @return NULL
+ */
+static void *checkpointMain(void *args)
+{
+    CheckpointWriter *writer = (CheckpointWriter *)args;
+    pthread_mutex_lock(&writer->lock);
+    while (true)
+    {
+        while (!writer->pending && !writer->stopping)
+        {
+            pthread_cond_wait(&writer->wake, &writer->lock);
+        }
+        if (!writer->pending)
+        {
+            break;
+        }
+
+        unsigned char *image = writer->pending;
+        size_t size = writer->pending_size;
+        writer->pending = NULL;
+        pthread_mutex_unlock(&writer->lock);
+
+        int status = writeCheckpointImage(image, size, writer->filename);
+        free(image);
+
+        pthread_mutex_lock(&writer->lock);
+        if (status < 0)
+        {
+            ++writer->failed;
+        }
+        else
+        {
+            ++writer->written;
+        }
+        writer->busy = false;
+        pthread_cond_broadcast(&writer->idle);
+    }
+    pthread_mutex_unlock(&writer->lock);
+
+    return NULL;
+}
+
+/**
+ * @brief Start a background checkpoint writer. Checkpoints are written by the caller when no
+ *        thread can be started.
+ *
+ * @param writer CheckpointWriter object to start
+ * @param filename relative or abolsute path of the checkpoint file
+ *
+ * @return 0 if successful, -1 if failure
+ */
+int startCheckpointWriter(CheckpointWriter *writer, const char *filename)
+{
+    if (!writer || !filename)
+    {
+        LOG_ERROR("Input variables to start the checkpoint writer were not correct.\n");
+        return -1;
+    }
+
+    memset(writer, 0, sizeof(CheckpointWriter));
+    if (snprintf(writer->filename, sizeof(writer->filename), "%s", filename) >= (int)sizeof(writer->filename))
+    {
+        LOG_ERROR("Checkpoint filename %s is too long.\n", filename);
+        return -1;
+    }
+
+    pthread_mutex_init(&writer->lock, NULL);
+    pthread_cond_init(&writer->wake, NULL);
+    pthread_cond_init(&writer->idle, NULL);
+    writer->has_thread = pthread_create(&writer->thread, NULL, checkpointMain, writer) == 0;
+    if (!writer->has_thread)
+    {
+        LOG_WARN("Could not start checkpoint thread, writing checkpoints inline.\n");
+    }
+
+    return 0;
+}
+
+/**
+ * @brief Hand a checkpoint of the model and its optimizer state to the writer. Only the copy
+ *        into the file image happens on the calling thread. While the previous checkpoint is
+ *        still being written this one is skipped, unless wait is set.
+ *
+ * @param writer CheckpointWriter object
+ * @param model Model object being trained
+ * @param state Optimizer state that goes with the model's weights
+ * @param wait Block until the previous checkpoint is written instead of skipping
+ *
+ * @return 0 if handed over, 1 if skipped, -1 if failure
+ */
+int submitCheckpoint(CheckpointWriter *writer, const Model *model, const OptimizerState *state, bool wait)
+{
+    if (!writer)
+    {
+        LOG_ERROR("Checkpoint writer was NULL.\n");
+        return -1;
+    }
+
+    pthread_mutex_lock(&writer->lock);
+    while (writer->busy && wait)
+    {
+        pthread_cond_wait(&writer->idle, &writer->lock);
+    }
+    bool busy = writer->busy;
+    pthread_mutex_unlock(&writer->lock);
+    if (busy)
+    {
+        LOG_DEBUG("Previous checkpoint is still being written, skipping epoch %d.\n", state ? state->epoch : 0);
+        return 1;
+    }
+
+    size_t size = 0;
+    unsigned char *image = buildCheckpointImage(model, state, &size);
+    if (!image)
+    {
+        return -1;
+    }
+
+    if (!writer->has_thread)
+    {
+        int status = writeCheckpointImage(image, size, writer->filename);
+        free(image);
+        if (status < 0)
+        {
+            ++writer->failed;
+        }
+        else
+        {
+            ++writer->written;
+        }
+        return status;
+    }
+
+    pthread_mutex_lock(&writer->lock);
+    writer->pending = image;
+    writer->pending_size = size;
+    writer->busy = true;
+    pthread_cond_signal(&writer->wake);
+    pthread_mutex_unlock(&writer->lock);
+
+    return 0;
+}
+
+/**
+ * @brief Wait for the last checkpoint to be written and stop the writer
+ *
+ * @param writer CheckpointWriter object
+ *
+ * @return 0 if every handed over checkpoint was written, -1 otherwise
+ */
+int stopCheckpointWriter(CheckpointWriter *writer)
+{
+    if (!writer)
+    {
+        return -1;
+    }
+
+    if (writer->has_thread)
+    {
+        pthread_mutex_lock(&writer->lock);
+        writer->stopping = true;
+        pthread_cond_signal(&writer->wake);
+        pthread_mutex_unlock(&writer->lock);
+        pthread_join(writer->thread, NULL);
+        writer->has_thread = false;
+    }
+    pthread_mutex_destroy(&writer->lock);
+    pthread_cond_destroy(&writer->wake);
+    pthread_cond_destroy(&writer->idle);
+
+    return (writer->failed > 0) ? -1 : 0;
+}
@@ -0,0 +1,384 @@
+/*
+ * file: prefetch.c
+ * description: double-buffered mini-batch pipeline used by the model trainer
+ * author: Ryan Wagner
+ * date: October 19, 2026
+ * notes: a producer thread shuffles and gathers batch b+1 into a free slot while the trainer
+ *        runs the forward and backward pass on batch b, the ring depth bounds how far ahead it runs
+ */
+
+#include "../header/prefetch.h"
+
+/**
+ * @brief Gather the next mini-batch into a slot and advance the producer position
+ *
+ * @param prefetcher BatchPrefetcher object
+ * @param slot Index of the free slot to fill
+ *
+ * @return 0 if successful, -1 if failure
+ */
+static int gatherNextBatch(BatchPrefetcher *prefetcher, int slot)
+{
+    // New epoch, reshuffle the row order from a stream of its own, so the order of an epoch only
+    // depends on the seed and the epoch number
+    if (prefetcher->next_batch == 0)
+    {
+        seedRandom(&prefetcher->rng, prefetcher->stream + (uint64_t)prefetcher->next_epoch * PREFETCH_EPOCH_STRIDE);
+        if (shufflePermutation(prefetcher->perm_arr, prefetcher->rows, &prefetcher->rng) < 0)
+        {
+            LOG_ERROR("Creating random permutation for input shuffling was unsuccessful.\n");
+            return -1;
+        }
+
+        // Shuffle positions in the index set, then read the rows they stand for
+        if (prefetcher->row_idx)
+        {
+            for (int i = 0; i < prefetcher->rows; ++i)
+            {
+                prefetcher->perm_arr[i] = prefetcher->row_idx[prefetcher->perm_arr[i]];
+            }
+        }
+    }
+
+    int start = prefetcher->next_batch * prefetcher->batch_size;
+    int rows = prefetcher->rows - start;
+    if (rows > prefetcher->batch_size)
+    {
+        rows = prefetcher->batch_size;
+    }
+
+    // Slots are allocated for a full batch, the last batch only uses the first rows
+    Matrix *mini_X = &prefetcher->mini_X[slot];
+    Matrix *mini_y = &prefetcher->mini_y[slot];
+    mini_X->rows = rows;
+    mini_y->rows = rows;
+    int status = prefetcher->table ? gatherTypedRows(prefetcher->table, prefetcher->perm_arr + start, rows, mini_X)
+                                   : gatherRows(prefetcher->X, prefetcher->perm_arr + start, rows, mini_X);
+    if (status < 0 || gatherRows(prefetcher->y, prefetcher->perm_arr + start, rows, mini_y) < 0)
+    {
+        LOG_ERROR("Creation of prefetched mini-batch was unsuccessful.\n");
+        return -1;
+    }
+
+    if (++prefetcher->next_batch == prefetcher->batches)
+    {
+        prefetcher->next_batch = 0;
+        ++prefetcher->next_epoch;
+    }
+
+    return 0;
+}
+
+/**
+ * @brief Producer thread, fills free slots until every epoch is gathered or the consumer stops
+ *
+ * @param args BatchPrefetcher object
+ *
+ * @return NULL
+ */
+static void *prefetchMain(void *args)
+{
+    BatchPrefetcher *prefetcher = (BatchPrefetcher *)args;
+
+    pthread_mutex_lock(&prefetcher->lock);
+    while (!prefetcher->closing && prefetcher->next_epoch < prefetcher->epochs)
+    {
+        while (prefetcher->ready + prefetcher->in_use == prefetcher->depth && !prefetcher->closing)
+        {
+            pthread_cond_wait(&prefetcher->not_full, &prefetcher->lock);
+        }
+        if (prefetcher->closing)
+        {
+            break;
+        }
+
+        // Gather outside the lock so the consumer can keep taking ready batches
+        int slot = prefetcher->head;
+        pthread_mutex_unlock(&prefetcher->lock);
+        int status = gatherNextBatch(prefetcher, slot);
+        pthread_mutex_lock(&prefetcher->lock);
+
+        if (status < 0)
+        {
+            prefetcher->failed = true;
+            break;
+        }
+        prefetcher->head = (prefetcher->head + 1) % prefetcher->depth;
+        ++prefetcher->ready;
+        pthread_cond_signal(&prefetcher->not_empty);
+    }
+    prefetcher->done = true;
+    pthread_cond_broadcast(&prefetcher->not_empty);
+    pthread_mutex_unlock(&prefetcher->lock);
+
+    return NULL;
+}
+
+/**
+ * @brief Allocate the batch slots and start the producer thread once the source is set
+ *
+ * @param prefetcher BatchPrefetcher object with X or table, y, and rows set
+ * @param cols Number of feature columns
+ * @param batch_size Rows per mini-batch
+ * @param epochs Number of passes over the data
+ * @param depth Number of batch slots, 1 gathers inline without a thread
+ * @param seed Seed of the shuffles, 0 to fork a stream from the calling thread
+ *
+ * @return 0 if successful, -1 if failure
+ */
+static int launchPrefetcher(BatchPrefetcher *prefetcher, int cols, int batch_size, int epochs, int depth, uint64_t seed)
+{
+    int rows = prefetcher->rows;
+    prefetcher->batch_size = (batch_size < rows) ? batch_size : rows;
+    prefetcher->batches = (rows + prefetcher->batch_size - 1) / prefetcher->batch_size;
+    prefetcher->epochs = epochs;
+    prefetcher->depth = (depth < 1) ? 1 : (depth > PREFETCH_MAX_DEPTH) ? PREFETCH_MAX_DEPTH : depth;
+    pthread_mutex_init(&prefetcher->lock, NULL);
+    pthread_cond_init(&prefetcher->not_empty, NULL);
+    pthread_cond_init(&prefetcher->not_full, NULL);
+    initRandomStream(&prefetcher->rng, seed);
+    prefetcher->stream = (seed != 0) ? seed : nextRandom(&prefetcher->rng);
+
+    prefetcher->perm_arr = (int *)calloc(rows, sizeof(int));
+    if (!prefetcher->perm_arr)
+    {
+        LOG_ERROR("Could not allocate the prefetch permutation array.\n");
+        stopPrefetcher(prefetcher);
+        return -1;
+    }
+
+    for (int s = 0; s < prefetcher->depth; ++s)
+    {
+        if (makeMatrixZeros(&prefetcher->mini_X[s], prefetcher->batch_size, cols) < 0 ||
+            makeMatrixZeros(&prefetcher->mini_y[s], prefetcher->batch_size, prefetcher->y.cols) < 0)
+        {
+            LOG_ERROR("Could not allocate prefetch batch slot %d.\n", s);
+            stopPrefetcher(prefetcher);
+            return -1;
+        }
+    }
+
+    if (prefetcher->depth > 1)
+    {
+        if (pthread_create(&prefetcher->producer, NULL, prefetchMain, prefetcher) == 0)
+        {
+            prefetcher->has_producer = true;
+        }
+        else
+        {
+            LOG_WARN("Could not start prefetch thread, gathering mini-batches inline.\n");
+        }
+    }
+
+    return 0;
+}
+
+/**
+ * @brief Allocate the batch slots and start gathering batches for every epoch
+ *
+ * @param prefetcher BatchPrefetcher object to start
+ * @param X Training features, must stay valid until stopPrefetcher
+ * @param y Training labels with the same number of rows as X
+ * @param batch_size Rows per mini-batch
+ * @param epochs Number of passes over the data
+ * @param depth Number of batch slots, 1 gathers inline without a thread
+ * @param seed Seed of the shuffles, 0 to fork a stream from the calling thread
+ *
+ * @return 0 if successful, -1 if failure
+ */
+int startPrefetcher(BatchPrefetcher *prefetcher, Matrix X, Matrix y, int batch_size, int epochs, int depth, uint64_t seed)
+{
+    if (!prefetcher || !X.data || !y.data || X.rows != y.rows || X.rows <= 0 || batch_size <= 0 || epochs <= 0)
+    {
+        LOG_ERROR("Input variables to start the batch prefetcher were not correct.\n");
+        return -1;
+    }
+
+    memset(prefetcher, 0, sizeof(BatchPrefetcher));
+    prefetcher->X = X;
+    prefetcher->y = y;
+    prefetcher->rows = X.rows;
+
+    return launchPrefetcher(prefetcher, X.cols, batch_size, epochs, depth, seed);
+}
+
+/**
+ * @brief Start gathering batches from a subset of the rows of X and y, which are read in place
+ *        so training on one fold of a dataset needs no copy of its rows
+ *
+ * @param prefetcher BatchPrefetcher object to start
+ * @param X Features, must stay valid until stopPrefetcher
+ * @param y Labels with the same number of rows as X
+ * @param row_idx Integer array of n rows of X to train on, must stay valid until stopPrefetcher
+ * @param n Number of rows in row_idx
+ * @param batch_size Rows per mini-batch
+ * @param epochs Number of passes over the rows
+ * @param depth Number of batch slots, 1 gathers inline without a thread
+ * @param seed Seed of the shuffles, 0 to fork a stream from the calling thread
+ *
+ * @return 0 if successful, -1 if failure
+ */
+int startIndexedPrefetcher(BatchPrefetcher *prefetcher, Matrix X, Matrix y, const int *row_idx, int n, int batch_size, int epochs, int depth,
+                           uint64_t seed)
+{
+    if (!prefetcher || !X.data || !y.data || !row_idx || X.rows != y.rows || n <= 0 || batch_size <= 0 || epochs <= 0)
+    {
+        LOG_ERROR("Input variables to start the indexed batch prefetcher were not correct.\n");
+        return -1;
+    }
+    for (int i = 0; i < n; ++i)
+    {
+        if (row_idx[i] < 0 || row_idx[i] >= X.rows)
+        {
+            LOG_ERROR("Row index %d is outside of the training features.\n", row_idx[i]);
+            return -1;
+        }
+    }
+
+    memset(prefetcher, 0, sizeof(BatchPrefetcher));
+    prefetcher->X = X;
+    prefetcher->y = y;
+    prefetcher->row_idx = row_idx;
+    prefetcher->rows = n;
+
+    return launchPrefetcher(prefetcher, X.cols, batch_size, epochs, depth, seed);
+}
+
+/**
+ * @brief Start gathering batches from a compact TypedTable, every batch is widened to double
+ *        on the producer thread so the trainer only ever sees dense double mini-batches
+ *
+ * @param prefetcher BatchPrefetcher object to start
+ * @param X Training features, must stay valid until stopPrefetcher
+ * @param y Training labels with the same number of rows as X
+ * @param batch_size Rows per mini-batch
+ * @param epochs Number of passes over the data
+ * @param depth Number of batch slots, 1 gathers inline without a thread
+ * @param seed Seed of the shuffles, 0 to fork a stream from the calling thread
+ *
+ * @return 0 if successful, -1 if failure
+ */
+int startTypedPrefetcher(BatchPrefetcher *prefetcher, const TypedTable *X, Matrix y, int batch_size, int epochs, int depth, uint64_t seed)
+{
+    if (!prefetcher || !X || !X->columns || !y.data || X->rows != y.rows || X->rows <= 0 || batch_size <= 0 || epochs <= 0)
+    {
+        LOG_ERROR("Input variables to start the typed batch prefetcher were not correct.\n");
+        return -1;
+    }
+
+    memset(prefetcher, 0, sizeof(BatchPrefetcher));
+    prefetcher->table = X;
+    prefetcher->y = y;
+    prefetcher->rows = X->rows;
+
+    return launchPrefetcher(prefetcher, X->cols, batch_size, epochs, depth, seed);
+}
+
+/**
+ * @brief Take the next mini-batch, blocking until the producer has gathered it.
+ *        The batch stays valid until releaseBatch is called.
+ *
+ * @param prefetcher BatchPrefetcher object
+ * @param mini_X Set to the gathered features
+ * @param mini_y Set to the gathered labels
+ *
+ * @return 0 if successful, -1 if failure or no batches are left
+ */
+int acquireBatch(BatchPrefetcher *prefetcher, Matrix **mini_X, Matrix **mini_y)
+{
+    if (!prefetcher || !mini_X || !mini_y || prefetcher->in_use > 0)
+    {
+        LOG_ERROR("Input variables to acquire a mini-batch were not correct.\n");
+        return -1;
+    }
+
+    if (!prefetcher->has_producer)
+    {
+        if (prefetcher->next_epoch >= prefetcher->epochs || gatherNextBatch(prefetcher, prefetcher->tail) < 0)
+        {
+            LOG_ERROR("No mini-batch could be gathered.\n");
+            return -1;
+        }
+        prefetcher->in_use = 1;
+    }
+    else
+    {
+        pthread_mutex_lock(&prefetcher->lock);
+        while (prefetcher->ready == 0 && !prefetcher->done)
+        {
+            pthread_cond_wait(&prefetcher->not_empty, &prefetcher->lock);
+        }
+        if (prefetcher->ready == 0)
+        {
+            pthread_mutex_unlock(&prefetcher->lock);
+            LOG_ERROR("No mini-batch was left to acquire from the prefetcher.\n");
+            return -1;
+        }
+        // Mark the slot held under the lock so the producer never refills it early
+        --prefetcher->ready;
+        prefetcher->in_use = 1;
+        pthread_mutex_unlock(&prefetcher->lock);
+    }
+
+    *mini_X = &prefetcher->mini_X[prefetcher->tail];
+    *mini_y = &prefetcher->mini_y[prefetcher->tail];
+
+    return 0;
+}
+
+/**
+ * @brief Hand the last acquired mini-batch slot back to the producer
+ *
+ * @param prefetcher BatchPrefetcher object
+ *
+ * @return None
+ */
+void releaseBatch(BatchPrefetcher *prefetcher)
+{
+    if (!prefetcher || prefetcher->in_use == 0)
+    {
+        return;
+    }
+
+    pthread_mutex_lock(&prefetcher->lock);
+    prefetcher->tail = (prefetcher->tail + 1) % prefetcher->depth;
+    prefetcher->in_use = 0;
+    pthread_cond_signal(&prefetcher->not_full);
+    pthread_mutex_unlock(&prefetcher->lock);
+}
+
+/**
+ * @brief Stop the producer thread and free the batch slots, call once for every successful start
+ *
+ * @param prefetcher BatchPrefetcher object
+ *
+ * @return None
+ */
+void stopPrefetcher(BatchPrefetcher *prefetcher)
+{
+    if (!prefetcher)
+    {
+        return;
+    }
+
+    if (prefetcher->has_producer)
+    {
+        pthread_mutex_lock(&prefetcher->lock);
+        prefetcher->closing = true;
+        pthread_cond_broadcast(&prefetcher->not_full);
+        pthread_mutex_unlock(&prefetcher->lock);
+        pthread_join(prefetcher->producer, NULL);
+        prefetcher->has_producer = false;
+    }
+    pthread_mutex_destroy(&prefetcher->lock);
+    pthread_cond_destroy(&prefetcher->not_empty);
+    pthread_cond_destroy(&prefetcher->not_full);
+
+    for (int s = 0; s < PREFETCH_MAX_DEPTH; ++s)
+    {
+        freeMatrix(&prefetcher->mini_X[s]);
+        freeMatrix(&prefetcher->mini_y[s]);
+    }
+    free(prefetcher->perm_arr);
+    prefetcher->perm_arr = NULL;
+}
@@ -0,0 +1,328 @@
+/*
+ * file: random.c
+ * description: seedable xoshiro256** generator, per-thread streams, and unbiased shuffles
+ * author: Ryan Wagner
+ * date: October 19, 2026
+ * notes: thread streams are cut from one sequence with the 2^192 jump and the forks of a thread
+ *        with the 2^128 jump, so two streams never overlap and every thread can draw without
+ *        locking
+ */
+
+#include <stdatomic.h>
+#include <time.h>
+
+#include "../header/random.h"
+
+#define SHUFFLE_LOOKAHEAD 16
+
+// Process-wide source the per-thread streams are cut from
+static pthread_mutex_t SOURCE_LOCK = PTHREAD_MUTEX_INITIALIZER;
+static RandomState SOURCE;
+static atomic_uint SOURCE_GENERATION = 0;
+
+// Stream of the calling thread, retaken whenever setRandomSeed bumps the generation
+static _Thread_local RandomState THREAD_STATE;
+static _Thread_local unsigned THREAD_GENERATION = 0;
+
+/**
+ * @brief SplitMix64 step, spreads the bits of a seed over a full 64 bit word
+ *
+ * @param x State to advance
+ *
+ * @return Next output
+ */
+static uint64_t splitMix64(uint64_t *x)
+{
+    uint64_t z = (*x += 0x9E3779B97F4A7C15ULL);
+    z = (z ^ (z >> 30)) * 0xBF58476D1CE4E5B9ULL;
+    z = (z ^ (z >> 27)) * 0x94D049BB133111EBULL;
+    return z ^ (z >> 31);
+}
+
+/**
+ * @brief Rotate a 64 bit word left
+ *
+ * @param x Word to rotate
+ * @param k Bits to rotate by
+ *
+ * @return Rotated word
+ */
+static inline uint64_t rotl(uint64_t x, int k)
+{
+    return (x << k) | (x >> (64 - k));
+}
+
+/**
+ * @brief Seed a generator, equal seeds always give equal sequences
+ *
+ * @param rng RandomState to seed
+ * @param seed Any 64 bit value, 0 included
+ *
+ * @return None
+ */
+void seedRandom(RandomState *rng, uint64_t seed)
+{
+    for (int i = 0; i < 4; ++i)
+    {
+        rng->s[i] = splitMix64(&seed);
+    }
+}
+
+/**
+ * @brief Next 64 random bits
+ *
+ * @param rng RandomState to advance
+ *
+ * @return Random 64 bit word
+ */
+uint64_t nextRandom(RandomState *rng)
+{
+    uint64_t *s = rng->s;
+    uint64_t result = rotl(s[1] * 5, 7) * 9;
+    uint64_t t = s[1] << 17;
+
+    s[2] ^= s[0];
+    s[3] ^= s[1];
+    s[1] ^= s[2];
+    s[0] ^= s[3];
+    s[2] ^= t;
+    s[3] = rotl(s[3], 45);
+
+    return result;
+}
+
+/**
+ * @brief Unbiased random integer in [0, bound) with Lemire's multiply-shift method,
+ *        which only redraws on the rare low products that would skew the result
+ *
+ * @param rng RandomState to advance
+ * @param bound Exclusive upper bound
+ *
+ * @return Random integer in [0, bound), 0 when bound is 0
+ */
+uint32_t randomBounded(RandomState *rng, uint32_t bound)
+{
+    if (bound == 0)
+    {
+        return 0;
+    }
+
+    uint64_t m = (nextRandom(rng) >> 32) * (uint64_t)bound;
+    uint32_t low = (uint32_t)m;
+    if (low < bound)
+    {
+        uint32_t threshold = (0u - bound) % bound;
+        while (low < threshold)
+        {
+            m = (nextRandom(rng) >> 32) * (uint64_t)bound;
+            low = (uint32_t)m;
+        }
+    }
+
+    return (uint32_t)(m >> 32);
+}
+
+/**
+ * @brief Random double in [0, 1) with 53 random bits
+ *
+ * @param rng RandomState to advance
+ *
+ * @return Random double in [0, 1)
+ */
+double randomUniform(RandomState *rng)
+{
+    return (double)(nextRandom(rng) >> 11) * 0x1.0p-53;
+}
+
+/**
+ * @brief Advance a generator by the jump polynomial of a xoshiro256** jump table
+ *
+ * @param rng RandomState to advance
+ * @param table Jump polynomial, four 64 bit words
+ *
+ * @return None
+ */
+static void applyJump(RandomState *rng, const uint64_t table[4])
+{
+    uint64_t s[4] = {0, 0, 0, 0};
+    for (int i = 0; i < 4; ++i)
+    {
+        for (int b = 0; b < 64; ++b)
+        {
+            if (table[i] & (1ULL << b))
+            {
+                for (int k = 0; k < 4; ++k)
+                {
+                    s[k] ^= rng->s[k];
+                }
+            }
+            nextRandom(rng);
+        }
+    }
+
+    for (int k = 0; k < 4; ++k)
+    {
+        rng->s[k] = s[k];
+    }
+}
+
+/**
+ * @brief Advance a generator by 2^128 draws, the skipped range is a stream of its own
+ *
+ * @param rng RandomState to advance
+ *
+ * @return None
+ */
+void jumpRandom(RandomState *rng)
+{
+    static const uint64_t JUMP[] = {0x180EC6D33CFD0ABAULL, 0xD5A61266F0C9392CULL, 0xA9582618E03FC9AAULL, 0x39ABDC4529B1661CULL};
+    applyJump(rng, JUMP);
+}
+
+/**
+ * @brief Advance a generator by 2^192 draws. Thread streams are cut this far apart so the
+ *        2^128 forks every thread takes from its own stream stay inside it.
+ *
+ * @param rng RandomState to advance
+ *
+ * @return None
+ */
+void longJumpRandom(RandomState *rng)
+{
+    static const uint64_t LONG_JUMP[] = {0x76E15D3EFEFDCBBFULL, 0xC5004E441C522FB3ULL, 0x77710069854EE241ULL, 0x39109BB02ACBE635ULL};
+    applyJump(rng, LONG_JUMP);
+}
+
+/**
+ * @brief Split off an independent stream, the child takes the next 2^128 draws of the parent
+ *        and the parent jumps past them
+ *
+ * @param parent RandomState to split
+ * @param child RandomState set to the new stream
+ *
+ * @return None
+ */
+void forkRandom(RandomState *parent, RandomState *child)
+{
+    *child = *parent;
+    jumpRandom(parent);
+}
+
+/**
+ * @brief Reseed the process-wide source, every thread takes a fresh stream on its next draw.
+ *        The first thread to draw after this gets the first stream, so single threaded
+ *        programs repeat exactly.
+ *
+ * @param seed Any 64 bit value
+ *
+ * @return None
+ */
+void setRandomSeed(uint64_t seed)
+{
+    pthread_mutex_lock(&SOURCE_LOCK);
+    seedRandom(&SOURCE, seed);
+    atomic_fetch_add(&SOURCE_GENERATION, 1);
+    pthread_mutex_unlock(&SOURCE_LOCK);
+}
+
+/**
+ * @brief Generator of the calling thread, cut from the process-wide source on first use.
+ *        Threads take 2^192 draws each, room for 2^64 forks of 2^128 that never reach the
+ *        next thread. The source is seeded from the clock when setRandomSeed was never called.
+ *
+ * @return RandomState owned by the calling thread
+ */
+RandomState *threadRandom(void)
+{
+    unsigned generation = atomic_load(&SOURCE_GENERATION);
+    if (THREAD_GENERATION != 0 && THREAD_GENERATION == generation)
+    {
+        return &THREAD_STATE;
+    }
+
+    pthread_mutex_lock(&SOURCE_LOCK);
+    if (atomic_load(&SOURCE_GENERATION) == 0)
+    {
+        uint64_t seed = (uint64_t)time(NULL) * 0x9E3779B97F4A7C15ULL ^ (uint64_t)clock();
+        LOG_DEBUG("Random source was not seeded, using seed %llu.\n", (unsigned long long)seed);
+        seedRandom(&SOURCE, seed);
+        atomic_store(&SOURCE_GENERATION, 1);
+    }
+    THREAD_STATE = SOURCE;
+    longJumpRandom(&SOURCE);
+    THREAD_GENERATION = atomic_load(&SOURCE_GENERATION);
+    pthread_mutex_unlock(&SOURCE_LOCK);
+
+    return &THREAD_STATE;
+}
+
+/**
+ * @brief Start a generator from an explicit seed, or split it off the calling thread's
+ *        stream when the seed is 0
+ *
+ * @param rng RandomState to initialize
+ * @param seed Seed, 0 to fork from threadRandom()
+ *
+ * @return None
+ */
+void initRandomStream(RandomState *rng, uint64_t seed)
+{
+    if (seed != 0)
+    {
+        seedRandom(rng, seed);
+        return;
+    }
+
+    forkRandom(threadRandom(), rng);
+}
+
+/**
+ * @brief Uniform random permutation of 0 to n-1 with Fisher-Yates and unbiased indices.
+ *        Swap targets are drawn a few steps ahead and prefetched, which hides the cache
+ *        misses that dominate shuffles of arrays larger than the cache.
+ *
+ * @param arr Integer array of n values to fill
+ * @param n Length of array arr
+ * @param rng RandomState to draw from
+ *
+ * @return 0 if successful, -1 if failure
+ */
+int shufflePermutation(int *arr, int n, RandomState *rng)
+{
+    if (!arr || !rng || n <= 0)
+    {
+        LOG_ERROR("Input variables to shuffle a permutation were not correct.\n");
+        return -1;
+    }
+
+    for (int i = 0; i < n; ++i)
+    {
+        arr[i] = i;
+    }
+
+    // Position i swaps with a uniform j in [0, i], drawn when i + SHUFFLE_LOOKAHEAD was swapped
+    int ahead[SHUFFLE_LOOKAHEAD];
+    for (int k = 0; k < SHUFFLE_LOOKAHEAD && n - 1 - k > 0; ++k)
+    {
+        ahead[k] = (int)randomBounded(rng, (uint32_t)(n - k));
+        __builtin_prefetch(&arr[ahead[k]], 1);
+    }
+
+    for (int i = n - 1; i > 0; --i)
+    {
+        int slot = (n - 1 - i) % SHUFFLE_LOOKAHEAD;
+        int j = ahead[slot];
+        int next = i - SHUFFLE_LOOKAHEAD;
+        if (next > 0)
+        {
+            ahead[slot] = (int)randomBounded(rng, (uint32_t)(next + 1));
+            __builtin_prefetch(&arr[ahead[slot]], 1);
+        }
+
+        int temp = arr[j];
+        arr[j] = arr[i];
+        arr[i] = temp;
+    }
+
+    return 0;
+}
@@ -9,9 +9,154 @@
 
 #include "../header/regression.h"
 #include "../header/progressbar.h"
+#include "../header/prefetch.h"
+#include "../header/threading.h"
+#include "../header/linalg.h"
+#include "../header/eval_matrics.h"
+#include "../header/model_io.h"
+
+#define TRAIN_MIN_ROWS_PER_THREAD 32
+#define HOGWILD_MIN_ROWS_PER_THREAD 64
+#define GRAM_MIN_ROWS_PER_THREAD 4096
+#define CLOSED_FORM_MAX_CONDITION 1e10
+#define LBFGS_DEFAULT_HISTORY 10
+#define LBFGS_MAX_LINE_SEARCH 20
+#define LBFGS_WOLFE_C1 1e-4
+#define LBFGS_WOLFE_C2 0.9
+#define LBFGS_MIN_CURVATURE 1e-10
+#define LBFGS_MIN_DECREASE 1e-12
+#define NEWTON_MAX_FEATURES 1000
+#define NEWTON_MAX_BACKTRACKS 30
+#define NEWTON_MAX_DAMPING_TRIES 12
+#define NEWTON_MIN_DAMPING 1e-10
+#define NEWTON_ARMIJO 1e-4
+#define CD_MIN_IRLS_WEIGHT 1e-5
+
+typedef struct
+{
+    Matrix grad_w;           // Gradient of the weights
+    Vector grad_b;           // Gradient of the bias(es)
+    Matrix velocity_weights; // Momentum or first moment of the weights, carried across batches
+    Vector velocity_bias;    // Momentum or first moment of the bias(es), carried across batches
+    Matrix square_weights;   // Running squared gradient of the weights, adaptive optimizers only
+    Vector square_bias;      // Running squared gradient of the bias(es), adaptive optimizers only
+    long step;               // Optimizer updates applied so far, for the Adam bias correction
+    Matrix dZ;               // Prediction error of the batch, only for the sharded step
+    int capacity;            // Rows the logits and dZ buffers were allocated for
+    int threads;             // Shards every mini-batch is split into, fixed for the whole run
+    Matrix partial_w;        // Unscaled weight gradient of every shard, threads x weights
+    Matrix partial_b;        // Unscaled bias gradient of every shard, threads x classes
+    Vector partial_loss;     // Summed loss terms of every shard
+    int *shard_status;       // Forward pass status of every shard
+} TrainWorkspace;
+
+typedef struct
+{
+    Model *model;       // Model being trained
+    Matrix X;           // Mini-batch of features
+    Matrix y;           // Mini-batch of labels
+    TrainWorkspace *ws; // Workspace the shards write into
+} ShardTask;
+
+typedef struct
+{
+    Model *model;  // Model whose weights and bias every worker updates
+    Matrix y;      // Training labels, class indices for softmax
+    int *perm_arr; // Row order of the current epoch
+    Matrix logits; // Scratch row of logits for every worker, threads x classes
+    Vector loss;   // Summed loss terms of every worker
+    int *status;   // Forward pass status of every worker
+} HogwildTask;
+
+typedef struct
+{
+    Matrix X;    // Training features
+    Matrix y;    // Training labels
+    Matrix gram; // Upper triangle of [X 1]^T * [X 1] for every thread, threads x (features + 1)^2
+    Matrix xty;  // [X 1]^T * y for every thread, threads x (features + 1) * outputs
+} GramTask;
+
+typedef struct
+{
+    Model *model;               // Model being fitted, holds the trial parameters during evaluations
+    Matrix X;                   // Training features
+    const SparseMatrix *sparse; // CSR training features, NULL for the dense X
+    Matrix y;                   // Training labels, class indices for softmax
+    TrainWorkspace ws;          // Full-batch workspace for the fused loss and gradient pass
+    Vector x;                   // Current parameters, weights then bias
+    Vector g;                   // Gradient at x
+    Vector d;                   // Search direction
+    Vector x_trial;             // Parameters at the last line search trial
+    Vector g_trial;             // Gradient at x_trial
+    Vector s_new;               // Step of the last iteration, stored in S once its curvature is accepted
+    Vector y_new;               // Gradient change of the last iteration, stored in Y with s_new
+    Matrix S;                   // Ring of parameter steps s_k, history x parameters
+    Matrix Y;                   // Ring of gradient changes y_k, history x parameters
+    Vector rho;                 // 1 / (y_k^T * s_k) for every stored pair
+    Vector alpha;               // Two-loop recursion coefficients
+    int history;                // Number of pairs the rings hold
+    int pairs;                  // Number of pairs stored so far
+    int newest;                 // Slot of the newest pair
+    int evaluations;            // Objective evaluations so far
+    double dphi0;               // Slope g^T * d at the start of the line search
+} LBFGSState;
+
+typedef struct
+{
+    Matrix X;             // Training features
+    Matrix y;             // Training labels of 0 and 1
+    const double *params; // Weights then bias the pass evaluates
+    bool with_hessian;    // Also accumulate the Hessian
+    int threads;          // Number of thread slots in the sums
+    Matrix hessian;       // Upper triangle of every thread's Hessian sum, threads x (d * d)
+    Matrix grad;          // Every thread's gradient sum, threads x d
+    Vector loss;          // Every thread's loss sum
+} NewtonTask;
+
+typedef struct
+{
+    bool enabled;        // config.patience is positive
+    bool validate;       // Monitor the validation split, else the mean training loss
+    Matrix X;            // Validation features
+    Matrix y;            // Validation labels, class indices for softmax
+    Matrix logits;       // Predictions on the validation features
+    Matrix best_weights; // Weights at the best monitored loss
+    Vector best_bias;    // Bias at the best monitored loss
+    double best_loss;    // Best monitored loss so far
+    int best_epoch;      // Epoch the best weights come from, 0 before the first epoch
+    int stale_epochs;    // Epochs since the last improvement
+} EarlyStopping;
+
+typedef struct
+{
+    Matrix Xt;          // Column-major training features, features x rows
+    Matrix y;           // Training labels, 0 and 1 for logistic regression
+    bool logistic;      // Binary logistic loss through IRLS, else squared error through covariance updates
+    int row_threads;    // Threads of the passes over rows
+    int column_threads; // Threads of the passes over features
+    int column;         // Feature whose Gram column the parallel fill computes
+    Vector mean;        // Column means of the features
+    Vector curvature;   // Second derivative of the smooth loss along every coordinate
+    Vector xty;         // Centered X^T * y / n, linear only
+    Vector q;           // G * w for the centered Gram G = X^T * X / n, linear only
+    Vector *gram;       // Centered Gram column of every feature, filled once its weight turns nonzero
+    Vector grad;        // Gradient of the smooth loss at the current weights, drives the screening
+    Vector weights;     // Current weights
+    double bias;        // Current bias, logistic only, linear recovers it from the means
+    double y_mean;      // Mean label
+    Vector z;           // Linear predictor of every row, logistic only
+    Vector irls;        // IRLS weight p * (1 - p) of every row, logistic only
+    Vector resid;       // Working residual (y - p) / (p * (1 - p)) of the quadratic model, logistic only
+    bool *working;      // Coordinates the sweeps visit, the strong set plus every nonzero weight
+    int *order;         // Working coordinates of the current sweep
+    int *perm;          // Random visit order of the current sweep
+    RandomState rng;    // Draws the visit order when config.shuffle_coordinates is set
+    bool shuffle;       // Visit the working coordinates in a random order
+    int sweeps;         // Sweeps run so far
+} CoordinateDescent;
 
 /**
- * @brief Initialize a Model object by malloc-ing the Matrix and Vector members
+ * @brief Initialize a Model object by allocating empty Matrix and Vector members
  *
  * @param model Model object to init
  *
@@ -19,18 +164,29 @@
  */
 int initModel(Model *model)
 {
-    model->X = malloc(sizeof(Matrix));
-    model->y = malloc(sizeof(Matrix));
-    model->weights = malloc(sizeof(Matrix));
-    model->bias = malloc(sizeof(Vector));
-    model->logits = malloc(sizeof(Matrix));
+    model->X = calloc(1, sizeof(Matrix));
+    model->y = calloc(1, sizeof(Matrix));
+    model->weights = calloc(1, sizeof(Matrix));
+    model->bias = calloc(1, sizeof(Vector));
+    model->logits = calloc(1, sizeof(Matrix));
+    if (!model->X || !model->y || !model->weights || !model->bias || !model->logits)
+    {
+        LOG_ERROR("Failed to allocate Model members.\n");
+        return -1;
+    }
 
     model->splitdata = makeDefaultSplitData();
+    model->train_table = makeTypedTableEmpty();
+    model->train_sparse = makeSparseMatrixEmpty();
+    model->train_rows = NULL;
+    model->n_train_rows = 0;
+    memset(&model->state, 0, sizeof(OptimizerState));
 
     model->config = makeDefaultConfig();
 
     model->func = ACT_NONE;
     model->batch_size = -1;
+    model->beta = 0;
     model->classes = 1;
 
     return 0;
@@ -47,6 +203,7 @@ ModelConfig makeDefaultConfig()
     config.epochs = 1000;
     config.lambda = 0;
     config.regularization = REG_NONE;
+    config.l1_ratio = 0.5;
 
     LearningRate lr;
     config.learning_rate.decay_constant = 0;
@@ -54,9 +211,77 @@ ModelConfig makeDefaultConfig()
     config.learning_rate.decay_type = EXPONENTIAL_DECAY;
     config.learning_rate.init_learning_rate = 0.01;
     config.learning_rate.min_learning_rate = 0.01;
+    config.learning_rate.curr_learning_rate = 0.01;
+    config.learning_rate.max_epoch_cycle = config.epochs;
+    config.preallocate = false;
+    config.hogwild = false;
+    config.solver = SOLVER_GRADIENT_DESCENT;
+    config.history = 10;
+    config.shuffle_coordinates = false;
+    config.seed = 0;
+    config.patience = 0;
+    config.min_improvement = 1e-4;
+    config.grad_norm_tolerance = 0;
+    config.optimizer.type = OPTIMIZER_MOMENTUM;
+    config.optimizer.beta1 = 0.9;
+    config.optimizer.beta2 = 0.999;
+    config.optimizer.epsilon = 1e-8;
+    config.optimizer.weight_decay = 0.01;
+    config.tolerance = 1e-5;
+    config.checkpoint_path = NULL;
+    config.checkpoint_every = 0;
     return config;
 }
 
+/**
+ * @brief Number of training rows, from the typed table or sparse features when one is set
+ *
+ * @param model Model to check
+ *
+ * @return Number of training rows
+ */
+static int getTrainRows(const Model *model)
+{
+    if (model->train_rows)
+    {
+        return model->n_train_rows;
+    }
+    if (model->train_sparse.rows > 0)
+    {
+        return model->train_sparse.rows;
+    }
+    return (model->train_table.rows > 0) ? model->train_table.rows : model->splitdata.train_features.rows;
+}
+
+/**
+ * @brief Check that softmax labels are one column of class indices in [0, classes). The
+ *        loss and gradients index the probabilities with them directly.
+ *
+ * @param y Labels to check
+ * @param classes Number of classes
+ *
+ * @return 0 if successful, -1 if failure
+ */
+static int checkClassLabels(Matrix y, int classes)
+{
+    if (y.cols != 1)
+    {
+        LOG_ERROR("Softmax labels must be one column of class indices, got %d columns.\n", y.cols);
+        return -1;
+    }
+    for (int r = 0; r < y.rows; ++r)
+    {
+        double label = y.data[r];
+        if (!(label >= 0 && label < classes) || label != floor(label))
+        {
+            LOG_ERROR("Label %f in row %d is not a class index below %d.\n", label, r, classes);
+            return -1;
+        }
+    }
+
+    return 0;
+}
+
 /**
  * @brief Check to see if the model is setup correctly; if enough information is given
  *
@@ -66,13 +291,22 @@ ModelConfig makeDefaultConfig()
  */
 int checkModel(Model *model)
 {
-    // Check if X has been set
-    if (model->splitdata.train_features.data == NULL)
+    // Check if X has been set, either dense, as a compact typed table, or as sparse rows
+    if (model->splitdata.train_features.data == NULL && model->train_table.rows == 0 && model->train_sparse.rows == 0)
     {
         LOG_ERROR("X Matrix is NULL and unset.\n");
         return -1;
     }
 
+    // Sparse features are only read by the L-BFGS objective, one label row per feature row
+    if (model->train_sparse.rows > 0 &&
+        (model->config.solver != SOLVER_LBFGS || model->train_rows ||
+         (model->splitdata.train_labels.data && model->splitdata.train_labels.rows != model->train_sparse.rows)))
+    {
+        LOG_ERROR("Sparse training features need SOLVER_LBFGS, every row, and one label per row.\n");
+        return -1;
+    }
+
     // Check if y has been set
     if (model->splitdata.train_labels.data == NULL)
     {
@@ -94,12 +328,31 @@ int checkModel(Model *model)
         return -1;
     }
 
+    // A row subset is drawn by the mini-batch prefetcher, the other solvers read every row
+    if (model->train_rows && (model->n_train_rows < 1 || model->train_table.rows > 0 ||
+                              model->config.solver != SOLVER_GRADIENT_DESCENT || model->config.hogwild))
+    {
+        LOG_ERROR("Training on a subset of rows needs dense features and mini-batch gradient descent.\n");
+        return -1;
+    }
+
+    // Hogwild! workers apply plain per-row SGD and only meet at the end of every epoch, so they
+    // have no adaptive optimizer state, no early stopping, and nothing to checkpoint
+    const ModelConfig *config = &model->config;
+    if (config->hogwild && config->solver == SOLVER_GRADIENT_DESCENT &&
+        (config->optimizer.type != OPTIMIZER_MOMENTUM || config->patience > 0 || config->grad_norm_tolerance > 0 ||
+         (config->checkpoint_path && config->checkpoint_every > 0)))
+    {
+        LOG_ERROR("Hogwild training supports neither adaptive optimizers, early stopping, nor checkpoints.\n");
+        return -1;
+    }
+
     // Check if batch size has been set
     if (model->batch_size < 1)
     {
         LOG_WARN("Batch size was invalid or unset. Setting automatically based on input size.\n");
         int batch_size = 1;
-        while (batch_size < (int)model->splitdata.train_features.rows / 2)
+        while (batch_size < getTrainRows(model) / 2)
         {
             batch_size *= 2;
         }
@@ -144,57 +397,25 @@ int checkModel(Model *model)
     }
 
     // Check if model config regularization has been set, default to none
-    if (model->config.regularization < 0 || model->config.regularization > 2)
+    if (model->config.regularization < REG_NONE || model->config.regularization > REG_ELASTIC_NET)
     {
         LOG_WARN("Regularization is not recognized. Setting to default 0 or REG_NONE\n");
         model->config.regularization = REG_NONE;
     }
 
-    return 0;
-}
-
-/**
- * @brief Computes the one-hot encoded form of a Matrix
- *
- * @param m Original matrix values
- * @param m_encoded Matrix to get one-hot encoded values
- * @param classes Number of classes for encoding
- *
- * @return 0 if successful, -1 if failure
- */
-int computeOneHotEncodedMatrix(Matrix m, Matrix *m_encoded, int classes)
-{
-    // Temp Matrix
-    Matrix temp_y = {0};
-    if (makeMatrixZeros(&temp_y, m.rows, classes) < 0)
-    {
-        LOG_ERROR("Could not initialize temp y matrix.\n");
-        return -1;
-    }
-
-    // Create one-hot encoded row in the matrix
-    for (int i = 0; i < temp_y.rows; ++i)
-    {
-        temp_y.data[i * temp_y.cols + (int)m.data[i]] = 1.0;
-    }
-
-    freeMatrix(m_encoded);
-
-    // Reallocate memory for bigger y matrix in one-hot encoded form
-    if (makeMatrixZeros(m_encoded, temp_y.rows, classes) < 0)
+    // Check that the elastic net mixes L1 and L2, default to an even split
+    if (model->config.regularization == REG_ELASTIC_NET && (model->config.l1_ratio < 0 || model->config.l1_ratio > 1))
     {
-        LOG_ERROR("Recreation of encoded matrix was unsuccessful.\n");
-        return -1;
+        LOG_WARN("Elastic-net l1_ratio is outside [0, 1]. Setting to default 0.5\n");
+        model->config.l1_ratio = 0.5;
     }
 
-    // Copy contents of one-hot encoded form to y matrix
-    if (copyMatrix(temp_y, m_encoded) < 0)
+    // Softmax trains on the class indices in place
+    if (model->type == SOFTMAX_REGRESSION && checkClassLabels(model->splitdata.train_labels, model->classes) < 0)
     {
-        LOG_ERROR("Copying of temp matrix in encoded matrix was unsuccessful.\n");
         return -1;
     }
 
-    freeMatrix(&temp_y);
     return 0;
 }
 
@@ -309,14 +530,17 @@ int comptueLabels(Matrix X, Matrix weights, Vector biases, Matrix *labels, Activ
  * @brief Computes logits and applies activation function based on regression type
  *
  * @param x_inputs Matrix of inputs
+ * @param rows Integer array of n rows of x_inputs to compute, NULL for every row
+ * @param n Number of rows in rows
  * @param model Model object
  *
  * @return 0 if successful, -1 if failure
  */
-static int computeLogits(Matrix x_inputs, Model *model)
+static int computeLogitsRows(Matrix x_inputs, const int *rows, int n, Model *model)
 {
-    // Calculate X * weights
-    if (mat_mul(x_inputs, *model->weights, model->logits) < 0)
+    // Calculate X * weights, reading the selected rows in place
+    int status = rows ? mat_mul_indexed(x_inputs, rows, n, *model->weights, model->logits) : mat_mul(x_inputs, *model->weights, model->logits);
+    if (status < 0)
     {
         LOG_ERROR("Matrix multiplication in logits computation was unsuccessful.\n");
         return -1;
@@ -389,74 +613,123 @@ static int computeLogits(Matrix x_inputs, Model *model)
 }
 
 /**
- * @brief Compute the loss of the current epoch with MSE and L2 Regularization with lambda
+ * @brief Computes logits and applies activation function based on regression type
  *
- * @param y_real Matrix object holding real values
+ * @param x_inputs Matrix of inputs
  * @param model Model object
- * @param loss Resulting Vector of losses
  *
  * @return 0 if successful, -1 if failure
  */
-static int computeLoss(Matrix y_real, Model *model, double *loss)
+static int computeLogits(Matrix x_inputs, Model *model)
 {
-    double y_pred = 0;
-    *loss = 0;
+    return computeLogitsRows(x_inputs, NULL, x_inputs.rows, model);
+}
 
-    // Accumulate error based on prediction and target values
+/**
+ * @brief Sum the unnormalized loss terms of rows [start, end) of the logits
+ *
+ * @param y_real Matrix object holding real values, class indices for softmax
+ * @param model Model object with the logits computed
+ * @param start First row
+ * @param end One past the last row
+ *
+ * @return Sum of squared errors for linear, sum of log likelihoods otherwise
+ */
+static double sumLossRows(Matrix y_real, const Model *model, int start, int end)
+{
+    const Matrix *logits = model->logits;
     double error = 0.0;
-    int index = 0;
-    switch (model->type)
-    {
-    case LINEAR_REGRESSION:
+
+    if (model->type == SOFTMAX_REGRESSION)
     {
-        // Performing MSE
-        for (int r = 0; r < model->logits->rows; ++r)
+        // CCE (Categorical Cross Entropy), only the probability of the true class contributes
+        for (int r = start; r < end; ++r)
         {
-            for (int c = 0; c < model->logits->cols; ++c)
-            {
-                index = r * model->logits->cols + c;
-
-                double y_pred = model->logits->data[index];
-                double diff = y_real.data[index] - y_pred;
-
-                error += diff * diff;
-            }
+            error += log(logits->data[r * logits->cols + (int)y_real.data[r]]);
         }
-        *loss = error / model->logits->rows;
-        break;
+        return error;
     }
-    case LOGISTIC_REGRESSION:
+
+    for (int index = start * logits->cols; index < end * logits->cols; ++index)
     {
-        // Performing BCE (Binary Cross Entropy)
-        for (int r = 0; r < model->logits->rows; ++r)
+        double y_pred = logits->data[index];
+        switch (model->type)
         {
-            for (int c = 0; c < model->logits->cols; ++c)
-            {
-                index = r * model->logits->cols + c;
+        case LINEAR_REGRESSION:
+        {
+            // MSE
+            double diff = y_real.data[index] - y_pred;
+            error += diff * diff;
+            break;
+        }
+        case LOGISTIC_REGRESSION:
+        {
+            // BCE (Binary Cross Entropy)
+            error += y_real.data[index] * log(y_pred) + (1 - y_real.data[index]) * log(1 - y_pred);
+            break;
+        }
+        default:
+        {
+            break;
+        }
+        }
+    }
+
+    return error;
+}
 
-                double y_pred = model->logits->data[index];
+/**
+ * @brief Split lambda into the L1 and L2 strengths of the configured penalty,
+ *        l1 * ||w||_1 + l2 * ||w||^2. The elastic net gives l1_ratio of lambda to the L1 term.
+ *
+ * @param config ModelConfig object
+ * @param l1 Resulting L1 strength
+ * @param l2 Resulting L2 strength
+ *
+ * @return None
+ */
+static void penaltyStrengths(const ModelConfig *config, double *l1, double *l2)
+{
+    *l1 = 0.0;
+    *l2 = 0.0;
+    if (config->regularization == REG_L1)
+    {
+        *l1 = config->lambda;
+    }
+    else if (config->regularization == REG_L2)
+    {
+        *l2 = config->lambda;
+    }
+    else if (config->regularization == REG_ELASTIC_NET)
+    {
+        *l1 = config->lambda * config->l1_ratio;
+        *l2 = config->lambda * (1.0 - config->l1_ratio);
+    }
+}
 
-                error += y_real.data[index] * log(y_pred) + (1 - y_real.data[index]) * log(1 - y_pred);
-            }
-        }
-        *loss = -1 * error / model->logits->rows;
+/**
+ * @brief Turn a summed error over a batch into the loss with L1, L2 or elastic-net Regularization with lambda
+ *
+ * @param model Model object
+ * @param error Sum from sumLossRows over the whole batch
+ * @param rows Number of rows in the batch
+ * @param loss Resulting loss
+ *
+ * @return 0 if successful, -1 if failure
+ */
+static int lossFromError(const Model *model, double error, int rows, double *loss)
+{
+    switch (model->type)
+    {
+    case LINEAR_REGRESSION:
+    {
+        *loss = error / rows;
         break;
     }
+    case LOGISTIC_REGRESSION:
     case SOFTMAX_REGRESSION:
     {
-        // Performing CCE (Categorical Cross Entropy)
-        for (int r = 0; r < model->logits->rows; ++r)
-        {
-            for (int c = 0; c < model->logits->cols; ++c)
-            {
-                index = r * model->logits->cols + c;
-
-                double y_pred = model->logits->data[index];
-
-                error += y_real.data[index] * log(y_pred);
-            }
-        }
-        *loss = -1 * error / model->logits->rows;
+        *loss = -1 * error / rows;
         break;
     }
     default:
@@ -472,30 +745,39 @@ static int computeLoss(Matrix y_real, Model *model, double *loss)
         return 0;
     }
 
-    double reg_penalty = 0.0;
-    double sum = 0.0;
-    for (int r = 0; r < model->weights->rows; ++r)
+    double l1 = 0.0;
+    double l2 = 0.0;
+    penaltyStrengths(&model->config, &l1, &l2);
+    double sum_abs = 0.0;
+    double sum_sq = 0.0;
+    for (int i = 0; i < model->weights->rows * model->weights->cols; ++i)
     {
-        for (int c = 0; c < model->weights->cols; ++c)
-        {
-            if (model->config.regularization == REG_L1)
-            {
-                sum += fabs(model->weights->data[r * model->weights->cols + c]);
-            }
-            else if (model->config.regularization == REG_L2)
-            {
-                double value = model->weights->data[r * model->weights->cols + c];
-                sum += value * value;
-            }
-        }
+        double value = model->weights->data[i];
+        sum_abs += fabs(value);
+        sum_sq += value * value;
     }
-    reg_penalty = model->config.lambda * sum;
+    double reg_penalty = l1 * sum_abs + l2 * sum_sq;
 
     *loss += reg_penalty;
 
     return 0;
 }
 
+/**
+ * @brief Compute the loss of the current epoch with MSE and L2 Regularization with lambda
+ *
+ * @param y_real Matrix object holding real values
+ * @param model Model object
+ * @param loss Resulting Vector of losses
+ *
+ * @return 0 if successful, -1 if failure
+ */
+static int computeLoss(Matrix y_real, Model *model, double *loss)
+{
+    *loss = 0;
+    return lossFromError(model, sumLossRows(y_real, model, 0, model->logits->rows), model->logits->rows, loss);
+}
+
 /**
  * @brief Computes the gradient descent as it solves the problem
  *
@@ -613,12 +895,16 @@ static int computeGradients(Matrix x_inputs, Matrix y_real, Model *model, Matrix
     }
     else if (model->type == SOFTMAX_REGRESSION)
     {
-        // Calculate dZ matrix
-        if (mat_sub(*model->logits, y_real, &dZ) < 0)
+        // Calculate dZ matrix, the probabilities less a 1 at the true class of every row
+        if (copyMatrix(*model->logits, &dZ) < 0)
         {
-            LOG_ERROR("Matrix subtraction was unsuccessful.");
+            LOG_ERROR("Copying the probabilities into delta Z was unsuccessful.");
             return -1;
         }
+        for (int r = 0; r < dZ.rows; ++r)
+        {
+            dZ.data[r * dZ.cols + (int)y_real.data[r]] -= 1.0;
+        }
 
         // Init transpose of X matrix
         Matrix X_T = {0};
@@ -682,142 +968,119 @@ static int computeGradients(Matrix x_inputs, Matrix y_real, Model *model, Matrix
  */
 static int computeRegularization(Model model, Matrix *grad_w)
 {
-    for (int r = 0; r < grad_w->rows; ++r)
+    if (model.config.regularization == REG_NONE)
     {
-        for (int c = 0; c < grad_w->cols; ++c)
-        {
-            int idx = r * grad_w->cols + c;
-            // Add regularization gradient
-            if (model.config.regularization == REG_NONE)
-            {
-                return 0;
-            }
-            else if (model.config.regularization == REG_L1)
-            {
-                grad_w->data[idx] += model.config.lambda * ((model.weights->data[idx] > 0) ? 1.0 : (model.weights->data[idx] < 0) ? -1.0
-                                                                                                                                  : 0.0);
-            }
-            else if (model.config.regularization == REG_L2)
-            {
-                grad_w->data[idx] += 2 * model.config.lambda * model.weights->data[idx];
-            }
-        }
+        return 0;
+    }
+
+    // Add regularization gradient, a sign subgradient for the L1 part
+    double l1 = 0.0;
+    double l2 = 0.0;
+    penaltyStrengths(&model.config, &l1, &l2);
+    for (int idx = 0; idx < grad_w->rows * grad_w->cols; ++idx)
+    {
+        double w = model.weights->data[idx];
+        grad_w->data[idx] += l1 * ((w > 0) ? 1.0 : (w < 0) ? -1.0 : 0.0) + 2 * l2 * w;
     }
     return 0;
 }
 
 /**
- * @brief Computes velocity matrix (velocity) for weights Matrix
+ * @brief Fused single-pass update of one parameter block, every element is read and written once
  *
- * @param v_t Matrix object of velocity values
- * @param beta Double that is the velocity constant
- * @param grad_w Matrix object of model Weights
+ * @param opt Optimizer settings
+ * @param beta Momentum constant, only used by OPTIMIZER_MOMENTUM
+ * @param lr Current learning rate
+ * @param decay Decoupled weight decay, only used by OPTIMIZER_ADAMW
+ * @param correction1 Adam bias correction of the first moment, 1 - beta1^t
+ * @param correction2 Adam bias correction of the second moment, 1 - beta2^t
+ * @param param Parameters to update
+ * @param grad Gradient of the parameters
+ * @param m Velocity or first moment state
+ * @param v Squared gradient state, unused by OPTIMIZER_MOMENTUM
+ * @param n Number of parameters
  *
- * @return 0 if successful, -1 if failure
+ * @return None
  */
-int computeVelocityWeights(Matrix *v_t, double beta, Matrix grad_w)
+static void optimizerKernel(const Optimizer *opt, double beta, double lr, double decay, double correction1,
+                            double correction2, double *restrict param, const double *restrict grad,
+                            double *restrict m, double *restrict v, int n)
 {
-    // Check current velocity matrix
-    if (!v_t || !v_t->data || v_t->rows <= 0 || v_t->cols <= 0)
+    double beta1 = opt->beta1;
+    double beta2 = opt->beta2;
+    double eps = opt->epsilon;
+
+    switch (opt->type)
     {
-        LOG_ERROR("Input current Momentum matrix was invalid. Momentum calculation was unsuccessful.\n");
-        return -1;
-    }
-    
-    // Check weight matrix
-    if (!grad_w.data || grad_w.rows <= 0 || grad_w.cols <= 0)
+    case OPTIMIZER_MOMENTUM:
     {
-        LOG_ERROR("Input Weights matrix was invalid. Momentum calculation was unsuccessful.\n");
-        return -1;
+        // v = lr * (beta * v + grad) and param -= v
+        for (int i = 0; i < n; ++i)
+        {
+            m[i] = lr * (beta * m[i] + grad[i]);
+            param[i] -= m[i];
+        }
+        break;
     }
-
-    // Check beta is greater than zero
-    if (beta <= 0)
+    case OPTIMIZER_ADAM:
+    case OPTIMIZER_ADAMW:
     {
-        LOG_WARN("Input Momentum Beta constant was <= 0. Using value close to zero instead.\n");
-        beta = 0.0000001;
+        // Bias corrections folded into the step size and epsilon
+        double step = lr * sqrt(correction2) / correction1;
+        double eps_hat = eps * sqrt(correction2);
+        for (int i = 0; i < n; ++i)
+        {
+            m[i] = beta1 * m[i] + (1.0 - beta1) * grad[i];
+            v[i] = beta2 * v[i] + (1.0 - beta2) * grad[i] * grad[i];
+            param[i] -= step * m[i] / (sqrt(v[i]) + eps_hat) + lr * decay * param[i];
+        }
+        break;
     }
-
-    Matrix temp_left = {0};
-    if (makeMatrixZeros(&temp_left, grad_w.rows, grad_w.cols) < 0)
+    case OPTIMIZER_RMSPROP:
     {
-        LOG_ERROR("Unsuccessful initialization of temp Matrix in Momentum computation.\n");
-        return -1;
+        for (int i = 0; i < n; ++i)
+        {
+            v[i] = beta2 * v[i] + (1.0 - beta2) * grad[i] * grad[i];
+            param[i] -= lr * grad[i] / (sqrt(v[i]) + eps);
+        }
+        break;
     }
-
-    if (mat_mul(*v_t, beta, &temp_left) < 0)
+    case OPTIMIZER_ADAGRAD:
     {
-        LOG_ERROR("Matrix multiplication of beta * m_t-1 in Momentum calculation was unsuccessful.\n");
-        freeMatrix(&temp_left);
-        return -1;
+        for (int i = 0; i < n; ++i)
+        {
+            v[i] += grad[i] * grad[i];
+            param[i] -= lr * grad[i] / (sqrt(v[i]) + eps);
+        }
+        break;
     }
-
-    if (mat_add(temp_left, grad_w, v_t) < 0)
-    {
-        LOG_ERROR("Matrix addition of part [beta * m_t-1] and [(1 - beta) * weights] in Momentum calculation was unsuccessful.\n");
-        freeMatrix(&temp_left);
-        return -1;
     }
-
-    return 0;
 }
 
 /**
- * @brief Computes velocity matrix (velocity) for bias Vector
+ * @brief Apply config.optimizer to the weights and bias in place with the gradients in the workspace
  *
- * @param mt Vector object of velocity values
- * @param beta Double that is the velocity constant
- * @param grad_b Vector object of model bias(es)
+ * @param model Model object being trained
+ * @param ws TrainWorkspace holding the gradients and the optimizer state
  *
- * @return 0 if successful, -1 if failure
+ * @return None
  */
-int computeVelocityBias(Vector *mt, double beta, Vector grad_b)
+static void applyOptimizer(Model *model, TrainWorkspace *ws)
 {
-    // Check current velocity matrix
-    if (!mt || !mt->data || mt->size <= 0)
-    {
-        LOG_ERROR("Input current Momentum matrix was invalid. Momentum calculation was unsuccessful.\n");
-        return -1;
-    }
-    
-    // Check weight matrix
-    if (!grad_b.data || grad_b.size <= 0)
-    {
-        LOG_ERROR("Input Weights matrix was invalid. Momentum calculation was unsuccessful.\n");
-        return -1;
-    }
-
-    // Check beta is greater than zero
-    if (beta <= 0)
-    {
-        LOG_WARN("Input Momentum Beta constant was <= 0. Using value close to zero instead.\n");
-        beta = 0.0000001;
-    }
-
-    Vector temp_left = {0};
-    if (makeVectorZeros(&temp_left, grad_b.size) < 0)
-    {
-        LOG_ERROR("Unsuccessful initialization of temp Vector in Momentum computation.\n");
-        return -1;
-    }
-
-    if (vect_mul(*mt, beta, &temp_left) < 0)
-    {
-        LOG_ERROR("Vector multiplication of beta * m_t-1 in Momentum calculation was unsuccessful.\n");
-        freeVector(&temp_left);
-        return -1;
-    }
-
-    if (vect_add(temp_left, grad_b, mt) < 0)
-    {
-        LOG_ERROR("Vector addition of part [beta * m_t-1] and [(1 - beta) * bias] in Momentum calculation was unsuccessful.\n");
-        freeVector(&temp_left);
-        return -1;
-    }
-
-    freeVector(&temp_left);
-
-    return 0;
+    const Optimizer *opt = &model->config.optimizer;
+    double beta = (model->beta > 0) ? model->beta : 0.0000001;
+    double lr = model->config.learning_rate.curr_learning_rate;
+    double decay = (opt->type == OPTIMIZER_ADAMW) ? opt->weight_decay : 0.0;
+
+    ++ws->step;
+    double correction1 = 1.0 - pow(opt->beta1, (double)ws->step);
+    double correction2 = 1.0 - pow(opt->beta2, (double)ws->step);
+
+    optimizerKernel(opt, beta, lr, decay, correction1, correction2, model->weights->data, ws->grad_w.data,
+                    ws->velocity_weights.data, ws->square_weights.data, ws->grad_w.rows * ws->grad_w.cols);
+    // The bias is never decayed
+    optimizerKernel(opt, beta, lr, 0.0, correction1, correction2, model->bias->data, ws->grad_b.data,
+                    ws->velocity_bias.data, ws->square_bias.data, ws->grad_b.size);
 }
 
 /**
@@ -883,241 +1146,3549 @@ int updateLearningRate(Model *model, int epoch)
 }
 
 /**
- * @brief
+ * @brief Allocate the gradient and optimizer buffers used by every mini-batch, and for the
+ *        in-place step also the logits, dZ, and per-shard buffers sized for a full batch
  *
- * @param model Model object that holds the configuration, matrices, and vectors to run
+ * @param ws TrainWorkspace object to fill
+ * @param model Model object with weights and bias already made
+ * @param batch_rows Rows in a full mini-batch
+ * @param in_place Allocate the buffers used by computeBatchGradients
  *
  * @return 0 if successful, -1 if failure
  */
-int trainModel(Model *model)
+static int makeTrainWorkspace(TrainWorkspace *ws, Model *model, int batch_rows, bool in_place)
 {
-    // Init weights matrix and bias vector
-    if (makeMatrixZeros(model->weights, model->splitdata.train_features.cols, model->classes) < 0)
+    memset(ws, 0, sizeof(TrainWorkspace));
+
+    if (makeMatrixZeros(&ws->grad_w, model->weights->rows, model->weights->cols) < 0)
     {
-        LOG_ERROR("Problem initializing weight Matrix\n");
+        LOG_ERROR("Unsuccessful initialization of gradient weights Matrix in model training.\n");
         return -1;
     }
-    if (makeVectorZeros(model->bias, model->classes) < 0)
+    if (makeVectorZeros(&ws->grad_b, model->bias->size) < 0)
     {
-        LOG_ERROR("Problem initializing bias Matrix\n");
+        LOG_ERROR("Unsuccessful initialization of gradient bias Vector in model training.\n");
         return -1;
     }
-
-    // Check that the model has been setup correctly before trying to train
-    if (checkModel(model) < 0)
+    if (makeMatrixZeros(&ws->velocity_weights, model->weights->rows, model->weights->cols) < 0)
     {
-        LOG_ERROR("The model object submitted to train has not be setup properly.\n");
+        LOG_ERROR("Unsuccessful initialization of velocity weights Matrix in model training.\n");
         return -1;
     }
-
-    // Convert y matrix to one-hot encoded form if performing softmax regression
+    if (makeVectorZeros(&ws->velocity_bias, model->bias->size) < 0)
+    {
+        LOG_ERROR("Unsuccessful initialization of velocity bias Vector in model training.\n");
+        return -1;
+    }
+    if (model->config.optimizer.type != OPTIMIZER_MOMENTUM &&
+        (makeMatrixZeros(&ws->square_weights, model->weights->rows, model->weights->cols) < 0 ||
+         makeVectorZeros(&ws->square_bias, model->bias->size) < 0))
+    {
+        LOG_ERROR("Unsuccessful initialization of the optimizer state in model training.\n");
+        return -1;
+    }
+
+    if (!in_place)
+    {
+        return 0;
+    }
+
+    // Sized for a full batch, the last partial batch only shrinks the row counts
+    freeMatrix(model->logits);
+    if (makeMatrixZeros(model->logits, batch_rows, model->classes) < 0)
+    {
+        LOG_ERROR("Problem initializing logits Matrix\n");
+        return -1;
+    }
+    if (makeMatrixZeros(&ws->dZ, batch_rows, model->classes) < 0)
+    {
+        LOG_ERROR("Creation of delta Z matrix for the training workspace was unsuccessful.\n");
+        return -1;
+    }
+    ws->capacity = batch_rows;
+
+    // One gradient buffer per shard so the shards never share an accumulator
+    ws->threads = planThreads(batch_rows, TRAIN_MIN_ROWS_PER_THREAD);
+    if (makeMatrixZeros(&ws->partial_w, ws->threads, model->weights->rows * model->weights->cols) < 0 ||
+        makeMatrixZeros(&ws->partial_b, ws->threads, model->classes) < 0 ||
+        makeVectorZeros(&ws->partial_loss, ws->threads) < 0)
+    {
+        LOG_ERROR("Creation of the per-shard gradients for the training workspace was unsuccessful.\n");
+        return -1;
+    }
+    ws->shard_status = (int *)calloc(ws->threads, sizeof(int));
+    if (!ws->shard_status)
+    {
+        LOG_ERROR("Creation of the per-shard status for the training workspace was unsuccessful.\n");
+        return -1;
+    }
+
+    return 0;
+}
+
+/**
+ * @brief Free every buffer in a TrainWorkspace
+ *
+ * @param ws TrainWorkspace to free
+ *
+ * @return None
+ */
+static void freeTrainWorkspace(TrainWorkspace *ws)
+{
+    freeMatrix(&ws->grad_w);
+    freeVector(&ws->grad_b);
+    freeMatrix(&ws->velocity_weights);
+    freeVector(&ws->velocity_bias);
+    freeMatrix(&ws->square_weights);
+    freeVector(&ws->square_bias);
+    freeMatrix(&ws->dZ);
+    freeMatrix(&ws->partial_w);
+    freeMatrix(&ws->partial_b);
+    freeVector(&ws->partial_loss);
+    free(ws->shard_status);
+    ws->shard_status = NULL;
+}
+
+/**
+ * @brief Allocate the workspace of the sharded mini-batch step, or when its per-shard buffers do
+ *        not fit fall back to the single threaded step that allocates every batch. With
+ *        config.preallocate the fallback is an error instead.
+ *
+ * @param ws TrainWorkspace object to fill, ws->capacity is 0 for the fallback
+ * @param model Model object with weights and bias already made
+ * @param batch_rows Rows in a full mini-batch
+ *
+ * @return 0 if successful, -1 if failure
+ */
+static int makeStepWorkspace(TrainWorkspace *ws, Model *model, int batch_rows)
+{
+    if (makeTrainWorkspace(ws, model, batch_rows, true) == 0)
+    {
+        return 0;
+    }
+    freeTrainWorkspace(ws);
+    freeMatrix(model->logits);
+    if (model->config.preallocate)
+    {
+        LOG_ERROR("The preallocated training buffers could not be allocated.\n");
+        return -1;
+    }
+
+    LOG_WARN("The sharded training buffers could not be allocated, every mini-batch allocates its own instead.\n");
+    return makeTrainWorkspace(ws, model, batch_rows, false);
+}
+
+/**
+ * @brief Exchange the optimizer buffers and step count of a workspace with an OptimizerState,
+ *        which hands a run's state to the model and back without copying
+ *
+ * @param ws TrainWorkspace object
+ * @param state OptimizerState object
+ *
+ * @return None
+ */
+static void swapOptimizerState(TrainWorkspace *ws, OptimizerState *state)
+{
+    Matrix weights = ws->velocity_weights;
+    ws->velocity_weights = state->velocity_weights;
+    state->velocity_weights = weights;
+
+    Vector bias = ws->velocity_bias;
+    ws->velocity_bias = state->velocity_bias;
+    state->velocity_bias = bias;
+
+    weights = ws->square_weights;
+    ws->square_weights = state->square_weights;
+    state->square_weights = weights;
+
+    bias = ws->square_bias;
+    ws->square_bias = state->square_bias;
+    state->square_bias = bias;
+
+    long step = ws->step;
+    ws->step = state->step;
+    state->step = step;
+}
+
+/**
+ * @brief Free the buffers of an OptimizerState and rewind it to the first epoch
+ *
+ * @param state OptimizerState to free
+ *
+ * @return None
+ */
+void freeOptimizerState(OptimizerState *state)
+{
+    if (!state)
+    {
+        return;
+    }
+    freeMatrix(&state->velocity_weights);
+    freeVector(&state->velocity_bias);
+    freeMatrix(&state->square_weights);
+    freeVector(&state->square_bias);
+    freeMatrix(&state->best_weights);
+    freeVector(&state->best_bias);
+    state->step = 0;
+    state->epoch = 0;
+    state->stream = 0;
+    state->best_loss = 0.0;
+    state->best_epoch = 0;
+    state->stale_epochs = 0;
+    state->stopped = false;
+}
+
+/**
+ * @brief Run the forward pass, backward pass, and optimizer update for one mini-batch on a
+ *        single thread, allocating the logits of every batch. Only used when the buffers of the
+ *        sharded step could not be allocated.
+ *
+ * @param model Model object being trained
+ * @param mini_X Mini-batch of features
+ * @param mini_y Mini-batch of labels, class indices for softmax
+ * @param ws TrainWorkspace with the gradients and the optimizer state carried across batches
+ * @param loss Set to the loss of the mini-batch
+ *
+ * @return 0 if successful, -1 if failure
+ */
+static int trainStep(Model *model, Matrix mini_X, Matrix mini_y, TrainWorkspace *ws, double *loss)
+{
+    // Make Logits matrix
+    if (makeMatrixZeros(model->logits, mini_X.rows, model->classes) < 0)
+    {
+        LOG_ERROR("Problem initializing logits Matrix\n");
+        return -1;
+    }
+
+    *loss = 0;
+    // --- FORWARD PASS ---
+
+    // Compute logits and apply activation function
+    if (computeLogits(mini_X, model) < 0)
+    {
+        LOG_ERROR("Computation of logits was unsuccessful while training model.\n");
+        return -1;
+    }
+
+    // Compute loss
+    if (computeLoss(mini_y, model, loss) < 0)
+    {
+        LOG_ERROR("Computation of Loss was unsuccessful while training model.\n");
+        return -1;
+    }
+
+    // --- BACKWARD PASS (GRADIENTS) ---
+
+    if (clearMatrix(&ws->grad_w) < 0)
+    {
+        LOG_ERROR("Clearing gradient weights matrix was unsuccessful.\n");
+        return -1;
+    }
+    if (clearVector(&ws->grad_b) < 0)
+    {
+        LOG_ERROR("Clearing gradient bias vector was unsuccessful.\n");
+        return -1;
+    }
+
+    // Compute gradients
+    if (computeGradients(mini_X, mini_y, model, &ws->grad_w, &ws->grad_b) < 0)
+    {
+        LOG_ERROR("Computation of Gradient was unsuccessful while training model.\n");
+        return -1;
+    }
+
+    // Optional regularization
+    if (computeRegularization(*model, &ws->grad_w) < 0)
+    {
+        LOG_ERROR("Computation of Regularization was unsuccessful while training model.\n");
+        return -1;
+    }
+
+    // Fused update with config.optimizer
+    applyOptimizer(model, ws);
+
+    freeMatrix(model->logits);
+    return 0;
+}
+
+/**
+ * @brief Add the bias to rows [start, end) of the logits and apply the activation of the
+ *        regression type in place
+ *
+ * @param model Model object with the bias to add
+ * @param logits Logits with at least end rows and one column per class
+ * @param start First row
+ * @param end One past the last row
+ *
+ * @return 0 if successful, -1 if failure
+ */
+static int activateRows(const Model *model, Matrix *logits, int start, int end)
+{
+    int cols = logits->cols;
+    for (int r = start; r < end; ++r)
+    {
+        double *out = &logits->data[r * cols];
+        for (int c = 0; c < cols; ++c)
+        {
+            out[c] += model->bias->data[c];
+        }
+
+        if (model->type == SOFTMAX_REGRESSION)
+        {
+            // Row-wise softmax, shifted by the row max for stability
+            double maxx = out[0];
+            for (int c = 1; c < cols; ++c)
+            {
+                if (out[c] > maxx)
+                {
+                    maxx = out[c];
+                }
+            }
+            double sum = 0.0;
+            for (int c = 0; c < cols; ++c)
+            {
+                sum += exp(out[c] - maxx);
+            }
+            for (int c = 0; c < cols; ++c)
+            {
+                out[c] = exp(out[c] - maxx) / sum;
+            }
+        }
+    }
+
+    if (model->type == LOGISTIC_REGRESSION && end > start)
+    {
+        Matrix rows_logits = {end - start, cols, &logits->data[start * cols]};
+        if (applyToMatrix(&rows_logits, model->func) < 0)
+        {
+            return -1;
+        }
+    }
+
+    return 0;
+}
+
+/**
+ * @brief Predict rows [start, end) of the features straight into preallocated logits, applying
+ *        the activation of the regression type in place
+ *
+ * @param model Model object with the weights and bias to predict with
+ * @param X Features
+ * @param logits Logits with at least end rows and one column per class
+ * @param start First row
+ * @param end One past the last row
+ *
+ * @return 0 if successful, -1 if failure
+ */
+static int forwardRows(const Model *model, Matrix X, Matrix *logits, int start, int end)
+{
+    int cols = logits->cols;
+    for (int r = start; r < end; ++r)
+    {
+        double *out = &logits->data[r * cols];
+        for (int c = 0; c < cols; ++c)
+        {
+            out[c] = 0.0;
+        }
+
+        // Sum row r of X times the weights, kept in the same order as mat_mul
+        for (int k = 0; k < X.cols; ++k)
+        {
+            double x = X.data[r * X.cols + k];
+            const double *w = &model->weights->data[k * cols];
+            for (int c = 0; c < cols; ++c)
+            {
+                out[c] += x * w[c];
+            }
+        }
+    }
+
+    return activateRows(model, logits, start, end);
+}
+
+/**
+ * @brief Error of one row of the logits, prediction - target for every regression type. The
+ *        softmax target is a single 1 at the class index of the row.
+ *
+ * @param model Model object with the logits computed
+ * @param y Labels, class indices for softmax
+ * @param r Row
+ * @param dz Resulting error, one value per class
+ *
+ * @return None
+ */
+static inline void errorRow(const Model *model, Matrix y, int r, double *dz)
+{
+    int cols = model->logits->cols;
+    const double *p = &model->logits->data[r * cols];
     if (model->type == SOFTMAX_REGRESSION)
     {
-        computeOneHotEncodedMatrix(*model->y, model->y, model->classes);
+        for (int c = 0; c < cols; ++c)
+        {
+            dz[c] = p[c];
+        }
+        dz[(int)y.data[r]] -= 1.0;
+        return;
+    }
+
+    for (int c = 0; c < cols; ++c)
+    {
+        dz[c] = p[c] - y.data[r * cols + c];
+    }
+}
+
+/**
+ * @brief Forward pass, loss, and backward pass over one shard of a mini-batch. Logits and dZ
+ *        rows of the shard are written in place, loss and gradient sums go into the shard's
+ *        own partial buffers and are left unscaled for the reduction.
+ *
+ * @param args ShardTask object
+ * @param thread_id Shard index
+ * @param start First row of the shard
+ * @param end One past the last row of the shard
+ *
+ * @return None
+ */
+static void trainShardTask(void *args, int thread_id, int start, int end)
+{
+    ShardTask *task = (ShardTask *)args;
+    Model *model = task->model;
+    TrainWorkspace *ws = task->ws;
+    Matrix X = task->X;
+    int cols = model->logits->cols;
+
+    // --- FORWARD PASS ---
+    if (forwardRows(model, X, model->logits, start, end) < 0)
+    {
+        ws->shard_status[thread_id] = -1;
+        return;
+    }
+
+    ws->partial_loss.data[thread_id] = sumLossRows(task->y, model, start, end);
+
+    // --- BACKWARD PASS (GRADIENTS) ---
+    double *grad_w = &ws->partial_w.data[thread_id * ws->partial_w.cols];
+    double *grad_b = &ws->partial_b.data[thread_id * cols];
+    for (int r = start; r < end; ++r)
+    {
+        double *dz = &ws->dZ.data[r * cols];
+        errorRow(model, task->y, r, dz);
+
+        for (int k = 0; k < X.cols; ++k)
+        {
+            double x = X.data[r * X.cols + k];
+            double *g = &grad_w[k * cols];
+            for (int c = 0; c < cols; ++c)
+            {
+                g[c] += x * dz[c];
+            }
+        }
+        for (int c = 0; c < cols; ++c)
+        {
+            grad_b[c] += dz[c];
+        }
+    }
+}
+
+/**
+ * @brief Sum the shard rows of a partial buffer into row 0 with a pairwise tree. The order
+ *        of the additions only depends on the number of shards, so a fixed thread count
+ *        always gives bitwise identical sums.
+ *
+ * @param data Partial buffer of shards x width values
+ * @param width Values per shard
+ * @param shards Number of shards to combine
+ *
+ * @return None
+ */
+static void reduceShards(double *data, int width, int shards)
+{
+    for (int stride = 1; stride < shards; stride *= 2)
+    {
+        for (int t = 0; t + stride < shards; t += 2 * stride)
+        {
+            double *dst = &data[t * width];
+            const double *src = &data[(t + stride) * width];
+            for (int i = 0; i < width; ++i)
+            {
+                dst[i] += src[i];
+            }
+        }
+    }
+}
+
+/**
+ * @brief Loss and gradients of a batch into the preallocated workspace in one fused pass.
+ *        The batch is split into shards that run on their own threads and are reduced in a
+ *        fixed order, the scaled and regularized gradients end up in ws->grad_w and ws->grad_b.
+ *
+ * @param model Model object being trained
+ * @param mini_X Batch of features
+ * @param mini_y Batch of labels, class indices for softmax
+ * @param ws Preallocated TrainWorkspace
+ * @param loss Set to the loss of the batch
+ *
+ * @return 0 if successful, -1 if failure
+ */
+static int computeBatchGradients(Model *model, Matrix mini_X, Matrix mini_y, TrainWorkspace *ws, double *loss)
+{
+    int n = mini_X.rows;
+    if (n > ws->capacity)
+    {
+        LOG_ERROR("Mini-batch of %d rows does not fit the training workspace.\n", n);
+        return -1;
+    }
+
+    model->logits->rows = n;
+    ws->dZ.rows = n;
+    if (clearMatrix(&ws->partial_w) < 0 || clearMatrix(&ws->partial_b) < 0)
+    {
+        LOG_ERROR("Clearing the per-shard gradients was unsuccessful.\n");
+        return -1;
+    }
+    memset(ws->shard_status, 0, ws->threads * sizeof(int));
+
+    ShardTask task = {model, mini_X, mini_y, ws};
+    if (parallelFor(ws->threads, n, trainShardTask, &task) < 0)
+    {
+        LOG_ERROR("Running the mini-batch shards was unsuccessful.\n");
+        return -1;
+    }
+
+    // parallelFor runs a single chunk for batches of one row
+    int shards = (n <= 1) ? 1 : ws->threads;
+    for (int t = 0; t < shards; ++t)
+    {
+        if (ws->shard_status[t] < 0)
+        {
+            LOG_ERROR("Applying function to each member in logits matrix was unsuccessful.\n");
+            return -1;
+        }
+    }
+
+    reduceShards(ws->partial_w.data, ws->partial_w.cols, shards);
+    reduceShards(ws->partial_b.data, ws->partial_b.cols, shards);
+    reduceShards(ws->partial_loss.data, 1, shards);
+
+    if (lossFromError(model, ws->partial_loss.data[0], n, loss) < 0)
+    {
+        LOG_ERROR("Computation of Loss was unsuccessful while training model.\n");
+        return -1;
+    }
+
+    // MSE carries a factor of 2, cross entropy does not
+    double scale = ((model->type == LINEAR_REGRESSION) ? 2.0 : 1.0) / n;
+    for (int i = 0; i < ws->grad_w.rows * ws->grad_w.cols; ++i)
+    {
+        ws->grad_w.data[i] = ws->partial_w.data[i] * scale;
+    }
+    for (int i = 0; i < ws->grad_b.size; ++i)
+    {
+        ws->grad_b.data[i] = ws->partial_b.data[i] * scale;
+    }
+
+    if (computeRegularization(*model, &ws->grad_w) < 0)
+    {
+        LOG_ERROR("Computation of Regularization was unsuccessful while training model.\n");
+        return -1;
+    }
+
+    return 0;
+}
+
+/**
+ * @brief Loss and gradients of the full batch for CSR features into the workspace. The logits
+ *        come from one sparse product with the weights and the weight gradient from one
+ *        transposed product with the errors, so both passes only touch the stored values.
+ *
+ * @param model Model object being trained, logits sized for every row
+ * @param X Sparse training features
+ * @param y Training labels, class indices for softmax
+ * @param ws TrainWorkspace with grad_w, grad_b and dZ sized for every row
+ * @param loss Set to the loss of the batch
+ *
+ * @return 0 if successful, -1 if failure
+ */
+static int computeSparseGradients(Model *model, SparseMatrix X, Matrix y, TrainWorkspace *ws, double *loss)
+{
+    int n = X.rows;
+    if (sparseMatMul(X, *model->weights, model->logits) < 0 || activateRows(model, model->logits, 0, n) < 0)
+    {
+        LOG_ERROR("Computing the logits of the sparse features was unsuccessful.\n");
+        return -1;
+    }
+
+    if (lossFromError(model, sumLossRows(y, model, 0, n), n, loss) < 0)
+    {
+        LOG_ERROR("Computation of Loss was unsuccessful while training model.\n");
+        return -1;
+    }
+
+    int cols = model->logits->cols;
+    if (clearVector(&ws->grad_b) < 0)
+    {
+        LOG_ERROR("Clearing the bias gradient was unsuccessful.\n");
+        return -1;
+    }
+    for (int r = 0; r < n; ++r)
+    {
+        double *dz = &ws->dZ.data[r * cols];
+        errorRow(model, y, r, dz);
+        for (int c = 0; c < cols; ++c)
+        {
+            ws->grad_b.data[c] += dz[c];
+        }
+    }
+    if (sparseTransMatMul(X, ws->dZ, &ws->grad_w) < 0)
+    {
+        LOG_ERROR("Computing the weight gradient of the sparse features was unsuccessful.\n");
+        return -1;
+    }
+
+    // MSE carries a factor of 2, cross entropy does not
+    double scale = ((model->type == LINEAR_REGRESSION) ? 2.0 : 1.0) / n;
+    for (int i = 0; i < ws->grad_w.rows * ws->grad_w.cols; ++i)
+    {
+        ws->grad_w.data[i] *= scale;
+    }
+    for (int i = 0; i < ws->grad_b.size; ++i)
+    {
+        ws->grad_b.data[i] *= scale;
+    }
+
+    if (computeRegularization(*model, &ws->grad_w) < 0)
+    {
+        LOG_ERROR("Computation of Regularization was unsuccessful while training model.\n");
+        return -1;
+    }
+
+    return 0;
+}
+
+/**
+ * @brief Same step as trainStep but every buffer comes from the preallocated workspace,
+ *        so a mini-batch of any size up to the full batch never allocates
+ *
+ * @param model Model object being trained
+ * @param mini_X Mini-batch of features
+ * @param mini_y Mini-batch of labels, class indices for softmax
+ * @param ws Preallocated TrainWorkspace
+ * @param loss Set to the loss of the mini-batch
+ *
+ * @return 0 if successful, -1 if failure
+ */
+static int trainStepInPlace(Model *model, Matrix mini_X, Matrix mini_y, TrainWorkspace *ws, double *loss)
+{
+    if (computeBatchGradients(model, mini_X, mini_y, ws, loss) < 0)
+    {
+        return -1;
+    }
+
+    applyOptimizer(model, ws);
+    return 0;
+}
+
+/**
+ * @brief Run one mini-batch step with the step the workspace was made for
+ *
+ * @param model Model object being trained
+ * @param mini_X Mini-batch of features
+ * @param mini_y Mini-batch of labels, class indices for softmax
+ * @param ws TrainWorkspace from makeStepWorkspace
+ * @param loss Set to the loss of the mini-batch
+ *
+ * @return 0 if successful, -1 if failure
+ */
+static int trainBatch(Model *model, Matrix mini_X, Matrix mini_y, TrainWorkspace *ws, double *loss)
+{
+    return (ws->capacity > 0) ? trainStepInPlace(model, mini_X, mini_y, ws, loss) : trainStep(model, mini_X, mini_y, ws, loss);
+}
+
+/**
+ * @brief Relaxed atomic read of a weight shared by the Hogwild workers
+ *
+ * @param value Pointer to the weight
+ *
+ * @return Current value of the weight
+ */
+static inline double loadShared(const double *value)
+{
+    double out;
+    __atomic_load(value, &out, __ATOMIC_RELAXED);
+    return out;
+}
+
+/**
+ * @brief Relaxed atomic write of a weight shared by the Hogwild workers
+ *
+ * @param value Pointer to the weight
+ * @param update New value of the weight
+ *
+ * @return None
+ */
+static inline void storeShared(double *value, double update)
+{
+    __atomic_store(value, &update, __ATOMIC_RELAXED);
+}
+
+/**
+ * @brief Hogwild worker, runs per-row SGD over its block of the epoch's permutation and writes
+ *        straight into the shared weights without locks. Only the weights of non-zero features
+ *        are touched, so on sparse data two workers rarely update the same weight.
+ *
+ * @param args HogwildTask object
+ * @param thread_id Thread index
+ * @param start First position in the permutation
+ * @param end One past the last position in the permutation
+ *
+ * @return None
+ */
+static void hogwildTask(void *args, int thread_id, int start, int end)
+{
+    HogwildTask *task = (HogwildTask *)args;
+    Model *model = task->model;
+    Matrix X = model->splitdata.train_features;
+    int cols = model->classes;
+    double *out = &task->logits.data[thread_id * cols];
+    double lr = model->config.learning_rate.curr_learning_rate;
+    double l1 = 0.0;
+    double l2 = 0.0;
+    penaltyStrengths(&model->config, &l1, &l2);
+    // MSE carries a factor of 2, cross entropy does not
+    double scale = (model->type == LINEAR_REGRESSION) ? 2.0 : 1.0;
+    double error = 0.0;
+
+    for (int i = start; i < end; ++i)
+    {
+        int row = task->perm_arr[i];
+        const double *x = &X.data[row * X.cols];
+        const double *y = &task->y.data[row * task->y.cols];
+
+        // --- FORWARD PASS ---
+        for (int c = 0; c < cols; ++c)
+        {
+            out[c] = loadShared(&model->bias->data[c]);
+        }
+        for (int k = 0; k < X.cols; ++k)
+        {
+            if (x[k] == 0.0)
+            {
+                continue;
+            }
+            for (int c = 0; c < cols; ++c)
+            {
+                out[c] += x[k] * loadShared(&model->weights->data[k * cols + c]);
+            }
+        }
+
+        if (model->type == SOFTMAX_REGRESSION)
+        {
+            double maxx = out[0];
+            for (int c = 1; c < cols; ++c)
+            {
+                maxx = MAX(maxx, out[c]);
+            }
+            double sum = 0.0;
+            for (int c = 0; c < cols; ++c)
+            {
+                sum += exp(out[c] - maxx);
+            }
+            for (int c = 0; c < cols; ++c)
+            {
+                out[c] = exp(out[c] - maxx) / sum;
+            }
+        }
+        else if (model->type == LOGISTIC_REGRESSION)
+        {
+            Matrix row_logits = {1, cols, out};
+            if (applyToMatrix(&row_logits, model->func) < 0)
+            {
+                task->status[thread_id] = -1;
+                return;
+            }
+        }
+
+        // Softmax labels are class indices, the loss reads the true class only
+        int label = (model->type == SOFTMAX_REGRESSION) ? (int)y[0] : -1;
+        if (model->type == SOFTMAX_REGRESSION)
+        {
+            error += log(out[label]);
+        }
+        for (int c = 0; c < cols && model->type != SOFTMAX_REGRESSION; ++c)
+        {
+            if (model->type == LINEAR_REGRESSION)
+            {
+                error += (y[c] - out[c]) * (y[c] - out[c]);
+            }
+            else
+            {
+                error += y[c] * log(out[c]) + (1 - y[c]) * log(1 - out[c]);
+            }
+        }
+
+        // --- BACKWARD PASS, applied in place ---
+        for (int c = 0; c < cols; ++c)
+        {
+            double target = (model->type == SOFTMAX_REGRESSION) ? (double)(c == label) : y[c];
+            out[c] = scale * (out[c] - target);
+            double *bias = &model->bias->data[c];
+            storeShared(bias, loadShared(bias) - lr * out[c]);
+        }
+        for (int k = 0; k < X.cols; ++k)
+        {
+            if (x[k] == 0.0)
+            {
+                continue;
+            }
+            for (int c = 0; c < cols; ++c)
+            {
+                double *weight = &model->weights->data[k * cols + c];
+                double w = loadShared(weight);
+                double grad = out[c] * x[k];
+                // Regularize only the weights this row touches so the update stays sparse
+                grad += l1 * ((w > 0) ? 1.0 : (w < 0) ? -1.0 : 0.0) + 2 * l2 * w;
+                storeShared(weight, w - lr * grad);
+            }
+        }
+    }
+
+    task->loss.data[thread_id] = error;
+}
+
+/**
+ * @brief Train the model with Hogwild! lock-free asynchronous SGD. Every epoch the rows of
+ *        splitdata.train_features are shuffled and split into one block per thread, and every
+ *        thread updates the shared weights and bias after each of its rows.
+ *
+ * @param model Model object with weights and bias already made
+ * @param train_y Training labels, class indices for softmax
+ *
+ * @return 0 if successful, -1 if failure
+ */
+static int trainHogwild(Model *model, Matrix train_y)
+{
+    if (model->train_table.rows > 0 || !model->splitdata.train_features.data)
+    {
+        LOG_ERROR("Hogwild training reads splitdata.train_features, which was not set.\n");
+        return -1;
+    }
+
+    int rows = model->splitdata.train_features.rows;
+    HogwildTask task = {model, train_y, NULL, {0}, {0}, NULL};
+    int threads = planThreads(rows, HOGWILD_MIN_ROWS_PER_THREAD);
+    task.perm_arr = (int *)calloc(rows, sizeof(int));
+    task.status = (int *)calloc(threads, sizeof(int));
+    if (!task.perm_arr || !task.status ||
+        makeMatrixZeros(&task.logits, threads, model->classes) < 0 ||
+        makeVectorZeros(&task.loss, threads) < 0)
+    {
+        LOG_ERROR("Allocating the Hogwild worker buffers was unsuccessful.\n");
+        free(task.perm_arr);
+        free(task.status);
+        freeMatrix(&task.logits);
+        freeVector(&task.loss);
+        return -1;
+    }
+
+    int status = 0;
+    RandomState rng;
+    initRandomStream(&rng, model->config.seed);
+    PBD progress_bar;
+    initProgressBar(&progress_bar, 50, '[', ']', '#', '.', 0.1);
+    drawProgressBar(&progress_bar);
+
+    for (int epoch = 1; epoch <= model->config.epochs; ++epoch)
+    {
+        if (shufflePermutation(task.perm_arr, rows, &rng) < 0)
+        {
+            LOG_ERROR("Creating random permutation for input shuffling was unsuccessful.\n");
+            status = -1;
+            break;
+        }
+
+        if (parallelFor(threads, rows, hogwildTask, &task) < 0)
+        {
+            LOG_ERROR("Running the Hogwild workers was unsuccessful.\n");
+            status = -1;
+            break;
+        }
+        for (int t = 0; t < threads; ++t)
+        {
+            status = (task.status[t] < 0) ? -1 : status;
+        }
+        if (status < 0)
+        {
+            LOG_ERROR("Applying function to each member in logits matrix was unsuccessful.\n");
+            break;
+        }
+
+        // Average loss over the epoch, with the penalty of the final weights
+        double error = 0.0;
+        for (int t = 0; t < threads; ++t)
+        {
+            error += task.loss.data[t];
+        }
+        double loss = 0;
+        if (lossFromError(model, error, rows, &loss) < 0 || updateLearningRate(model, epoch) < 0)
+        {
+            LOG_ERROR("Updating the loss or learning rate was unsuccessful.\n");
+            status = -1;
+            break;
+        }
+
+        // Progress over time/epoch
+        progress_bar.n_curr_len = (epoch * progress_bar.m_max_len) / model->config.epochs;
+        progress_bar.loss = loss;
+        progress_bar.progress = (int)(((double)epoch / (double)model->config.epochs) * 100.0);
+        drawProgressBar(&progress_bar);
+    }
+    LOG_INFO("\n");
+
+    free(task.perm_arr);
+    free(task.status);
+    freeMatrix(&task.logits);
+    freeVector(&task.loss);
+    return status;
+}
+
+/**
+ * @brief Accumulate the upper triangle of [X 1]^T * [X 1] and [X 1]^T * y over a block of rows
+ *        into the thread's own slot, the trailing column of ones fits the bias
+ *
+ * @param args GramTask object
+ * @param thread_id Thread index
+ * @param start First row
+ * @param end One past the last row
+ *
+ * @return None
+ */
+static void gramTask(void *args, int thread_id, int start, int end)
+{
+    GramTask *task = (GramTask *)args;
+    int p = task->X.cols;
+    int d = p + 1;
+    int k = task->y.cols;
+    double *gram = &task->gram.data[thread_id * d * d];
+    double *xty = &task->xty.data[thread_id * d * k];
+
+    for (int r = start; r < end; ++r)
+    {
+        const double *x = &task->X.data[r * p];
+        const double *t = &task->y.data[r * k];
+        for (int i = 0; i < p; ++i)
+        {
+            double x_i = x[i];
+            if (x_i == 0.0)
+            {
+                continue;
+            }
+            double *g = &gram[i * d];
+            for (int j = i; j < p; ++j)
+            {
+                g[j] += x_i * x[j];
+            }
+            g[p] += x_i;
+            for (int c = 0; c < k; ++c)
+            {
+                xty[i * k + c] += x_i * t[c];
+            }
+        }
+        gram[p * d + p] += 1.0;
+        for (int c = 0; c < k; ++c)
+        {
+            xty[p * k + c] += t[c];
+        }
+    }
+}
+
+/**
+ * @brief Least squares fallback on the data itself, min ||[X 1; sqrt(n * lambda) I 0] * W - [y; 0]||
+ *
+ * @param X Training features
+ * @param y Training labels
+ * @param ridge Diagonal ridge term n * lambda, 0 for ordinary least squares
+ * @param W Resulting (features + 1) x outputs solution, bias in the last row
+ *
+ * @return 0 if successful, -1 if failure
+ */
+static int solveClosedFormQR(Matrix X, Matrix y, double ridge, Matrix *W)
+{
+    int p = X.cols;
+    int d = p + 1;
+    int extra = (ridge > 0) ? p : 0;
+    Matrix A = {0};
+    Matrix B = {0};
+    if (makeMatrixZeros(&A, X.rows + extra, d) < 0 || makeMatrixZeros(&B, X.rows + extra, y.cols) < 0)
+    {
+        LOG_ERROR("Could not allocate the least squares system.\n");
+        freeMatrix(&A);
+        return -1;
+    }
+
+    for (int r = 0; r < X.rows; ++r)
+    {
+        memcpy(&A.data[r * d], &X.data[r * p], p * sizeof(double));
+        A.data[r * d + p] = 1.0;
+        memcpy(&B.data[r * y.cols], &y.data[r * y.cols], y.cols * sizeof(double));
+    }
+    for (int i = 0; i < extra; ++i)
+    {
+        A.data[(X.rows + i) * d + i] = sqrt(ridge);
+    }
+
+    int status = qrLeastSquares(A, B, W);
+    freeMatrix(&A);
+    freeMatrix(&B);
+    return status;
+}
+
+/**
+ * @brief Fit a linear model exactly from the normal equations,
+ *        (X^T * X + n * lambda * I) * w = X^T * y with an unpenalized bias. The sums come from
+ *        one parallel pass over the data and are solved with Cholesky, falling back to QR on
+ *        the data when the system is singular or badly conditioned.
+ *
+ * @param model Model object with weights and bias already made
+ * @param train_y Training labels
+ *
+ * @return 0 if successful, -1 if failure
+ */
+static int solveClosedForm(Model *model, Matrix train_y)
+{
+    if (model->type != LINEAR_REGRESSION || model->config.regularization == REG_L1 || model->config.regularization == REG_ELASTIC_NET)
+    {
+        LOG_ERROR("The closed form solver only fits linear regression with no or L2 regularization.\n");
+        return -1;
+    }
+    if (model->train_table.rows > 0 || !model->splitdata.train_features.data)
+    {
+        LOG_ERROR("The closed form solver reads splitdata.train_features, which was not set.\n");
+        return -1;
+    }
+
+    Matrix X = model->splitdata.train_features;
+    int p = X.cols;
+    int d = p + 1;
+    int k = train_y.cols;
+    int threads = planThreads(X.rows, GRAM_MIN_ROWS_PER_THREAD);
+    GramTask task = {X, train_y, {0}, {0}};
+    if (makeMatrixZeros(&task.gram, threads, d * d) < 0 || makeMatrixZeros(&task.xty, threads, d * k) < 0)
+    {
+        LOG_ERROR("Could not allocate the normal equation sums.\n");
+        freeMatrix(&task.gram);
+        return -1;
+    }
+    parallelFor(threads, X.rows, gramTask, &task);
+
+    // Combine the thread slots in thread order so the sums do not depend on timing
+    Matrix L = {0};
+    Matrix W = {0};
+    if (makeMatrix(&L, d, d, task.gram.data, TYPE_DOUBLE) < 0 || makeMatrix(&W, d, k, task.xty.data, TYPE_DOUBLE) < 0)
+    {
+        LOG_ERROR("Could not allocate the normal equations.\n");
+        freeMatrix(&task.gram);
+        freeMatrix(&task.xty);
+        freeMatrix(&L);
+        return -1;
+    }
+    for (int t = 1; t < threads; ++t)
+    {
+        for (int i = 0; i < d * d; ++i)
+        {
+            L.data[i] += task.gram.data[t * d * d + i];
+        }
+        for (int i = 0; i < d * k; ++i)
+        {
+            W.data[i] += task.xty.data[t * d * k + i];
+        }
+    }
+    freeMatrix(&task.gram);
+    freeMatrix(&task.xty);
+
+    double ridge = (model->config.regularization == REG_L2) ? X.rows * model->config.lambda : 0.0;
+    for (int i = 0; i < d; ++i)
+    {
+        for (int j = 0; j < i; ++j)
+        {
+            L.data[i * d + j] = L.data[j * d + i];
+        }
+        if (i < p)
+        {
+            L.data[i * d + i] += ridge;
+        }
+    }
+
+    // cond(X^T * X) is at least (max L_ii / min L_ii)^2
+    bool use_qr = choleskyDecompose(&L) < 0;
+    if (!use_qr)
+    {
+        double lo = L.data[0];
+        double hi = L.data[0];
+        for (int i = 1; i < d; ++i)
+        {
+            lo = MIN(lo, L.data[i * d + i]);
+            hi = MAX(hi, L.data[i * d + i]);
+        }
+        use_qr = (hi / lo) * (hi / lo) > CLOSED_FORM_MAX_CONDITION;
+    }
+
+    int status = 0;
+    if (use_qr)
+    {
+        LOG_WARN("Normal equations are badly conditioned, solving with QR instead.\n");
+        status = solveClosedFormQR(X, train_y, ridge, &W);
+    }
+    else
+    {
+        status = choleskySolve(L, &W);
+    }
+
+    if (status == 0)
+    {
+        memcpy(model->weights->data, W.data, p * k * sizeof(double));
+        memcpy(model->bias->data, &W.data[p * k], k * sizeof(double));
+    }
+    else
+    {
+        LOG_ERROR("Solving the normal equations was unsuccessful.\n");
+    }
+
+    freeMatrix(&L);
+    freeMatrix(&W);
+    return status;
+}
+
+/**
+ * @brief Copy the weights and bias into one flat parameter array, weights first
+ *
+ * @param model Model object
+ * @param x Parameter array of weights + bias values
+ *
+ * @return None
+ */
+static void getParameters(const Model *model, double *x)
+{
+    int w = model->weights->rows * model->weights->cols;
+    memcpy(x, model->weights->data, w * sizeof(double));
+    memcpy(&x[w], model->bias->data, model->bias->size * sizeof(double));
+}
+
+/**
+ * @brief Copy a flat parameter array back into the weights and bias
+ *
+ * @param model Model object
+ * @param x Parameter array of weights + bias values
+ *
+ * @return None
+ */
+static void setParameters(Model *model, const double *x)
+{
+    int w = model->weights->rows * model->weights->cols;
+    memcpy(model->weights->data, x, w * sizeof(double));
+    memcpy(model->bias->data, &x[w], model->bias->size * sizeof(double));
+}
+
+/**
+ * @brief Full-batch objective and gradient at x + alpha * d, the trial point is left in x_trial
+ *
+ * @param solver LBFGSState object
+ * @param alpha Step length along the search direction
+ * @param loss Set to the objective at the trial point
+ * @param dphi Set to the directional derivative g^T * d at the trial point
+ *
+ * @return 0 if successful, -1 if failure
+ */
+static int evaluateLBFGSTrial(LBFGSState *solver, double alpha, double *loss, double *dphi)
+{
+    Model *model = solver->model;
+    int n = solver->x.size;
+    for (int i = 0; i < n; ++i)
+    {
+        solver->x_trial.data[i] = solver->x.data[i] + alpha * solver->d.data[i];
+    }
+    setParameters(model, solver->x_trial.data);
+
+    int status = (solver->sparse) ? computeSparseGradients(model, *solver->sparse, solver->y, &solver->ws, loss)
+                                  : computeBatchGradients(model, solver->X, solver->y, &solver->ws, loss);
+    if (status < 0)
+    {
+        LOG_ERROR("Evaluating the objective for L-BFGS was unsuccessful.\n");
+        return -1;
+    }
+
+    int w = solver->ws.grad_w.rows * solver->ws.grad_w.cols;
+    memcpy(solver->g_trial.data, solver->ws.grad_w.data, w * sizeof(double));
+    memcpy(&solver->g_trial.data[w], solver->ws.grad_b.data, solver->ws.grad_b.size * sizeof(double));
+    ++solver->evaluations;
+
+    return dot_product(solver->g_trial, solver->d, dphi);
+}
+
+/**
+ * @brief Minimizer of the cubic through two points with known values and slopes,
+ *        kept inside the middle 80% of the interval and bisected otherwise
+ *
+ * @param a First step length
+ * @param f_a Objective at a
+ * @param dphi_a Slope at a
+ * @param b Second step length
+ * @param f_b Objective at b
+ * @param dphi_b Slope at b
+ *
+ * @return Step length between a and b
+ */
+static double interpolateStep(double a, double f_a, double dphi_a, double b, double f_b, double dphi_b)
+{
+    double d1 = dphi_a + dphi_b - 3.0 * (f_a - f_b) / (a - b);
+    double radicand = d1 * d1 - dphi_a * dphi_b;
+    double lo = MIN(a, b) + 0.1 * fabs(b - a);
+    double hi = MAX(a, b) - 0.1 * fabs(b - a);
+    if (radicand >= 0.0 && isfinite(f_a) && isfinite(f_b))
+    {
+        double d2 = ((b > a) ? 1.0 : -1.0) * sqrt(radicand);
+        double step = b - (b - a) * (dphi_b + d2 - d1) / (dphi_b - dphi_a + 2.0 * d2);
+        if (isfinite(step) && step >= lo && step <= hi)
+        {
+            return step;
+        }
+    }
+
+    return 0.5 * (a + b);
+}
+
+/**
+ * @brief Line search along d for a step that meets the strong Wolfe conditions,
+ *        Algorithms 3.5 and 3.6 in Nocedal and Wright. On success the accepted point
+ *        and its gradient are left in x_trial and g_trial.
+ *
+ * @param solver LBFGSState object with x, its objective f and slope dphi0 along d
+ * @param alpha Initial step length, set to the accepted step
+ * @param f Objective at x, set to the objective at the accepted step
+ *
+ * @return 0 if successful, -1 if no acceptable step was found
+ */
+static int strongWolfeSearch(LBFGSState *solver, double *alpha, double *f)
+{
+    double f0 = *f;
+    double dphi0 = solver->dphi0;
+    double a_prev = 0.0;
+    double f_prev = f0;
+    double dphi_prev = dphi0;
+    double a = *alpha;
+
+    for (int i = 0; i < LBFGS_MAX_LINE_SEARCH; ++i)
+    {
+        double f_a = 0.0;
+        double dphi_a = 0.0;
+        if (evaluateLBFGSTrial(solver, a, &f_a, &dphi_a) < 0)
+        {
+            return -1;
+        }
+
+        // Bracketing phase, an overflowing loss counts as too large
+        bool bracketed = !isfinite(f_a) || f_a > f0 + LBFGS_WOLFE_C1 * a * dphi0 || (i > 0 && f_a >= f_prev);
+        double lo = a_prev, f_lo = f_prev, dphi_lo = dphi_prev;
+        double hi = a, f_hi = f_a, dphi_hi = dphi_a;
+        if (!bracketed)
+        {
+            if (fabs(dphi_a) <= -LBFGS_WOLFE_C2 * dphi0)
+            {
+                *alpha = a;
+                *f = f_a;
+                return 0;
+            }
+            if (dphi_a < 0.0)
+            {
+                a_prev = a;
+                f_prev = f_a;
+                dphi_prev = dphi_a;
+                a *= 2.0;
+                continue;
+            }
+            // Slope turned positive, the minimum lies between a and the previous step
+            lo = a;
+            f_lo = f_a;
+            dphi_lo = dphi_a;
+            hi = a_prev;
+            f_hi = f_prev;
+            dphi_hi = dphi_prev;
+        }
+
+        // Zoom phase, shrink [lo, hi] keeping lo the best point with sufficient decrease
+        for (int j = 0; j < LBFGS_MAX_LINE_SEARCH; ++j)
+        {
+            a = interpolateStep(lo, f_lo, dphi_lo, hi, f_hi, dphi_hi);
+            if (evaluateLBFGSTrial(solver, a, &f_a, &dphi_a) < 0)
+            {
+                return -1;
+            }
+
+            if (!isfinite(f_a) || f_a > f0 + LBFGS_WOLFE_C1 * a * dphi0 || f_a >= f_lo)
+            {
+                hi = a;
+                f_hi = f_a;
+                dphi_hi = dphi_a;
+                continue;
+            }
+            if (fabs(dphi_a) <= -LBFGS_WOLFE_C2 * dphi0)
+            {
+                *alpha = a;
+                *f = f_a;
+                return 0;
+            }
+            if (dphi_a * (hi - lo) >= 0.0)
+            {
+                hi = lo;
+                f_hi = f_lo;
+                dphi_hi = dphi_lo;
+            }
+            lo = a;
+            f_lo = f_a;
+            dphi_lo = dphi_a;
+        }
+        break;
+    }
+
+    return -1;
+}
+
+/**
+ * @brief Search direction d = -H * g from the stored correction pairs, the L-BFGS two-loop recursion
+ *
+ * @param solver LBFGSState object
+ *
+ * @return None
+ */
+static void computeLBFGSDirection(LBFGSState *solver)
+{
+    int n = solver->x.size;
+    double *d = solver->d.data;
+    for (int i = 0; i < n; ++i)
+    {
+        d[i] = -solver->g.data[i];
+    }
+
+    // Newest pair to oldest
+    for (int k = 0; k < solver->pairs; ++k)
+    {
+        int slot = (solver->newest - k + solver->history) % solver->history;
+        const double *s = &solver->S.data[slot * n];
+        const double *y = &solver->Y.data[slot * n];
+        double a = 0.0;
+        for (int i = 0; i < n; ++i)
+        {
+            a += s[i] * d[i];
+        }
+        a *= solver->rho.data[slot];
+        solver->alpha.data[slot] = a;
+        for (int i = 0; i < n; ++i)
+        {
+            d[i] -= a * y[i];
+        }
+    }
+
+    // Initial Hessian guess gamma * I from the newest pair
+    if (solver->pairs > 0)
+    {
+        const double *s = &solver->S.data[solver->newest * n];
+        const double *y = &solver->Y.data[solver->newest * n];
+        double sy = 0.0;
+        double yy = 0.0;
+        for (int i = 0; i < n; ++i)
+        {
+            sy += s[i] * y[i];
+            yy += y[i] * y[i];
+        }
+        for (int i = 0; i < n; ++i)
+        {
+            d[i] *= sy / yy;
+        }
+    }
+
+    // Oldest pair to newest
+    for (int k = solver->pairs - 1; k >= 0; --k)
+    {
+        int slot = (solver->newest - k + solver->history) % solver->history;
+        const double *s = &solver->S.data[slot * n];
+        const double *y = &solver->Y.data[slot * n];
+        double b = 0.0;
+        for (int i = 0; i < n; ++i)
+        {
+            b += y[i] * d[i];
+        }
+        b *= solver->rho.data[slot];
+        for (int i = 0; i < n; ++i)
+        {
+            d[i] += (solver->alpha.data[slot] - b) * s[i];
+        }
+    }
+}
+
+/**
+ * @brief Free every buffer of the L-BFGS solver
+ *
+ * @param solver LBFGSState object
+ *
+ * @return None
+ */
+static void freeLBFGSState(LBFGSState *solver)
+{
+    freeVector(&solver->x);
+    freeVector(&solver->g);
+    freeVector(&solver->d);
+    freeVector(&solver->x_trial);
+    freeVector(&solver->g_trial);
+    freeVector(&solver->s_new);
+    freeVector(&solver->y_new);
+    freeMatrix(&solver->S);
+    freeMatrix(&solver->Y);
+    freeVector(&solver->rho);
+    freeVector(&solver->alpha);
+    freeTrainWorkspace(&solver->ws);
+}
+
+/**
+ * @brief Fit the model with full-batch L-BFGS and a strong Wolfe line search. Every objective
+ *        evaluation is one fused parallel pass for the loss and gradient, or two CSR products
+ *        when train_sparse is set, config.epochs caps the iterations and the fit stops once the
+ *        largest gradient entry is below config.tolerance.
+ *
+ * @param model Model object with weights and bias already made
+ * @param train_y Training labels, class indices for softmax
+ *
+ * @return 0 if successful, -1 if failure
+ */
+static int trainLBFGS(Model *model, Matrix train_y)
+{
+    if (model->config.regularization == REG_L1 || model->config.regularization == REG_ELASTIC_NET)
+    {
+        LOG_ERROR("L-BFGS needs a smooth objective, use REG_NONE or REG_L2.\n");
+        return -1;
+    }
+    bool sparse = model->train_sparse.rows > 0;
+    if (model->train_table.rows > 0 || (!sparse && !model->splitdata.train_features.data))
+    {
+        LOG_ERROR("L-BFGS reads splitdata.train_features or train_sparse, neither was set.\n");
+        return -1;
+    }
+
+    LBFGSState solver;
+    memset(&solver, 0, sizeof(LBFGSState));
+    solver.model = model;
+    solver.X = model->splitdata.train_features;
+    solver.sparse = (sparse) ? &model->train_sparse : NULL;
+    solver.y = train_y;
+    solver.history = (model->config.history > 0) ? model->config.history : LBFGS_DEFAULT_HISTORY;
+    int rows = (sparse) ? model->train_sparse.rows : solver.X.rows;
+    int n = model->weights->rows * model->weights->cols + model->bias->size;
+
+    // Sparse features skip the dense shards and only need the full-batch logits and errors
+    int ws_status = makeTrainWorkspace(&solver.ws, model, rows, !sparse);
+    if (ws_status == 0 && sparse)
+    {
+        freeMatrix(model->logits);
+        ws_status = (makeMatrixZeros(model->logits, rows, model->classes) < 0 ||
+                     makeMatrixZeros(&solver.ws.dZ, rows, model->classes) < 0) ? -1 : 0;
+    }
+    if (ws_status < 0 ||
+        makeVectorZeros(&solver.x, n) < 0 || makeVectorZeros(&solver.g, n) < 0 ||
+        makeVectorZeros(&solver.d, n) < 0 || makeVectorZeros(&solver.x_trial, n) < 0 ||
+        makeVectorZeros(&solver.g_trial, n) < 0 || makeVectorZeros(&solver.s_new, n) < 0 ||
+        makeVectorZeros(&solver.y_new, n) < 0 || makeMatrixZeros(&solver.S, solver.history, n) < 0 ||
+        makeMatrixZeros(&solver.Y, solver.history, n) < 0 || makeVectorZeros(&solver.rho, solver.history) < 0 ||
+        makeVectorZeros(&solver.alpha, solver.history) < 0)
+    {
+        LOG_ERROR("Allocating the L-BFGS buffers was unsuccessful.\n");
+        freeLBFGSState(&solver);
+        return -1;
+    }
+
+    // Objective and gradient at the starting point
+    double f = 0.0;
+    double dphi = 0.0;
+    getParameters(model, solver.x.data);
+    int status = evaluateLBFGSTrial(&solver, 0.0, &f, &dphi);
+    memcpy(solver.g.data, solver.g_trial.data, n * sizeof(double));
+
+    PBD progress_bar;
+    initProgressBar(&progress_bar, 50, '[', ']', '#', '.', 0.1);
+    drawProgressBar(&progress_bar);
+
+    for (int iter = 1; iter <= model->config.epochs && status == 0; ++iter)
+    {
+        double g_max = 0.0;
+        for (int i = 0; i < n; ++i)
+        {
+            g_max = MAX(g_max, fabs(solver.g.data[i]));
+        }
+        if (g_max <= model->config.tolerance)
+        {
+            break;
+        }
+
+        computeLBFGSDirection(&solver);
+        dot_product(solver.g, solver.d, &solver.dphi0);
+        if (solver.dphi0 >= 0.0)
+        {
+            // Curvature information went stale, restart from steepest descent
+            solver.pairs = 0;
+            computeLBFGSDirection(&solver);
+            dot_product(solver.g, solver.d, &solver.dphi0);
+        }
+
+        // Unit step once the curvature is known, a step of unit length before that
+        double alpha = (solver.pairs > 0) ? 1.0 : MIN(1.0, 1.0 / g_max);
+        double f_prev = f;
+        if (strongWolfeSearch(&solver, &alpha, &f) < 0)
+        {
+            LOG_WARN("L-BFGS line search found no acceptable step, stopping at iteration %d.\n", iter);
+            f = f_prev;
+            break;
+        }
+
+        // Store the new correction pair, skipping pairs without positive curvature. A skipped
+        // pair must not touch the ring, its next slot still holds the oldest live pair.
+        double sy = 0.0;
+        for (int i = 0; i < n; ++i)
+        {
+            solver.s_new.data[i] = solver.x_trial.data[i] - solver.x.data[i];
+            solver.y_new.data[i] = solver.g_trial.data[i] - solver.g.data[i];
+            sy += solver.s_new.data[i] * solver.y_new.data[i];
+        }
+        if (sy > LBFGS_MIN_CURVATURE)
+        {
+            int slot = (solver.newest + 1) % solver.history;
+            memcpy(&solver.S.data[slot * n], solver.s_new.data, n * sizeof(double));
+            memcpy(&solver.Y.data[slot * n], solver.y_new.data, n * sizeof(double));
+            solver.rho.data[slot] = 1.0 / sy;
+            solver.newest = slot;
+            solver.pairs = MIN(solver.pairs + 1, solver.history);
+        }
+        memcpy(solver.x.data, solver.x_trial.data, n * sizeof(double));
+        memcpy(solver.g.data, solver.g_trial.data, n * sizeof(double));
+
+        // Progress over time/iteration
+        progress_bar.n_curr_len = (iter * progress_bar.m_max_len) / model->config.epochs;
+        progress_bar.loss = f;
+        progress_bar.progress = (int)(((double)iter / (double)model->config.epochs) * 100.0);
+        drawProgressBar(&progress_bar);
+
+        if (f_prev - f <= LBFGS_MIN_DECREASE * MAX(fabs(f), 1.0))
+        {
+            break;
+        }
+    }
+    LOG_INFO("\n");
+    LOG_DEBUG("L-BFGS finished with loss %f after %d objective evaluations.\n", f, solver.evaluations);
+
+    // The model keeps the last accepted point, not the last trial
+    setParameters(model, solver.x.data);
+    freeMatrix(model->logits);
+    freeLBFGSState(&solver);
+    return status;
+}
+
+/**
+ * @brief Accumulate the logistic loss, the gradient and optionally the upper triangle of the
+ *        weighted Hessian [X 1]^T * W * [X 1] over a block of rows, W = p * (1 - p)
+ *
+ * @param args NewtonTask object
+ * @param thread_id Thread index, selects the thread's slot in the sums
+ * @param start First row
+ * @param end One past the last row
+ *
+ * @return None
+ */
+static void newtonTask(void *args, int thread_id, int start, int end)
+{
+    NewtonTask *task = (NewtonTask *)args;
+    int p = task->X.cols;
+    int d = p + 1;
+    const double *params = task->params;
+    double *grad = &task->grad.data[thread_id * d];
+    double *hessian = task->with_hessian ? &task->hessian.data[thread_id * d * d] : NULL;
+    double loss = 0.0;
+
+    for (int r = start; r < end; ++r)
+    {
+        const double *x = &task->X.data[r * p];
+        double t = task->y.data[r];
+        double z = params[p];
+        for (int i = 0; i < p; ++i)
+        {
+            z += x[i] * params[i];
+        }
+
+        // log(1 + e^z) - t * z without overflow for large |z|
+        loss += ((z > 0.0) ? z + log1p(exp(-z)) : log1p(exp(z))) - t * z;
+        double prob = 1.0 / (1.0 + exp(-z));
+        double residual = prob - t;
+        for (int i = 0; i < p; ++i)
+        {
+            grad[i] += residual * x[i];
+        }
+        grad[p] += residual;
+
+        if (!hessian)
+        {
+            continue;
+        }
+        double weight = prob * (1.0 - prob);
+        for (int i = 0; i < p; ++i)
+        {
+            double wx_i = weight * x[i];
+            if (wx_i == 0.0)
+            {
+                continue;
+            }
+            double *h = &hessian[i * d];
+            for (int j = i; j < p; ++j)
+            {
+                h[j] += wx_i * x[j];
+            }
+            h[p] += wx_i;
+        }
+        hessian[p * d + p] += weight;
+    }
+
+    task->loss.data[thread_id] = loss;
+}
+
+/**
+ * @brief Mean L2 regularized logistic loss and gradient at task->params, with the Hessian
+ *        when task->with_hessian is set. Thread slots are summed in thread order.
+ *
+ * @param task NewtonTask object
+ * @param lambda L2 strength, 0 for none
+ * @param H Resulting d x d Hessian, only written when task->with_hessian is set
+ * @param g Resulting gradient of d values
+ * @param loss Resulting loss
+ *
+ * @return 0 if successful, -1 if failure
+ */
+static int evaluateNewton(NewtonTask *task, double lambda, Matrix *H, Vector *g, double *loss)
+{
+    int p = task->X.cols;
+    int d = p + 1;
+    int n = task->X.rows;
+    clearMatrix(&task->grad);
+    clearVector(&task->loss);
+    if (task->with_hessian)
+    {
+        clearMatrix(&task->hessian);
+    }
+    if (parallelFor(task->threads, n, newtonTask, task) < 0)
+    {
+        LOG_ERROR("Newton objective pass was unsuccessful.\n");
+        return -1;
+    }
+
+    double penalty = 0.0;
+    for (int i = 0; i < p; ++i)
+    {
+        penalty += task->params[i] * task->params[i];
+    }
+    *loss = 0.0;
+    for (int t = 0; t < task->threads; ++t)
+    {
+        *loss += task->loss.data[t];
+    }
+    *loss = *loss / n + lambda * penalty;
+
+    for (int i = 0; i < d; ++i)
+    {
+        double sum = 0.0;
+        for (int t = 0; t < task->threads; ++t)
+        {
+            sum += task->grad.data[t * d + i];
+        }
+        g->data[i] = sum / n + ((i < p) ? 2.0 * lambda * task->params[i] : 0.0);
+    }
+
+    if (!task->with_hessian)
+    {
+        return 0;
+    }
+    for (int i = 0; i < d; ++i)
+    {
+        for (int j = i; j < d; ++j)
+        {
+            double sum = 0.0;
+            for (int t = 0; t < task->threads; ++t)
+            {
+                sum += task->hessian.data[t * d * d + i * d + j];
+            }
+            H->data[i * d + j] = sum / n + ((i == j && i < p) ? 2.0 * lambda : 0.0);
+            H->data[j * d + i] = H->data[i * d + j];
+        }
+    }
+
+    return 0;
+}
+
+/**
+ * @brief Newton step d = -H^-1 * g through Cholesky, the diagonal is damped when H is not
+ *        positive definite, which happens on separable data without L2
+ *
+ * @param H d x d Hessian
+ * @param g Gradient
+ * @param L d x d scratch Matrix for the factor
+ * @param step d x 1 Matrix set to the step
+ *
+ * @return 0 if successful, -1 if failure
+ */
+static int solveNewtonStep(Matrix H, Vector g, Matrix *L, Matrix *step)
+{
+    int d = H.rows;
+    double scale = 0.0;
+    for (int i = 0; i < d; ++i)
+    {
+        scale = MAX(scale, H.data[i * d + i]);
+    }
+
+    double damping = 0.0;
+    for (int attempt = 0; attempt < NEWTON_MAX_DAMPING_TRIES; ++attempt)
+    {
+        memcpy(L->data, H.data, d * d * sizeof(double));
+        for (int i = 0; i < d; ++i)
+        {
+            L->data[i * d + i] += damping;
+            step->data[i] = -g.data[i];
+        }
+        if (choleskyDecompose(L) == 0)
+        {
+            return choleskySolve(*L, step);
+        }
+        damping = (damping > 0.0) ? damping * 10.0 : NEWTON_MIN_DAMPING * MAX(scale, 1.0);
+    }
+
+    LOG_ERROR("Hessian stayed singular after damping, Newton step was unsuccessful.\n");
+    return -1;
+}
+
+/**
+ * @brief Free every buffer of the Newton solver
+ *
+ * @param task NewtonTask object
+ * @param H Hessian
+ * @param L Cholesky factor
+ * @param step Newton step
+ * @param g Gradient
+ * @param trial Trial parameters
+ *
+ * @return None
+ */
+static void freeNewtonBuffers(NewtonTask *task, Matrix *H, Matrix *L, Matrix *step, Vector *g, Vector *trial)
+{
+    freeMatrix(&task->hessian);
+    freeMatrix(&task->grad);
+    freeVector(&task->loss);
+    freeMatrix(H);
+    freeMatrix(L);
+    freeMatrix(step);
+    freeVector(g);
+    freeVector(trial);
+}
+
+/**
+ * @brief Fit binary logistic regression with Newton's method (IRLS). Each iteration forms the
+ *        gradient and the weighted Hessian [X 1]^T * W * [X 1] in one parallel pass, solves
+ *        for the step with Cholesky and backtracks until the loss decreases. config.epochs
+ *        caps the iterations and the fit stops once the largest gradient entry is below
+ *        config.tolerance.
+ *
+ * @param model Model object with weights and bias already made
+ * @param train_y Training labels of 0 and 1
+ *
+ * @return 0 if successful, -1 if failure
+ */
+static int trainNewton(Model *model, Matrix train_y)
+{
+    if (model->type != LOGISTIC_REGRESSION || model->classes != 1 || model->config.regularization == REG_L1 ||
+        model->config.regularization == REG_ELASTIC_NET)
+    {
+        LOG_ERROR("The Newton solver only fits binary logistic regression with no or L2 regularization.\n");
+        return -1;
+    }
+    if (model->train_table.rows > 0 || !model->splitdata.train_features.data)
+    {
+        LOG_ERROR("The Newton solver reads splitdata.train_features, which was not set.\n");
+        return -1;
+    }
+
+    Matrix X = model->splitdata.train_features;
+    int p = X.cols;
+    int d = p + 1;
+    if (p > NEWTON_MAX_FEATURES)
+    {
+        LOG_WARN("Newton solver forms a %d x %d Hessian every iteration, L-BFGS scales better.\n", d, d);
+    }
+
+    NewtonTask task = {X, train_y, NULL, false, planThreads(X.rows, GRAM_MIN_ROWS_PER_THREAD), {0}, {0}, {0}};
+    Matrix H = {0};
+    Matrix L = {0};
+    Matrix step = {0};
+    Vector g = {0};
+    Vector x = {0};
+    Vector trial = {0};
+    if (makeMatrixZeros(&task.hessian, task.threads, d * d) < 0 || makeMatrixZeros(&task.grad, task.threads, d) < 0 ||
+        makeVectorZeros(&task.loss, task.threads) < 0 || makeMatrixZeros(&H, d, d) < 0 ||
+        makeMatrixZeros(&L, d, d) < 0 || makeMatrixZeros(&step, d, 1) < 0 ||
+        makeVectorZeros(&g, d) < 0 || makeVectorZeros(&x, d) < 0 || makeVectorZeros(&trial, d) < 0)
+    {
+        LOG_ERROR("Allocating the Newton solver buffers was unsuccessful.\n");
+        freeNewtonBuffers(&task, &H, &L, &step, &g, &trial);
+        freeVector(&x);
+        return -1;
+    }
+    memcpy(x.data, model->weights->data, p * sizeof(double));
+    x.data[p] = model->bias->data[0];
+
+    double lambda = (model->config.regularization == REG_L2) ? model->config.lambda : 0.0;
+    double f = 0.0;
+    int status = 0;
+
+    PBD progress_bar;
+    initProgressBar(&progress_bar, 50, '[', ']', '#', '.', 0.1);
+    drawProgressBar(&progress_bar);
+
+    for (int iter = 1; iter <= model->config.epochs; ++iter)
+    {
+        task.params = x.data;
+        task.with_hessian = true;
+        if (evaluateNewton(&task, lambda, &H, &g, &f) < 0)
+        {
+            status = -1;
+            break;
+        }
+
+        double g_max = 0.0;
+        for (int i = 0; i < d; ++i)
+        {
+            g_max = MAX(g_max, fabs(g.data[i]));
+        }
+        if (g_max <= model->config.tolerance)
+        {
+            break;
+        }
+
+        if (solveNewtonStep(H, g, &L, &step) < 0)
+        {
+            status = -1;
+            break;
+        }
+
+        // Backtrack from the full step until the loss decreases enough
+        double slope = 0.0;
+        for (int i = 0; i < d; ++i)
+        {
+            slope += g.data[i] * step.data[i];
+        }
+        double alpha = 1.0;
+        double f_trial = f;
+        task.params = trial.data;
+        task.with_hessian = false;
+        int tries = 0;
+        for (; tries < NEWTON_MAX_BACKTRACKS; ++tries, alpha *= 0.5)
+        {
+            for (int i = 0; i < d; ++i)
+            {
+                trial.data[i] = x.data[i] + alpha * step.data[i];
+            }
+            if (evaluateNewton(&task, lambda, NULL, &g, &f_trial) < 0)
+            {
+                status = -1;
+                break;
+            }
+            if (f_trial <= f + NEWTON_ARMIJO * alpha * slope)
+            {
+                break;
+            }
+        }
+        if (status < 0)
+        {
+            break;
+        }
+        if (tries == NEWTON_MAX_BACKTRACKS)
+        {
+            LOG_WARN("Newton step did not decrease the loss, stopping at iteration %d.\n", iter);
+            break;
+        }
+        memcpy(x.data, trial.data, d * sizeof(double));
+        f = f_trial;
+
+        // Progress over time/iteration
+        progress_bar.n_curr_len = (iter * progress_bar.m_max_len) / model->config.epochs;
+        progress_bar.loss = f;
+        progress_bar.progress = (int)(((double)iter / (double)model->config.epochs) * 100.0);
+        drawProgressBar(&progress_bar);
+    }
+    LOG_INFO("\n");
+    LOG_DEBUG("Newton solver finished with loss %f.\n", f);
+
+    memcpy(model->weights->data, x.data, p * sizeof(double));
+    model->bias->data[0] = x.data[p];
+    freeNewtonBuffers(&task, &H, &L, &step, &g, &trial);
+    freeVector(&x);
+    return status;
+}
+
+/**
+ * @brief Soft-thresholding S(x, t) = sign(x) * max(|x| - t, 0), the exact minimizer of a
+ *        quadratic plus an L1 term along one coordinate
+ *
+ * @param x Value to shrink
+ * @param t Threshold
+ *
+ * @return Shrunk value, exactly 0 when |x| <= t
+ */
+static double softThreshold(double x, double t)
+{
+    if (x > t)
+    {
+        return x - t;
+    }
+    if (x < -t)
+    {
+        return x + t;
+    }
+    return 0.0;
+}
+
+/**
+ * @brief Column means over a block of features, for linear regression also the centered
+ *        curvature 2 * G_jj and the centered X^T * y / n
+ *
+ * @param args CoordinateDescent object
+ * @param thread_id Thread index
+ * @param start First feature
+ * @param end One past the last feature
+ *
+ * @return None
+ */
+static void cdStatsTask(void *args, int thread_id, int start, int end)
+{
+    (void)thread_id;
+    CoordinateDescent *cd = (CoordinateDescent *)args;
+    int n = cd->Xt.cols;
+
+    for (int j = start; j < end; ++j)
+    {
+        const double *x = &cd->Xt.data[j * n];
+        double sum = 0.0;
+        for (int i = 0; i < n; ++i)
+        {
+            sum += x[i];
+        }
+        double mean = sum / n;
+        cd->mean.data[j] = mean;
+        if (cd->logistic)
+        {
+            continue;
+        }
+
+        double square = 0.0;
+        double cross = 0.0;
+        for (int i = 0; i < n; ++i)
+        {
+            double centered = x[i] - mean;
+            square += centered * centered;
+            cross += centered * (cd->y.data[i] - cd->y_mean);
+        }
+        cd->curvature.data[j] = 2.0 * square / n;
+        cd->xty.data[j] = cross / n;
+    }
+}
+
+/**
+ * @brief Centered Gram entries G_jk = (x_j - mean_j)^T * (x_k - mean_k) / n of column
+ *        k = cd->column over a block of features j
+ *
+ * @param args CoordinateDescent object
+ * @param thread_id Thread index
+ * @param start First feature
+ * @param end One past the last feature
+ *
+ * @return None
+ */
+static void cdGramTask(void *args, int thread_id, int start, int end)
+{
+    (void)thread_id;
+    CoordinateDescent *cd = (CoordinateDescent *)args;
+    int n = cd->Xt.cols;
+    int k = cd->column;
+    const double *x_k = &cd->Xt.data[k * n];
+    double mean_k = cd->mean.data[k];
+
+    for (int j = start; j < end; ++j)
+    {
+        const double *x_j = &cd->Xt.data[j * n];
+        double mean_j = cd->mean.data[j];
+        double sum = 0.0;
+        for (int i = 0; i < n; ++i)
+        {
+            sum += (x_j[i] - mean_j) * (x_k[i] - mean_k);
+        }
+        cd->gram[k].data[j] = sum / n;
+    }
+}
+
+/**
+ * @brief Fill the Gram column of a feature the first time its weight turns nonzero, so only
+ *        the columns of the active features are ever computed
+ *
+ * @param cd CoordinateDescent object
+ * @param k Feature index
+ *
+ * @return 0 if successful, -1 if failure
+ */
+static int cdGramColumn(CoordinateDescent *cd, int k)
+{
+    if (cd->gram[k].data)
+    {
+        return 0;
+    }
+
+    int p = cd->Xt.rows;
+    if (makeVectorZeros(&cd->gram[k], p) < 0)
+    {
+        LOG_ERROR("Allocating Gram column %d was unsuccessful.\n", k);
+        return -1;
+    }
+    cd->column = k;
+    if (parallelFor(cd->column_threads, p, cdGramTask, cd) < 0)
+    {
+        LOG_ERROR("Computing Gram column %d was unsuccessful.\n", k);
+        return -1;
+    }
+    return 0;
+}
+
+/**
+ * @brief Linear predictor, IRLS weight and working residual over a block of rows. The
+ *        predictor is summed column by column over the nonzero weights only.
+ *
+ * @param args CoordinateDescent object
+ * @param thread_id Thread index
+ * @param start First row
+ * @param end One past the last row
+ *
+ * @return None
+ */
+static void cdLinkTask(void *args, int thread_id, int start, int end)
+{
+    (void)thread_id;
+    CoordinateDescent *cd = (CoordinateDescent *)args;
+    int n = cd->Xt.cols;
+    int p = cd->Xt.rows;
+    double *z = cd->z.data;
+
+    for (int i = start; i < end; ++i)
+    {
+        z[i] = cd->bias;
+    }
+    for (int j = 0; j < p; ++j)
+    {
+        double w = cd->weights.data[j];
+        if (w == 0.0)
+        {
+            continue;
+        }
+        const double *x = &cd->Xt.data[j * n];
+        for (int i = start; i < end; ++i)
+        {
+            z[i] += w * x[i];
+        }
+    }
+    for (int i = start; i < end; ++i)
+    {
+        double prob = 1.0 / (1.0 + exp(-z[i]));
+        double weight = MAX(prob * (1.0 - prob), CD_MIN_IRLS_WEIGHT);
+        cd->irls.data[i] = weight;
+        cd->resid.data[i] = (cd->y.data[i] - prob) / weight;
+    }
+}
+
+/**
+ * @brief Weighted curvature (1 / n) * sum(w * x_j^2) and logistic loss gradient
+ *        (1 / n) * sum((p - y) * x_j) over a block of features
+ *
+ * @param args CoordinateDescent object
+ * @param thread_id Thread index
+ * @param start First feature
+ * @param end One past the last feature
+ *
+ * @return None
+ */
+static void cdCurvatureTask(void *args, int thread_id, int start, int end)
+{
+    (void)thread_id;
+    CoordinateDescent *cd = (CoordinateDescent *)args;
+    int n = cd->Xt.cols;
+
+    for (int j = start; j < end; ++j)
+    {
+        const double *x = &cd->Xt.data[j * n];
+        double curvature = 0.0;
+        double grad = 0.0;
+        for (int i = 0; i < n; ++i)
+        {
+            double wx = cd->irls.data[i] * x[i];
+            curvature += wx * x[i];
+            grad -= wx * cd->resid.data[i];
+        }
+        cd->curvature.data[j] = curvature / n;
+        cd->grad.data[j] = grad / n;
+    }
+}
+
+/**
+ * @brief Refresh the quadratic model of the logistic loss at the current weights, along with
+ *        the gradient of every feature for the screening
+ *
+ * @param cd CoordinateDescent object
+ *
+ * @return 0 if successful, -1 if failure
+ */
+static int cdLogisticPass(CoordinateDescent *cd)
+{
+    if (parallelFor(cd->row_threads, cd->Xt.cols, cdLinkTask, cd) < 0 ||
+        parallelFor(cd->column_threads, cd->Xt.rows, cdCurvatureTask, cd) < 0)
+    {
+        LOG_ERROR("Coordinate descent IRLS pass was unsuccessful.\n");
+        return -1;
+    }
+    return 0;
+}
+
+/**
+ * @brief Squared error gradient 2 * (G * w - X^T * y / n) of every feature, read off the
+ *        maintained product q = G * w without touching the data
+ *
+ * @param cd CoordinateDescent object
+ *
+ * @return None
+ */
+static void cdLinearGradient(CoordinateDescent *cd)
+{
+    for (int j = 0; j < cd->weights.size; ++j)
+    {
+        cd->grad.data[j] = 2.0 * (cd->q.data[j] - cd->xty.data[j]);
+    }
+}
+
+/**
+ * @brief One sweep over the working coordinates, each minimized exactly with
+ *        w_j = S(rho_j, l1) / (v_j + 2 * l2). Linear regression reads rho_j off the Gram
+ *        columns in O(features), logistic regression takes it from one column of the data
+ *        and refits the bias after the sweep.
+ *
+ * @param cd CoordinateDescent object
+ * @param l1 L1 strength
+ * @param l2 L2 strength
+ * @param change Resulting largest coordinate step, scaled by sqrt(v_j)
+ *
+ * @return 0 if successful, -1 if failure
+ */
+static int cdSweep(CoordinateDescent *cd, double l1, double l2, double *change)
+{
+    int n = cd->Xt.cols;
+    int p = cd->Xt.rows;
+    int m = 0;
+    for (int j = 0; j < p; ++j)
+    {
+        if (cd->working[j])
+        {
+            cd->order[m++] = j;
+        }
+    }
+    bool shuffled = cd->shuffle && m > 1;
+    if (shuffled && shufflePermutation(cd->perm, m, &cd->rng) < 0)
+    {
+        return -1;
+    }
+
+    *change = 0.0;
+    for (int t = 0; t < m; ++t)
+    {
+        int j = shuffled ? cd->order[cd->perm[t]] : cd->order[t];
+        double curvature = cd->curvature.data[j];
+        if (curvature + 2.0 * l2 <= 0.0)
+        {
+            continue;
+        }
+
+        const double *x = &cd->Xt.data[j * n];
+        double old = cd->weights.data[j];
+        double rho = 0.0;
+        if (cd->logistic)
+        {
+            for (int i = 0; i < n; ++i)
+            {
+                rho += cd->irls.data[i] * x[i] * cd->resid.data[i];
+            }
+            rho = rho / n + curvature * old;
+        }
+        else
+        {
+            rho = 2.0 * (cd->xty.data[j] - cd->q.data[j]) + curvature * old;
+        }
+
+        double w = softThreshold(rho, l1) / (curvature + 2.0 * l2);
+        double delta = w - old;
+        if (delta == 0.0)
+        {
+            continue;
+        }
+        cd->weights.data[j] = w;
+        *change = MAX(*change, sqrt(curvature) * fabs(delta));
+
+        if (cd->logistic)
+        {
+            for (int i = 0; i < n; ++i)
+            {
+                cd->resid.data[i] -= x[i] * delta;
+            }
+            continue;
+        }
+        if (cdGramColumn(cd, j) < 0)
+        {
+            return -1;
+        }
+        const double *g = cd->gram[j].data;
+        for (int k = 0; k < p; ++k)
+        {
+            cd->q.data[k] += g[k] * delta;
+        }
+    }
+
+    // Unpenalized bias, its exact minimizer is the weighted mean of the residual
+    if (cd->logistic)
+    {
+        double sum_w = 0.0;
+        double sum_wr = 0.0;
+        for (int i = 0; i < n; ++i)
+        {
+            sum_w += cd->irls.data[i];
+            sum_wr += cd->irls.data[i] * cd->resid.data[i];
+        }
+        double delta = sum_wr / sum_w;
+        for (int i = 0; i < n; ++i)
+        {
+            cd->resid.data[i] -= delta;
+        }
+        cd->bias += delta;
+        *change = MAX(*change, sqrt(sum_w / n) * fabs(delta));
+    }
+
+    cd->sweeps++;
+    return 0;
+}
+
+/**
+ * @brief Minimize the penalized loss from the current weights. Coordinates are screened
+ *        with the sequential strong rule |g_j| < 2 * l1 - prev_l1, the rest are swept until
+ *        no step exceeds the tolerance, then every screened coordinate is checked against
+ *        the KKT condition |g_j| <= l1 and violators rejoin the sweeps.
+ *
+ * @param cd CoordinateDescent object whose gradient matches the current weights
+ * @param l1 L1 strength
+ * @param l2 L2 strength
+ * @param prev_l1 L1 strength the current weights were fitted at
+ * @param max_sweeps Total sweeps cd may reach
+ * @param tolerance Largest scaled coordinate step at convergence
+ *
+ * @return 0 if successful, -1 if failure
+ */
+static int fitCoordinateDescent(CoordinateDescent *cd, double l1, double l2, double prev_l1, int max_sweeps, double tolerance)
+{
+    int p = cd->Xt.rows;
+    double cutoff = 2.0 * l1 - prev_l1;
+    for (int j = 0; j < p; ++j)
+    {
+        cd->working[j] = cd->weights.data[j] != 0.0 || fabs(cd->grad.data[j]) >= cutoff;
+    }
+
+    while (true)
+    {
+        int start = cd->sweeps;
+        double change = INFINITY;
+        double first_change = INFINITY;
+        while (change > tolerance && cd->sweeps < max_sweeps)
+        {
+            if (cdSweep(cd, l1, l2, &change) < 0)
+            {
+                LOG_ERROR("Coordinate descent sweep was unsuccessful.\n");
+                return -1;
+            }
+            if (cd->sweeps == start + 1)
+            {
+                first_change = change;
+            }
+        }
+
+        // Logistic regression converged once a fresh quadratic model no longer moves the weights
+        if (cd->logistic)
+        {
+            if (cdLogisticPass(cd) < 0)
+            {
+                return -1;
+            }
+        }
+        else
+        {
+            cdLinearGradient(cd);
+        }
+        bool converged = (cd->logistic) ? first_change <= tolerance : change <= tolerance;
+
+        int violations = 0;
+        for (int j = 0; j < p; ++j)
+        {
+            if (!cd->working[j] && fabs(cd->grad.data[j]) > l1)
+            {
+                cd->working[j] = true;
+                ++violations;
+            }
+        }
+        if (converged && violations == 0)
+        {
+            return 0;
+        }
+        if (cd->sweeps >= max_sweeps)
+        {
+            LOG_WARN("Coordinate descent reached %d sweeps before converging.\n", max_sweeps);
+            return 0;
+        }
+    }
+}
+
+/**
+ * @brief Free every buffer of the coordinate descent solver
+ *
+ * @param cd CoordinateDescent object
+ *
+ * @return None
+ */
+static void freeCoordinateDescent(CoordinateDescent *cd)
+{
+    if (cd->gram)
+    {
+        for (int k = 0; k < cd->Xt.rows; ++k)
+        {
+            freeVector(&cd->gram[k]);
+        }
+    }
+    free(cd->gram);
+    free(cd->working);
+    free(cd->order);
+    free(cd->perm);
+    freeMatrix(&cd->Xt);
+    freeVector(&cd->mean);
+    freeVector(&cd->curvature);
+    freeVector(&cd->xty);
+    freeVector(&cd->q);
+    freeVector(&cd->grad);
+    freeVector(&cd->weights);
+    freeVector(&cd->z);
+    freeVector(&cd->irls);
+    freeVector(&cd->resid);
+}
+
+/**
+ * @brief Set up coordinate descent at zero weights. The features are copied column-major so
+ *        every coordinate reads one contiguous column, and the gradient at zero is ready for
+ *        the first screening.
+ *
+ * @param cd CoordinateDescent object to fill
+ * @param model Model object with dense training features
+ * @param train_y Training labels
+ *
+ * @return 0 if successful, -1 if failure
+ */
+static int makeCoordinateDescent(CoordinateDescent *cd, const Model *model, Matrix train_y)
+{
+    memset(cd, 0, sizeof(CoordinateDescent));
+    Matrix X = model->splitdata.train_features;
+    int n = X.rows;
+    int p = X.cols;
+    cd->y = train_y;
+    cd->logistic = model->type == LOGISTIC_REGRESSION;
+    cd->row_threads = planThreads(n, GRAM_MIN_ROWS_PER_THREAD);
+    cd->column_threads = planThreads(p, MAX(1, GRAM_MIN_ROWS_PER_THREAD / n));
+    cd->shuffle = model->config.shuffle_coordinates;
+    if (cd->shuffle)
+    {
+        initRandomStream(&cd->rng, model->config.seed);
+    }
+
+    cd->gram = calloc(p, sizeof(Vector));
+    cd->working = calloc(p, sizeof(bool));
+    cd->order = calloc(p, sizeof(int));
+    cd->perm = calloc(p, sizeof(int));
+    if (!cd->gram || !cd->working || !cd->order || !cd->perm ||
+        makeMatrixZeros(&cd->Xt, p, n) < 0 || makeVectorZeros(&cd->mean, p) < 0 ||
+        makeVectorZeros(&cd->curvature, p) < 0 || makeVectorZeros(&cd->grad, p) < 0 ||
+        makeVectorZeros(&cd->weights, p) < 0)
+    {
+        LOG_ERROR("Allocating the coordinate descent buffers was unsuccessful.\n");
+        return -1;
+    }
+    if (cd->logistic)
+    {
+        if (makeVectorZeros(&cd->z, n) < 0 || makeVectorZeros(&cd->irls, n) < 0 || makeVectorZeros(&cd->resid, n) < 0)
+        {
+            LOG_ERROR("Allocating the coordinate descent IRLS buffers was unsuccessful.\n");
+            return -1;
+        }
+    }
+    else if (makeVectorZeros(&cd->xty, p) < 0 || makeVectorZeros(&cd->q, p) < 0)
+    {
+        LOG_ERROR("Allocating the coordinate descent covariance buffers was unsuccessful.\n");
+        return -1;
+    }
+    if (transpose(X, &cd->Xt) < 0)
+    {
+        LOG_ERROR("Column-major copy of the training features was unsuccessful.\n");
+        return -1;
+    }
+
+    double sum = 0.0;
+    for (int i = 0; i < n; ++i)
+    {
+        sum += train_y.data[i];
+    }
+    cd->y_mean = sum / n;
+    if (parallelFor(cd->column_threads, p, cdStatsTask, cd) < 0)
+    {
+        LOG_ERROR("Coordinate descent feature statistics were unsuccessful.\n");
+        return -1;
+    }
+
+    if (!cd->logistic)
+    {
+        cdLinearGradient(cd);
+        return 0;
+    }
+    // Start from the intercept-only model
+    double prior = MIN(MAX(cd->y_mean, CD_MIN_IRLS_WEIGHT), 1.0 - CD_MIN_IRLS_WEIGHT);
+    cd->bias = log(prior / (1.0 - prior));
+    return cdLogisticPass(cd);
+}
+
+/**
+ * @brief Smallest L1 strength at which every weight stays zero, the largest gradient entry
+ *        at zero weights
+ *
+ * @param cd CoordinateDescent object fresh from makeCoordinateDescent
+ *
+ * @return Largest absolute gradient entry
+ */
+static double cdLargestGradient(const CoordinateDescent *cd)
+{
+    double largest = 0.0;
+    for (int j = 0; j < cd->grad.size; ++j)
+    {
+        largest = MAX(largest, fabs(cd->grad.data[j]));
+    }
+    return largest;
+}
+
+/**
+ * @brief Copy the solver's weights and bias into a model, linear regression recovers the
+ *        bias from the means as mean(y) - mean(X) * w
+ *
+ * @param cd CoordinateDescent object
+ * @param weights Weights Matrix of features x 1 to write
+ * @param bias Bias Vector of 1 value to write
+ *
+ * @return None
+ */
+static void cdExport(const CoordinateDescent *cd, Matrix *weights, Vector *bias)
+{
+    int p = cd->weights.size;
+    memcpy(weights->data, cd->weights.data, p * sizeof(double));
+    if (cd->logistic)
+    {
+        bias->data[0] = cd->bias;
+        return;
+    }
+
+    double intercept = cd->y_mean;
+    for (int j = 0; j < p; ++j)
+    {
+        intercept -= cd->mean.data[j] * cd->weights.data[j];
+    }
+    bias->data[0] = intercept;
+}
+
+/**
+ * @brief Fit linear or binary logistic regression with coordinate descent, which reaches the
+ *        exact zeros of L1 and elastic-net penalties. Linear regression uses covariance
+ *        updates on lazily cached Gram columns, logistic regression sweeps the columns of
+ *        IRLS quadratic models. config.epochs caps the sweeps and the fit stops once no
+ *        scaled coordinate step exceeds config.tolerance.
+ *
+ * @param model Model object with weights and bias already made
+ * @param train_y Training labels, 0 and 1 for logistic regression
+ *
+ * @return 0 if successful, -1 if failure
+ */
+static int trainCoordinateDescent(Model *model, Matrix train_y)
+{
+    if ((model->type != LINEAR_REGRESSION && model->type != LOGISTIC_REGRESSION) || model->classes != 1)
+    {
+        LOG_ERROR("The coordinate descent solver only fits linear and binary logistic regression.\n");
+        return -1;
+    }
+    if (model->train_table.rows > 0 || !model->splitdata.train_features.data)
+    {
+        LOG_ERROR("The coordinate descent solver reads splitdata.train_features, which was not set.\n");
+        return -1;
+    }
+
+    CoordinateDescent cd;
+    if (makeCoordinateDescent(&cd, model, train_y) < 0)
+    {
+        freeCoordinateDescent(&cd);
+        return -1;
+    }
+
+    // A fit from zero screens against the strength at which every weight is still zero
+    double l1 = 0.0;
+    double l2 = 0.0;
+    penaltyStrengths(&model->config, &l1, &l2);
+    double l1_max = cdLargestGradient(&cd);
+    int status = fitCoordinateDescent(&cd, l1, l2, MAX(l1_max, l1), model->config.epochs, model->config.tolerance);
+    if (status == 0)
+    {
+        cdExport(&cd, model->weights, model->bias);
+        int nonzero = 0;
+        for (int j = 0; j < cd.weights.size; ++j)
+        {
+            nonzero += cd.weights.data[j] != 0.0;
+        }
+        LOG_DEBUG("Coordinate descent finished after %d sweeps with %d of %d weights nonzero.\n", cd.sweeps, nonzero, cd.weights.size);
+    }
+
+    freeCoordinateDescent(&cd);
+    return status;
+}
+
+/**
+ * @brief Free every buffer of a regularization path
+ *
+ * @param path RegularizationPath object
+ *
+ * @return None
+ */
+void freeRegularizationPath(RegularizationPath *path)
+{
+    if (!path)
+    {
+        return;
+    }
+    freeVector(&path->lambdas);
+    freeMatrix(&path->weights);
+    freeVector(&path->bias);
+    free(path->nonzero);
+    path->nonzero = NULL;
+    freeVector(&path->valid_loss);
+    freeVector(&path->valid_score);
+}
+
+/**
+ * @brief Unpenalized validation loss and score of the model's current weights
+ *
+ * @param model Model object
+ * @param logits Validation predictions to fill, validation rows x 1
+ * @param labels Scratch Matrix for the thresholded predictions, validation rows x 1
+ * @param loss Resulting MSE or log loss
+ * @param score Resulting R2 score or accuracy
+ *
+ * @return 0 if successful, -1 if failure
+ */
+static int scoreValidation(Model *model, Matrix *logits, Matrix *labels, double *loss, double *score)
+{
+    Matrix valid_y = model->splitdata.valid_labels;
+    Matrix *train_logits = model->logits;
+    model->logits = logits;
+    int status = computeLogits(model->splitdata.valid_features, model);
+    double error = (status == 0) ? sumLossRows(valid_y, model, 0, logits->rows) : 0.0;
+    model->logits = train_logits;
+    if (status < 0)
+    {
+        LOG_ERROR("Predicting the validation split was unsuccessful.\n");
+        return -1;
+    }
+
+    if (model->type == LINEAR_REGRESSION)
+    {
+        *loss = error / logits->rows;
+        return computeR2Score(valid_y, *logits, score);
+    }
+
+    *loss = -error / logits->rows;
+    int TP = 0;
+    int FP = 0;
+    int TN = 0;
+    int FN = 0;
+    if (applyLabelThreshold(*logits, labels, 0.5) < 0 || computeConfusionMatrix(valid_y, *labels, &TP, &FP, &TN, &FN) < 0 ||
+        computeAccuracy(TP, FP, TN, FN, score) < 0)
+    {
+        LOG_ERROR("Scoring the validation split was unsuccessful.\n");
+        return -1;
+    }
+    return 0;
+}
+
+/**
+ * @brief Fit a whole path of lambdas from the largest to the smallest with coordinate descent,
+ *        starting every fit from the weights of the previous one. The column-major data, the
+ *        centered X^T * y and every Gram column computed for linear regression are kept for
+ *        the whole path, and the strong rules screen each fit against the previous lambda, so
+ *        a long path costs little more than its smallest lambda alone. The model is left
+ *        trained at path->best with config.lambda set to it.
+ *
+ * @param model Model object of linear or binary logistic regression with a configured penalty
+ * @param lambdas Lambdas in decreasing order, NULL for count values spaced evenly on a log scale
+ *        from the smallest lambda that zeroes every weight down to min_ratio times it
+ * @param count Number of lambdas
+ * @param min_ratio Ratio of the smallest to the largest generated lambda, unused with lambdas
+ * @param path RegularizationPath to fill, free with freeRegularizationPath
+ *
+ * @return 0 if successful, -1 if failure
+ */
+int computeRegularizationPath(Model *model, const double *lambdas, int count, double min_ratio, RegularizationPath *path)
+{
+    if (!model || !path || count < 1 || (!lambdas && (min_ratio <= 0 || min_ratio >= 1)))
+    {
+        LOG_ERROR("Input variables to compute a regularization path were not correct.\n");
+        return -1;
+    }
+    memset(path, 0, sizeof(RegularizationPath));
+    if (model->config.regularization == REG_NONE)
+    {
+        LOG_ERROR("A regularization path needs config.regularization to be set.\n");
+        return -1;
+    }
+    for (int k = 0; lambdas && k < count; ++k)
+    {
+        if (lambdas[k] <= 0 || (k > 0 && lambdas[k] >= lambdas[k - 1]))
+        {
+            LOG_ERROR("Path lambdas must be positive and strictly decreasing.\n");
+            return -1;
+        }
+    }
+
+    int features = (model->train_table.rows > 0) ? model->train_table.cols : model->splitdata.train_features.cols;
+    if (makeMatrixZeros(model->weights, features, model->classes) < 0 || makeVectorZeros(model->bias, model->classes) < 0)
+    {
+        LOG_ERROR("Problem initializing the weights and bias of the path.\n");
+        return -1;
+    }
+    if (checkModel(model) < 0)
+    {
+        LOG_ERROR("The model object submitted for a path has not be setup properly.\n");
+        return -1;
+    }
+    if ((model->type != LINEAR_REGRESSION && model->type != LOGISTIC_REGRESSION) || model->classes != 1 ||
+        model->train_table.rows > 0)
+    {
+        LOG_ERROR("Regularization paths fit dense linear and binary logistic regression.\n");
+        return -1;
+    }
+
+    // Share of lambda that goes to the L1 term, the path is walked in that term's units
+    ModelConfig unit = model->config;
+    unit.lambda = 1.0;
+    double l1_unit = 0.0;
+    double l2_unit = 0.0;
+    penaltyStrengths(&unit, &l1_unit, &l2_unit);
+    if (!lambdas && l1_unit <= 0)
+    {
+        LOG_ERROR("Generated path lambdas need an L1 term, pass the lambdas for an L2 path.\n");
+        return -1;
+    }
+
+    Matrix valid_X = model->splitdata.valid_features;
+    Matrix valid_y = model->splitdata.valid_labels;
+    bool validate = valid_X.data && valid_y.data && valid_X.rows > 1 && valid_X.rows == valid_y.rows &&
+                    valid_X.cols == features;
+
+    CoordinateDescent cd;
+    memset(&cd, 0, sizeof(CoordinateDescent));
+    Matrix logits = {0};
+    Matrix labels = {0};
+    path->count = count;
+    path->best = count - 1;
+    path->nonzero = calloc(count, sizeof(int));
+    if (!path->nonzero || makeCoordinateDescent(&cd, model, model->splitdata.train_labels) < 0 ||
+        makeVectorZeros(&path->lambdas, count) < 0 || makeMatrixZeros(&path->weights, count, features) < 0 ||
+        makeVectorZeros(&path->bias, count) < 0 || makeVectorZeros(&path->valid_loss, count) < 0 ||
+        makeVectorZeros(&path->valid_score, count) < 0 ||
+        (validate && (makeMatrixZeros(&logits, valid_X.rows, 1) < 0 || makeMatrixZeros(&labels, valid_X.rows, 1) < 0)))
+    {
+        LOG_ERROR("Allocating the regularization path was unsuccessful.\n");
+        freeCoordinateDescent(&cd);
+        freeRegularizationPath(path);
+        freeMatrix(&logits);
+        freeMatrix(&labels);
+        return -1;
+    }
+
+    double l1_max = cdLargestGradient(&cd);
+    for (int k = 0; k < count; ++k)
+    {
+        path->lambdas.data[k] = lambdas ? lambdas[k] : (l1_max / l1_unit) * pow(min_ratio, (count > 1) ? (double)k / (count - 1) : 0.0);
+    }
+
+    int status = 0;
+    double prev_l1 = MAX(l1_max, l1_unit * path->lambdas.data[0]);
+    double best_loss = INFINITY;
+    for (int k = 0; k < count && status == 0; ++k)
+    {
+        double lambda = path->lambdas.data[k];
+        status = fitCoordinateDescent(&cd, l1_unit * lambda, l2_unit * lambda, prev_l1, cd.sweeps + model->config.epochs, model->config.tolerance);
+        if (status < 0)
+        {
+            break;
+        }
+        prev_l1 = l1_unit * lambda;
+
+        Matrix row = {1, features, &path->weights.data[k * features]};
+        Vector bias = {1, &path->bias.data[k]};
+        cdExport(&cd, &row, &bias);
+        for (int j = 0; j < features; ++j)
+        {
+            path->nonzero[k] += row.data[j] != 0.0;
+        }
+        path->valid_loss.data[k] = NAN;
+        path->valid_score.data[k] = NAN;
+        if (validate)
+        {
+            cdExport(&cd, model->weights, model->bias);
+            status = scoreValidation(model, &logits, &labels, &path->valid_loss.data[k], &path->valid_score.data[k]);
+            if (status == 0 && path->valid_loss.data[k] < best_loss)
+            {
+                best_loss = path->valid_loss.data[k];
+                path->best = k;
+            }
+        }
+        LOG_DEBUG("Path lambda %g: %d nonzero weights, validation loss %f after %d total sweeps.\n", lambda, path->nonzero[k], path->valid_loss.data[k], cd.sweeps);
+    }
+
+    freeCoordinateDescent(&cd);
+    freeMatrix(&logits);
+    freeMatrix(&labels);
+    if (status < 0)
+    {
+        LOG_ERROR("Fitting the regularization path was unsuccessful.\n");
+        freeRegularizationPath(path);
+        return -1;
+    }
+
+    memcpy(model->weights->data, &path->weights.data[path->best * features], features * sizeof(double));
+    model->bias->data[0] = path->bias.data[path->best];
+    model->config.lambda = path->lambdas.data[path->best];
+    return 0;
+}
+
+/**
+ * @brief Free every buffer of the early stopping state
+ *
+ * @param es EarlyStopping object
+ *
+ * @return None
+ */
+static void freeEarlyStopping(EarlyStopping *es)
+{
+    freeMatrix(&es->logits);
+    freeMatrix(&es->best_weights);
+    freeVector(&es->best_bias);
+}
+
+/**
+ * @brief Set up early stopping when config.patience is positive. The validation split is
+ *        monitored when it is set, otherwise the mean training loss of every epoch is. The best
+ *        weights and patience count left in the model's optimizer state carry over.
+ *
+ * @param es EarlyStopping object to fill
+ * @param model Model object with weights and bias already made
+ *
+ * @return 0 if successful, -1 if failure
+ */
+static int makeEarlyStopping(EarlyStopping *es, Model *model)
+{
+    memset(es, 0, sizeof(EarlyStopping));
+    es->enabled = model->config.patience > 0;
+    if (!es->enabled)
+    {
+        return 0;
+    }
+
+    if (makeMatrixZeros(&es->best_weights, model->weights->rows, model->weights->cols) < 0 ||
+        makeVectorZeros(&es->best_bias, model->bias->size) < 0)
+    {
+        LOG_ERROR("Allocating the best weights for early stopping was unsuccessful.\n");
+        return -1;
+    }
+    const OptimizerState *state = &model->state;
+    if (state->best_epoch > 0 && state->best_weights.data && state->best_bias.data &&
+        state->best_weights.rows == es->best_weights.rows && state->best_weights.cols == es->best_weights.cols &&
+        state->best_bias.size == es->best_bias.size)
+    {
+        memcpy(es->best_weights.data, state->best_weights.data, es->best_weights.rows * es->best_weights.cols * sizeof(double));
+        memcpy(es->best_bias.data, state->best_bias.data, es->best_bias.size * sizeof(double));
+        es->best_loss = state->best_loss;
+        es->best_epoch = state->best_epoch;
+        es->stale_epochs = state->stale_epochs;
+    }
+
+    // makeDefaultSplitData leaves 1 x 1 placeholders, which are not a validation split
+    Matrix valid_X = model->splitdata.valid_features;
+    Matrix valid_y = model->splitdata.valid_labels;
+    es->validate = valid_X.data && valid_y.data && valid_X.rows > 1 && valid_X.rows == valid_y.rows &&
+                   valid_X.cols == model->weights->rows;
+    if (!es->validate)
+    {
+        return 0;
+    }
+
+    es->X = valid_X;
+    es->y = valid_y;
+    if (model->type == SOFTMAX_REGRESSION && checkClassLabels(valid_y, model->classes) < 0)
+    {
+        LOG_ERROR("The validation labels cannot be monitored for early stopping.\n");
+        return -1;
+    }
+    if (makeMatrixZeros(&es->logits, valid_X.rows, model->classes) < 0)
+    {
+        LOG_ERROR("Allocating the validation logits for early stopping was unsuccessful.\n");
+        return -1;
+    }
+
+    return 0;
+}
+
+/**
+ * @brief Record the monitored loss after an epoch, keep a copy of the weights when it improved
+ *        by more than config.min_improvement relative to the best so far, and signal a stop once
+ *        config.patience epochs went by without an improvement
+ *
+ * @param es EarlyStopping object
+ * @param model Model object being trained
+ * @param epoch Epoch that just finished
+ * @param train_loss Mean training loss of the epoch, used when there is no validation split
+ * @param stop Set to true when training should stop
+ *
+ * @return 0 if successful, -1 if failure
+ */
+static int updateEarlyStopping(EarlyStopping *es, Model *model, int epoch, double train_loss, bool *stop)
+{
+    *stop = false;
+    double loss = train_loss;
+    if (es->validate)
+    {
+        // Predict into the validation logits made with the early stopping state, without
+        // touching the training buffers or allocating
+        Matrix *train_logits = model->logits;
+        model->logits = &es->logits;
+        int status = forwardRows(model, es->X, &es->logits, 0, es->X.rows);
+        if (status == 0)
+        {
+            status = computeLoss(es->y, model, &loss);
+        }
+        model->logits = train_logits;
+        if (status < 0)
+        {
+            LOG_ERROR("Computing the validation loss for early stopping was unsuccessful.\n");
+            return -1;
+        }
+    }
+
+    // The first finite loss always counts, a NaN or infinite loss never does
+    bool improved = isfinite(loss) && (es->best_epoch == 0 || es->best_loss - loss > model->config.min_improvement * fabs(es->best_loss));
+    if (improved)
+    {
+        es->best_loss = loss;
+        es->best_epoch = epoch;
+        es->stale_epochs = 0;
+        memcpy(es->best_weights.data, model->weights->data, model->weights->rows * model->weights->cols * sizeof(double));
+        memcpy(es->best_bias.data, model->bias->data, model->bias->size * sizeof(double));
+        return 0;
+    }
+
+    *stop = ++es->stale_epochs >= model->config.patience;
+    return 0;
+}
+
+/**
+ * @brief Exchange the best weights and patience count of early stopping with an
+ *        OptimizerState, which hands them to the model and back without copying
+ *
+ * @param es EarlyStopping object
+ * @param state OptimizerState object
+ *
+ * @return None
+ */
+static void swapEarlyStopping(EarlyStopping *es, OptimizerState *state)
+{
+    Matrix weights = es->best_weights;
+    es->best_weights = state->best_weights;
+    state->best_weights = weights;
+
+    Vector bias = es->best_bias;
+    es->best_bias = state->best_bias;
+    state->best_bias = bias;
+
+    double loss = es->best_loss;
+    es->best_loss = state->best_loss;
+    state->best_loss = loss;
+
+    int epoch = es->best_epoch;
+    es->best_epoch = state->best_epoch;
+    state->best_epoch = epoch;
+
+    int stale = es->stale_epochs;
+    es->stale_epochs = state->stale_epochs;
+    state->stale_epochs = stale;
+}
+
+/**
+ * @brief Squared L2 norm of the gradients of the last mini-batch
+ *
+ * @param ws TrainWorkspace holding the gradients
+ *
+ * @return Sum of the squared weight and bias gradients
+ */
+static double gradientNormSquared(const TrainWorkspace *ws)
+{
+    double sum = 0.0;
+    for (int i = 0; i < ws->grad_w.rows * ws->grad_w.cols; ++i)
+    {
+        sum += ws->grad_w.data[i] * ws->grad_w.data[i];
+    }
+    for (int i = 0; i < ws->grad_b.size; ++i)
+    {
+        sum += ws->grad_b.data[i] * ws->grad_b.data[i];
+    }
+
+    return sum;
+}
+
+/**
+ * @brief Hand a checkpoint of the weights, the optimizer state held by the workspace, and the
+ *        early stopping state to the writer
+ *
+ * @param writer CheckpointWriter object
+ * @param model Model object being trained
+ * @param ws TrainWorkspace with the optimizer state of the run
+ * @param es EarlyStopping object of the run
+ * @param wait Block until the previous checkpoint is written instead of skipping
+ *
+ * @return 0 if handed over, 1 if skipped, -1 if failure
+ */
+static int submitEpochCheckpoint(CheckpointWriter *writer, const Model *model, const TrainWorkspace *ws, const EarlyStopping *es,
+                                 bool wait)
+{
+    OptimizerState state;
+    memset(&state, 0, sizeof(state));
+    state.velocity_weights = ws->velocity_weights;
+    state.velocity_bias = ws->velocity_bias;
+    state.square_weights = ws->square_weights;
+    state.square_bias = ws->square_bias;
+    state.step = ws->step;
+    state.epoch = model->state.epoch;
+    state.stream = model->state.stream;
+    state.stopped = model->state.stopped;
+    if (es->enabled)
+    {
+        state.best_weights = es->best_weights;
+        state.best_bias = es->best_bias;
+        state.best_loss = es->best_loss;
+        state.best_epoch = es->best_epoch;
+        state.stale_epochs = es->stale_epochs;
+    }
+
+    int status = submitCheckpoint(writer, model, &state, wait);
+    if (status < 0)
+    {
+        LOG_WARN("Checkpoint of epoch %d could not be taken.\n", state.epoch);
+    }
+    return status;
+}
+
+/**
+ * @brief Run epochs of mini-batch gradient descent from the model's current weights and
+ *        optimizer state, handing the state back to the model at the end so a later call
+ *        carries on where this one stopped
+ *
+ * @param model Model object with weights, bias and a checked configuration
+ * @param train_y Training labels, class indices for softmax
+ * @param epochs Number of epochs to run
+ *
+ * @return 0 if successful, -1 if failure
+ */
+static int trainMiniBatch(Model *model, Matrix train_y, int epochs)
+{
+    // Init gradient weight Matrix, bias Vector, and velocity Matrix
+    TrainWorkspace ws;
+    if (makeStepWorkspace(&ws, model, MIN(model->batch_size, getTrainRows(model))) < 0)
+    {
+        LOG_ERROR("Allocating the training workspace was unsuccessful.\n");
+        freeTrainWorkspace(&ws);
+        return -1;
+    }
+
+    // Continue from the optimizer state of the previous run, the zeroed buffers go back to
+    // the model in its place and are freed with the workspace
+    if (model->state.velocity_weights.data)
+    {
+        swapOptimizerState(&ws, &model->state);
+    }
+
+    // The shuffle of every epoch is derived from the run's stream and the epoch number, so a
+    // resumed run draws the same mini-batches the uninterrupted run would have
+    if (model->state.stream == 0)
+    {
+        RandomState rng;
+        initRandomStream(&rng, model->config.seed);
+        model->state.stream = (model->config.seed != 0) ? model->config.seed : (nextRandom(&rng) | 1);
+    }
+    uint64_t seed = model->state.stream + (uint64_t)model->state.epoch * PREFETCH_EPOCH_STRIDE;
+    model->state.stopped = false;
+
+    // Start shuffling and gathering mini-batches on the prefetch thread, compact typed features
+    // are widened to double as each batch is gathered
+    BatchPrefetcher prefetcher;
+    int status = 0;
+    if (model->train_rows)
+    {
+        status = startIndexedPrefetcher(&prefetcher, model->splitdata.train_features, train_y, model->train_rows, model->n_train_rows,
+                                        model->batch_size, epochs, PREFETCH_DEPTH, seed);
+    }
+    else
+    {
+        status = (model->train_table.rows > 0)
+                     ? startTypedPrefetcher(&prefetcher, &model->train_table, train_y, model->batch_size, epochs, PREFETCH_DEPTH, seed)
+                     : startPrefetcher(&prefetcher, model->splitdata.train_features, train_y, model->batch_size, epochs, PREFETCH_DEPTH, seed);
+    }
+    if (status < 0)
+    {
+        LOG_ERROR("Starting the mini-batch prefetcher was unsuccessful.\n");
+        swapOptimizerState(&ws, &model->state);
+        freeTrainWorkspace(&ws);
+        return -1;
+    }
+
+    EarlyStopping stopping;
+    if (makeEarlyStopping(&stopping, model) < 0)
+    {
+        stopPrefetcher(&prefetcher);
+        freeEarlyStopping(&stopping);
+        swapOptimizerState(&ws, &model->state);
+        freeTrainWorkspace(&ws);
+        return -1;
+    }
+
+    // Checkpoints are copied out between epochs and written by a thread of their own
+    CheckpointWriter writer;
+    bool checkpointing = model->config.checkpoint_path && model->config.checkpoint_every > 0 &&
+                         startCheckpointWriter(&writer, model->config.checkpoint_path) == 0;
+    int checkpointed = 0;
+
+    // Init reused variables
+    double loss = 0;
+    long first_epoch_allocations = 0;
+    PBD progress_bar;
+    initProgressBar(&progress_bar, 50, '[', ']', '#', '.', 0.1);
+    drawProgressBar(&progress_bar);
+
+    // Iterate through N-number of epochs adjusting the weights and bias, the epoch count and
+    // learning rate schedule carry on from the previous run
+    for (int e = 1; e <= epochs && status == 0; ++e)
+    {
+        int epoch = model->state.epoch + 1;
+        double epoch_loss = 0;
+        double grad_norm_sq = 0;
+
+        // Iterate through forward and backward pass for each mini-batch matrix
+        for (int b = 0; b < prefetcher.batches && status == 0; ++b)
+        {
+            Matrix *mini_X = NULL;
+            Matrix *mini_y = NULL;
+            if (acquireBatch(&prefetcher, &mini_X, &mini_y) < 0)
+            {
+                LOG_ERROR("Getting the next mini-batch was unsuccessful.\n");
+                status = -1;
+                break;
+            }
+
+            status = trainBatch(model, *mini_X, *mini_y, &ws, &loss);
+            releaseBatch(&prefetcher);
+            epoch_loss += loss;
+            if (model->config.grad_norm_tolerance > 0)
+            {
+                grad_norm_sq += gradientNormSquared(&ws);
+            }
+        }
+        if (status < 0)
+        {
+            break;
+        }
+
+        // Update learning rate
+        if (updateLearningRate(model, epoch) < 0)
+        {
+            LOG_ERROR("Bias update with gradient bias was not successful.\n");
+            status = -1;
+            break;
+        }
+        model->state.epoch = epoch;
+
+        // Progress over time/epoch
+        progress_bar.n_curr_len = (e * progress_bar.m_max_len) / epochs;
+        progress_bar.loss = loss;
+        progress_bar.progress = (int)(((double)e / (double)epochs) * 100.0);
+        drawProgressBar(&progress_bar);
+
+        if (e == 1)
+        {
+            first_epoch_allocations = getAllocationCount();
+        }
+
+        // Stop once the gradients vanish or the monitored loss stops improving
+        bool converged = model->config.grad_norm_tolerance > 0 &&
+                         sqrt(grad_norm_sq / prefetcher.batches) < model->config.grad_norm_tolerance;
+        bool stop = false;
+        if (!converged && stopping.enabled && updateEarlyStopping(&stopping, model, epoch, epoch_loss / prefetcher.batches, &stop) < 0)
+        {
+            status = -1;
+            break;
+        }
+        model->state.stopped = converged || stop;
+
+        // The checkpoint is taken once the epoch is fully accounted for, stopping decision included
+        if (checkpointing && epoch % model->config.checkpoint_every == 0 &&
+            submitEpochCheckpoint(&writer, model, &ws, &stopping, false) == 0)
+        {
+            checkpointed = epoch;
+        }
+        if (converged)
+        {
+            LOG_INFO("\nGradient norm converged after epoch %d.", epoch);
+            break;
+        }
+        if (stop)
+        {
+            LOG_INFO("\nNo improvement for %d epochs, stopping after epoch %d.", model->config.patience, epoch);
+            break;
+        }
+    }
+    LOG_INFO("\n");
+
+    // The last epoch trained is always on disk when training returns, with the weights that go
+    // with its optimizer state. A failed write only costs the ability to resume.
+    if (checkpointing)
+    {
+        if (status == 0 && checkpointed != model->state.epoch && model->state.epoch > 0)
+        {
+            submitEpochCheckpoint(&writer, model, &ws, &stopping, true);
+        }
+        if (stopCheckpointWriter(&writer) < 0)
+        {
+            LOG_WARN("Some checkpoints could not be written to %s.\n", model->config.checkpoint_path);
+        }
     }
 
-    // Init gradient weight Matrix, bias Vector, and velocity Matrix
-    Matrix grad_w = {0};
-    if (makeMatrixZeros(&grad_w, model->weights->rows, model->weights->cols) < 0)
+    // Keep the weights of the best monitored epoch rather than the last one
+    if (status == 0 && stopping.enabled && stopping.best_epoch > 0)
     {
-        LOG_ERROR("Unsuccessful initialization of gradient weights Matrix in model training.\n");
-        return -1;
+        LOG_DEBUG("Restoring the weights of epoch %d, loss %f.\n", stopping.best_epoch, stopping.best_loss);
+        memcpy(model->weights->data, stopping.best_weights.data, model->weights->rows * model->weights->cols * sizeof(double));
+        memcpy(model->bias->data, stopping.best_bias.data, model->bias->size * sizeof(double));
     }
-    Vector grad_b = {0};
-    if (makeVectorZeros(&grad_b, model->bias->size) < 0)
+    if (ws.capacity > 0 && status == 0)
     {
-        LOG_ERROR("Unsuccessful initialization of gradient bias Vector in model training.\n");
+        LOG_DEBUG("Buffers allocated after the first epoch: %ld\n", getAllocationCount() - first_epoch_allocations);
+    }
+
+    stopPrefetcher(&prefetcher);
+    if (ws.capacity > 0)
+    {
+        freeMatrix(model->logits);
+    }
+    if (stopping.enabled)
+    {
+        swapEarlyStopping(&stopping, &model->state);
+    }
+    freeEarlyStopping(&stopping);
+    swapOptimizerState(&ws, &model->state);
+    freeTrainWorkspace(&ws);
+    return status;
+}
+
+/**
+ * @brief Train the model with mini-batch gradient descent, updating with config.optimizer
+ *        (momentum, Adam, AdamW, RMSProp or Adagrad). Mini-batches are shuffled and gathered
+ *        by a prefetch thread one batch ahead of the compute, and every batch is split into
+ *        shards that compute their gradients on their own threads into buffers allocated before
+ *        the first epoch. config.preallocate makes those buffers mandatory rather than falling
+ *        back to a single threaded step that allocates every batch. config.hogwild switches to
+ *        lock-free asynchronous plain SGD instead, which rejects adaptive optimizers, early
+ *        stopping and checkpoints. config.patience and config.grad_norm_tolerance end training
+ *        early, with the weights of the best monitored epoch restored. Linear models can be
+ *        solved exactly with config.solver set to SOLVER_CLOSED_FORM, SOLVER_LBFGS fits
+ *        any model with full-batch L-BFGS and is the solver that trains on CSR features set
+ *        in train_sparse, SOLVER_NEWTON fits binary logistic regression with Newton's method
+ *        and SOLVER_COORDINATE_DESCENT fits sparse L1 or elastic-net linear and binary
+ *        logistic models. Mini-batch training keeps its optimizer state in the model for
+ *        resumeModel.
+ *
+ * @param model Model object that holds the configuration, matrices, and vectors to run
+ *
+ * @return 0 if successful, -1 if failure
+ */
+int trainModel(Model *model)
+{
+    // Init weights matrix and bias vector
+    int features = (model->train_sparse.rows > 0)  ? model->train_sparse.cols
+                   : (model->train_table.rows > 0) ? model->train_table.cols
+                                                   : model->splitdata.train_features.cols;
+    if (makeMatrixZeros(model->weights, features, model->classes) < 0)
+    {
+        LOG_ERROR("Problem initializing weight Matrix\n");
         return -1;
     }
-    Matrix velocity_weights = {0};
-    if (makeMatrixZeros(&velocity_weights, model->weights->rows, model->weights->cols) < 0)
+    if (makeVectorZeros(model->bias, model->classes) < 0)
     {
-        LOG_ERROR("Unsuccessful initialization of velocity weights Matrix in model training.\n");
+        LOG_ERROR("Problem initializing bias Matrix\n");
         return -1;
     }
-    Vector velocity_bias = {0};
-    if (makeVectorZeros(&velocity_bias, model->bias->size) < 0)
+
+    // Check that the model has been setup correctly before trying to train
+    if (checkModel(model) < 0)
     {
-        LOG_ERROR("Unsuccessful initialization of velocity bias Vector in model training.\n");
+        LOG_ERROR("The model object submitted to train has not be setup properly.\n");
         return -1;
     }
 
-    // Init reused variables, build batch sizing
-    double loss = 0;
-    int *perm_arr = (int *)calloc(model->splitdata.train_features.rows, sizeof(int));
-    int batches = (int)ceil(model->splitdata.train_features.rows / (double)model->batch_size);
-    int mini_batch_idx = 0;
-    int batch_size = 0;
-    PBD progress_bar;
-    initProgressBar(&progress_bar, 50, '[', ']', '#', '.', 0.1);
-    drawProgressBar(&progress_bar);
+    // A fresh fit starts the optimizer from zero
+    freeOptimizerState(&model->state);
 
-    // Iterate through N-number of epochs adjusting the weights and bias
-    for (int epoch = 1; epoch <= model->config.epochs; ++epoch)
+    // Softmax labels stay class indices, the loss and gradients read the true class directly
+    Matrix train_y = model->splitdata.train_labels;
+
+    if (model->config.solver == SOLVER_CLOSED_FORM)
+    {
+        return solveClosedForm(model, train_y);
+    }
+    if (model->config.solver == SOLVER_LBFGS)
+    {
+        return trainLBFGS(model, train_y);
+    }
+    if (model->config.solver == SOLVER_NEWTON)
+    {
+        return trainNewton(model, train_y);
+    }
+    if (model->config.solver == SOLVER_COORDINATE_DESCENT)
+    {
+        return trainCoordinateDescent(model, train_y);
+    }
+    if (model->config.hogwild)
     {
-        // --- SHUFFLE DATASET ---
+        return trainHogwild(model, train_y);
+    }
+
+    return trainMiniBatch(model, train_y, model->config.epochs);
+}
 
-        // Create a random permutation of the number of samples in the dataset
-        if (generateRandomPermutation(perm_arr, model->splitdata.train_features.rows) < 0)
+/**
+ * @brief Make zero weights and bias for a model that has none, or check that the existing
+ *        ones fit the features and classes, before training continues from them
+ *
+ * @param model Model object to continue training
+ * @param features Number of features of the training data
+ *
+ * @return 0 if successful, -1 if failure
+ */
+static int prepareContinuedWeights(Model *model, int features)
+{
+    if (!model->weights->data || !model->bias->data)
+    {
+        freeOptimizerState(&model->state);
+        if (makeMatrixZeros(model->weights, features, model->classes) < 0 || makeVectorZeros(model->bias, model->classes) < 0)
         {
-            LOG_ERROR("Creating random permutation for input shuffling was unsuccessful.\n");
+            LOG_ERROR("Problem initializing the weights and bias to continue training.\n");
             return -1;
         }
+    }
+    else if (model->weights->rows != features || model->weights->cols != model->classes || model->bias->size != model->classes)
+    {
+        LOG_ERROR("Weights of %d x %d do not match %d features and %d classes.\n", model->weights->rows,
+                  model->weights->cols, features, model->classes);
+        return -1;
+    }
 
-        // Iterate through forward and backward pass for each mini-batch matrix
-        for (int b = 0; b < batches; ++b)
-        {
-            if (model->splitdata.train_features.rows - mini_batch_idx < model->batch_size)
-            {
-                batch_size = model->splitdata.train_features.rows - mini_batch_idx;
-            }
-            else
-            {
-                batch_size = model->batch_size;
-            }
+    return 0;
+}
 
-            // Make Logits matrix
-            if (makeMatrixZeros(model->logits, batch_size, model->classes) < 0)
-            {
-                LOG_ERROR("Problem initializing logits Matrix\n");
-                return -1;
-            }
+/**
+ * @brief Check that the model's saved optimizer state belongs to the configured optimizer,
+ *        the adaptive optimizers keep squared gradients that momentum never made, and back
+ *
+ * @param model Model object to continue training
+ *
+ * @return 0 if successful, -1 if failure
+ */
+static int checkOptimizerState(const Model *model)
+{
+    bool adaptive = model->config.optimizer.type != OPTIMIZER_MOMENTUM;
+    if (model->state.velocity_weights.data && adaptive != (model->state.square_weights.data != NULL))
+    {
+        LOG_ERROR("The saved optimizer state does not belong to the configured optimizer.\n");
+        return -1;
+    }
 
-            // Get mini-batch of X
-            Matrix mini_X = {0};
-            if (makeMatrixZeros(&mini_X, batch_size, model->splitdata.train_features.cols) < 0)
-            {
-                LOG_ERROR("Creation of empty mini-batch X matrix was unsuccessful.\n");
-                return -1;
-            }
-            if (makeMiniMatrix(*model->X, &mini_X, perm_arr, b, batch_size) < 0)
-            {
-                LOG_ERROR("Creation of mini-batch X matrix was unsuccessful.\n");
-                return -1;
-            }
+    return 0;
+}
 
-            // Get mini-batch of y
-            Matrix mini_y = {0};
-            if (makeMatrixZeros(&mini_y, batch_size, model->splitdata.train_labels.cols) < 0)
-            {
-                LOG_ERROR("Creation of empty mini-batch y matrix was unsuccessful.\n");
-                return -1;
-            }
-            if (makeMiniMatrix(*model->y, &mini_y, perm_arr, b, batch_size) < 0)
-            {
-                LOG_ERROR("Creation of mini-batch X matrix was unsuccessful.\n");
-                return -1;
-            }
+/**
+ * @brief Continue mini-batch gradient descent for more epochs from the model's weights and
+ *        optimizer state. The momentum or moment estimates, the Adam step count, and the epoch
+ *        count of the learning rate schedule all pick up where the last run stopped, so
+ *        training for a and then b epochs follows the same schedule as a + b epochs at once;
+ *        config.epochs stays the horizon of LINEAR_DECAY. A model without weights starts from
+ *        zero.
+ *
+ * @param model Model object set up as for trainModel, with the gradient descent solver
+ * @param epochs Number of additional epochs
+ *
+ * @return 0 if successful, -1 if failure
+ */
+int resumeModel(Model *model, int epochs)
+{
+    if (!model || epochs < 1)
+    {
+        LOG_ERROR("Input variables to resume training were not correct.\n");
+        return -1;
+    }
+    if (model->config.solver != SOLVER_GRADIENT_DESCENT || model->config.hogwild)
+    {
+        LOG_ERROR("Only synchronous mini-batch gradient descent can resume training.\n");
+        return -1;
+    }
 
-            loss = 0;
-            // --- FORWARD PASS ---
+    int features = (model->train_table.rows > 0) ? model->train_table.cols : model->splitdata.train_features.cols;
+    if (prepareContinuedWeights(model, features) < 0)
+    {
+        return -1;
+    }
 
-            // Compute logits and apply activation function
-            if (computeLogits(mini_X, model) < 0)
-            {
-                LOG_ERROR("Computation of logits was unsuccessful while training model.\n");
-                return -1;
-            }
+    if (checkModel(model) < 0)
+    {
+        LOG_ERROR("The model object submitted to resume training has not be setup properly.\n");
+        return -1;
+    }
+    if (checkOptimizerState(model) < 0)
+    {
+        return -1;
+    }
 
-            // Compute loss
-            if (computeLoss(mini_y, model, &loss) < 0)
-            {
-                LOG_ERROR("Computation of Loss was unsuccessful while training model.\n");
-                return -1;
-            }
+    return trainMiniBatch(model, model->splitdata.train_labels, epochs);
+}
 
-            // --- BACKWARD PASS (GRADIENTS) ---
+/**
+ * @brief Apply optimizer steps to the model from one mini-batch supplied by the caller, for
+ *        models that learn from a stream of new rows instead of retraining on their history.
+ *        The weights, the optimizer moments and the step count carry over between calls and
+ *        from trainModel or resumeModel, so repeated calls continue one optimizer run. Steps
+ *        use config.learning_rate.curr_learning_rate, which the caller may lower over time;
+ *        the epoch schedule is not advanced. A model without weights starts from zero.
+ *
+ * @param model Model object with type, activation, classes and a gradient descent config
+ * @param X Features of the mini-batch
+ * @param y Labels of the mini-batch, class indices for softmax
+ * @param steps Number of optimizer steps to take on the mini-batch
+ * @param loss Set to the loss of the mini-batch before the last step, NULL to skip
+ *
+ * @return 0 if successful, -1 if failure
+ */
+int partialFit(Model *model, Matrix X, Matrix y, int steps, double *loss)
+{
+    if (!model || !model->weights || !model->bias || !X.data || !y.data || X.rows < 1 || X.rows != y.rows || y.cols != 1 || steps < 1)
+    {
+        LOG_ERROR("Input variables to partially fit the model were not correct.\n");
+        return -1;
+    }
+    if (model->config.solver != SOLVER_GRADIENT_DESCENT || model->type < LINEAR_REGRESSION || model->type > SOFTMAX_REGRESSION || model->classes < 1)
+    {
+        LOG_ERROR("Only mini-batch gradient descent models can be partially fit.\n");
+        return -1;
+    }
+    if ((model->type == SOFTMAX_REGRESSION && checkClassLabels(y, model->classes) < 0) ||
+        prepareContinuedWeights(model, X.cols) < 0 || checkOptimizerState(model) < 0)
+    {
+        return -1;
+    }
 
-            if (clearMatrix(&grad_w) < 0)
-            {
-                LOG_ERROR("Clearing gradient weights matrix was unsuccessful.\n");
-                return -1;
-            }
-            if (clearVector(&grad_b) < 0)
-            {
-                LOG_ERROR("Clearing gradient bias vector was unsuccessful.\n");
-                return -1;
-            }
+    // The optimizer state lives in the model between calls and in the workspace during them
+    TrainWorkspace ws;
+    if (makeStepWorkspace(&ws, model, X.rows) < 0)
+    {
+        LOG_ERROR("Allocating the training workspace was unsuccessful.\n");
+        freeTrainWorkspace(&ws);
+        return -1;
+    }
+    if (model->state.velocity_weights.data)
+    {
+        swapOptimizerState(&ws, &model->state);
+    }
 
-            // Compute gradients
-            if (computeGradients(mini_X, mini_y, model, &grad_w, &grad_b) < 0)
-            {
-                LOG_ERROR("Computation of Gradient was unsuccessful while training model.\n");
-                return -1;
-            }
+    int status = 0;
+    double batch_loss = 0;
+    for (int s = 0; s < steps && status == 0; ++s)
+    {
+        status = trainBatch(model, X, y, &ws, &batch_loss);
+    }
+    if (status == 0 && loss)
+    {
+        *loss = batch_loss;
+    }
 
-            // Optional regularization
-            if (computeRegularization(*model, &grad_w) < 0)
-            {
-                LOG_ERROR("Computation of Regularization was unsuccessful while training model.\n");
-                return -1;
-            }
+    if (ws.capacity > 0)
+    {
+        freeMatrix(model->logits);
+    }
+    swapOptimizerState(&ws, &model->state);
+    freeTrainWorkspace(&ws);
+    return status;
+}
 
-            // Calculate weights velocity matrix
-            if (computeVelocityWeights(&velocity_weights, model->beta, grad_w))
-            {
-                LOG_ERROR("Computation of Weights Momentum was unsuccessful while training model.\n");
-                return -1;
-            }
-            // Calculate biases velocity vector
-            if (computeVelocityBias(&velocity_bias, model->beta, grad_b))
-            {
-                LOG_ERROR("Computation of Biases Momentum was unsuccessful while training model.\n");
-                return -1;
-            }
+/**
+ * @brief Restore a run from its last checkpoint and train the epochs it had left. The model
+ *        needs only its training data set, and its validation split when early stopping
+ *        monitored one. The weights, optimizer and early stopping state, and the configuration
+ *        come from the checkpoint, later checkpoints go to the same file, and the result
+ *        matches the run that was never interrupted. A run that had already stopped only gets
+ *        its best weights back.
+ *
+ * @param model Model object from initModel with the training data of the checkpointed run
+ * @param filename relative or abolsute path of the checkpoint file
+ *
+ * @return 0 if successful, -1 if failure
+ */
+int resumeFromCheckpoint(Model *model, const char *filename)
+{
+    if (!model || !filename)
+    {
+        LOG_ERROR("Input variables to resume from a checkpoint were not correct.\n");
+        return -1;
+    }
+    if (loadCheckpoint(model, filename) < 0)
+    {
+        LOG_ERROR("Loading checkpoint %s was unsuccessful.\n", filename);
+        return -1;
+    }
+    model->config.checkpoint_path = filename;
 
-            // Gradient descent update with momentum
-            if (mat_mul(velocity_weights, model->config.learning_rate.curr_learning_rate, &velocity_weights) < 0)
-            {
-                LOG_ERROR("Weights gradient descent update with learning rate was not successful.\n");
-                return -1;
-            }
+    int remaining = model->config.epochs - model->state.epoch;
+    if (remaining >= 1 && !model->state.stopped)
+    {
+        return resumeModel(model, remaining);
+    }
 
-            if (mat_sub(*model->weights, velocity_weights, model->weights) < 0)
-            {
-                LOG_ERROR("Weights update with gradient weights was not successful.\n");
-                return -1;
-            }
+    // The checkpoint holds the last epoch's weights, a finished run returns its best ones
+    LOG_DEBUG("Checkpoint %s already holds the whole run of %d epochs.\n", filename, model->state.epoch);
+    const OptimizerState *state = &model->state;
+    if (model->config.patience > 0 && state->best_epoch > 0)
+    {
+        memcpy(model->weights->data, state->best_weights.data, model->weights->rows * model->weights->cols * sizeof(double));
+        memcpy(model->bias->data, state->best_bias.data, model->bias->size * sizeof(double));
+    }
+    return 0;
+}
 
-            if (vect_mul(velocity_bias, model->config.learning_rate.curr_learning_rate, &velocity_bias) < 0)
-            {
-                LOG_ERROR("Bias gradient descent update with learning rate was not successful.\n");
-                return -1;
-            }
+/**
+ * @brief Unpenalized mean loss of the model's current weights on a dataset, MSE for linear
+ *        regression and log loss otherwise
+ *
+ * @param model Trained Model object
+ * @param X Features
+ * @param y Labels, class indices for softmax regression
+ * @param loss Resulting loss
+ *
+ * @return 0 if successful, -1 if failure
+ */
+int evaluateLoss(Model *model, Matrix X, Matrix y, double *loss)
+{
+    if (!model || !loss || !model->weights->data || !X.data || !y.data || X.rows < 1 || X.rows != y.rows ||
+        X.cols != model->weights->rows)
+    {
+        LOG_ERROR("Input variables to evaluate the loss were not correct.\n");
+        return -1;
+    }
 
-            if (vect_sub(*model->bias, velocity_bias, model->bias) < 0)
-            {
-                LOG_ERROR("Bias update with gradient bias was not successful.\n");
-                return -1;
-            }
+    if (model->type == SOFTMAX_REGRESSION && checkClassLabels(y, model->classes) < 0)
+    {
+        return -1;
+    }
 
-            mini_batch_idx += batch_size;
-            freeMatrix(&mini_X);
-            freeMatrix(&mini_y);
-            freeMatrix(model->logits);
-        }
-        mini_batch_idx = 0;
+    Matrix logits = {0};
+    if (makeMatrixZeros(&logits, X.rows, model->classes) < 0)
+    {
+        LOG_ERROR("Allocating the logits to evaluate the loss was unsuccessful.\n");
+        return -1;
+    }
 
-        // Update learning rate
-        if (updateLearningRate(model, epoch) < 0)
-        {
-            LOG_ERROR("Bias update with gradient bias was not successful.\n");
-            return -1;
-        }
+    // Predict into scratch logits without touching the training buffers
+    Matrix *train_logits = model->logits;
+    model->logits = &logits;
+    int status = computeLogits(X, model);
+    double error = (status == 0) ? sumLossRows(y, model, 0, X.rows) : 0.0;
+    model->logits = train_logits;
+    freeMatrix(&logits);
+    if (status < 0)
+    {
+        LOG_ERROR("Predicting the rows to evaluate the loss was unsuccessful.\n");
+        return -1;
+    }
 
-        // Progress over time/epoch
-        progress_bar.n_curr_len = (epoch * progress_bar.m_max_len) / model->config.epochs;
-        progress_bar.loss = loss;
-        progress_bar.progress = (int)(((double)epoch / (double)model->config.epochs) * 100.0);
-        drawProgressBar(&progress_bar);
+    *loss = (model->type == LINEAR_REGRESSION) ? error / X.rows : -error / X.rows;
+    return 0;
+}
+
+/**
+ * @brief Predictions of the model's current weights for selected rows of X, which are read in
+ *        place. Linear models give values, logistic models probabilities, and softmax models
+ *        a row of class probabilities.
+ *
+ * @param model Trained Model object
+ * @param X Features
+ * @param rows Integer array of n rows of X to predict
+ * @param n Number of rows in rows
+ * @param predicted Resulting n x classes Matrix, resized if its shape does not match
+ *
+ * @return 0 if successful, -1 if failure
+ */
+int predictRows(Model *model, Matrix X, const int *rows, int n, Matrix *predicted)
+{
+    if (!model || !predicted || !rows || n < 1 || !model->weights->data || !X.data || X.cols != model->weights->rows)
+    {
+        LOG_ERROR("Input variables to predict rows were not correct.\n");
+        return -1;
+    }
+
+    Matrix *train_logits = model->logits;
+    model->logits = predicted;
+    int status = computeLogitsRows(X, rows, n, model);
+    model->logits = train_logits;
+    if (status < 0)
+    {
+        LOG_ERROR("Predicting %d rows was unsuccessful.\n", n);
+        return -1;
     }
-    LOG_INFO("\n");
 
-    freeMatrix(&grad_w);
-    freeMatrix(&velocity_weights);
-    freeVector(&grad_b);
-    freeVector(&velocity_bias);
-    free(perm_arr);
     return 0;
 }
 
@@ -1170,4 +4741,12 @@ void freeModel(Model *model)
         free(model->logits->data);
         model->logits->data = NULL;
     }
+
+    // Free compact and sparse training features and the optimizer state
+    if (model)
+    {
+        freeTypedTable(&model->train_table);
+        freeSparseMatrix(&model->train_sparse);
+        freeOptimizerState(&model->state);
+    }
 }
\ No newline at end of file
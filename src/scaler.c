@@ -0,0 +1,504 @@
+/*
+ * file: scaler.c
+ * description: fit/transform feature scaling with stored per-column statistics
+ * author: Ryan Wagner
+ * date: October 19, 2026
+ * notes: statistics are gathered in one row-major pass, each thread owns a block of rows
+ *        and the per-thread results are merged in thread order (Chan et al. for variance)
+ */
+
+#include <math.h>
+
+#include "../header/scaler.h"
+
+#define SCALER_MIN_ROWS_PER_THREAD 4096
+
+typedef struct
+{
+    Matrix m;       // Matrix being fitted or transformed
+    int threads;    // Number of threads in the pass
+    int *counts;    // Rows seen by each thread
+    double *first;  // threads x cols, mean or min per thread
+    double *second; // threads x cols, M2 or max per thread
+    double *center; // Column centers used by the transform
+    double *inv;    // Column inverse scales used by the transform
+    double *column; // threads x rows scratch for the robust scaler
+} ScalerTask;
+
+/**
+ * @brief Welford running mean and M2 over a block of rows
+ *
+ * @param args ScalerTask object
+ * @param thread_id Thread index
+ * @param start First row
+ * @param end One past the last row
+ *
+ * @return None
+ */
+static void welfordTask(void *args, int thread_id, int start, int end)
+{
+    ScalerTask *task = (ScalerTask *)args;
+    int cols = task->m.cols;
+    double *mean = &task->first[thread_id * cols];
+    double *m2 = &task->second[thread_id * cols];
+    int n = 0;
+
+    for (int r = start; r < end; ++r)
+    {
+        const double *row = &task->m.data[r * cols];
+        ++n;
+        double inv_n = 1.0 / n;
+        for (int c = 0; c < cols; ++c)
+        {
+            double delta = row[c] - mean[c];
+            mean[c] += delta * inv_n;
+            m2[c] += delta * (row[c] - mean[c]);
+        }
+    }
+
+    task->counts[thread_id] = n;
+}
+
+/**
+ * @brief Column minimum and maximum over a block of rows
+ *
+ * @param args ScalerTask object
+ * @param thread_id Thread index
+ * @param start First row
+ * @param end One past the last row
+ *
+ * @return None
+ */
+static void minMaxTask(void *args, int thread_id, int start, int end)
+{
+    ScalerTask *task = (ScalerTask *)args;
+    int cols = task->m.cols;
+    double *lo = &task->first[thread_id * cols];
+    double *hi = &task->second[thread_id * cols];
+
+    if (start >= end)
+    {
+        task->counts[thread_id] = 0;
+        return;
+    }
+
+    memcpy(lo, &task->m.data[start * cols], cols * sizeof(double));
+    memcpy(hi, &task->m.data[start * cols], cols * sizeof(double));
+    for (int r = start + 1; r < end; ++r)
+    {
+        const double *row = &task->m.data[r * cols];
+        for (int c = 0; c < cols; ++c)
+        {
+            lo[c] = (row[c] < lo[c]) ? row[c] : lo[c];
+            hi[c] = (row[c] > hi[c]) ? row[c] : hi[c];
+        }
+    }
+
+    task->counts[thread_id] = end - start;
+}
+
+/**
+ * @brief Quickselect, partially orders arr so arr[k] holds the k-th smallest value
+ *
+ * @param arr Array of values
+ * @param n Length of arr
+ * @param k Rank to select
+ *
+ * @return k-th smallest value
+ */
+static double selectKth(double *arr, int n, int k)
+{
+    int lo = 0;
+    int hi = n - 1;
+    while (lo < hi)
+    {
+        double pivot = arr[lo + (hi - lo) / 2];
+        int i = lo;
+        int j = hi;
+        while (i <= j)
+        {
+            while (arr[i] < pivot)
+                ++i;
+            while (arr[j] > pivot)
+                --j;
+            if (i <= j)
+            {
+                double temp = arr[i];
+                arr[i] = arr[j];
+                arr[j] = temp;
+                ++i;
+                --j;
+            }
+        }
+        if (k <= j)
+            hi = j;
+        else if (k >= i)
+            lo = i;
+        else
+            break;
+    }
+
+    return arr[k];
+}
+
+/**
+ * @brief Linearly interpolated quantile of an array, reorders the array
+ *
+ * @param arr Array of values
+ * @param n Length of arr
+ * @param q Quantile in [0, 1]
+ *
+ * @return Quantile value
+ */
+static double computeQuantile(double *arr, int n, double q)
+{
+    double pos = q * (n - 1);
+    int below = (int)pos;
+    double lower = selectKth(arr, n, below);
+    if (below + 1 >= n)
+    {
+        return lower;
+    }
+
+    // After selection everything past index below is >= lower, the next order statistic is their minimum
+    double upper = arr[below + 1];
+    for (int i = below + 2; i < n; ++i)
+    {
+        upper = (arr[i] < upper) ? arr[i] : upper;
+    }
+
+    return lower + (pos - below) * (upper - lower);
+}
+
+/**
+ * @brief Median and interquartile range of a block of columns
+ *
+ * @param args ScalerTask object
+ * @param thread_id Thread index
+ * @param start First column
+ * @param end One past the last column
+ *
+ * @return None
+ */
+static void robustTask(void *args, int thread_id, int start, int end)
+{
+    ScalerTask *task = (ScalerTask *)args;
+    int rows = task->m.rows;
+    int cols = task->m.cols;
+    double *column = &task->column[thread_id * rows];
+
+    for (int c = start; c < end; ++c)
+    {
+        for (int r = 0; r < rows; ++r)
+        {
+            column[r] = task->m.data[r * cols + c];
+        }
+
+        task->first[c] = computeQuantile(column, rows, 0.5);
+        double q1 = computeQuantile(column, rows, 0.25);
+        double q3 = computeQuantile(column, rows, 0.75);
+        task->second[c] = q3 - q1;
+    }
+}
+
+/**
+ * @brief Fused (x - center) * inverse scale over a block of rows
+ *
+ * @param args ScalerTask object
+ * @param thread_id Thread index
+ * @param start First row
+ * @param end One past the last row
+ *
+ * @return None
+ */
+static void transformTask(void *args, int thread_id, int start, int end)
+{
+    (void)thread_id;
+    ScalerTask *task = (ScalerTask *)args;
+    int cols = task->m.cols;
+    const double *restrict center = task->center;
+    const double *restrict inv = task->inv;
+
+    for (int r = start; r < end; ++r)
+    {
+        double *restrict row = &task->m.data[r * cols];
+        for (int c = 0; c < cols; ++c)
+        {
+            row[c] = (row[c] - center[c]) * inv[c];
+        }
+    }
+}
+
+/**
+ * @brief Make an unfitted Scaler object
+ *
+ * @param type ScalerType enum of the scaling to apply
+ *
+ * @return Scaler object
+ */
+Scaler makeDefaultScaler(ScalerType type)
+{
+    Scaler scaler;
+    scaler.type = type;
+    scaler.samples = 0;
+    scaler.center.size = 0;
+    scaler.center.data = NULL;
+    scaler.scale.size = 0;
+    scaler.scale.data = NULL;
+
+    return scaler;
+}
+
+/**
+ * @brief Compute and store the per-column statistics of a Matrix
+ *
+ * @param scaler Pointer to Scaler object, type must already be set
+ * @param m Matrix to fit on, usually the training features
+ *
+ * @return 0 if successful, -1 if failure
+ */
+int fitScaler(Scaler *scaler, Matrix m)
+{
+    if (!scaler || !m.data || m.rows < 1 || m.cols < 1)
+    {
+        LOG_ERROR("Input variables to fit the scaler were not correct.\n");
+        return -1;
+    }
+    if (scaler->type == SCALE_NONE)
+    {
+        LOG_ERROR("Scaler type was not set before fitting.\n");
+        return -1;
+    }
+
+    freeScaler(scaler);
+    if (makeVectorZeros(&scaler->center, m.cols) < 0 || makeVectorZeros(&scaler->scale, m.cols) < 0)
+    {
+        LOG_ERROR("Failed to allocate scaler statistics.\n");
+        freeScaler(scaler);
+        return -1;
+    }
+
+    ScalerTask task = {0};
+    task.m = m;
+    task.threads = (scaler->type == SCALE_ROBUST) ? planThreads(m.cols, 1) : planThreads(m.rows, SCALER_MIN_ROWS_PER_THREAD);
+    task.counts = calloc(task.threads, sizeof(int));
+    task.first = calloc(task.threads * m.cols, sizeof(double));
+    task.second = calloc(task.threads * m.cols, sizeof(double));
+    if (scaler->type == SCALE_ROBUST)
+    {
+        task.column = malloc(task.threads * m.rows * sizeof(double));
+    }
+    if (!task.counts || !task.first || !task.second || (scaler->type == SCALE_ROBUST && !task.column))
+    {
+        LOG_ERROR("Failed to allocate scaler work buffers.\n");
+        free(task.counts);
+        free(task.first);
+        free(task.second);
+        free(task.column);
+        freeScaler(scaler);
+        return -1;
+    }
+
+    double *center = scaler->center.data;
+    double *scale = scaler->scale.data;
+    int status = 0;
+
+    switch (scaler->type)
+    {
+    case SCALE_STANDARD:
+    {
+        parallelFor(task.threads, m.rows, welfordTask, &task);
+
+        // Chan's parallel merge of (count, mean, M2), in thread order
+        double *m2 = calloc(m.cols, sizeof(double));
+        if (!m2)
+        {
+            LOG_ERROR("Failed to allocate the merged scaler variances.\n");
+            status = -1;
+            break;
+        }
+        double n = 0.0;
+        for (int t = 0; t < task.threads; ++t)
+        {
+            double nb = task.counts[t];
+            if (nb == 0)
+            {
+                continue;
+            }
+            double total = n + nb;
+            const double *mean_b = &task.first[t * m.cols];
+            const double *m2_b = &task.second[t * m.cols];
+            for (int c = 0; c < m.cols; ++c)
+            {
+                double delta = mean_b[c] - center[c];
+                center[c] += delta * nb / total;
+                m2[c] += m2_b[c] + delta * delta * n * nb / total;
+            }
+            n = total;
+        }
+        for (int c = 0; c < m.cols; ++c)
+        {
+            scale[c] = sqrt(m2[c] / n);
+        }
+        free(m2);
+        break;
+    }
+    case SCALE_MINMAX:
+    {
+        parallelFor(task.threads, m.rows, minMaxTask, &task);
+
+        bool seen = false;
+        double *hi = malloc(m.cols * sizeof(double));
+        if (!hi)
+        {
+            LOG_ERROR("Failed to allocate the merged scaler maximums.\n");
+            status = -1;
+            break;
+        }
+        for (int t = 0; t < task.threads; ++t)
+        {
+            if (task.counts[t] == 0)
+            {
+                continue;
+            }
+            const double *lo_t = &task.first[t * m.cols];
+            const double *hi_t = &task.second[t * m.cols];
+            for (int c = 0; c < m.cols; ++c)
+            {
+                center[c] = (!seen || lo_t[c] < center[c]) ? lo_t[c] : center[c];
+                hi[c] = (!seen || hi_t[c] > hi[c]) ? hi_t[c] : hi[c];
+            }
+            seen = true;
+        }
+        for (int c = 0; c < m.cols; ++c)
+        {
+            scale[c] = hi[c] - center[c];
+        }
+        free(hi);
+        break;
+    }
+    case SCALE_ROBUST:
+    {
+        // Quantiles need every value of a column, so this variant is parallel over columns
+        parallelFor(task.threads, m.cols, robustTask, &task);
+        memcpy(center, task.first, m.cols * sizeof(double));
+        memcpy(scale, task.second, m.cols * sizeof(double));
+        break;
+    }
+    default:
+    {
+        LOG_ERROR("Scaler type was not recognized.\n");
+        status = -1;
+        break;
+    }
+    }
+
+    free(task.counts);
+    free(task.first);
+    free(task.second);
+    free(task.column);
+    if (status < 0)
+    {
+        freeScaler(scaler);
+        return -1;
+    }
+
+    // Constant columns are only centered
+    for (int c = 0; c < m.cols; ++c)
+    {
+        if (scale[c] == 0.0 || !isfinite(scale[c]))
+        {
+            scale[c] = 1.0;
+        }
+    }
+
+    scaler->samples = m.rows;
+
+    return 0;
+}
+
+/**
+ * @brief Apply stored statistics to a Matrix in place
+ *
+ * @param scaler Fitted Scaler object
+ * @param m Pointer to Matrix to scale, must have as many columns as the fitted data
+ *
+ * @return 0 if successful, -1 if failure
+ */
+int transformScaler(const Scaler *scaler, Matrix *m)
+{
+    if (!scaler || !initialized_matrix(m))
+    {
+        LOG_ERROR("Input variables to transform with the scaler were not correct.\n");
+        return -1;
+    }
+    if (scaler->type == SCALE_NONE)
+    {
+        return 0;
+    }
+    if (!scaler->center.data || scaler->center.size != m->cols)
+    {
+        LOG_ERROR("Scaler was fitted on %d columns, Matrix has %d.\n", scaler->center.size, m->cols);
+        return -1;
+    }
+
+    ScalerTask task = {0};
+    task.m = *m;
+    task.center = scaler->center.data;
+    task.inv = malloc(m->cols * sizeof(double));
+    if (!task.inv)
+    {
+        LOG_ERROR("Failed to allocate inverse scales.\n");
+        return -1;
+    }
+    for (int c = 0; c < m->cols; ++c)
+    {
+        task.inv[c] = 1.0 / scaler->scale.data[c];
+    }
+
+    parallelFor(planThreads(m->rows, SCALER_MIN_ROWS_PER_THREAD), m->rows, transformTask, &task);
+
+    free(task.inv);
+
+    return 0;
+}
+
+/**
+ * @brief Fit a Scaler on a Matrix and scale that Matrix in place
+ *
+ * @param scaler Pointer to Scaler object, type must already be set
+ * @param m Pointer to Matrix to fit and scale
+ *
+ * @return 0 if successful, -1 if failure
+ */
+int fitTransformScaler(Scaler *scaler, Matrix *m)
+{
+    if (!m || fitScaler(scaler, *m) < 0)
+    {
+        LOG_ERROR("Fitting the scaler was unsuccessful.\n");
+        return -1;
+    }
+
+    return transformScaler(scaler, m);
+}
+
+/**
+ * @brief Free the statistics of a Scaler object, the type is kept
+ *
+ * @param scaler Scaler to free
+ *
+ * @return None
+ */
+void freeScaler(Scaler *scaler)
+{
+    if (!scaler)
+    {
+        return;
+    }
+
+    freeVector(&scaler->center);
+    freeVector(&scaler->scale);
+    scaler->center.size = 0;
+    scaler->scale.size = 0;
+    scaler->samples = 0;
+}
@@ -0,0 +1,252 @@
+/*
+ * file: sparse.c
+ * description: compressed sparse row (CSR) matrix create, free, convert, and multiply functions
+ * author: Ryan Wagner
+ * date: October 19, 2026
+ * notes: kernels only touch stored values, so hashed features with millions of columns
+ *        cost O(nnz) instead of O(rows * cols)
+ */
+
+#include "../header/sparse.h"
+
+#define SPARSE_MIN_ROWS_PER_THREAD 256
+
+typedef struct
+{
+    SparseMatrix A;
+    Matrix B;
+    Matrix *result;
+} SparseTask;
+
+/**
+ * @brief Make a SparseMatrix with no rows and no storage
+ *
+ * @return SparseMatrix object
+ */
+SparseMatrix makeSparseMatrixEmpty(void)
+{
+    SparseMatrix s;
+    s.rows = 0;
+    s.cols = 0;
+    s.nnz = 0;
+    s.row_ptr = NULL;
+    s.col_idx = NULL;
+    s.values = NULL;
+
+    return s;
+}
+
+/**
+ * @brief Allocate a SparseMatrix with room for exactly nnz values, row_ptr is zeroed
+ *
+ * @param s Pointer to SparseMatrix object to make
+ * @param rows Number of rows
+ * @param cols Number of columns
+ * @param nnz Number of values to store
+ *
+ * @return 0 if successful, -1 if failure
+ */
+int makeSparseMatrix(SparseMatrix *s, int rows, int cols, int64_t nnz)
+{
+    if (!s || rows <= 0 || cols <= 0 || nnz < 0)
+    {
+        LOG_ERROR("Input variables to make a sparse matrix were not correct.\n");
+        return -1;
+    }
+
+    *s = makeSparseMatrixEmpty();
+    s->row_ptr = calloc((size_t)rows + 1, sizeof(int64_t));
+    // Keep a valid pointer for empty matrices so callers can test the members like a Matrix
+    s->col_idx = malloc((size_t)(nnz > 0 ? nnz : 1) * sizeof(int));
+    s->values = malloc((size_t)(nnz > 0 ? nnz : 1) * sizeof(double));
+    if (!s->row_ptr || !s->col_idx || !s->values)
+    {
+        LOG_ERROR("Failed to allocate sparse matrix with %lld values.\n", (long long)nnz);
+        freeSparseMatrix(s);
+        return -1;
+    }
+
+    s->rows = rows;
+    s->cols = cols;
+    s->nnz = nnz;
+
+    return 0;
+}
+
+/**
+ * @brief Free a SparseMatrix and reset it to empty
+ *
+ * @param s SparseMatrix to free
+ *
+ * @return None
+ */
+void freeSparseMatrix(SparseMatrix *s)
+{
+    if (!s)
+    {
+        return;
+    }
+
+    free(s->row_ptr);
+    free(s->col_idx);
+    free(s->values);
+    *s = makeSparseMatrixEmpty();
+}
+
+/**
+ * @brief Expand a SparseMatrix into a dense Matrix, duplicate entries are summed
+ *
+ * @param s SparseMatrix to expand
+ * @param m Pointer to Matrix, (re)allocated to s.rows x s.cols
+ *
+ * @return 0 if successful, -1 if failure
+ */
+int sparseToDense(SparseMatrix s, Matrix *m)
+{
+    if (!s.row_ptr || !m)
+    {
+        LOG_ERROR("Input variables to densify a sparse matrix were not correct.\n");
+        return -1;
+    }
+
+    freeMatrix(m);
+    if (makeMatrixZeros(m, s.rows, s.cols) < 0)
+    {
+        LOG_ERROR("Failed to allocate the dense matrix.\n");
+        return -1;
+    }
+
+    for (int r = 0; r < s.rows; ++r)
+    {
+        double *row = &m->data[(size_t)r * s.cols];
+        for (int64_t k = s.row_ptr[r]; k < s.row_ptr[r + 1]; ++k)
+        {
+            row[s.col_idx[k]] += s.values[k];
+        }
+    }
+
+    return 0;
+}
+
+/**
+ * @brief Make sure a result Matrix has the right shape and is zeroed
+ *
+ * @param result Matrix to prepare
+ * @param rows Required rows
+ * @param cols Required columns
+ *
+ * @return 0 if successful, -1 if failure
+ */
+static int prepareResult(Matrix *result, int rows, int cols)
+{
+    if (initialized_matrix(result) && result->rows == rows && result->cols == cols)
+    {
+        return clearMatrix(result);
+    }
+
+    freeMatrix(result);
+    return makeMatrixZeros(result, rows, cols);
+}
+
+/**
+ * @brief result rows = A rows * B over a block of rows
+ *
+ * @param args SparseTask object
+ * @param thread_id Thread index
+ * @param start First row
+ * @param end One past the last row
+ *
+ * @return None
+ */
+static void sparseMatMulTask(void *args, int thread_id, int start, int end)
+{
+    (void)thread_id;
+    SparseTask *task = (SparseTask *)args;
+    int cols = task->B.cols;
+
+    for (int r = start; r < end; ++r)
+    {
+        double *restrict out = &task->result->data[(size_t)r * cols];
+        for (int64_t k = task->A.row_ptr[r]; k < task->A.row_ptr[r + 1]; ++k)
+        {
+            const double *restrict b = &task->B.data[(size_t)task->A.col_idx[k] * cols];
+            double v = task->A.values[k];
+            for (int c = 0; c < cols; ++c)
+            {
+                out[c] += v * b[c];
+            }
+        }
+    }
+}
+
+/**
+ * @brief Sparse times dense matrix multiplication, result = A * B
+ *
+ * @param A SparseMatrix of M x K
+ * @param B Matrix of K x N
+ * @param result Matrix of M x N, resized if its shape does not match
+ *
+ * @return 0 if successful, -1 if failure
+ */
+int sparseMatMul(SparseMatrix A, Matrix B, Matrix *result)
+{
+    if (!A.row_ptr || !B.data || !result || A.cols != B.rows)
+    {
+        LOG_ERROR("Input variables could not pass inital tests for sparse matrix multiplication.\n");
+        return -1;
+    }
+
+    if (prepareResult(result, A.rows, B.cols) < 0)
+    {
+        LOG_ERROR("Error initializing zero output matrix.\n");
+        return -1;
+    }
+
+    // Rows write disjoint output rows, so they split across threads without reduction
+    SparseTask task = {A, B, result};
+    return parallelFor(planThreads(A.rows, SPARSE_MIN_ROWS_PER_THREAD), A.rows, sparseMatMulTask, &task);
+}
+
+/**
+ * @brief Transposed sparse times dense matrix multiplication, result = A^T * B.
+ *        This is the gradient product X^T * error when X is sparse.
+ *
+ * @param A SparseMatrix of M x K
+ * @param B Matrix of M x N
+ * @param result Matrix of K x N, resized if its shape does not match
+ *
+ * @return 0 if successful, -1 if failure
+ */
+int sparseTransMatMul(SparseMatrix A, Matrix B, Matrix *result)
+{
+    if (!A.row_ptr || !B.data || !result || A.rows != B.rows)
+    {
+        LOG_ERROR("Input variables could not pass inital tests for sparse transpose multiplication.\n");
+        return -1;
+    }
+
+    if (prepareResult(result, A.cols, B.cols) < 0)
+    {
+        LOG_ERROR("Error initializing zero output matrix.\n");
+        return -1;
+    }
+
+    // Scatter every stored value's row of B into its column's output row, serial because
+    // rows of A share columns and per-thread K x N buffers would not fit for hashed features
+    int cols = B.cols;
+    for (int r = 0; r < A.rows; ++r)
+    {
+        const double *restrict b = &B.data[(size_t)r * cols];
+        for (int64_t k = A.row_ptr[r]; k < A.row_ptr[r + 1]; ++k)
+        {
+            double *restrict out = &result->data[(size_t)A.col_idx[k] * cols];
+            double v = A.values[k];
+            for (int c = 0; c < cols; ++c)
+            {
+                out[c] += v * b[c];
+            }
+        }
+    }
+
+    return 0;
+}
@@ -0,0 +1,706 @@
+/*
+ * file: sweep.c
+ * description: in-process hyperparameter sweep that trains many models concurrently
+ * author: Ryan Wagner
+ * date: October 19, 2026
+ * notes: every trial reads the base model's SplitData in place, so a sweep holds one copy of
+ *        the dataset no matter how many models train at once. Workers pull trials from a
+ *        shared counter and split the cores between the trials they run. Successive halving
+ *        keeps every trial's weights and optimizer state between rounds and resumes the
+ *        survivors from them.
+ */
+
+#include <stdatomic.h>
+
+#include "../header/sweep.h"
+#include "../header/threading.h"
+
+typedef struct
+{
+    const Model *base;  // Template model that owns the shared dataset
+    SweepTrial *trials; // Trials to train
+    int count;          // Number of trials
+    int inner_threads;  // Threads every trial may use inside trainModel
+    int budget;         // Epochs every trial is trained up to, 0 to train from scratch for config.epochs
+    atomic_int next;    // Next trial to hand out
+} SweepTask;
+
+/**
+ * @brief Start a trial from the base model's configuration
+ *
+ * @param base Template Model object
+ * @param trial SweepTrial to fill
+ * @param index Position of the trial in the generated set
+ *
+ * @return None
+ */
+static void initTrial(const Model *base, SweepTrial *trial, int index)
+{
+    memset(trial, 0, sizeof(SweepTrial));
+    trial->index = index;
+    trial->config = base->config;
+    trial->batch_size = base->batch_size;
+    trial->beta = base->beta;
+    trial->status = -1;
+    trial->score = -INFINITY;
+    trial->loss = INFINITY;
+}
+
+/**
+ * @brief Set the initial learning rate of a trial
+ *
+ * @param trial SweepTrial object
+ * @param learning_rate Initial learning rate
+ *
+ * @return None
+ */
+static void setTrialLearningRate(SweepTrial *trial, double learning_rate)
+{
+    trial->config.learning_rate.init_learning_rate = learning_rate;
+    trial->config.learning_rate.curr_learning_rate = learning_rate;
+}
+
+/**
+ * @brief Every combination of the swept values, the first hyperparameter varies slowest
+ *
+ * @param base Template Model object whose configuration fills the unswept values
+ * @param space Values to sweep
+ * @param trials Resulting array of trials, free with freeSweepTrials
+ * @param count Resulting number of trials
+ *
+ * @return 0 if successful, -1 if failure
+ */
+int makeGridTrials(const Model *base, const SweepSpace *space, SweepTrial **trials, int *count)
+{
+    if (!base || !space || !trials || !count)
+    {
+        LOG_ERROR("Input variables to make a sweep grid were not correct.\n");
+        return -1;
+    }
+
+    int sizes[5] = {space->n_learning_rates, space->n_decay_types, space->n_lambdas, space->n_batch_sizes, space->n_betas};
+    long total = 1;
+    for (int d = 0; d < 5; ++d)
+    {
+        total *= (sizes[d] > 0) ? sizes[d] : 1;
+    }
+    if (total > INT32_MAX)
+    {
+        LOG_ERROR("Sweep grid of %ld trials is too large.\n", total);
+        return -1;
+    }
+
+    *trials = calloc(total, sizeof(SweepTrial));
+    if (!*trials)
+    {
+        LOG_ERROR("Allocating %ld sweep trials was unsuccessful.\n", total);
+        return -1;
+    }
+    *count = (int)total;
+
+    for (int t = 0; t < *count; ++t)
+    {
+        SweepTrial *trial = &(*trials)[t];
+        initTrial(base, trial, t);
+
+        // Split the trial index into one digit per hyperparameter, the last one varies fastest
+        int digits[5] = {0};
+        int rest = t;
+        for (int d = 4; d >= 0; --d)
+        {
+            int size = (sizes[d] > 0) ? sizes[d] : 1;
+            digits[d] = rest % size;
+            rest /= size;
+        }
+
+        if (space->n_learning_rates > 0)
+        {
+            setTrialLearningRate(trial, space->learning_rates[digits[0]]);
+        }
+        if (space->n_decay_types > 0)
+        {
+            trial->config.learning_rate.decay_type = space->decay_types[digits[1]];
+        }
+        if (space->n_lambdas > 0)
+        {
+            trial->config.lambda = space->lambdas[digits[2]];
+        }
+        if (space->n_batch_sizes > 0)
+        {
+            trial->batch_size = space->batch_sizes[digits[3]];
+        }
+        if (space->n_betas > 0)
+        {
+            trial->beta = space->betas[digits[4]];
+        }
+    }
+
+    return 0;
+}
+
+/**
+ * @brief Draw a value between the smallest and largest entry of a list, log-uniformly when
+ *        both are positive
+ *
+ * @param values List of values
+ * @param n Number of values
+ * @param log_scale Draw on a log scale when the range is positive
+ * @param rng RandomState to draw from
+ *
+ * @return Random value in the range of the list
+ */
+static double drawInRange(const double *values, int n, bool log_scale, RandomState *rng)
+{
+    double low = values[0];
+    double high = values[0];
+    for (int i = 1; i < n; ++i)
+    {
+        low = MIN(low, values[i]);
+        high = MAX(high, values[i]);
+    }
+
+    double u = randomUniform(rng);
+    if (log_scale && low > 0)
+    {
+        return exp(log(low) + u * (log(high) - log(low)));
+    }
+    return low + u * (high - low);
+}
+
+/**
+ * @brief Random search over the space. Learning rates and lambdas are drawn log-uniformly and
+ *        betas uniformly between the smallest and largest listed value, decay types and
+ *        batch sizes are picked from their lists.
+ *
+ * @param base Template Model object whose configuration fills the unswept values
+ * @param space Values that bound or list every hyperparameter
+ * @param count Number of trials to draw
+ * @param seed Seed of the draws, 0 to draw one from the calling thread's stream
+ * @param trials Resulting array of trials, free with freeSweepTrials
+ *
+ * @return 0 if successful, -1 if failure
+ */
+int makeRandomTrials(const Model *base, const SweepSpace *space, int count, uint64_t seed, SweepTrial **trials)
+{
+    if (!base || !space || !trials || count < 1)
+    {
+        LOG_ERROR("Input variables to draw random sweep trials were not correct.\n");
+        return -1;
+    }
+
+    *trials = calloc(count, sizeof(SweepTrial));
+    if (!*trials)
+    {
+        LOG_ERROR("Allocating %d sweep trials was unsuccessful.\n", count);
+        return -1;
+    }
+
+    RandomState rng;
+    initRandomStream(&rng, seed);
+    for (int t = 0; t < count; ++t)
+    {
+        SweepTrial *trial = &(*trials)[t];
+        initTrial(base, trial, t);
+        if (space->n_learning_rates > 0)
+        {
+            setTrialLearningRate(trial, drawInRange(space->learning_rates, space->n_learning_rates, true, &rng));
+        }
+        if (space->n_decay_types > 0)
+        {
+            trial->config.learning_rate.decay_type = space->decay_types[randomBounded(&rng, space->n_decay_types)];
+        }
+        if (space->n_lambdas > 0)
+        {
+            trial->config.lambda = drawInRange(space->lambdas, space->n_lambdas, true, &rng);
+        }
+        if (space->n_batch_sizes > 0)
+        {
+            trial->batch_size = space->batch_sizes[randomBounded(&rng, space->n_batch_sizes)];
+        }
+        if (space->n_betas > 0)
+        {
+            trial->beta = drawInRange(space->betas, space->n_betas, false, &rng);
+        }
+    }
+
+    return 0;
+}
+
+/**
+ * @brief Train one trial on the base model's data and score it on the validation split. The
+ *        trial's model borrows the dataset and hands it back before it is freed, and the
+ *        weights and optimizer state it ends with stay with the trial.
+ *
+ * @param base Template Model object that owns the dataset
+ * @param trial SweepTrial to train
+ * @param epochs Epochs to continue from the trial's weights and optimizer state, 0 to train
+ *        from scratch for config.epochs
+ *
+ * @return 0 if successful, -1 if failure
+ */
+static int trainTrial(const Model *base, SweepTrial *trial, int epochs)
+{
+    Model model;
+    if (initModel(&model) < 0)
+    {
+        return -1;
+    }
+    freeSplitData(&model.splitdata);
+    model.splitdata = base->splitdata;
+    model.train_table = base->train_table;
+    model.type = base->type;
+    model.func = base->func;
+    model.classes = base->classes;
+    model.config = trial->config;
+    model.config.checkpoint_path = NULL; // Concurrent models would overwrite one checkpoint
+    model.batch_size = trial->batch_size;
+    model.beta = trial->beta;
+
+    // Resuming takes over the trial's weights and optimizer state, a fresh fit replaces them
+    if (epochs > 0)
+    {
+        *model.weights = trial->weights;
+        *model.bias = trial->bias;
+        model.state = trial->state;
+        memset(&trial->weights, 0, sizeof(Matrix));
+        memset(&trial->bias, 0, sizeof(Vector));
+        memset(&trial->state, 0, sizeof(OptimizerState));
+    }
+    else
+    {
+        freeMatrix(&trial->weights);
+        freeVector(&trial->bias);
+        freeOptimizerState(&trial->state);
+    }
+
+    int status = (epochs > 0) ? resumeModel(&model, epochs) : trainModel(&model);
+    if (status == 0)
+    {
+        status = evaluateModel(&model, base->splitdata.valid_features, base->splitdata.valid_labels, &trial->metrics);
+    }
+    if (status == 0)
+    {
+        status = evaluateLoss(&model, base->splitdata.valid_features, base->splitdata.valid_labels, &trial->loss);
+    }
+    if (status == 0)
+    {
+        trial->score = metricScore(trial->metrics, model.type);
+    }
+
+    // Hand the training state back, the learning rate schedule carries on from it
+    trial->config.learning_rate = model.config.learning_rate;
+    trial->epochs = model.state.epoch;
+    trial->weights = *model.weights;
+    trial->bias = *model.bias;
+    trial->state = model.state;
+    model.weights->data = NULL;
+    model.bias->data = NULL;
+    memset(&model.state, 0, sizeof(OptimizerState));
+
+    // The dataset belongs to the base model
+    memset(&model.splitdata, 0, sizeof(SplitData));
+    model.train_table = makeTypedTableEmpty();
+    freeModel(&model);
+    return status;
+}
+
+/**
+ * @brief Worker loop that trains trials until none are left
+ *
+ * @param args SweepTask object
+ * @param thread_id Worker index
+ * @param start Unused, trials are handed out dynamically
+ * @param end Unused, trials are handed out dynamically
+ *
+ * @return None
+ */
+static void sweepWorker(void *args, int thread_id, int start, int end)
+{
+    (void)thread_id;
+    (void)start;
+    (void)end;
+    SweepTask *task = (SweepTask *)args;
+
+    // parallelFor runs the first worker on the caller, whose own count must survive the sweep
+    int previous_threads = getLocalThreadCount();
+    setLocalThreadCount(task->inner_threads);
+
+    int t = atomic_fetch_add(&task->next, 1);
+    while (t < task->count)
+    {
+        SweepTrial *trial = &task->trials[t];
+        t = atomic_fetch_add(&task->next, 1);
+
+        // A trial that stopped early has used every epoch it will, its last score stands for
+        // the rest of the budget
+        bool spent = task->budget > 0 && trial->status == 0 && trial->state.stopped;
+        trial->budget = task->budget;
+        if (spent)
+        {
+            continue;
+        }
+        int epochs = (task->budget > 0) ? MAX(1, task->budget - trial->epochs) : 0;
+        trial->status = trainTrial(task->base, trial, epochs);
+        if (trial->status < 0)
+        {
+            LOG_WARN("Sweep trial %d failed to train or score.\n", trial->index);
+        }
+    }
+
+    setLocalThreadCount(previous_threads);
+}
+
+/**
+ * @brief Order trials by score, best first, failed trials last
+ *
+ * @param a First SweepTrial
+ * @param b Second SweepTrial
+ *
+ * @return Negative when a ranks before b
+ */
+static int compareTrials(const void *a, const void *b)
+{
+    const SweepTrial *x = (const SweepTrial *)a;
+    const SweepTrial *y = (const SweepTrial *)b;
+    bool x_ok = x->status == 0 && !isnan(x->score);
+    bool y_ok = y->status == 0 && !isnan(y->score);
+    if (x_ok != y_ok)
+    {
+        return x_ok ? -1 : 1;
+    }
+    if (x_ok && x->score != y->score)
+    {
+        return (x->score > y->score) ? -1 : 1;
+    }
+    return x->index - y->index;
+}
+
+/**
+ * @brief Order trials for successive halving, trials that reached the largest budget first and
+ *        the lowest validation loss first among them, failed trials last. A trial that stopped
+ *        early counts as having reached the budget of its round.
+ *
+ * @param a First SweepTrial
+ * @param b Second SweepTrial
+ *
+ * @return Negative when a ranks before b
+ */
+static int compareBudgets(const void *a, const void *b)
+{
+    const SweepTrial *x = (const SweepTrial *)a;
+    const SweepTrial *y = (const SweepTrial *)b;
+    bool x_ok = x->status == 0 && !isnan(x->loss);
+    bool y_ok = y->status == 0 && !isnan(y->loss);
+    if (x_ok != y_ok)
+    {
+        return x_ok ? -1 : 1;
+    }
+    if (x_ok && x->budget != y->budget)
+    {
+        return y->budget - x->budget;
+    }
+    if (x_ok && x->loss != y->loss)
+    {
+        return (x->loss < y->loss) ? -1 : 1;
+    }
+    return x->index - y->index;
+}
+
+/**
+ * @brief Check that the base model has a validation split to rank trials on
+ *
+ * @param base Template Model object
+ *
+ * @return true if the validation split is set
+ */
+static bool hasValidationSplit(const Model *base)
+{
+    // makeDefaultSplitData leaves 1 x 1 placeholders, which are not a validation split
+    Matrix valid_X = base->splitdata.valid_features;
+    Matrix valid_y = base->splitdata.valid_labels;
+    if (!valid_X.data || !valid_y.data || valid_X.rows < 2 || valid_X.rows != valid_y.rows)
+    {
+        LOG_ERROR("A sweep ranks trials on the validation split, which was not set.\n");
+        return false;
+    }
+    return true;
+}
+
+/**
+ * @brief Train trials concurrently, each worker taking the next trial as soon as it finishes one
+ *
+ * @param base Template Model object that owns the dataset
+ * @param trials Trials to train
+ * @param count Number of trials
+ * @param budget Epochs every trial is trained up to, 0 to train from scratch for config.epochs
+ * @param workers Trials trained at once, <= 0 for one per core
+ *
+ * @return Number of trials that trained successfully, -1 if the workers could not run
+ */
+static int trainTrials(const Model *base, SweepTrial *trials, int count, int budget, int workers)
+{
+    int cores = getThreadCount();
+    workers = (workers <= 0) ? cores : workers;
+    workers = MIN(MIN(workers, count), MAX_THREADS);
+
+    SweepTask task;
+    task.base = base;
+    task.trials = trials;
+    task.count = count;
+    task.inner_threads = MAX(1, cores / workers);
+    task.budget = budget;
+    atomic_init(&task.next, 0);
+    if (parallelFor(workers, workers, sweepWorker, &task) < 0)
+    {
+        LOG_ERROR("Running the sweep workers was unsuccessful.\n");
+        return -1;
+    }
+
+    int trained = 0;
+    for (int t = 0; t < count; ++t)
+    {
+        trained += trials[t].status == 0;
+    }
+    return trained;
+}
+
+/**
+ * @brief Train every trial concurrently on the base model's dataset and rank them by their
+ *        validation score. Workers take the next untrained trial as soon as they finish one,
+ *        and each trial may use an equal share of the cores for its own parallel work.
+ *
+ * @param base Template Model object with the type, activation, classes, and a training and
+ *        validation split, which every trial reads without copying
+ * @param trials Trials from makeGridTrials or makeRandomTrials, sorted best first on return
+ * @param count Number of trials
+ * @param workers Trials trained at once, <= 0 for one per core
+ *
+ * @return 0 if successful, -1 if failure
+ */
+int runSweep(const Model *base, SweepTrial *trials, int count, int workers)
+{
+    if (!base || !trials || count < 1)
+    {
+        LOG_ERROR("Input variables to run a sweep were not correct.\n");
+        return -1;
+    }
+    if (!hasValidationSplit(base))
+    {
+        return -1;
+    }
+
+    int trained = trainTrials(base, trials, count, 0, workers);
+    if (trained < 0)
+    {
+        return -1;
+    }
+    qsort(trials, count, sizeof(SweepTrial), compareTrials);
+    if (trained == 0)
+    {
+        LOG_ERROR("No sweep trial trained successfully.\n");
+        return -1;
+    }
+    LOG_DEBUG("Sweep trained %d of %d trials, best score %f from trial %d.\n", trained, count, trials[0].score, trials[0].index);
+
+    return 0;
+}
+
+/**
+ * @brief Successive halving: train every trial for min_epochs, keep the 1 / eta with the lowest
+ *        validation loss, and resume the survivors from their weights and optimizer state until
+ *        they reach eta times the budget, repeating until one trial is left or max_epochs is
+ *        reached. Poor configurations stop after a few epochs, so the search costs about
+ *        rounds * count * min_epochs epochs instead of count * max_epochs. Every trial's
+ *        config.epochs is set to max_epochs, the horizon of its learning rate schedule.
+ *
+ * @param base Template Model object with the type, activation, classes, and a training and
+ *        validation split, which every trial reads without copying
+ * @param trials Fresh trials from makeGridTrials or makeRandomTrials with the gradient descent
+ *        solver, sorted on return by the budget reached and then validation loss, best first
+ * @param count Number of trials
+ * @param min_epochs Budget of the first round
+ * @param max_epochs Budget of the last round
+ * @param eta Factor the field shrinks and the budget grows by every round, at least 2
+ * @param workers Trials trained at once, <= 0 for one per core
+ *
+ * @return 0 if successful, -1 if failure
+ */
+int runSuccessiveHalving(const Model *base, SweepTrial *trials, int count, int min_epochs, int max_epochs, int eta, int workers)
+{
+    if (!base || !trials || count < 1 || min_epochs < 1 || max_epochs < min_epochs || eta < 2)
+    {
+        LOG_ERROR("Input variables to run successive halving were not correct.\n");
+        return -1;
+    }
+    if (!hasValidationSplit(base))
+    {
+        return -1;
+    }
+    for (int t = 0; t < count; ++t)
+    {
+        trials[t].config.epochs = max_epochs;
+    }
+
+    long epochs_run = 0;
+    int alive = count;
+    int budget = min_epochs;
+    while (true)
+    {
+        for (int t = 0; t < alive; ++t)
+        {
+            epochs_run -= trials[t].epochs;
+        }
+        int trained = trainTrials(base, trials, alive, budget, workers);
+        if (trained < 0)
+        {
+            return -1;
+        }
+        for (int t = 0; t < alive; ++t)
+        {
+            epochs_run += trials[t].epochs;
+        }
+
+        // Survivors go to the front, the rest keep the epochs they were cut at
+        qsort(trials, alive, sizeof(SweepTrial), compareBudgets);
+        if (trained == 0)
+        {
+            LOG_ERROR("No trial survived the successive halving round of %d epochs.\n", budget);
+            return -1;
+        }
+        LOG_DEBUG("Successive halving round of %d epochs: %d trials, best loss %f.\n", budget, alive, trials[0].loss);
+
+        if (budget >= max_epochs || alive <= 1)
+        {
+            break;
+        }
+        alive = MIN(MAX(1, alive / eta), trained);
+        budget = (budget > max_epochs / eta) ? max_epochs : budget * eta;
+    }
+
+    qsort(trials, count, sizeof(SweepTrial), compareBudgets);
+    LOG_DEBUG("Successive halving trained %ld epochs where the full search takes %ld.\n", epochs_run, (long)count * max_epochs);
+
+    return 0;
+}
+
+/**
+ * @brief Hyperband: run successive halving brackets that trade the number of random trials
+ *        against their first budget, from many trials at min_epochs down to a few trained for
+ *        max_epochs from the start, which hedges against configurations that only pay off late
+ *
+ * @param base Template Model object with a training and validation split
+ * @param space Values that bound or list every hyperparameter, drawn as in makeRandomTrials
+ * @param min_epochs Smallest budget any trial is trained for
+ * @param max_epochs Largest budget any trial is trained for
+ * @param eta Factor the field shrinks and the budget grows by every round, at least 2
+ * @param seed Seed of the draws, 0 to draw one from the calling thread's stream
+ * @param workers Trials trained at once, <= 0 for one per core
+ * @param trials Resulting trials of every bracket, sorted as in runSuccessiveHalving, free with
+ *        freeSweepTrials
+ * @param count Resulting number of trials
+ *
+ * @return 0 if successful, -1 if failure
+ */
+int runHyperband(const Model *base, const SweepSpace *space, int min_epochs, int max_epochs, int eta, uint64_t seed, int workers,
+                 SweepTrial **trials, int *count)
+{
+    if (!base || !space || !trials || !count || min_epochs < 1 || max_epochs < min_epochs || eta < 2)
+    {
+        LOG_ERROR("Input variables to run hyperband were not correct.\n");
+        return -1;
+    }
+
+    // Brackets s_max down to 0, bracket s starts ceil((s_max + 1) / (s + 1) * eta^s) trials
+    // at max_epochs / eta^s epochs
+    int s_max = 0;
+    long reach = min_epochs;
+    while (reach * eta <= max_epochs)
+    {
+        reach *= eta;
+        ++s_max;
+    }
+
+    long total = 0;
+    long scale = 1;
+    for (int s = 0; s <= s_max; ++s)
+    {
+        total += (long)ceil((double)(s_max + 1) / (s + 1) * scale);
+        scale *= eta;
+    }
+    if (total > INT32_MAX)
+    {
+        LOG_ERROR("Hyperband with %ld trials is too large.\n", total);
+        return -1;
+    }
+    *trials = calloc(total, sizeof(SweepTrial));
+    if (!*trials)
+    {
+        LOG_ERROR("Allocating %ld hyperband trials was unsuccessful.\n", total);
+        return -1;
+    }
+    *count = 0;
+
+    RandomState rng;
+    initRandomStream(&rng, seed);
+    int status = 0;
+    for (int s = s_max; s >= 0 && status == 0; --s)
+    {
+        long power = 1;
+        for (int i = 0; i < s; ++i)
+        {
+            power *= eta;
+        }
+        int n = (int)ceil((double)(s_max + 1) / (s + 1) * power);
+        int first = (int)MAX(min_epochs, max_epochs / power);
+
+        SweepTrial *bracket = NULL;
+        status = makeRandomTrials(base, space, n, nextRandom(&rng) | 1, &bracket);
+        if (status == 0)
+        {
+            for (int t = 0; t < n; ++t)
+            {
+                bracket[t].index = *count + t;
+            }
+            status = runSuccessiveHalving(base, bracket, n, first, max_epochs, eta, workers);
+            memcpy(&(*trials)[*count], bracket, n * sizeof(SweepTrial));
+            *count += n;
+        }
+        free(bracket);
+    }
+    if (status < 0)
+    {
+        LOG_ERROR("A hyperband bracket was unsuccessful.\n");
+        freeSweepTrials(*trials, *count);
+        *trials = NULL;
+        *count = 0;
+        return -1;
+    }
+
+    qsort(*trials, *count, sizeof(SweepTrial), compareBudgets);
+    LOG_DEBUG("Hyperband ran %d brackets and %d trials, best loss %f from trial %d.\n", s_max + 1, *count, (*trials)[0].loss, (*trials)[0].index);
+
+    return 0;
+}
+
+/**
+ * @brief Free the trained weights and optimizer state of every trial and the trial array
+ *
+ * @param trials Array of trials
+ * @param count Number of trials
+ *
+ * @return None
+ */
+void freeSweepTrials(SweepTrial *trials, int count)
+{
+    if (!trials)
+    {
+        return;
+    }
+    for (int t = 0; t < count; ++t)
+    {
+        freeMatrix(&trials[t].weights);
+        freeVector(&trials[t].bias);
+        freeOptimizerState(&trials[t].state);
+    }
+    free(trials);
+}
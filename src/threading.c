@@ -0,0 +1,201 @@
+/*
+ * file: threading.c
+ * description: minimal fork-join parallel-for built on pthreads
+ * author: Ryan Wagner
+ * date: October 19, 2026
+ * notes: ranges are split into equal contiguous chunks by thread index, so for a fixed
+ *        thread count every thread always sees the same rows (reductions stay reproducible)
+ */
+
+#include <unistd.h>
+
+#include "../header/threading.h"
+
+static int THREAD_COUNT = 0;
+
+// Override of THREAD_COUNT for parallel functions called from this thread, 0 to follow it
+static _Thread_local int LOCAL_THREAD_COUNT = 0;
+
+typedef struct
+{
+    ParallelTask task;
+    void *args;
+    int thread_id;
+    int start;
+    int end;
+} ThreadJob;
+
+/**
+ * @brief Number of threads parallel functions may use, the calling thread's own count when
+ *        set, otherwise the process count, which defaults to the number of online CPUs
+ *
+ * @return Thread count
+ */
+int getThreadCount(void)
+{
+    if (LOCAL_THREAD_COUNT > 0)
+    {
+        return LOCAL_THREAD_COUNT;
+    }
+    if (THREAD_COUNT <= 0)
+    {
+        long cpus = sysconf(_SC_NPROCESSORS_ONLN);
+        THREAD_COUNT = (cpus <= 0) ? 1 : (cpus > MAX_THREADS) ? MAX_THREADS : (int)cpus;
+    }
+
+    return THREAD_COUNT;
+}
+
+/**
+ * @brief Set the number of threads parallel functions may use
+ *
+ * @param threads Thread count, <= 0 resets to the number of online CPUs
+ *
+ * @return None
+ */
+void setThreadCount(int threads)
+{
+    THREAD_COUNT = (threads > MAX_THREADS) ? MAX_THREADS : threads;
+}
+
+/**
+ * @brief Get the thread count set for the calling thread with setLocalThreadCount
+ *
+ * @return Thread count, <= 0 when the calling thread follows setThreadCount
+ */
+int getLocalThreadCount(void)
+{
+    return LOCAL_THREAD_COUNT;
+}
+
+/**
+ * @brief Set the number of threads parallel functions called from the calling thread may use,
+ *        so several concurrent callers can split the cores between them
+ *
+ * @param threads Thread count, <= 0 follows setThreadCount again
+ *
+ * @return None
+ */
+void setLocalThreadCount(int threads)
+{
+    LOCAL_THREAD_COUNT = (threads > MAX_THREADS) ? MAX_THREADS : threads;
+}
+
+/**
+ * @brief Decide how many threads to use for n items so that no thread gets fewer than min_chunk
+ *
+ * @param n Number of items
+ * @param min_chunk Minimum number of items per thread
+ *
+ * @return Thread count, at least 1
+ */
+int planThreads(int n, int min_chunk)
+{
+    int threads = getThreadCount();
+    if (min_chunk < 1)
+    {
+        min_chunk = 1;
+    }
+    if (n / min_chunk < threads)
+    {
+        threads = n / min_chunk;
+    }
+
+    return (threads < 1) ? 1 : threads;
+}
+
+/**
+ * @brief First item of a thread's chunk
+ *
+ * @param n Number of items
+ * @param threads Thread count
+ * @param thread_id Thread index, passing threads gives n
+ *
+ * @return Start index of the chunk
+ */
+int getChunkStart(int n, int threads, int thread_id)
+{
+    return (int)(((long long)n * thread_id) / threads);
+}
+
+/**
+ * @brief pthread entry point that runs one chunk
+ *
+ * @param arg Pointer to ThreadJob
+ *
+ * @return NULL
+ */
+static void *runThreadJob(void *arg)
+{
+    ThreadJob *job = (ThreadJob *)arg;
+    job->task(job->args, job->thread_id, job->start, job->end);
+
+    return NULL;
+}
+
+/**
+ * @brief Run a task over [0, n) split into one contiguous chunk per thread. The calling
+ *        thread runs chunk 0 and the function returns once every chunk is done.
+ *
+ * @param threads Number of threads to use, usually from planThreads
+ * @param n Number of items
+ * @param task Function run on every chunk
+ * @param args Shared argument passed to every chunk
+ *
+ * @return 0 if successful, -1 if failure
+ */
+int parallelFor(int threads, int n, ParallelTask task, void *args)
+{
+    if (!task || n < 0)
+    {
+        LOG_ERROR("Input variables to parallel for were not correct.\n");
+        return -1;
+    }
+    if (threads > MAX_THREADS)
+    {
+        threads = MAX_THREADS;
+    }
+
+    if (threads <= 1 || n <= 1)
+    {
+        task(args, 0, 0, n);
+        return 0;
+    }
+
+    pthread_t handles[MAX_THREADS];
+    bool joinable[MAX_THREADS] = {false};
+    ThreadJob jobs[MAX_THREADS];
+
+    for (int t = 0; t < threads; ++t)
+    {
+        jobs[t].task = task;
+        jobs[t].args = args;
+        jobs[t].thread_id = t;
+        jobs[t].start = getChunkStart(n, threads, t);
+        jobs[t].end = getChunkStart(n, threads, t + 1);
+    }
+
+    for (int t = 1; t < threads; ++t)
+    {
+        if (pthread_create(&handles[t], NULL, runThreadJob, &jobs[t]) != 0)
+        {
+            // Run the chunk inline rather than failing the whole operation
+            LOG_WARN("Could not start worker thread %d, running its chunk inline.\n", t);
+            runThreadJob(&jobs[t]);
+            continue;
+        }
+        joinable[t] = true;
+    }
+
+    runThreadJob(&jobs[0]);
+
+    for (int t = 1; t < threads; ++t)
+    {
+        if (joinable[t])
+        {
+            pthread_join(handles[t], NULL);
+        }
+    }
+
+    return 0;
+}
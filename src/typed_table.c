@@ -0,0 +1,494 @@
+/*
+ * file: typed_table.c
+ * description: column-typed table create, free, convert, and gather functions
+ * author: Ryan Wagner
+ * date: October 19, 2026
+ * notes: each column is stored in the narrowest of uint8, int16, int32, float32, or float64
+ *        that holds it exactly, values are widened to double only when rows are gathered
+ */
+
+#include "../header/typed_table.h"
+
+typedef struct
+{
+    Matrix m;
+    TypedTable *t;
+    const StorageType *types;
+} TypedTableTask;
+
+/**
+ * @brief Size in bytes of one element of a storage type
+ *
+ * @param type StorageType enum
+ *
+ * @return Element size
+ */
+size_t storageTypeSize(StorageType type)
+{
+    switch (type)
+    {
+    case STORE_UINT8:
+        return sizeof(uint8_t);
+    case STORE_INT16:
+        return sizeof(int16_t);
+    case STORE_INT32:
+        return sizeof(int32_t);
+    case STORE_FLOAT32:
+        return sizeof(float);
+    default:
+        return sizeof(double);
+    }
+}
+
+/**
+ * @brief Make a ColumnProfile that no value has been added to yet
+ *
+ * @return ColumnProfile object
+ */
+ColumnProfile makeColumnProfile(void)
+{
+    ColumnProfile profile;
+    profile.integral = true;
+    profile.float_exact = true;
+    profile.min = INFINITY;
+    profile.max = -INFINITY;
+
+    return profile;
+}
+
+/**
+ * @brief Add one value to a column profile
+ *
+ * @param profile ColumnProfile to update
+ * @param value Value of the column
+ *
+ * @return None
+ */
+void updateColumnProfile(ColumnProfile *profile, double value)
+{
+    if (value < profile->min)
+    {
+        profile->min = value;
+    }
+    if (value > profile->max)
+    {
+        profile->max = value;
+    }
+    if (profile->integral && value != floor(value))
+    {
+        profile->integral = false;
+    }
+    if (profile->float_exact && (double)(float)value != value)
+    {
+        profile->float_exact = false;
+    }
+}
+
+/**
+ * @brief Pick the narrowest storage type that holds every value of a profiled column exactly
+ *
+ * @param profile ColumnProfile of the column
+ *
+ * @return StorageType enum
+ */
+StorageType narrowestStorageType(ColumnProfile profile)
+{
+    // Empty columns cost nothing to store as bytes
+    if (profile.min > profile.max)
+    {
+        return STORE_UINT8;
+    }
+
+    if (profile.integral)
+    {
+        if (profile.min >= 0 && profile.max <= UINT8_MAX)
+        {
+            return STORE_UINT8;
+        }
+        if (profile.min >= INT16_MIN && profile.max <= INT16_MAX)
+        {
+            return STORE_INT16;
+        }
+        if (profile.min >= INT32_MIN && profile.max <= INT32_MAX)
+        {
+            return STORE_INT32;
+        }
+    }
+
+    return profile.float_exact ? STORE_FLOAT32 : STORE_FLOAT64;
+}
+
+/**
+ * @brief Make a TypedTable with no rows and no storage
+ *
+ * @return TypedTable object
+ */
+TypedTable makeTypedTableEmpty(void)
+{
+    TypedTable t;
+    t.rows = 0;
+    t.cols = 0;
+    t.types = NULL;
+    t.columns = NULL;
+
+    return t;
+}
+
+/**
+ * @brief Allocate a zeroed TypedTable with one storage type per column
+ *
+ * @param t Pointer to TypedTable object to make
+ * @param rows Number of rows
+ * @param cols Number of columns
+ * @param types Storage type of every column
+ *
+ * @return 0 if successful, -1 if failure
+ */
+int makeTypedTable(TypedTable *t, int rows, int cols, const StorageType *types)
+{
+    if (!t || rows <= 0 || cols <= 0 || !types)
+    {
+        LOG_ERROR("Input variables to make a typed table were not correct.\n");
+        return -1;
+    }
+
+    *t = makeTypedTableEmpty();
+    t->types = malloc(cols * sizeof(StorageType));
+    t->columns = calloc(cols, sizeof(void *));
+    if (!t->types || !t->columns)
+    {
+        LOG_ERROR("Failed to allocate typed table columns.\n");
+        freeTypedTable(t);
+        return -1;
+    }
+    t->cols = cols;
+
+    for (int c = 0; c < cols; ++c)
+    {
+        t->types[c] = types[c];
+        t->columns[c] = calloc(rows, storageTypeSize(types[c]));
+        if (!t->columns[c])
+        {
+            LOG_ERROR("Failed to allocate typed table column %d.\n", c);
+            freeTypedTable(t);
+            return -1;
+        }
+    }
+    t->rows = rows;
+
+    return 0;
+}
+
+/**
+ * @brief Clamp and round a value into an integer range
+ *
+ * @param value Value to convert
+ * @param lo Smallest value of the range
+ * @param hi Largest value of the range
+ *
+ * @return Rounded value inside [lo, hi]
+ */
+static double clampIntegral(double value, double lo, double hi)
+{
+    if (isnan(value))
+    {
+        return 0.0;
+    }
+    value = nearbyint(value);
+    return (value < lo) ? lo : (value > hi) ? hi : value;
+}
+
+/**
+ * @brief Store one value, integer columns round and clamp values outside their range
+ *
+ * @param t TypedTable object
+ * @param row Row index
+ * @param col Column index
+ * @param value Value to store
+ *
+ * @return None
+ */
+void setTypedValue(TypedTable *t, int row, int col, double value)
+{
+    switch (t->types[col])
+    {
+    case STORE_UINT8:
+        ((uint8_t *)t->columns[col])[row] = (uint8_t)clampIntegral(value, 0, UINT8_MAX);
+        break;
+    case STORE_INT16:
+        ((int16_t *)t->columns[col])[row] = (int16_t)clampIntegral(value, INT16_MIN, INT16_MAX);
+        break;
+    case STORE_INT32:
+        ((int32_t *)t->columns[col])[row] = (int32_t)clampIntegral(value, INT32_MIN, INT32_MAX);
+        break;
+    case STORE_FLOAT32:
+        ((float *)t->columns[col])[row] = (float)value;
+        break;
+    default:
+        ((double *)t->columns[col])[row] = value;
+        break;
+    }
+}
+
+/**
+ * @brief Read one value widened to double
+ *
+ * @param t TypedTable object
+ * @param row Row index
+ * @param col Column index
+ *
+ * @return Stored value
+ */
+double getTypedValue(const TypedTable *t, int row, int col)
+{
+    switch (t->types[col])
+    {
+    case STORE_UINT8:
+        return ((const uint8_t *)t->columns[col])[row];
+    case STORE_INT16:
+        return ((const int16_t *)t->columns[col])[row];
+    case STORE_INT32:
+        return ((const int32_t *)t->columns[col])[row];
+    case STORE_FLOAT32:
+        return ((const float *)t->columns[col])[row];
+    default:
+        return ((const double *)t->columns[col])[row];
+    }
+}
+
+/**
+ * @brief Profile a block of Matrix columns and pick their storage types
+ *
+ * @param args TypedTableTask object, types points at the output array
+ * @param thread_id Thread index
+ * @param start First column
+ * @param end One past the last column
+ *
+ * @return None
+ */
+static void inferColumnsTask(void *args, int thread_id, int start, int end)
+{
+    (void)thread_id;
+    TypedTableTask *task = (TypedTableTask *)args;
+    StorageType *types = (StorageType *)task->types;
+
+    for (int c = start; c < end; ++c)
+    {
+        ColumnProfile profile = makeColumnProfile();
+        for (int r = 0; r < task->m.rows; ++r)
+        {
+            updateColumnProfile(&profile, task->m.data[r * task->m.cols + c]);
+        }
+        types[c] = narrowestStorageType(profile);
+    }
+}
+
+/**
+ * @brief Narrow a block of Matrix columns into the table
+ *
+ * @param args TypedTableTask object
+ * @param thread_id Thread index
+ * @param start First column
+ * @param end One past the last column
+ *
+ * @return None
+ */
+static void fillColumnsTask(void *args, int thread_id, int start, int end)
+{
+    (void)thread_id;
+    TypedTableTask *task = (TypedTableTask *)args;
+
+    for (int c = start; c < end; ++c)
+    {
+        for (int r = 0; r < task->m.rows; ++r)
+        {
+            setTypedValue(task->t, r, c, task->m.data[r * task->m.cols + c]);
+        }
+    }
+}
+
+/**
+ * @brief Convert a dense Matrix into a TypedTable
+ *
+ * @param m Matrix to convert
+ * @param types Storage type of every column, NULL to infer the narrowest exact type
+ * @param t Pointer to TypedTable, allocated here
+ *
+ * @return 0 if successful, -1 if failure
+ */
+int typedTableFromMatrix(Matrix m, const StorageType *types, TypedTable *t)
+{
+    if (!m.data || m.rows < 1 || m.cols < 1 || !t)
+    {
+        LOG_ERROR("Input variables to convert a Matrix to a typed table were not correct.\n");
+        return -1;
+    }
+
+    StorageType *inferred = NULL;
+    int threads = planThreads(m.cols, 1);
+    if (!types)
+    {
+        inferred = malloc(m.cols * sizeof(StorageType));
+        if (!inferred)
+        {
+            LOG_ERROR("Failed to allocate typed table schema.\n");
+            return -1;
+        }
+        TypedTableTask task = {m, NULL, inferred};
+        parallelFor(threads, m.cols, inferColumnsTask, &task);
+        types = inferred;
+    }
+
+    int status = makeTypedTable(t, m.rows, m.cols, types);
+    free(inferred);
+    if (status < 0)
+    {
+        return -1;
+    }
+
+    TypedTableTask task = {m, t, t->types};
+    parallelFor(threads, m.cols, fillColumnsTask, &task);
+
+    return 0;
+}
+
+/**
+ * @brief Gather rows of a TypedTable into a dense double Matrix, widening each column from its
+ *        storage type on the fly. Used to build mini-batches straight from compact storage.
+ *
+ * @param t TypedTable to gather from
+ * @param row_idx Rows to gather in output order, NULL for rows 0 to n - 1
+ * @param n Number of rows to gather
+ * @param out Matrix of n x t->cols, (re)allocated if its shape does not match
+ *
+ * @return 0 if successful, -1 if failure
+ */
+int gatherTypedRows(const TypedTable *t, const int *row_idx, int n, Matrix *out)
+{
+    if (!t || !t->columns || !out || n <= 0 || (!row_idx && n > t->rows))
+    {
+        LOG_ERROR("Input variables to gather typed table rows were not correct.\n");
+        return -1;
+    }
+
+    if (!out->data || out->rows != n || out->cols != t->cols)
+    {
+        freeMatrix(out);
+        if (makeMatrixZeros(out, n, t->cols) < 0)
+        {
+            LOG_ERROR("Failed to allocate gathered rows Matrix.\n");
+            return -1;
+        }
+    }
+
+    // Column at a time so the type switch runs once per column, not once per value
+    int cols = t->cols;
+    for (int c = 0; c < cols; ++c)
+    {
+        double *restrict dst = out->data + c;
+        switch (t->types[c])
+        {
+        case STORE_UINT8:
+        {
+            const uint8_t *src = t->columns[c];
+            for (int i = 0; i < n; ++i)
+            {
+                dst[(size_t)i * cols] = src[row_idx ? row_idx[i] : i];
+            }
+            break;
+        }
+        case STORE_INT16:
+        {
+            const int16_t *src = t->columns[c];
+            for (int i = 0; i < n; ++i)
+            {
+                dst[(size_t)i * cols] = src[row_idx ? row_idx[i] : i];
+            }
+            break;
+        }
+        case STORE_INT32:
+        {
+            const int32_t *src = t->columns[c];
+            for (int i = 0; i < n; ++i)
+            {
+                dst[(size_t)i * cols] = src[row_idx ? row_idx[i] : i];
+            }
+            break;
+        }
+        case STORE_FLOAT32:
+        {
+            const float *src = t->columns[c];
+            for (int i = 0; i < n; ++i)
+            {
+                dst[(size_t)i * cols] = src[row_idx ? row_idx[i] : i];
+            }
+            break;
+        }
+        default:
+        {
+            const double *src = t->columns[c];
+            for (int i = 0; i < n; ++i)
+            {
+                dst[(size_t)i * cols] = src[row_idx ? row_idx[i] : i];
+            }
+            break;
+        }
+        }
+    }
+
+    return 0;
+}
+
+/**
+ * @brief Expand a whole TypedTable into a dense double Matrix
+ *
+ * @param t TypedTable to expand
+ * @param m Pointer to Matrix, (re)allocated to t->rows x t->cols
+ *
+ * @return 0 if successful, -1 if failure
+ */
+int typedTableToMatrix(const TypedTable *t, Matrix *m)
+{
+    return gatherTypedRows(t, NULL, t ? t->rows : 0, m);
+}
+
+/**
+ * @brief Bytes used by the column storage of a TypedTable
+ *
+ * @param t TypedTable object
+ *
+ * @return Number of bytes
+ */
+size_t typedTableBytes(const TypedTable *t)
+{
+    size_t bytes = 0;
+    for (int c = 0; t && t->types && c < t->cols; ++c)
+    {
+        bytes += (size_t)t->rows * storageTypeSize(t->types[c]);
+    }
+
+    return bytes;
+}
+
+/**
+ * @brief Free a TypedTable and reset it to empty
+ *
+ * @param t TypedTable to free
+ *
+ * @return None
+ */
+void freeTypedTable(TypedTable *t)
+{
+    if (!t)
+    {
+        return;
+    }
+
+    for (int c = 0; t->columns && c < t->cols; ++c)
+    {
+        free(t->columns[c]);
+    }
+    free(t->columns);
+    free(t->types);
+    *t = makeTypedTableEmpty();
+}
@@ -40,15 +40,15 @@ int clearVector(Vector *v)
  */
 void printVector(Vector v)
 {
-    LOG_INFO("[");
-    for (int i = 0; i < v.size; ++i)
+    char *line = formatValues(v.data, v.size);
+    if (!line)
     {
-        LOG_INFO("%.6lf", ((double *)v.data)[i]);
-
-        if (i < v.size - 1)
-            LOG_INFO(", ");
+        LOG_ERROR("Printing Vector v was unsuccessful.\n");
+        return;
     }
-    LOG_INFO("]\n");
+
+    LOG_INFO("%s", line);
+    free(line);
 }
 
 /**
@@ -129,6 +129,7 @@ int makeVector(Vector *v, int size, void *data, DataType type)
         LOG_ERROR("Failed to allocate vector\n");
         return -1;
     }
+    countAllocation();
 
     // Assign values to matrix if given
     if (data != NULL)
@@ -195,6 +196,7 @@ int makeVectorZeros(Vector *v, int size)
         LOG_ERROR("Failed to allocate vector\n");
         return -1;
     }
+    countAllocation();
 
     return 0;
 }
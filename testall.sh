@@ -4,6 +4,9 @@ path="/home/ryan/ML-Library/build/"
 echo "---------- Test Activation Functions ----------"
 ${path}testActivation
 
+echo "---------- Test Cross-Validation ----------"
+${path}testCrossValidation
+
 echo "---------- Test Data Manipulation ----------"
 ${path}testDataManip
 
@@ -19,9 +22,18 @@ ${path}testMatVect
 echo "---------- Test Matrix Math Functions ----------"
 ${path}testMatOps
 
+echo "---------- Test Model Serialization ----------"
+${path}testModelIO
+
 echo "---------- Test Random Permutation Function ----------"
 ${path}testRandPerm
 
+echo "---------- Test Regression Training ----------"
+${path}testRegression
+
+echo "---------- Test Hyperparameter Sweep ----------"
+${path}testSweep
+
 echo "---------- Test Transpose Functions ----------"
 ${path}testTrans
 
@@ -0,0 +1,185 @@
+/*
+ * file: test_cross_validation.c
+ * description: script to test k-fold cross-validation over index sets
+ * author: Ryan Wagner
+ * date: October 19, 2026
+ * notes:
+ */
+
+#include "unity.h"
+#include "../header/cross_validation.h"
+
+void setUp(void)
+{
+    // Optional: initialize stuff before each test
+}
+
+void tearDown(void)
+{
+    // Optional: clean up after each test
+}
+
+// 600 rows of y = 2 x0 - x1 + 0.5 plus noise, thresholded at 0.5 for logistic regression
+static void makeFoldData(Matrix *X, Matrix *y, RegressionType type)
+{
+    int rows = 600;
+    TEST_ASSERT_EQUAL_INT(0, makeMatrixZeros(X, rows, 2));
+    TEST_ASSERT_EQUAL_INT(0, makeMatrixZeros(y, rows, 1));
+    for (int r = 0; r < rows; ++r)
+    {
+        double x0 = sin(r * 0.37);
+        double x1 = cos(r * 1.13);
+        X->data[r * 2] = x0;
+        X->data[r * 2 + 1] = x1;
+        double value = 2.0 * x0 - x1 + 0.5 + 0.05 * sin(r * 7.77);
+        y->data[r] = (type == LINEAR_REGRESSION) ? value : (value > 0.5);
+    }
+}
+
+static void makeFoldBase(Model *model, RegressionType type)
+{
+    TEST_ASSERT_EQUAL_INT(0, initModel(model));
+    model->type = type;
+    model->func = (type == LOGISTIC_REGRESSION) ? SIGMOID : ACT_NONE;
+    model->classes = 1;
+    model->batch_size = 32;
+    model->beta = 0.9;
+    model->config.epochs = 40;
+    model->config.seed = 7;
+    model->config.learning_rate.decay_type = CONSTANT;
+    model->config.learning_rate.init_learning_rate = (type == LINEAR_REGRESSION) ? 0.05 : 0.5;
+}
+
+void test_make_folds_partition(void)
+{
+    CrossValidation cv;
+    CrossValidation again;
+    TEST_ASSERT_EQUAL_INT(0, makeFolds(103, 5, 9, &cv));
+    TEST_ASSERT_EQUAL_INT(0, makeFolds(103, 5, 9, &again));
+
+    // Every row is held out by exactly one fold, and trained on by every other fold
+    int held_out[103] = {0};
+    for (int f = 0; f < 5; ++f)
+    {
+        int size = cv.bounds[f + 1] - cv.bounds[f];
+        TEST_ASSERT_TRUE(size == 20 || size == 21);
+
+        int in_fold[103] = {0};
+        for (int i = cv.bounds[f]; i < cv.bounds[f + 1]; ++i)
+        {
+            ++held_out[cv.order[i]];
+            in_fold[cv.order[i]] = 1;
+        }
+        const int *train = &cv.order[cv.bounds[f + 1]];
+        for (int i = 0; i < 103 - size; ++i)
+        {
+            TEST_ASSERT_EQUAL_INT(0, in_fold[train[i]]);
+            in_fold[train[i]] = 2;
+        }
+        for (int r = 0; r < 103; ++r)
+        {
+            TEST_ASSERT_TRUE(in_fold[r] > 0);
+        }
+    }
+    for (int r = 0; r < 103; ++r)
+    {
+        TEST_ASSERT_EQUAL_INT(1, held_out[r]);
+        TEST_ASSERT_EQUAL_INT(cv.order[r], again.order[r]);
+    }
+    freeCrossValidation(&cv);
+    freeCrossValidation(&again);
+
+    TEST_ASSERT_EQUAL_INT(-1, makeFolds(10, 1, 9, &cv));
+    TEST_ASSERT_EQUAL_INT(-1, makeFolds(3, 4, 9, &cv));
+}
+
+void test_cross_validate_linear(void)
+{
+    Matrix X = {0};
+    Matrix y = {0};
+    makeFoldData(&X, &y, LINEAR_REGRESSION);
+    Model base;
+    makeFoldBase(&base, LINEAR_REGRESSION);
+
+    // Concurrent folds match folds trained one at a time, leave the dataset untouched, and hand
+    // the caller its own thread count back
+    CrossValidation cv;
+    CrossValidation serial;
+    setThreadCount(4);
+    setLocalThreadCount(3);
+    int status = crossValidate(&base, X, y, 5, 3, 0, &cv);
+    TEST_ASSERT_EQUAL_INT(3, getLocalThreadCount());
+    setLocalThreadCount(0);
+    setThreadCount(0);
+    TEST_ASSERT_EQUAL_INT(0, status);
+    TEST_ASSERT_EQUAL_INT(0, crossValidate(&base, X, y, 5, 3, 1, &serial));
+    for (int f = 0; f < 5; ++f)
+    {
+        TEST_ASSERT_EQUAL_INT(0, cv.status[f]);
+        TEST_ASSERT_TRUE(cv.scores[f] > 0.95);
+        TEST_ASSERT_FLOAT_WITHIN(0.000001f, serial.scores[f], cv.scores[f]);
+    }
+    TEST_ASSERT_TRUE(X.data[2] == sin(0.37) && y.rows == 600);
+
+    // Means and sample standard deviations of the fold metrics
+    double mean = 0.0;
+    for (int f = 0; f < 5; ++f)
+    {
+        mean += cv.metrics[f].mse / 5;
+    }
+    double squares = 0.0;
+    for (int f = 0; f < 5; ++f)
+    {
+        squares += (cv.metrics[f].mse - mean) * (cv.metrics[f].mse - mean);
+    }
+    TEST_ASSERT_FLOAT_WITHIN(0.0000001f, mean, cv.mean.mse);
+    TEST_ASSERT_FLOAT_WITHIN(0.0000001f, sqrt(squares / 4), cv.std.mse);
+    TEST_ASSERT_TRUE(cv.mean.mse < 0.01);
+    TEST_ASSERT_TRUE(cv.mean_score == cv.mean.r2score);
+    TEST_ASSERT_TRUE(cv.std_score > 0 && cv.std_score < 0.05);
+    freeCrossValidation(&cv);
+    freeCrossValidation(&serial);
+
+    // Folds train on row subsets with mini-batch gradient descent only
+    base.config.solver = SOLVER_LBFGS;
+    TEST_ASSERT_EQUAL_INT(-1, crossValidate(&base, X, y, 5, 3, 2, &cv));
+    freeCrossValidation(&cv);
+    freeModel(&base);
+    freeMatrix(&X);
+    freeMatrix(&y);
+}
+
+void test_cross_validate_logistic(void)
+{
+    Matrix X = {0};
+    Matrix y = {0};
+    makeFoldData(&X, &y, LOGISTIC_REGRESSION);
+    Model base;
+    makeFoldBase(&base, LOGISTIC_REGRESSION);
+
+    CrossValidation cv;
+    TEST_ASSERT_EQUAL_INT(0, crossValidate(&base, X, y, 10, 5, 0, &cv));
+    int held_out = 0;
+    for (int f = 0; f < 10; ++f)
+    {
+        TEST_ASSERT_EQUAL_INT(0, cv.status[f]);
+        held_out += cv.metrics[f].TP + cv.metrics[f].FP + cv.metrics[f].TN + cv.metrics[f].FN;
+    }
+    TEST_ASSERT_EQUAL_INT(600, held_out);
+    TEST_ASSERT_TRUE(cv.mean.accuracy > 0.9);
+    TEST_ASSERT_TRUE(cv.mean_score == cv.mean.accuracy);
+    TEST_ASSERT_TRUE(cv.std.accuracy < 0.1);
+    freeCrossValidation(&cv);
+    freeModel(&base);
+    freeMatrix(&X);
+    freeMatrix(&y);
+}
+
+int main(void)
+{
+    UNITY_BEGIN();
+    RUN_TEST(test_make_folds_partition);
+    RUN_TEST(test_cross_validate_linear);
+    RUN_TEST(test_cross_validate_logistic);
+    return UNITY_END();
+}
@@ -8,8 +8,13 @@
 
 #include "unity.h"
 #include <stdio.h>
+#include <unistd.h>
 #include "../header/file_handling.h"
 
+#ifdef ML_HAVE_ZLIB
+#include <zlib.h>
+#endif
+
 void setUp(void)
 {
     // Optional: initialize stuff before each test
@@ -177,6 +182,543 @@ void test_test_train_valid_split_wrong(void)
     freeSplitData(&splitdata);
 }
 
+void test_load_csv_categorical(void)
+{
+    int status = -1;
+
+    const char *filename = "test_categorical.csv";
+    FILE *file = fopen(filename, "w");
+    TEST_ASSERT_NOT_NULL(file);
+    fprintf(file, "Sick,Age,Sex\n");
+    fprintf(file, "No,31.5,Male\n");
+    fprintf(file, "Yes,40,Female\n");
+    fprintf(file, "No,22,Female\n");
+    fclose(file);
+
+    // Label encoding builds one dictionary per categorical column
+    CategoricalEncoder encoder = makeDefaultEncoder();
+    Matrix m = {0};
+    status = loadCSVtoMatrixEncoded(filename, true, &m, &encoder);
+    TEST_ASSERT_EQUAL_INT(0, status);
+    TEST_ASSERT_EQUAL_INT(3, m.rows);
+    TEST_ASSERT_EQUAL_INT(3, m.cols);
+    TEST_ASSERT_EQUAL_INT(COL_CATEGORICAL, encoder.types[0]);
+    TEST_ASSERT_EQUAL_INT(COL_NUMERIC, encoder.types[1]);
+    TEST_ASSERT_EQUAL_INT(COL_CATEGORICAL, encoder.types[2]);
+    TEST_ASSERT_EQUAL_INT(1, lookupCategory(&encoder.dicts[0], "Yes"));
+    TEST_ASSERT_EQUAL_INT(-1, lookupCategory(&encoder.dicts[0], "Maybe"));
+
+    double label_ans[] = {0, 31.5, 0,
+                          1, 40, 1,
+                          0, 22, 1};
+    for (int i = 0; i < (int)LEN(label_ans); ++i)
+    {
+        TEST_ASSERT_FLOAT_WITHIN(0.0001f, label_ans[i], m.data[i]);
+    }
+    freeMatrix(&m);
+
+    // Reusing the fitted encoder with one-hot output
+    encoder.encoding = ENCODE_ONE_HOT;
+    encoder.frozen = true;
+    status = loadCSVtoMatrixEncoded(filename, true, &m, &encoder);
+    TEST_ASSERT_EQUAL_INT(0, status);
+    TEST_ASSERT_EQUAL_INT(5, m.cols);
+    TEST_ASSERT_EQUAL_INT(5, getEncodedColumnCount(&encoder));
+
+    double one_hot_ans[] = {1, 0, 31.5, 1, 0,
+                            0, 1, 40, 0, 1,
+                            1, 0, 22, 0, 1};
+    for (int i = 0; i < (int)LEN(one_hot_ans); ++i)
+    {
+        TEST_ASSERT_FLOAT_WITHIN(0.0001f, one_hot_ans[i], m.data[i]);
+    }
+
+    freeMatrix(&m);
+    freeEncoder(&encoder);
+    remove(filename);
+}
+
+void test_category_dict_growth(void)
+{
+    int status = -1;
+
+    CategoryDict dict;
+    status = initCategoryDict(&dict, 2);
+    TEST_ASSERT_EQUAL_INT(0, status);
+
+    char label[32];
+    for (int i = 0; i < 1000; ++i)
+    {
+        snprintf(label, sizeof(label), "category_%d", i);
+        TEST_ASSERT_EQUAL_INT(i, addCategory(&dict, label));
+    }
+
+    // Re-adding returns the existing code
+    TEST_ASSERT_EQUAL_INT(417, addCategory(&dict, "category_417"));
+    TEST_ASSERT_EQUAL_INT(1000, dict.size);
+    TEST_ASSERT_EQUAL_STRING("category_999", dict.labels[999]);
+
+    freeCategoryDict(&dict);
+}
+
+void test_scaler_standard_fit_transform(void)
+{
+    int status = -1;
+
+    double init_train[] = {1, 10,
+                           2, 20,
+                           3, 30,
+                           4, 40};
+    Matrix train = {0};
+    status = makeMatrix(&train, 4, 2, &init_train, TYPE_DOUBLE);
+    TEST_ASSERT_EQUAL_INT(0, status);
+
+    Scaler scaler = makeDefaultScaler(SCALE_STANDARD);
+    status = fitTransformScaler(&scaler, &train);
+    TEST_ASSERT_EQUAL_INT(0, status);
+    TEST_ASSERT_FLOAT_WITHIN(0.0001f, 2.5, scaler.center.data[0]);
+    TEST_ASSERT_FLOAT_WITHIN(0.0001f, 25.0, scaler.center.data[1]);
+    TEST_ASSERT_FLOAT_WITHIN(0.0001f, 1.11803399, scaler.scale.data[0]);
+    TEST_ASSERT_FLOAT_WITHIN(0.0001f, 11.1803399, scaler.scale.data[1]);
+    TEST_ASSERT_FLOAT_WITHIN(0.0001f, -1.34164079, train.data[0]);
+    TEST_ASSERT_FLOAT_WITHIN(0.0001f, 1.34164079, train.data[7]);
+
+    // New data is scaled with the training statistics
+    double init_test[] = {5, 25};
+    Matrix test = {0};
+    status = makeMatrix(&test, 1, 2, &init_test, TYPE_DOUBLE);
+    TEST_ASSERT_EQUAL_INT(0, status);
+    status = transformScaler(&scaler, &test);
+    TEST_ASSERT_EQUAL_INT(0, status);
+    TEST_ASSERT_FLOAT_WITHIN(0.0001f, 2.23606798, test.data[0]);
+    TEST_ASSERT_FLOAT_WITHIN(0.0001f, 0.0, test.data[1]);
+
+    // Column count mismatch
+    Matrix wrong = {0};
+    status = makeMatrixZeros(&wrong, 2, 3);
+    TEST_ASSERT_EQUAL_INT(0, status);
+    status = transformScaler(&scaler, &wrong);
+    TEST_ASSERT_EQUAL_INT(-1, status);
+
+    freeMatrix(&train);
+    freeMatrix(&test);
+    freeMatrix(&wrong);
+    freeScaler(&scaler);
+}
+
+void test_scaler_minmax_and_robust(void)
+{
+    int status = -1;
+
+    double init_input[] = {1, 7,
+                           5, 7,
+                           3, 7,
+                           9, 7,
+                           7, 7};
+    Matrix input = {0};
+    status = makeMatrix(&input, 5, 2, &init_input, TYPE_DOUBLE);
+    TEST_ASSERT_EQUAL_INT(0, status);
+
+    Scaler minmax = makeDefaultScaler(SCALE_MINMAX);
+    status = fitScaler(&minmax, input);
+    TEST_ASSERT_EQUAL_INT(0, status);
+    TEST_ASSERT_FLOAT_WITHIN(0.0001f, 1.0, minmax.center.data[0]);
+    TEST_ASSERT_FLOAT_WITHIN(0.0001f, 8.0, minmax.scale.data[0]);
+    // Constant column keeps a unit scale
+    TEST_ASSERT_FLOAT_WITHIN(0.0001f, 1.0, minmax.scale.data[1]);
+
+    Scaler robust = makeDefaultScaler(SCALE_ROBUST);
+    status = fitScaler(&robust, input);
+    TEST_ASSERT_EQUAL_INT(0, status);
+    TEST_ASSERT_FLOAT_WITHIN(0.0001f, 5.0, robust.center.data[0]);
+    TEST_ASSERT_FLOAT_WITHIN(0.0001f, 4.0, robust.scale.data[0]);
+    TEST_ASSERT_FLOAT_WITHIN(0.0001f, 7.0, robust.center.data[1]);
+
+    // An unknown type fails without leaving statistics behind
+    Scaler unknown = makeDefaultScaler((ScalerType)99);
+    status = fitScaler(&unknown, input);
+    TEST_ASSERT_EQUAL_INT(-1, status);
+    TEST_ASSERT_NULL(unknown.center.data);
+    TEST_ASSERT_NULL(unknown.scale.data);
+
+    status = transformScaler(&minmax, &input);
+    TEST_ASSERT_EQUAL_INT(0, status);
+    TEST_ASSERT_FLOAT_WITHIN(0.0001f, 0.0, input.data[0]);
+    TEST_ASSERT_FLOAT_WITHIN(0.0001f, 1.0, input.data[6]);
+    TEST_ASSERT_FLOAT_WITHIN(0.0001f, 0.0, input.data[7]);
+
+    freeMatrix(&input);
+    freeScaler(&minmax);
+    freeScaler(&robust);
+}
+
+void test_load_csv_compressed(void)
+{
+#ifdef ML_HAVE_ZLIB
+    int status = -1;
+
+    // Large enough to wrap the decompression ring buffer a few times
+    const char *filename = "test_compressed.csv.gz";
+    int rows = 200000;
+    gzFile gz = gzopen(filename, "wb");
+    TEST_ASSERT_NOT_NULL(gz);
+    gzprintf(gz, "a,b,c\n");
+    for (int r = 0; r < rows; ++r)
+    {
+        gzprintf(gz, "%d,%d.5,%d\n", r, r % 7, -r);
+    }
+    gzclose(gz);
+
+    Matrix m = {0};
+    status = loadCSVtoMatrix(filename, true, &m);
+    TEST_ASSERT_EQUAL_INT(1, status);
+    TEST_ASSERT_EQUAL_INT(rows, m.rows);
+    TEST_ASSERT_EQUAL_INT(3, m.cols);
+    for (int r = 0; r < rows; r += 997)
+    {
+        TEST_ASSERT_FLOAT_WITHIN(0.0001f, (double)r, m.data[r * 3]);
+        TEST_ASSERT_FLOAT_WITHIN(0.0001f, (r % 7) + 0.5, m.data[r * 3 + 1]);
+        TEST_ASSERT_FLOAT_WITHIN(0.0001f, -(double)r, m.data[r * 3 + 2]);
+    }
+    TEST_ASSERT_FLOAT_WITHIN(0.0001f, -(double)(rows - 1), m.data[rows * 3 - 1]);
+
+    freeMatrix(&m);
+    remove(filename);
+#else
+    TEST_IGNORE_MESSAGE("Built without zlib");
+#endif
+}
+
+void test_load_compressed_truncated(void)
+{
+#ifdef ML_HAVE_ZLIB
+    // A gzip file cut in half fails to decompress, which must fail the load rather than
+    // returning the rows that came before the cut
+    const char *filename = "test_truncated.csv.gz";
+    int rows = 200000;
+    gzFile gz = gzopen(filename, "wb");
+    TEST_ASSERT_NOT_NULL(gz);
+    gzprintf(gz, "a,b,c\n");
+    for (int r = 0; r < rows; ++r)
+    {
+        gzprintf(gz, "%d,%d.5,%d\n", r, r % 7, -r);
+    }
+    gzclose(gz);
+    FILE *fp = fopen(filename, "rb");
+    TEST_ASSERT_NOT_NULL(fp);
+    fseek(fp, 0, SEEK_END);
+    long size = ftell(fp);
+    fclose(fp);
+    TEST_ASSERT_EQUAL_INT(0, truncate(filename, size / 2));
+
+    Matrix m = {0};
+    TEST_ASSERT_EQUAL_INT(-1, loadCSVtoMatrix(filename, true, &m));
+    TEST_ASSERT_NULL(m.data);
+
+    CategoricalEncoder encoder = makeDefaultEncoder();
+    TEST_ASSERT_EQUAL_INT(-1, loadCSVtoMatrixEncoded(filename, true, &m, &encoder));
+    freeEncoder(&encoder);
+
+    encoder = makeDefaultEncoder();
+    TypedTable t = makeTypedTableEmpty();
+    TEST_ASSERT_EQUAL_INT(-1, loadCSVtoTypedTable(filename, true, NULL, &encoder, &t));
+    freeEncoder(&encoder);
+    remove(filename);
+
+    // LIBSVM files are read into memory through the same stream
+    const char *svm_filename = "test_truncated.svm.gz";
+    gz = gzopen(svm_filename, "wb");
+    TEST_ASSERT_NOT_NULL(gz);
+    for (int r = 0; r < rows; ++r)
+    {
+        gzprintf(gz, "%d 1:%d 3:%d.25\n", (r % 2) ? 1 : -1, r, r % 11);
+    }
+    gzclose(gz);
+    fp = fopen(svm_filename, "rb");
+    TEST_ASSERT_NOT_NULL(fp);
+    fseek(fp, 0, SEEK_END);
+    size = ftell(fp);
+    fclose(fp);
+    TEST_ASSERT_EQUAL_INT(0, truncate(svm_filename, size / 2));
+
+    Matrix labels = {0};
+    SparseMatrix features = {0};
+    TEST_ASSERT_EQUAL_INT(-1, loadLIBSVM(svm_filename, 0, &labels, &features, NULL));
+    remove(svm_filename);
+#else
+    TEST_IGNORE_MESSAGE("Built without zlib");
+#endif
+}
+
+void test_load_libsvm_small(void)
+{
+    int status = -1;
+
+    const char *filename = "test_small.svm";
+    FILE *fp = fopen(filename, "w");
+    TEST_ASSERT_NOT_NULL(fp);
+    fprintf(fp, "# sparse header comment\n");
+    fprintf(fp, "1 1:0.5 3:2\n");
+    fprintf(fp, "\n");
+    fprintf(fp, "-1 qid:4 2:-1.25 # trailing comment\n");
+    fprintf(fp, "0\n");
+    fprintf(fp, "+1 1:1e2 4:3");
+    fclose(fp);
+
+    Matrix labels = {0};
+    SparseMatrix features = makeSparseMatrixEmpty();
+    Matrix dense = {0};
+    status = loadLIBSVM(filename, 0, &labels, &features, &dense);
+    TEST_ASSERT_EQUAL_INT(0, status);
+
+    TEST_ASSERT_EQUAL_INT(4, labels.rows);
+    TEST_ASSERT_EQUAL_INT(4, features.rows);
+    TEST_ASSERT_EQUAL_INT(4, features.cols);
+    TEST_ASSERT_EQUAL_INT(5, (int)features.nnz);
+
+    double ans_labels[] = {1, -1, 0, 1};
+    long long ans_ptr[] = {0, 2, 3, 3, 5};
+    int ans_cols[] = {0, 2, 1, 0, 3};
+    double ans_values[] = {0.5, 2, -1.25, 100, 3};
+    for (int r = 0; r < 4; ++r)
+    {
+        TEST_ASSERT_FLOAT_WITHIN(0.0001f, ans_labels[r], labels.data[r]);
+    }
+    for (int r = 0; r <= 4; ++r)
+    {
+        TEST_ASSERT_EQUAL_INT((int)ans_ptr[r], (int)features.row_ptr[r]);
+    }
+    for (int k = 0; k < 5; ++k)
+    {
+        TEST_ASSERT_EQUAL_INT(ans_cols[k], features.col_idx[k]);
+        TEST_ASSERT_FLOAT_WITHIN(0.0001f, ans_values[k], features.values[k]);
+    }
+
+    double ans_dense[] = {0.5, 0, 2, 0,
+                          0, -1.25, 0, 0,
+                          0, 0, 0, 0,
+                          100, 0, 0, 3};
+    TEST_ASSERT_EQUAL_INT(4, dense.rows);
+    TEST_ASSERT_EQUAL_INT(4, dense.cols);
+    for (int i = 0; i < LEN(ans_dense); ++i)
+    {
+        TEST_ASSERT_FLOAT_WITHIN(0.0001f, ans_dense[i], dense.data[i]);
+    }
+
+    // Asking for more features pads the columns, fewer than the file uses is an error
+    status = loadLIBSVM(filename, 10, &labels, &features, NULL);
+    TEST_ASSERT_EQUAL_INT(0, status);
+    TEST_ASSERT_EQUAL_INT(10, features.cols);
+    status = loadLIBSVM(filename, 2, &labels, &features, NULL);
+    TEST_ASSERT_EQUAL_INT(-1, status);
+
+#ifdef ML_HAVE_ZLIB
+    // Compressed files are decompressed into memory and parsed the same way
+    const char *gz_filename = "test_small.svm.gz";
+    gzFile gz = gzopen(gz_filename, "wb");
+    TEST_ASSERT_NOT_NULL(gz);
+    gzprintf(gz, "1 1:0.5 3:2\n-1 2:-1.25\n");
+    gzclose(gz);
+    status = loadLIBSVM(gz_filename, 0, &labels, &features, NULL);
+    TEST_ASSERT_EQUAL_INT(0, status);
+    TEST_ASSERT_EQUAL_INT(2, features.rows);
+    TEST_ASSERT_EQUAL_INT(3, (int)features.nnz);
+    TEST_ASSERT_FLOAT_WITHIN(0.0001f, -1.25, features.values[2]);
+    remove(gz_filename);
+#endif
+
+    freeMatrix(&labels);
+    freeMatrix(&dense);
+    freeSparseMatrix(&features);
+    remove(filename);
+}
+
+void test_load_libsvm_zero_based_and_malformed(void)
+{
+    int status = -1;
+
+    const char *filename = "test_zero.svm";
+    FILE *fp = fopen(filename, "w");
+    TEST_ASSERT_NOT_NULL(fp);
+    fprintf(fp, "2 0:1 2:3\n3 1:4\n");
+    fclose(fp);
+
+    Matrix labels = {0};
+    Matrix dense = {0};
+    status = loadLIBSVM(filename, 0, &labels, NULL, &dense);
+    TEST_ASSERT_EQUAL_INT(0, status);
+    TEST_ASSERT_EQUAL_INT(2, dense.rows);
+    TEST_ASSERT_EQUAL_INT(3, dense.cols);
+    double ans_dense[] = {1, 0, 3, 0, 4, 0};
+    for (int i = 0; i < LEN(ans_dense); ++i)
+    {
+        TEST_ASSERT_FLOAT_WITHIN(0.0001f, ans_dense[i], dense.data[i]);
+    }
+
+    fp = fopen(filename, "w");
+    TEST_ASSERT_NOT_NULL(fp);
+    fprintf(fp, "1 1:2\n1 abc:2\n");
+    fclose(fp);
+    status = loadLIBSVM(filename, 0, &labels, NULL, &dense);
+    TEST_ASSERT_EQUAL_INT(-1, status);
+
+    status = loadLIBSVM("does_not_exist.svm", 0, &labels, NULL, &dense);
+    TEST_ASSERT_EQUAL_INT(-1, status);
+
+    freeMatrix(&labels);
+    freeMatrix(&dense);
+    remove(filename);
+}
+
+void test_load_libsvm_large(void)
+{
+    int status = -1;
+
+    // Several megabytes so the file is split across threads
+    const char *filename = "test_large.svm";
+    int rows = 150000;
+    FILE *fp = fopen(filename, "w");
+    TEST_ASSERT_NOT_NULL(fp);
+    for (int r = 0; r < rows; ++r)
+    {
+        fprintf(fp, "%d %d:%d %d:1.5 %d:-2\n", r % 2, (r % 7) + 1, r, (r % 13) + 20, 1000000 - (r % 3));
+    }
+    fclose(fp);
+
+    // Force several chunks even on a single core machine
+    setThreadCount(4);
+    Matrix labels = {0};
+    SparseMatrix features = makeSparseMatrixEmpty();
+    status = loadLIBSVM(filename, 0, &labels, &features, NULL);
+    setThreadCount(0);
+    TEST_ASSERT_EQUAL_INT(0, status);
+    TEST_ASSERT_EQUAL_INT(rows, features.rows);
+    TEST_ASSERT_EQUAL_INT(1000000, features.cols);
+    TEST_ASSERT_EQUAL_INT(rows * 3, (int)features.nnz);
+
+    for (int r = 0; r < rows; r += 997)
+    {
+        int64_t k = features.row_ptr[r];
+        TEST_ASSERT_EQUAL_INT(r * 3, (int)k);
+        TEST_ASSERT_FLOAT_WITHIN(0.0001f, (double)(r % 2), labels.data[r]);
+        TEST_ASSERT_EQUAL_INT(r % 7, features.col_idx[k]);
+        TEST_ASSERT_FLOAT_WITHIN(0.0001f, (double)r, features.values[k]);
+        TEST_ASSERT_EQUAL_INT((r % 13) + 19, features.col_idx[k + 1]);
+        TEST_ASSERT_EQUAL_INT(999999 - (r % 3), features.col_idx[k + 2]);
+    }
+    TEST_ASSERT_EQUAL_INT(rows * 3, (int)features.row_ptr[rows]);
+
+    freeMatrix(&labels);
+    freeSparseMatrix(&features);
+    remove(filename);
+}
+
+void test_typed_table_from_matrix(void)
+{
+    int status = -1;
+
+    // Columns: flag, small signed int, int32 range, float exact, needs double
+    double init[] = {0, -5, 70000, 0.5, 0.1,
+                     1, 300, -70000, 1.25, 0.2,
+                     1, 12, 3, -2.75, 0.3};
+    Matrix m;
+    status = makeMatrix(&m, 3, 5, init, TYPE_DOUBLE);
+    TEST_ASSERT_EQUAL_INT(0, status);
+
+    TypedTable t = makeTypedTableEmpty();
+    status = typedTableFromMatrix(m, NULL, &t);
+    TEST_ASSERT_EQUAL_INT(0, status);
+
+    StorageType ans_types[] = {STORE_UINT8, STORE_INT16, STORE_INT32, STORE_FLOAT32, STORE_FLOAT64};
+    for (int c = 0; c < 5; ++c)
+    {
+        TEST_ASSERT_EQUAL_INT(ans_types[c], t.types[c]);
+    }
+    TEST_ASSERT_EQUAL_INT(3 * (1 + 2 + 4 + 4 + 8), (int)typedTableBytes(&t));
+
+    // Widening back gives the exact original values
+    Matrix back = {0};
+    status = typedTableToMatrix(&t, &back);
+    TEST_ASSERT_EQUAL_INT(0, status);
+    TEST_ASSERT_EQUAL_MEMORY(m.data, back.data, sizeof(init));
+
+    // Gather picks rows in the given order
+    int rows[] = {2, 0};
+    Matrix gathered = {0};
+    status = gatherTypedRows(&t, rows, 2, &gathered);
+    TEST_ASSERT_EQUAL_INT(0, status);
+    TEST_ASSERT_EQUAL_INT(2, gathered.rows);
+    TEST_ASSERT_EQUAL_MEMORY(&init[10], gathered.data, 5 * sizeof(double));
+    TEST_ASSERT_EQUAL_MEMORY(&init[0], &gathered.data[5], 5 * sizeof(double));
+
+    // A given schema narrows values, integer columns round and clamp
+    freeTypedTable(&t);
+    StorageType schema[] = {STORE_UINT8, STORE_UINT8, STORE_INT16, STORE_FLOAT32, STORE_UINT8};
+    status = typedTableFromMatrix(m, schema, &t);
+    TEST_ASSERT_EQUAL_INT(0, status);
+    TEST_ASSERT_FLOAT_WITHIN(0.0001f, 0.0, getTypedValue(&t, 0, 1));
+    TEST_ASSERT_FLOAT_WITHIN(0.0001f, 255.0, getTypedValue(&t, 1, 1));
+    TEST_ASSERT_FLOAT_WITHIN(0.0001f, 32767.0, getTypedValue(&t, 0, 2));
+    TEST_ASSERT_FLOAT_WITHIN(0.0001f, 0.0, getTypedValue(&t, 2, 4));
+
+    freeTypedTable(&t);
+    TEST_ASSERT_NULL(t.columns);
+    freeMatrix(&m);
+    freeMatrix(&back);
+    freeMatrix(&gathered);
+}
+
+void test_load_csv_typed_table(void)
+{
+    int status = -1;
+
+    const char *filename = "test_typed.csv";
+    FILE *fp = fopen(filename, "w");
+    TEST_ASSERT_NOT_NULL(fp);
+    fprintf(fp, "flag,age,smoker,income\n");
+    for (int r = 0; r < 1000; ++r)
+    {
+        fprintf(fp, "%d,%d,%s,%d.1\n", r % 2, 20 + r % 60, (r % 3 == 0) ? "Yes" : "No", 1000 * r);
+    }
+    fclose(fp);
+
+    CategoricalEncoder encoder = makeDefaultEncoder();
+    TypedTable t = makeTypedTableEmpty();
+    status = loadCSVtoTypedTable(filename, true, NULL, &encoder, &t);
+    TEST_ASSERT_EQUAL_INT(0, status);
+    TEST_ASSERT_EQUAL_INT(1000, t.rows);
+    TEST_ASSERT_EQUAL_INT(4, t.cols);
+    TEST_ASSERT_EQUAL_INT(STORE_UINT8, t.types[0]);
+    TEST_ASSERT_EQUAL_INT(STORE_UINT8, t.types[1]);
+    TEST_ASSERT_EQUAL_INT(STORE_UINT8, t.types[2]);
+    TEST_ASSERT_EQUAL_INT(STORE_FLOAT64, t.types[3]);
+    TEST_ASSERT_EQUAL_INT(2, encoder.dicts[2].size);
+
+    // 1 + 1 + 1 + 8 bytes per row instead of 4 doubles
+    TEST_ASSERT_EQUAL_INT(1000 * 11, (int)typedTableBytes(&t));
+
+    for (int r = 0; r < 1000; r += 37)
+    {
+        TEST_ASSERT_FLOAT_WITHIN(0.0001f, (double)(r % 2), getTypedValue(&t, r, 0));
+        TEST_ASSERT_FLOAT_WITHIN(0.0001f, (double)(20 + r % 60), getTypedValue(&t, r, 1));
+        TEST_ASSERT_FLOAT_WITHIN(0.0001f, (r % 3 == 0) ? 0.0 : 1.0, getTypedValue(&t, r, 2));
+        TEST_ASSERT_FLOAT_WITHIN(0.0001f, 1000.0 * r + 0.1, getTypedValue(&t, r, 3));
+    }
+
+    // A given schema is used as is and the fitted encoder is reused
+    StorageType schema[] = {STORE_INT32, STORE_INT16, STORE_UINT8, STORE_FLOAT32};
+    status = loadCSVtoTypedTable(filename, true, schema, &encoder, &t);
+    TEST_ASSERT_EQUAL_INT(0, status);
+    TEST_ASSERT_EQUAL_INT(STORE_INT32, t.types[0]);
+    TEST_ASSERT_EQUAL_INT(STORE_FLOAT32, t.types[3]);
+    TEST_ASSERT_EQUAL_INT(2, encoder.dicts[2].size);
+    TEST_ASSERT_FLOAT_WITHIN(0.0001f, 1.0, getTypedValue(&t, 1, 2));
+
+    freeTypedTable(&t);
+    freeEncoder(&encoder);
+    remove(filename);
+}
+
 int main(void)
 {
     UNITY_BEGIN();
@@ -184,6 +726,17 @@ int main(void)
     RUN_TEST(test_normalization);
     RUN_TEST(test_test_train_valid_split);
     RUN_TEST(test_test_train_valid_split_wrong);
+    RUN_TEST(test_load_csv_categorical);
+    RUN_TEST(test_category_dict_growth);
+    RUN_TEST(test_scaler_standard_fit_transform);
+    RUN_TEST(test_scaler_minmax_and_robust);
+    RUN_TEST(test_load_csv_compressed);
+    RUN_TEST(test_load_compressed_truncated);
+    RUN_TEST(test_load_libsvm_small);
+    RUN_TEST(test_load_libsvm_zero_based_and_malformed);
+    RUN_TEST(test_load_libsvm_large);
+    RUN_TEST(test_typed_table_from_matrix);
+    RUN_TEST(test_load_csv_typed_table);
 
     return UNITY_END();
 }
\ No newline at end of file
@@ -0,0 +1,77 @@
+/*
+ * file: test_fixtures.c
+ * description: model fixtures shared by the training tests
+ * author: Ryan Wagner
+ * date: October 19, 2026
+ * notes:
+ */
+
+#include "unity.h"
+#include "test_fixtures.h"
+
+/**
+ * @brief Initialize a model of the given type and hand it a training set. The activation and
+ *        class count follow the type, softmax gets one class per label up to the largest.
+ *
+ * @param model Model object to initialize
+ * @param X Training features, owned by the model afterwards
+ * @param y Training labels, class indices for softmax, owned by the model afterwards
+ * @param type Type of regression
+ *
+ * @return None
+ */
+void setTrainingData(Model *model, Matrix X, Matrix y, RegressionType type)
+{
+    TEST_ASSERT_EQUAL_INT(0, initModel(model));
+    model->type = type;
+    model->func = (type == LINEAR_REGRESSION) ? ACT_NONE : (type == LOGISTIC_REGRESSION) ? SIGMOID : SOFTMAX;
+    model->classes = 1;
+    if (type == SOFTMAX_REGRESSION)
+    {
+        for (int r = 0; r < y.rows; ++r)
+        {
+            model->classes = ((int)y.data[r] + 1 > model->classes) ? (int)y.data[r] + 1 : model->classes;
+        }
+    }
+
+    freeMatrix(&model->splitdata.train_features);
+    freeMatrix(&model->splitdata.train_labels);
+    model->splitdata.train_features = X;
+    model->splitdata.train_labels = y;
+}
+
+/**
+ * @brief Make the features and labels of y = 2x + 1 on x = r / rows, spread over [0, 1)
+ *
+ * @param X Resulting rows x 1 features
+ * @param y Resulting rows x 1 labels
+ * @param rows Number of rows
+ *
+ * @return None
+ */
+void makeLinearData(Matrix *X, Matrix *y, int rows)
+{
+    TEST_ASSERT_EQUAL_INT(0, makeMatrixZeros(X, rows, 1));
+    TEST_ASSERT_EQUAL_INT(0, makeMatrixZeros(y, rows, 1));
+    for (int r = 0; r < rows; ++r)
+    {
+        X->data[r] = (double)r / rows;
+        y->data[r] = 2.0 * X->data[r] + 1.0;
+    }
+}
+
+/**
+ * @brief Start the learning rate schedule of a model at the given rate
+ *
+ * @param model Model object
+ * @param decay_type Learning rate decay type
+ * @param rate Initial learning rate
+ *
+ * @return None
+ */
+void setLearningRate(Model *model, DecayType decay_type, double rate)
+{
+    model->config.learning_rate.decay_type = decay_type;
+    model->config.learning_rate.init_learning_rate = rate;
+    model->config.learning_rate.curr_learning_rate = rate;
+}
@@ -0,0 +1,18 @@
+/*
+ * file: test_fixtures.h
+ * description: header file that gives access to the model fixtures shared by the training tests
+ * author: Ryan Wagner
+ * date: October 19, 2026
+ * notes:
+ */
+
+#ifndef TEST_FIXTURES_H
+#define TEST_FIXTURES_H
+
+#include "../header/regression.h"
+
+void setTrainingData(Model *model, Matrix X, Matrix y, RegressionType type);
+void makeLinearData(Matrix *X, Matrix *y, int rows);
+void setLearningRate(Model *model, DecayType decay_type, double rate);
+
+#endif // TEST_FIXTURES_H
@@ -9,6 +9,8 @@
 #include "unity.h"
 #include <stdio.h>
 #include "../header/math_funcs.h"
+#include "../header/sparse.h"
+#include "../header/linalg.h"
 
 void setUp(void)
 {
@@ -591,6 +593,263 @@ void test_mat_delete_row_wrong(void)
     TEST_ASSERT_EQUAL_INT(-1, status);
 }
 
+void test_sparse_multiply(void)
+{
+    int status = -1;
+
+    // A = [1 0 2; 0 0 0; 0 3 0; 4 0 5] in CSR form
+    SparseMatrix A = makeSparseMatrixEmpty();
+    status = makeSparseMatrix(&A, 4, 3, 5);
+    TEST_ASSERT_EQUAL_INT(0, status);
+    int64_t row_ptr[] = {0, 2, 2, 3, 5};
+    int col_idx[] = {0, 2, 1, 0, 2};
+    double values[] = {1, 2, 3, 4, 5};
+    memcpy(A.row_ptr, row_ptr, sizeof(row_ptr));
+    memcpy(A.col_idx, col_idx, sizeof(col_idx));
+    memcpy(A.values, values, sizeof(values));
+
+    Matrix dense = {0};
+    status = sparseToDense(A, &dense);
+    TEST_ASSERT_EQUAL_INT(0, status);
+
+    double init_B[] = {1, 2,
+                       3, 4,
+                       5, 6};
+    Matrix B;
+    status = makeMatrix(&B, 3, 2, init_B, TYPE_DOUBLE);
+    TEST_ASSERT_EQUAL_INT(0, status);
+
+    // Sparse product must match the dense product
+    Matrix expected = {0};
+    status = mat_mul(dense, B, &expected);
+    TEST_ASSERT_EQUAL_INT(0, status);
+    Matrix result = {0};
+    status = sparseMatMul(A, B, &result);
+    TEST_ASSERT_EQUAL_INT(0, status);
+    TEST_ASSERT_EQUAL_INT(4, result.rows);
+    TEST_ASSERT_EQUAL_INT(2, result.cols);
+    for (int i = 0; i < 8; ++i)
+    {
+        TEST_ASSERT_FLOAT_WITHIN(0.0001f, expected.data[i], result.data[i]);
+    }
+
+    // A^T * C against the dense transpose product
+    double init_C[] = {1, -1,
+                       2, 0,
+                       0, 3,
+                       -2, 1};
+    Matrix C;
+    status = makeMatrix(&C, 4, 2, init_C, TYPE_DOUBLE);
+    TEST_ASSERT_EQUAL_INT(0, status);
+    double ans_T[] = {-7, 3,
+                      0, 9,
+                      -8, 3};
+    status = sparseTransMatMul(A, C, &result);
+    TEST_ASSERT_EQUAL_INT(0, status);
+    TEST_ASSERT_EQUAL_INT(3, result.rows);
+    TEST_ASSERT_EQUAL_INT(2, result.cols);
+    for (int i = 0; i < LEN(ans_T); ++i)
+    {
+        TEST_ASSERT_FLOAT_WITHIN(0.0001f, ans_T[i], result.data[i]);
+    }
+
+    // Shape mismatch
+    status = sparseMatMul(A, C, &result);
+    TEST_ASSERT_EQUAL_INT(-1, status);
+
+    freeSparseMatrix(&A);
+    TEST_ASSERT_NULL(A.row_ptr);
+    freeMatrix(&dense);
+    freeMatrix(&B);
+    freeMatrix(&C);
+    freeMatrix(&expected);
+    freeMatrix(&result);
+}
+
+void test_gather_rows(void)
+{
+    int status = -1;
+
+    // 3000 rows of [r, -r] so every gathered row names its source
+    int rows = 3000;
+    Matrix m = {0};
+    status = makeMatrixZeros(&m, rows, 2);
+    TEST_ASSERT_EQUAL_INT(0, status);
+    for (int r = 0; r < rows; ++r)
+    {
+        m.data[r * 2] = r;
+        m.data[r * 2 + 1] = -r;
+    }
+    int *row_idx = malloc(rows * sizeof(int));
+    TEST_ASSERT_NOT_NULL(row_idx);
+    for (int r = 0; r < rows; ++r)
+    {
+        row_idx[r] = (r * 7 + 3) % rows;
+    }
+
+    // Force several chunks even on a single core machine
+    Matrix out = {0};
+    status = makeMatrixZeros(&out, rows, 2);
+    TEST_ASSERT_EQUAL_INT(0, status);
+    setThreadCount(4);
+    status = gatherRows(m, row_idx, rows, &out);
+    setThreadCount(0);
+    TEST_ASSERT_EQUAL_INT(0, status);
+    for (int r = 0; r < rows; ++r)
+    {
+        TEST_ASSERT_EQUAL_INT(row_idx[r], (int)out.data[r * 2]);
+        TEST_ASSERT_EQUAL_INT(-row_idx[r], (int)out.data[r * 2 + 1]);
+    }
+
+    // Fewer rows than the output holds only fills the first rows
+    out.data[4] = -1;
+    status = gatherRows(m, row_idx, 2, &out);
+    TEST_ASSERT_EQUAL_INT(0, status);
+    TEST_ASSERT_EQUAL_INT(-1, (int)out.data[4]);
+
+    // Out of range index and too many rows
+    row_idx[1] = rows;
+    status = gatherRows(m, row_idx, 2, &out);
+    TEST_ASSERT_EQUAL_INT(-1, status);
+    status = gatherRows(m, row_idx, rows + 1, &out);
+    TEST_ASSERT_EQUAL_INT(-1, status);
+
+    free(row_idx);
+    freeMatrix(&m);
+    freeMatrix(&out);
+}
+
+void test_mat_multiply_indexed(void)
+{
+    int status = -1;
+
+    double init_A[] = {1, 2,
+                       3, 4,
+                       5, 6};
+    Matrix A;
+    status = makeMatrix(&A, 3, 2, init_A, TYPE_DOUBLE);
+    TEST_ASSERT_EQUAL_INT(0, status);
+    double init_B[] = {1, 0, -1,
+                       2, 1, 0};
+    Matrix B;
+    status = makeMatrix(&B, 2, 3, init_B, TYPE_DOUBLE);
+    TEST_ASSERT_EQUAL_INT(0, status);
+
+    // Rows 2, 0, 2 of A times B
+    int row_idx[] = {2, 0, 2};
+    double ans[] = {17, 6, -5,
+                    5, 2, -1,
+                    17, 6, -5};
+    Matrix result = {0};
+    status = mat_mul_indexed(A, row_idx, 3, B, &result);
+    TEST_ASSERT_EQUAL_INT(0, status);
+    TEST_ASSERT_EQUAL_INT(3, result.rows);
+    TEST_ASSERT_EQUAL_INT(3, result.cols);
+    for (int i = 0; i < LEN(ans); ++i)
+    {
+        TEST_ASSERT_FLOAT_WITHIN(0.0001f, ans[i], result.data[i]);
+    }
+
+    // Out of range index and shape mismatch
+    row_idx[1] = 3;
+    status = mat_mul_indexed(A, row_idx, 3, B, &result);
+    TEST_ASSERT_EQUAL_INT(-1, status);
+    row_idx[1] = 0;
+    status = mat_mul_indexed(A, row_idx, 3, A, &result);
+    TEST_ASSERT_EQUAL_INT(-1, status);
+
+    freeMatrix(&A);
+    freeMatrix(&B);
+    freeMatrix(&result);
+}
+
+void test_cholesky_solve(void)
+{
+    int status = -1;
+
+    // A = L * L^T with L = [2 0 0; 1 3 0; -1 2 1]
+    double init_A[] = {4, 2, -2,
+                       2, 10, 5,
+                       -2, 5, 6};
+    Matrix A;
+    status = makeMatrix(&A, 3, 3, init_A, TYPE_DOUBLE);
+    TEST_ASSERT_EQUAL_INT(0, status);
+    status = choleskyDecompose(&A);
+    TEST_ASSERT_EQUAL_INT(0, status);
+    double ans_L[] = {2, 0, 0,
+                      1, 3, 0,
+                      -1, 2, 1};
+    for (int i = 0; i < LEN(ans_L); ++i)
+    {
+        TEST_ASSERT_FLOAT_WITHIN(0.0001f, ans_L[i], A.data[i]);
+    }
+
+    // A * [1; -1; 2] = [-2; 2; 5]
+    double init_B[] = {-2, 2, 5};
+    Matrix B;
+    status = makeMatrix(&B, 3, 1, init_B, TYPE_DOUBLE);
+    TEST_ASSERT_EQUAL_INT(0, status);
+    status = choleskySolve(A, &B);
+    TEST_ASSERT_EQUAL_INT(0, status);
+    TEST_ASSERT_FLOAT_WITHIN(0.0001f, 1.0f, B.data[0]);
+    TEST_ASSERT_FLOAT_WITHIN(0.0001f, -1.0f, B.data[1]);
+    TEST_ASSERT_FLOAT_WITHIN(0.0001f, 2.0f, B.data[2]);
+
+    // Singular matrix is rejected
+    double init_S[] = {1, 2,
+                       2, 4};
+    Matrix S;
+    status = makeMatrix(&S, 2, 2, init_S, TYPE_DOUBLE);
+    TEST_ASSERT_EQUAL_INT(0, status);
+    status = choleskyDecompose(&S);
+    TEST_ASSERT_EQUAL_INT(-1, status);
+
+    freeMatrix(&A);
+    freeMatrix(&B);
+    freeMatrix(&S);
+}
+
+void test_qr_least_squares(void)
+{
+    int status = -1;
+
+    // Fit y = 1 + 2x through 4 exact points
+    double init_A[] = {1, 0,
+                       1, 1,
+                       1, 2,
+                       1, 3};
+    double init_B[] = {1, 3, 5, 7};
+    Matrix A;
+    Matrix B;
+    status = makeMatrix(&A, 4, 2, init_A, TYPE_DOUBLE);
+    TEST_ASSERT_EQUAL_INT(0, status);
+    status = makeMatrix(&B, 4, 1, init_B, TYPE_DOUBLE);
+    TEST_ASSERT_EQUAL_INT(0, status);
+    Matrix X = {0};
+    status = qrLeastSquares(A, B, &X);
+    TEST_ASSERT_EQUAL_INT(0, status);
+    TEST_ASSERT_EQUAL_INT(2, X.rows);
+    TEST_ASSERT_FLOAT_WITHIN(0.0001f, 1.0f, X.data[0]);
+    TEST_ASSERT_FLOAT_WITHIN(0.0001f, 2.0f, X.data[1]);
+    TEST_ASSERT_FLOAT_WITHIN(0.0001f, 1.0f, A.data[0]);
+
+    // Fewer rows than unknowns
+    Matrix wide;
+    Matrix rhs;
+    status = makeMatrix(&wide, 2, 4, init_A, TYPE_DOUBLE);
+    TEST_ASSERT_EQUAL_INT(0, status);
+    status = makeMatrix(&rhs, 2, 1, init_B, TYPE_DOUBLE);
+    TEST_ASSERT_EQUAL_INT(0, status);
+    status = qrLeastSquares(wide, rhs, &X);
+    TEST_ASSERT_EQUAL_INT(-1, status);
+
+    freeMatrix(&A);
+    freeMatrix(&B);
+    freeMatrix(&X);
+    freeMatrix(&wide);
+    freeMatrix(&rhs);
+}
+
 int main(void)
 {
     UNITY_BEGIN();
@@ -618,5 +877,11 @@ int main(void)
     RUN_TEST(test_mat_delete_row);
     RUN_TEST(test_mat_delete_row_wrong);
 
+    RUN_TEST(test_sparse_multiply);
+    RUN_TEST(test_gather_rows);
+    RUN_TEST(test_mat_multiply_indexed);
+    RUN_TEST(test_cholesky_solve);
+    RUN_TEST(test_qr_least_squares);
+
     return UNITY_END();
 }
\ No newline at end of file
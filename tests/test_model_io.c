@@ -0,0 +1,376 @@
+/*
+ * file: test_model_io.c
+ * description: script to test saving, loading, and mapping of binary model files
+ * author: Ryan Wagner
+ * date: October 19, 2026
+ * notes:
+ */
+
+#include "unity.h"
+#include <stdio.h>
+#include <string.h>
+#include <unistd.h>
+#include "../header/model_io.h"
+#include "test_fixtures.h"
+
+#define TEST_MODEL_FILE "test_model_io.bin"
+#define TEST_CHECKPOINT_FILE "test_model_io.ckpt"
+
+void setUp(void)
+{
+    // Optional: initialize stuff before each test
+}
+
+void tearDown(void)
+{
+    remove(TEST_MODEL_FILE);
+    remove(TEST_CHECKPOINT_FILE);
+}
+
+// Build a small softmax model with known weights and a fitted scaler
+static void makeTestModel(Model *model, Scaler *scaler)
+{
+    TEST_ASSERT_EQUAL_INT(0, initModel(model));
+    model->type = SOFTMAX_REGRESSION;
+    model->func = SOFTMAX;
+    model->classes = 3;
+    model->batch_size = 16;
+    model->beta = 0.9;
+    model->config.epochs = 250;
+    model->config.lambda = 0.05;
+    model->config.regularization = REG_ELASTIC_NET;
+    model->config.l1_ratio = 0.25;
+    model->config.optimizer.type = OPTIMIZER_ADAMW;
+    model->config.optimizer.beta1 = 0.8;
+    model->config.optimizer.beta2 = 0.95;
+    model->config.optimizer.epsilon = 1e-7;
+    model->config.optimizer.weight_decay = 0.02;
+    model->config.learning_rate.curr_learning_rate = 0.0123;
+
+    double weights[] = {0.5, -1.25, 2.0,
+                        3.5, 0.0, -0.75,
+                        1e-8, 42.0, -3.0,
+                        0.1, 0.2, 0.3};
+    double bias[] = {0.25, -0.5, 1.0};
+    TEST_ASSERT_EQUAL_INT(0, makeMatrix(model->weights, 4, 3, weights, TYPE_DOUBLE));
+    TEST_ASSERT_EQUAL_INT(0, makeVector(model->bias, 3, bias, TYPE_DOUBLE));
+
+    double data[] = {1.0, 2.0, 3.0, 4.0,
+                     2.0, 4.0, 6.0, 8.0,
+                     3.0, 5.0, 7.0, 9.0};
+    Matrix X;
+    TEST_ASSERT_EQUAL_INT(0, makeMatrix(&X, 3, 4, data, TYPE_DOUBLE));
+    *scaler = makeDefaultScaler(SCALE_STANDARD);
+    TEST_ASSERT_EQUAL_INT(0, fitScaler(scaler, X));
+    freeMatrix(&X);
+}
+
+void test_save_load_round_trip(void)
+{
+    Model model;
+    Scaler scaler;
+    makeTestModel(&model, &scaler);
+
+    TEST_ASSERT_EQUAL_INT(0, saveModel(&model, &scaler, TEST_MODEL_FILE));
+
+    Model loaded;
+    TEST_ASSERT_EQUAL_INT(0, initModel(&loaded));
+    Scaler loaded_scaler = makeDefaultScaler(SCALE_NONE);
+    TEST_ASSERT_EQUAL_INT(0, loadModel(&loaded, &loaded_scaler, TEST_MODEL_FILE));
+
+    TEST_ASSERT_EQUAL_INT(SOFTMAX_REGRESSION, loaded.type);
+    TEST_ASSERT_EQUAL_INT(SOFTMAX, loaded.func);
+    TEST_ASSERT_EQUAL_INT(3, loaded.classes);
+    TEST_ASSERT_EQUAL_INT(16, loaded.batch_size);
+    TEST_ASSERT_EQUAL_INT(250, loaded.config.epochs);
+    TEST_ASSERT_EQUAL_INT(REG_ELASTIC_NET, loaded.config.regularization);
+    TEST_ASSERT_EQUAL_INT(OPTIMIZER_ADAMW, loaded.config.optimizer.type);
+    TEST_ASSERT_TRUE(loaded.config.l1_ratio == 0.25);
+    TEST_ASSERT_TRUE(loaded.config.optimizer.beta1 == 0.8);
+    TEST_ASSERT_TRUE(loaded.config.optimizer.beta2 == 0.95);
+    TEST_ASSERT_TRUE(loaded.config.optimizer.epsilon == 1e-7);
+    TEST_ASSERT_TRUE(loaded.config.optimizer.weight_decay == 0.02);
+    TEST_ASSERT_FLOAT_WITHIN(1e-9f, 0.9, loaded.beta);
+    TEST_ASSERT_FLOAT_WITHIN(1e-9f, 0.05, loaded.config.lambda);
+    TEST_ASSERT_FLOAT_WITHIN(1e-9f, 0.0123, loaded.config.learning_rate.curr_learning_rate);
+
+    // Weights are stored as raw doubles, so they must be bit exact
+    TEST_ASSERT_EQUAL_INT(model.weights->rows, loaded.weights->rows);
+    TEST_ASSERT_EQUAL_INT(model.weights->cols, loaded.weights->cols);
+    TEST_ASSERT_EQUAL_MEMORY(model.weights->data, loaded.weights->data, sizeof(double) * 12);
+    TEST_ASSERT_EQUAL_INT(3, loaded.bias->size);
+    TEST_ASSERT_EQUAL_MEMORY(model.bias->data, loaded.bias->data, sizeof(double) * 3);
+
+    TEST_ASSERT_EQUAL_INT(SCALE_STANDARD, loaded_scaler.type);
+    TEST_ASSERT_EQUAL_INT(3, loaded_scaler.samples);
+    TEST_ASSERT_EQUAL_INT(4, loaded_scaler.center.size);
+    TEST_ASSERT_EQUAL_MEMORY(scaler.center.data, loaded_scaler.center.data, sizeof(double) * 4);
+    TEST_ASSERT_EQUAL_MEMORY(scaler.scale.data, loaded_scaler.scale.data, sizeof(double) * 4);
+
+    freeScaler(&loaded_scaler);
+    freeModel(&loaded);
+    freeScaler(&scaler);
+    freeModel(&model);
+}
+
+void test_map_model_views(void)
+{
+    Model model;
+    Scaler scaler;
+    makeTestModel(&model, &scaler);
+    TEST_ASSERT_EQUAL_INT(0, saveModel(&model, &scaler, TEST_MODEL_FILE));
+
+    MappedModel mapped;
+    TEST_ASSERT_EQUAL_INT(0, mapModel(&mapped, TEST_MODEL_FILE));
+
+    // Sections start on aligned offsets inside the mapping
+    TEST_ASSERT_EQUAL_INT(0, ((uintptr_t)mapped.weights.data - (uintptr_t)mapped.base) % MODEL_FILE_ALIGN);
+    TEST_ASSERT_EQUAL_INT(0, ((uintptr_t)mapped.bias.data - (uintptr_t)mapped.base) % MODEL_FILE_ALIGN);
+
+    TEST_ASSERT_TRUE(mapped.model.weights == &mapped.weights);
+    TEST_ASSERT_EQUAL_INT(4, mapped.model.weights->rows);
+    TEST_ASSERT_EQUAL_INT(3, mapped.model.weights->cols);
+    TEST_ASSERT_EQUAL_MEMORY(model.weights->data, mapped.model.weights->data, sizeof(double) * 12);
+    TEST_ASSERT_EQUAL_MEMORY(model.bias->data, mapped.model.bias->data, sizeof(double) * 3);
+    TEST_ASSERT_EQUAL_MEMORY(scaler.center.data, mapped.scaler.center.data, sizeof(double) * 4);
+
+    unmapModel(&mapped);
+    TEST_ASSERT_NULL(mapped.base);
+
+    freeScaler(&scaler);
+    freeModel(&model);
+}
+
+void test_load_rejects_corruption(void)
+{
+    Model model;
+    Scaler scaler;
+    makeTestModel(&model, &scaler);
+    TEST_ASSERT_EQUAL_INT(0, saveModel(&model, &scaler, TEST_MODEL_FILE));
+
+    // Flip one byte inside the weights section
+    FILE *fp = fopen(TEST_MODEL_FILE, "r+b");
+    TEST_ASSERT_NOT_NULL(fp);
+    ModelFileHeader header;
+    TEST_ASSERT_EQUAL_INT(1, fread(&header, sizeof(header), 1, fp));
+    fseek(fp, (long)header.weights_offset + 3, SEEK_SET);
+    int byte = fgetc(fp);
+    fseek(fp, (long)header.weights_offset + 3, SEEK_SET);
+    fputc(byte ^ 0xFF, fp);
+    fclose(fp);
+
+    Model loaded;
+    TEST_ASSERT_EQUAL_INT(0, initModel(&loaded));
+    TEST_ASSERT_EQUAL_INT(-1, loadModel(&loaded, NULL, TEST_MODEL_FILE));
+
+    MappedModel mapped;
+    TEST_ASSERT_EQUAL_INT(-1, mapModel(&mapped, TEST_MODEL_FILE));
+
+    freeModel(&loaded);
+    freeScaler(&scaler);
+    freeModel(&model);
+}
+
+void test_load_rejects_bad_files(void)
+{
+    Model model;
+    Scaler scaler;
+    makeTestModel(&model, &scaler);
+    TEST_ASSERT_EQUAL_INT(0, saveModel(&model, &scaler, TEST_MODEL_FILE));
+
+    Model loaded;
+    TEST_ASSERT_EQUAL_INT(0, initModel(&loaded));
+
+    // Dimensions whose int32 product wraps to the real weight count, and a section offset near 2^64
+    FILE *fp = fopen(TEST_MODEL_FILE, "r+b");
+    TEST_ASSERT_NOT_NULL(fp);
+    ModelFileHeader header;
+    TEST_ASSERT_EQUAL_INT(1, fread(&header, sizeof(header), 1, fp));
+    ModelFileHeader overflow = header;
+    overflow.weight_rows = 4;
+    overflow.weight_cols = 3 + (1 << 30);
+    rewind(fp);
+    fwrite(&overflow, sizeof(overflow), 1, fp);
+    fflush(fp);
+    TEST_ASSERT_EQUAL_INT(-1, loadModel(&loaded, NULL, TEST_MODEL_FILE));
+    overflow = header;
+    overflow.bias_offset = UINT64_MAX - (MODEL_FILE_ALIGN - 1);
+    rewind(fp);
+    fwrite(&overflow, sizeof(overflow), 1, fp);
+    fclose(fp);
+    TEST_ASSERT_EQUAL_INT(-1, loadModel(&loaded, NULL, TEST_MODEL_FILE));
+
+    // Truncated file
+    TEST_ASSERT_EQUAL_INT(0, truncate(TEST_MODEL_FILE, sizeof(ModelFileHeader) + 8));
+    TEST_ASSERT_EQUAL_INT(-1, loadModel(&loaded, NULL, TEST_MODEL_FILE));
+
+    // Wrong magic
+    fp = fopen(TEST_MODEL_FILE, "wb");
+    TEST_ASSERT_NOT_NULL(fp);
+    memset(&header, 0, sizeof(header));
+    memcpy(header.magic, "NOTMODEL", 8);
+    fwrite(&header, sizeof(header), 1, fp);
+    fclose(fp);
+    TEST_ASSERT_EQUAL_INT(-1, loadModel(&loaded, NULL, TEST_MODEL_FILE));
+
+    // Missing file
+    TEST_ASSERT_EQUAL_INT(-1, loadModel(&loaded, NULL, "does_not_exist.bin"));
+
+    freeModel(&loaded);
+    freeScaler(&scaler);
+    freeModel(&model);
+}
+
+// Softmax model with Adam and small shuffled mini-batches on 200 rows of three classes
+static void makeCheckpointModel(Model *model)
+{
+    int rows = 200;
+    Matrix X = {0};
+    Matrix y = {0};
+    TEST_ASSERT_EQUAL_INT(0, makeMatrixZeros(&X, rows, 2));
+    TEST_ASSERT_EQUAL_INT(0, makeMatrixZeros(&y, rows, 1));
+    for (int r = 0; r < rows; ++r)
+    {
+        double x0 = sin(r * 0.71);
+        double x1 = cos(r * 1.37);
+        X.data[r * 2] = x0;
+        X.data[r * 2 + 1] = x1;
+        y.data[r] = (x0 > 0.3) ? 2 : ((x1 > 0) ? 1 : 0);
+    }
+
+    setTrainingData(model, X, y, SOFTMAX_REGRESSION);
+    model->batch_size = 8;
+    model->config.epochs = 30;
+    model->config.seed = 5;
+    model->config.optimizer.type = OPTIMIZER_ADAM;
+    model->config.learning_rate.init_learning_rate = 0.05;
+    model->config.learning_rate.curr_learning_rate = 0.05;
+    model->config.learning_rate.decay_constant = 0.01;
+    model->config.preallocate = true;
+    model->config.patience = 3;
+    model->config.min_improvement = 0.04;
+}
+
+void test_checkpoint_resume_matches(void)
+{
+    Model whole;
+    makeCheckpointModel(&whole);
+    TEST_ASSERT_EQUAL_INT(0, trainModel(&whole));
+
+    // Early stopping ends the run after epoch 29 with the weights of an earlier epoch
+    TEST_ASSERT_EQUAL_INT(29, whole.state.epoch);
+    TEST_ASSERT_TRUE(whole.state.stopped);
+    TEST_ASSERT_TRUE(whole.state.best_epoch > 20 && whole.state.best_epoch < 29);
+
+    // A run that stops after 20 of its 30 epochs, checkpointing every 10
+    Model crashed;
+    makeCheckpointModel(&crashed);
+    crashed.config.checkpoint_path = TEST_CHECKPOINT_FILE;
+    crashed.config.checkpoint_every = 10;
+    TEST_ASSERT_EQUAL_INT(0, resumeModel(&crashed, 20));
+    TEST_ASSERT_EQUAL_INT(-1, access(TEST_CHECKPOINT_FILE ".tmp", F_OK));
+
+    // A new process restores everything but the data from the checkpoint and finishes the run
+    // with the same weights as the run that was never interrupted
+    Model restored;
+    makeCheckpointModel(&restored);
+    restored.batch_size = 1;
+    restored.config = makeDefaultConfig();
+    TEST_ASSERT_EQUAL_INT(0, loadCheckpoint(&restored, TEST_CHECKPOINT_FILE));
+    TEST_ASSERT_EQUAL_INT(20, restored.state.epoch);
+    TEST_ASSERT_TRUE(restored.state.step == crashed.state.step);
+    TEST_ASSERT_TRUE(restored.state.stream == 5);
+    TEST_ASSERT_EQUAL_INT(8, restored.batch_size);
+    TEST_ASSERT_EQUAL_INT(OPTIMIZER_ADAM, restored.config.optimizer.type);
+    TEST_ASSERT_TRUE(restored.config.preallocate);
+    TEST_ASSERT_EQUAL_INT(3, restored.config.patience);
+    TEST_ASSERT_EQUAL_INT(10, restored.config.checkpoint_every);
+    TEST_ASSERT_FLOAT_WITHIN(1e-12f, 0.04, restored.config.min_improvement);
+    TEST_ASSERT_FALSE(restored.state.stopped);
+    TEST_ASSERT_EQUAL_INT(crashed.state.best_epoch, restored.state.best_epoch);
+    TEST_ASSERT_EQUAL_INT(crashed.state.stale_epochs, restored.state.stale_epochs);
+    TEST_ASSERT_TRUE(crashed.state.best_loss == restored.state.best_loss);
+    TEST_ASSERT_EQUAL_MEMORY(crashed.state.best_weights.data, restored.state.best_weights.data, sizeof(double) * 6);
+    TEST_ASSERT_EQUAL_MEMORY(crashed.state.square_weights.data, restored.state.square_weights.data, sizeof(double) * 6);
+
+    TEST_ASSERT_EQUAL_INT(0, resumeFromCheckpoint(&restored, TEST_CHECKPOINT_FILE));
+    TEST_ASSERT_EQUAL_INT(29, restored.state.epoch);
+    TEST_ASSERT_EQUAL_INT(whole.state.best_epoch, restored.state.best_epoch);
+    TEST_ASSERT_EQUAL_MEMORY(whole.weights->data, restored.weights->data, sizeof(double) * 6);
+    TEST_ASSERT_EQUAL_MEMORY(whole.bias->data, restored.bias->data, sizeof(double) * 3);
+    TEST_ASSERT_TRUE(whole.config.learning_rate.curr_learning_rate == restored.config.learning_rate.curr_learning_rate);
+
+    // The resumed run kept checkpointing to the same file. Its last checkpoint pairs the weights
+    // of epoch 29 with that epoch's optimizer state and records the stop, so resuming it again
+    // trains nothing and hands back the best weights.
+    Model finished;
+    makeCheckpointModel(&finished);
+    TEST_ASSERT_EQUAL_INT(0, loadCheckpoint(&finished, TEST_CHECKPOINT_FILE));
+    TEST_ASSERT_EQUAL_INT(29, finished.state.epoch);
+    TEST_ASSERT_TRUE(finished.state.stopped);
+    TEST_ASSERT_TRUE(finished.state.step == whole.state.step);
+    TEST_ASSERT_EQUAL_MEMORY(whole.state.velocity_weights.data, finished.state.velocity_weights.data, sizeof(double) * 6);
+    TEST_ASSERT_TRUE(memcmp(whole.weights->data, finished.weights->data, sizeof(double) * 6) != 0);
+    TEST_ASSERT_EQUAL_INT(0, resumeFromCheckpoint(&finished, TEST_CHECKPOINT_FILE));
+    TEST_ASSERT_EQUAL_INT(29, finished.state.epoch);
+    TEST_ASSERT_EQUAL_MEMORY(whole.weights->data, finished.weights->data, sizeof(double) * 6);
+    TEST_ASSERT_EQUAL_MEMORY(whole.bias->data, finished.bias->data, sizeof(double) * 3);
+
+    freeModel(&finished);
+
+    freeModel(&restored);
+    freeModel(&crashed);
+    freeModel(&whole);
+}
+
+void test_checkpoint_rejects_corruption(void)
+{
+    Model model;
+    makeCheckpointModel(&model);
+    model.config.checkpoint_path = TEST_CHECKPOINT_FILE;
+    model.config.checkpoint_every = 4;
+    TEST_ASSERT_EQUAL_INT(0, resumeModel(&model, 6));
+
+    // The last epoch is written even when it is not a multiple of checkpoint_every
+    Model loaded;
+    TEST_ASSERT_EQUAL_INT(0, initModel(&loaded));
+    TEST_ASSERT_EQUAL_INT(0, loadCheckpoint(&loaded, TEST_CHECKPOINT_FILE));
+    TEST_ASSERT_EQUAL_INT(6, loaded.state.epoch);
+
+    // Flip one byte inside the optimizer state
+    FILE *fp = fopen(TEST_CHECKPOINT_FILE, "r+b");
+    TEST_ASSERT_NOT_NULL(fp);
+    CheckpointFileHeader header;
+    TEST_ASSERT_EQUAL_INT(1, fread(&header, sizeof(header), 1, fp));
+    fseek(fp, (long)header.square_w_offset + 5, SEEK_SET);
+    int byte = fgetc(fp);
+    fseek(fp, (long)header.square_w_offset + 5, SEEK_SET);
+    fputc(byte ^ 0xFF, fp);
+    fclose(fp);
+    TEST_ASSERT_EQUAL_INT(-1, loadCheckpoint(&loaded, TEST_CHECKPOINT_FILE));
+    TEST_ASSERT_EQUAL_INT(-1, resumeFromCheckpoint(&loaded, TEST_CHECKPOINT_FILE));
+
+    // A model file is not a checkpoint
+    Model plain;
+    Scaler scaler;
+    makeTestModel(&plain, &scaler);
+    TEST_ASSERT_EQUAL_INT(0, saveModel(&plain, &scaler, TEST_MODEL_FILE));
+    TEST_ASSERT_EQUAL_INT(-1, loadCheckpoint(&loaded, TEST_MODEL_FILE));
+
+    freeScaler(&scaler);
+    freeModel(&plain);
+    freeModel(&loaded);
+    freeModel(&model);
+}
+
+int main(void)
+{
+    UNITY_BEGIN();
+    RUN_TEST(test_save_load_round_trip);
+    RUN_TEST(test_map_model_views);
+    RUN_TEST(test_load_rejects_corruption);
+    RUN_TEST(test_load_rejects_bad_files);
+    RUN_TEST(test_checkpoint_resume_matches);
+    RUN_TEST(test_checkpoint_rejects_corruption);
+    return UNITY_END();
+}
@@ -8,7 +8,9 @@
 
 #include "unity.h"
 #include <stdio.h>
+#include <string.h>
 #include "../header/math_funcs.h"
+#include "../header/random.h"
 
 void setUp(void)
 {
@@ -49,12 +51,198 @@ void test_create_perm(void)
     free(arr);
 }
 
+// Every value in [0, n) appears exactly once
+static void assertPermutation(const int *arr, int n)
+{
+    int *seen = (int *)calloc(n, sizeof(int));
+    for (int i = 0; i < n; ++i)
+    {
+        TEST_ASSERT_TRUE(arr[i] >= 0 && arr[i] < n);
+        ++seen[arr[i]];
+    }
+    for (int i = 0; i < n; ++i)
+    {
+        TEST_ASSERT_EQUAL_INT(1, seen[i]);
+    }
+    free(seen);
+}
+
+void test_seed_matches_splitmix64(void)
+{
+    // Reference SplitMix64 outputs for seed 0
+    RandomState rng;
+    seedRandom(&rng, 0);
+    TEST_ASSERT_TRUE(rng.s[0] == 0xE220A8397B1DCDAFULL);
+    TEST_ASSERT_TRUE(rng.s[1] == 0x6E789E6AA1B965F4ULL);
+    TEST_ASSERT_TRUE(rng.s[2] == 0x06C45D188009454FULL);
+    TEST_ASSERT_TRUE(rng.s[3] == 0xF88BB8A8724C81ECULL);
+}
+
+void test_seeded_permutation_repeats(void)
+{
+    int n = 1000;
+    int *first = (int *)calloc(n, sizeof(int));
+    int *second = (int *)calloc(n, sizeof(int));
+
+    setRandomSeed(42);
+    TEST_ASSERT_EQUAL_INT(0, generateRandomPermutation(first, n));
+    setRandomSeed(42);
+    TEST_ASSERT_EQUAL_INT(0, generateRandomPermutation(second, n));
+    TEST_ASSERT_EQUAL_INT_ARRAY(first, second, n);
+    assertPermutation(first, n);
+
+    // The next call continues the stream instead of repeating it
+    TEST_ASSERT_EQUAL_INT(0, generateRandomPermutation(second, n));
+    TEST_ASSERT_TRUE(memcmp(first, second, n * sizeof(int)) != 0);
+
+    free(first);
+    free(second);
+}
+
+void test_random_bounded_uniform(void)
+{
+    RandomState rng;
+    seedRandom(&rng, 7);
+    int counts[6] = {0};
+    for (int i = 0; i < 600000; ++i)
+    {
+        uint32_t value = randomBounded(&rng, 6);
+        TEST_ASSERT_TRUE(value < 6);
+        ++counts[value];
+    }
+    // 100000 expected per bin with a standard deviation near 290
+    for (int k = 0; k < 6; ++k)
+    {
+        TEST_ASSERT_INT_WITHIN(1500, 100000, counts[k]);
+    }
+
+    TEST_ASSERT_EQUAL_UINT32(0, randomBounded(&rng, 0));
+    TEST_ASSERT_EQUAL_UINT32(0, randomBounded(&rng, 1));
+    for (int i = 0; i < 1000; ++i)
+    {
+        double u = randomUniform(&rng);
+        TEST_ASSERT_TRUE(u >= 0.0 && u < 1.0);
+    }
+}
+
+void test_shuffle_uniform(void)
+{
+    // All 6 orders of 3 values come up equally often
+    RandomState rng;
+    seedRandom(&rng, 11);
+    int counts[9] = {0};
+    int arr[3];
+    for (int i = 0; i < 60000; ++i)
+    {
+        TEST_ASSERT_EQUAL_INT(0, shufflePermutation(arr, 3, &rng));
+        ++counts[arr[0] * 3 + arr[1]];
+    }
+    for (int a = 0; a < 3; ++a)
+    {
+        for (int b = 0; b < 3; ++b)
+        {
+            TEST_ASSERT_INT_WITHIN(600, (a == b) ? 0 : 10000, counts[a * 3 + b]);
+        }
+    }
+
+    // Longer than the lookahead window
+    int n = 100;
+    int big[100];
+    TEST_ASSERT_EQUAL_INT(0, shufflePermutation(big, n, &rng));
+    assertPermutation(big, n);
+    TEST_ASSERT_EQUAL_INT(0, shufflePermutation(big, 1, &rng));
+    TEST_ASSERT_EQUAL_INT(0, big[0]);
+    TEST_ASSERT_EQUAL_INT(-1, shufflePermutation(big, 0, &rng));
+}
+
+typedef struct
+{
+    int n;
+    int *perms; // One permutation of n values per thread
+} PermTask;
+
+static void permTask(void *args, int thread_id, int start, int end)
+{
+    (void)thread_id;
+    PermTask *task = (PermTask *)args;
+    for (int t = start; t < end; ++t)
+    {
+        generateRandomPermutation(&task->perms[t * task->n], task->n);
+    }
+}
+
+void test_thread_streams_independent(void)
+{
+    // Forked streams never repeat their parent
+    RandomState parent;
+    RandomState child;
+    seedRandom(&parent, 3);
+    forkRandom(&parent, &child);
+    TEST_ASSERT_TRUE(nextRandom(&parent) != nextRandom(&child));
+
+    // Every thread shuffles from its own stream at the same time
+    int threads = 4;
+    int n = 500;
+    PermTask task = {n, (int *)calloc(threads * n, sizeof(int))};
+    setThreadCount(threads);
+    TEST_ASSERT_EQUAL_INT(0, parallelFor(threads, threads, permTask, &task));
+    setThreadCount(0);
+    for (int t = 0; t < threads; ++t)
+    {
+        assertPermutation(&task.perms[t * n], n);
+        for (int u = 0; u < t; ++u)
+        {
+            TEST_ASSERT_TRUE(memcmp(&task.perms[t * n], &task.perms[u * n], n * sizeof(int)) != 0);
+        }
+    }
+    free(task.perms);
+}
+
+// First draws of three streams forked one after another on a new thread
+static void *forkStreamsTask(void *args)
+{
+    uint64_t *draws = (uint64_t *)args;
+    for (int i = 0; i < 3; ++i)
+    {
+        RandomState rng;
+        initRandomStream(&rng, 0);
+        draws[i] = nextRandom(&rng);
+    }
+    return NULL;
+}
+
+void test_thread_forks_stay_disjoint(void)
+{
+    // A thread forking from its stream never walks into the stream of the next thread
+    setRandomSeed(42);
+    uint64_t draws[2][3];
+    for (int t = 0; t < 2; ++t)
+    {
+        pthread_t thread;
+        TEST_ASSERT_EQUAL_INT(0, pthread_create(&thread, NULL, forkStreamsTask, draws[t]));
+        TEST_ASSERT_EQUAL_INT(0, pthread_join(thread, NULL));
+    }
+    for (int i = 0; i < 6; ++i)
+    {
+        for (int j = 0; j < i; ++j)
+        {
+            TEST_ASSERT_TRUE(draws[i / 3][i % 3] != draws[j / 3][j % 3]);
+        }
+    }
+}
+
 int main(void)
 {
     UNITY_BEGIN();
 
     RUN_TEST(test_create_perm_wrong);
     RUN_TEST(test_create_perm);
+    RUN_TEST(test_seed_matches_splitmix64);
+    RUN_TEST(test_seeded_permutation_repeats);
+    RUN_TEST(test_random_bounded_uniform);
+    RUN_TEST(test_shuffle_uniform);
+    RUN_TEST(test_thread_streams_independent);
+    RUN_TEST(test_thread_forks_stay_disjoint);
 
     return UNITY_END();
 }
\ No newline at end of file
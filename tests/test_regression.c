@@ -0,0 +1,1351 @@
+/*
+ * file: test_regression.c
+ * description: script to test the mini-batch pipeline and the model trainer
+ * author: Ryan Wagner
+ * date: October 19, 2026
+ * notes:
+ */
+
+#include "unity.h"
+#include <stdio.h>
+#include "../header/regression.h"
+#include "../header/prefetch.h"
+#include "../header/threading.h"
+#include "test_fixtures.h"
+
+void setUp(void)
+{
+    // Optional: initialize stuff before each test
+}
+
+void tearDown(void)
+{
+    // Optional: clean up after each test
+}
+
+// Pull every batch of every epoch and check each row shows up exactly once per epoch
+static void checkPrefetchCoverage(int depth)
+{
+    int rows = 10;
+    Matrix X = {0};
+    Matrix y = {0};
+    TEST_ASSERT_EQUAL_INT(0, makeMatrixZeros(&X, rows, 2));
+    TEST_ASSERT_EQUAL_INT(0, makeMatrixZeros(&y, rows, 1));
+    for (int r = 0; r < rows; ++r)
+    {
+        X.data[r * 2] = r;
+        X.data[r * 2 + 1] = -r;
+        y.data[r] = 10.0 * r;
+    }
+
+    BatchPrefetcher prefetcher;
+    TEST_ASSERT_EQUAL_INT(0, startPrefetcher(&prefetcher, X, y, 4, 3, depth, 0));
+    TEST_ASSERT_EQUAL_INT(3, prefetcher.batches);
+
+    int expected_rows[] = {4, 4, 2};
+    for (int epoch = 0; epoch < 3; ++epoch)
+    {
+        int seen[10] = {0};
+        for (int b = 0; b < prefetcher.batches; ++b)
+        {
+            Matrix *mini_X = NULL;
+            Matrix *mini_y = NULL;
+            TEST_ASSERT_EQUAL_INT(0, acquireBatch(&prefetcher, &mini_X, &mini_y));
+            TEST_ASSERT_EQUAL_INT(expected_rows[b], mini_X->rows);
+            TEST_ASSERT_EQUAL_INT(expected_rows[b], mini_y->rows);
+            for (int r = 0; r < mini_X->rows; ++r)
+            {
+                int row = (int)mini_X->data[r * 2];
+                TEST_ASSERT_TRUE(row >= 0 && row < rows);
+                TEST_ASSERT_EQUAL_INT(-row, (int)mini_X->data[r * 2 + 1]);
+                TEST_ASSERT_EQUAL_INT(10 * row, (int)mini_y->data[r]);
+                ++seen[row];
+            }
+            releaseBatch(&prefetcher);
+        }
+        for (int r = 0; r < rows; ++r)
+        {
+            TEST_ASSERT_EQUAL_INT(1, seen[r]);
+        }
+    }
+
+    // Every batch has been handed out
+    Matrix *mini_X = NULL;
+    Matrix *mini_y = NULL;
+    TEST_ASSERT_EQUAL_INT(-1, acquireBatch(&prefetcher, &mini_X, &mini_y));
+
+    stopPrefetcher(&prefetcher);
+    freeMatrix(&X);
+    freeMatrix(&y);
+}
+
+void test_prefetch_threaded(void)
+{
+    checkPrefetchCoverage(PREFETCH_DEPTH);
+}
+
+void test_prefetch_inline(void)
+{
+    checkPrefetchCoverage(1);
+}
+
+void test_prefetch_stop_early(void)
+{
+    Matrix X = {0};
+    Matrix y = {0};
+    TEST_ASSERT_EQUAL_INT(0, makeMatrixZeros(&X, 100, 3));
+    TEST_ASSERT_EQUAL_INT(0, makeMatrixZeros(&y, 100, 1));
+
+    // Producer is blocked on a full ring when the consumer stops, it must still exit
+    BatchPrefetcher prefetcher;
+    TEST_ASSERT_EQUAL_INT(0, startPrefetcher(&prefetcher, X, y, 8, 50, 3, 0));
+    Matrix *mini_X = NULL;
+    Matrix *mini_y = NULL;
+    TEST_ASSERT_EQUAL_INT(0, acquireBatch(&prefetcher, &mini_X, &mini_y));
+    stopPrefetcher(&prefetcher);
+
+    freeMatrix(&X);
+    freeMatrix(&y);
+}
+
+void test_train_linear_model(void)
+{
+    // y = 2x + 1 on x in [0, 1), the model owns the training split from here on
+    Matrix X = {0};
+    Matrix y = {0};
+    makeLinearData(&X, &y, 64);
+    Model model;
+    setTrainingData(&model, X, y, LINEAR_REGRESSION);
+    model.batch_size = 8;
+    model.beta = 0.5;
+    model.config.epochs = 400;
+    model.config.regularization = REG_NONE;
+    setLearningRate(&model, CONSTANT, 0.1);
+
+    TEST_ASSERT_EQUAL_INT(0, trainModel(&model));
+    TEST_ASSERT_FLOAT_WITHIN(0.05f, 2.0f, model.weights->data[0]);
+    TEST_ASSERT_FLOAT_WITHIN(0.05f, 1.0f, model.bias->data[0]);
+
+    freeModel(&model);
+}
+
+void test_prefetch_typed_table(void)
+{
+    int rows = 10;
+    Matrix X = {0};
+    Matrix y = {0};
+    TEST_ASSERT_EQUAL_INT(0, makeMatrixZeros(&X, rows, 2));
+    TEST_ASSERT_EQUAL_INT(0, makeMatrixZeros(&y, rows, 1));
+    for (int r = 0; r < rows; ++r)
+    {
+        X.data[r * 2] = r;
+        X.data[r * 2 + 1] = 0.5 * r;
+        y.data[r] = 10.0 * r;
+    }
+    TypedTable table = makeTypedTableEmpty();
+    TEST_ASSERT_EQUAL_INT(0, typedTableFromMatrix(X, NULL, &table));
+    TEST_ASSERT_EQUAL_INT(STORE_UINT8, table.types[0]);
+    TEST_ASSERT_EQUAL_INT(STORE_FLOAT32, table.types[1]);
+
+    // Batches come out as doubles matching their labels
+    BatchPrefetcher prefetcher;
+    TEST_ASSERT_EQUAL_INT(0, startTypedPrefetcher(&prefetcher, &table, y, 3, 2, PREFETCH_DEPTH, 0));
+    for (int b = 0; b < 2 * prefetcher.batches; ++b)
+    {
+        Matrix *mini_X = NULL;
+        Matrix *mini_y = NULL;
+        TEST_ASSERT_EQUAL_INT(0, acquireBatch(&prefetcher, &mini_X, &mini_y));
+        for (int r = 0; r < mini_X->rows; ++r)
+        {
+            TEST_ASSERT_FLOAT_WITHIN(0.0001f, 0.5 * mini_X->data[r * 2], mini_X->data[r * 2 + 1]);
+            TEST_ASSERT_FLOAT_WITHIN(0.0001f, 10.0 * mini_X->data[r * 2], mini_y->data[r]);
+        }
+        releaseBatch(&prefetcher);
+    }
+    stopPrefetcher(&prefetcher);
+
+    freeTypedTable(&table);
+    freeMatrix(&X);
+    freeMatrix(&y);
+}
+
+void test_train_linear_model_typed_table(void)
+{
+    // y = 2x + 1 with x stored as float32
+    Matrix X = {0};
+    Matrix y = {0};
+    makeLinearData(&X, &y, 64);
+    Model model;
+    TEST_ASSERT_EQUAL_INT(0, initModel(&model));
+    model.type = LINEAR_REGRESSION;
+    model.func = ACT_NONE;
+    model.classes = 1;
+    model.batch_size = 8;
+    model.beta = 0.5;
+    model.config.epochs = 400;
+    setLearningRate(&model, CONSTANT, 0.1);
+    TEST_ASSERT_EQUAL_INT(0, typedTableFromMatrix(X, NULL, &model.train_table));
+    TEST_ASSERT_EQUAL_INT(STORE_FLOAT32, model.train_table.types[0]);
+    freeMatrix(&model.splitdata.train_labels);
+    model.splitdata.train_labels = y;
+
+    TEST_ASSERT_EQUAL_INT(0, trainModel(&model));
+    TEST_ASSERT_EQUAL_INT(1, model.weights->rows);
+    TEST_ASSERT_FLOAT_WITHIN(0.05f, 2.0f, model.weights->data[0]);
+    TEST_ASSERT_FLOAT_WITHIN(0.05f, 1.0f, model.bias->data[0]);
+
+    freeModel(&model);
+    freeMatrix(&X);
+}
+
+// Train y = 2x + 1, or 3 classes split on x for softmax, with every buffer preallocated and
+// return how many Matrix and Vector buffers trainModel allocated. A positive patience also
+// monitors a validation split of every third row.
+static long trainPreallocated(Model *model, RegressionType type, int epochs, int patience)
+{
+    // 60 rows in batches of 8 leaves a partial batch of 4 rows at the end of every epoch
+    int rows = 60;
+    Matrix X = {0};
+    Matrix y = {0};
+    makeLinearData(&X, &y, rows);
+    for (int r = 0; r < rows && type == SOFTMAX_REGRESSION; ++r)
+    {
+        y.data[r] = (double)(r * 3 / rows);
+    }
+
+    setTrainingData(model, X, y, type);
+    model->batch_size = 8;
+    model->beta = 0.5;
+    model->config.epochs = epochs;
+    model->config.preallocate = true;
+    setLearningRate(model, CONSTANT, 0.1);
+    model->config.patience = patience;
+    model->config.min_improvement = 0.0;
+    if (patience > 0)
+    {
+        freeMatrix(&model->splitdata.valid_features);
+        freeMatrix(&model->splitdata.valid_labels);
+        TEST_ASSERT_EQUAL_INT(0, makeMatrixZeros(&model->splitdata.valid_features, rows / 3, 1));
+        TEST_ASSERT_EQUAL_INT(0, makeMatrixZeros(&model->splitdata.valid_labels, rows / 3, 1));
+        for (int r = 0; r < rows / 3; ++r)
+        {
+            model->splitdata.valid_features.data[r] = X.data[r * 3];
+            model->splitdata.valid_labels.data[r] = y.data[r * 3];
+        }
+    }
+
+    long before = getAllocationCount();
+    TEST_ASSERT_EQUAL_INT(0, trainModel(model));
+    return getAllocationCount() - before;
+}
+
+void test_train_preallocated_steady_state(void)
+{
+    // Every allocation happens before the first epoch, so more epochs allocate nothing more
+    Model model;
+    long one_epoch = trainPreallocated(&model, LINEAR_REGRESSION, 1, 0);
+    freeModel(&model);
+    long many_epochs = trainPreallocated(&model, LINEAR_REGRESSION, 400, 0);
+    TEST_ASSERT_EQUAL_INT(one_epoch, many_epochs);
+    TEST_ASSERT_FLOAT_WITHIN(0.05f, 2.0f, model.weights->data[0]);
+    TEST_ASSERT_FLOAT_WITHIN(0.05f, 1.0f, model.bias->data[0]);
+    freeModel(&model);
+
+    one_epoch = trainPreallocated(&model, SOFTMAX_REGRESSION, 1, 0);
+    freeModel(&model);
+    many_epochs = trainPreallocated(&model, SOFTMAX_REGRESSION, 50, 0);
+    TEST_ASSERT_EQUAL_INT(one_epoch, many_epochs);
+    // Low x goes to class 0 and high x to class 2
+    TEST_ASSERT_TRUE(model.weights->data[2] > model.weights->data[0]);
+    freeModel(&model);
+
+    // Monitoring the validation split every epoch allocates nothing more either, the patience
+    // outlasts the run so every epoch is monitored
+    RegressionType types[] = {LINEAR_REGRESSION, SOFTMAX_REGRESSION};
+    for (int t = 0; t < 2; ++t)
+    {
+        one_epoch = trainPreallocated(&model, types[t], 1, 1000);
+        freeModel(&model);
+        many_epochs = trainPreallocated(&model, types[t], 50, 1000);
+        TEST_ASSERT_EQUAL_INT(one_epoch, many_epochs);
+        TEST_ASSERT_EQUAL_INT(50, model.state.epoch);
+        TEST_ASSERT_TRUE(model.state.best_epoch > 1);
+        freeModel(&model);
+    }
+}
+
+void test_train_sharded_model(void)
+{
+    // y = 2x + 1 in batches of 128 rows, split into 4 shards of 32 rows
+    Matrix X = {0};
+    Matrix y = {0};
+    makeLinearData(&X, &y, 256);
+    Model model;
+    setTrainingData(&model, X, y, LINEAR_REGRESSION);
+    model.batch_size = 128;
+    model.beta = 0.5;
+    model.config.epochs = 1000;
+    setLearningRate(&model, CONSTANT, 0.2);
+
+    // The sharded step is the default, force several shards even on a single core machine
+    setThreadCount(4);
+    int status = trainModel(&model);
+    setThreadCount(0);
+    TEST_ASSERT_EQUAL_INT(0, status);
+    TEST_ASSERT_FLOAT_WITHIN(0.05f, 2.0f, model.weights->data[0]);
+    TEST_ASSERT_FLOAT_WITHIN(0.05f, 1.0f, model.bias->data[0]);
+
+    freeModel(&model);
+}
+
+void test_train_hogwild_model(void)
+{
+    // y = 2x + 1, 4 workers updating the same weights
+    Matrix X = {0};
+    Matrix y = {0};
+    makeLinearData(&X, &y, 256);
+    Model model;
+    setTrainingData(&model, X, y, LINEAR_REGRESSION);
+    model.batch_size = 1;
+    model.config.epochs = 200;
+    model.config.hogwild = true;
+    setLearningRate(&model, CONSTANT, 0.05);
+
+    // Force several workers even on a single core machine
+    setThreadCount(4);
+    int status = trainModel(&model);
+    setThreadCount(0);
+    TEST_ASSERT_EQUAL_INT(0, status);
+    TEST_ASSERT_FLOAT_WITHIN(0.05f, 2.0f, model.weights->data[0]);
+    TEST_ASSERT_FLOAT_WITHIN(0.05f, 1.0f, model.bias->data[0]);
+
+    // Settings the lock-free workers cannot honor are rejected rather than ignored
+    model.config.optimizer.type = OPTIMIZER_ADAM;
+    TEST_ASSERT_EQUAL_INT(-1, trainModel(&model));
+    model.config.optimizer.type = OPTIMIZER_MOMENTUM;
+    model.config.patience = 5;
+    TEST_ASSERT_EQUAL_INT(-1, trainModel(&model));
+    model.config.patience = 0;
+    model.config.grad_norm_tolerance = 1e-6;
+    TEST_ASSERT_EQUAL_INT(-1, trainModel(&model));
+    model.config.grad_norm_tolerance = 0;
+    model.config.checkpoint_path = "hogwild.ckpt";
+    model.config.checkpoint_every = 10;
+    TEST_ASSERT_EQUAL_INT(-1, trainModel(&model));
+    TEST_ASSERT_EQUAL_INT(-1, resumeModel(&model, 1));
+
+    freeModel(&model);
+}
+
+void test_train_hogwild_sparse_logistic(void)
+{
+    // One-hot rows, the label is set for even features, so every weight is learned on its own
+    int rows = 512;
+    int features = 16;
+    Matrix X = {0};
+    Matrix y = {0};
+    TEST_ASSERT_EQUAL_INT(0, makeMatrixZeros(&X, rows, features));
+    TEST_ASSERT_EQUAL_INT(0, makeMatrixZeros(&y, rows, 1));
+    for (int r = 0; r < rows; ++r)
+    {
+        X.data[r * features + r % features] = 1.0;
+        y.data[r] = (r % 2 == 0) ? 1.0 : 0.0;
+    }
+
+    Model model;
+    setTrainingData(&model, X, y, LOGISTIC_REGRESSION);
+    model.batch_size = 1;
+    model.config.epochs = 50;
+    model.config.hogwild = true;
+    model.config.regularization = REG_L2;
+    model.config.lambda = 0.0001;
+    setLearningRate(&model, CONSTANT, 0.1);
+
+    setThreadCount(4);
+    int status = trainModel(&model);
+    setThreadCount(0);
+    TEST_ASSERT_EQUAL_INT(0, status);
+    for (int k = 0; k < features; ++k)
+    {
+        double z = model.weights->data[k] + model.bias->data[0];
+        TEST_ASSERT_TRUE((k % 2 == 0) ? z > 2.0 : z < -2.0);
+    }
+
+    freeModel(&model);
+}
+
+// 100 rows of three features where y = 3 x0 - 2 x1 + 0.5 x2 + 4, x2 optionally a copy of x0
+static void makeThreeFeatureData(Matrix *X, Matrix *y, bool collinear)
+{
+    int rows = 100;
+    TEST_ASSERT_EQUAL_INT(0, makeMatrixZeros(X, rows, 3));
+    TEST_ASSERT_EQUAL_INT(0, makeMatrixZeros(y, rows, 1));
+    for (int r = 0; r < rows; ++r)
+    {
+        double *x = &X->data[r * 3];
+        x[0] = (double)r / rows;
+        x[1] = (double)((r * 37) % rows) / rows;
+        x[2] = collinear ? x[0] : sin((double)r);
+        y->data[r] = 3.0 * x[0] - 2.0 * x[1] + 0.5 * x[2] + 4.0;
+    }
+}
+
+void test_train_closed_form(void)
+{
+    // Ordinary least squares recovers the exact coefficients
+    Matrix X = {0};
+    Matrix y = {0};
+    makeThreeFeatureData(&X, &y, false);
+    Model model;
+    setTrainingData(&model, X, y, LINEAR_REGRESSION);
+    model.config.solver = SOLVER_CLOSED_FORM;
+    TEST_ASSERT_EQUAL_INT(0, trainModel(&model));
+    TEST_ASSERT_FLOAT_WITHIN(0.0001f, 3.0f, model.weights->data[0]);
+    TEST_ASSERT_FLOAT_WITHIN(0.0001f, -2.0f, model.weights->data[1]);
+    TEST_ASSERT_FLOAT_WITHIN(0.0001f, 0.5f, model.weights->data[2]);
+    TEST_ASSERT_FLOAT_WITHIN(0.0001f, 4.0f, model.bias->data[0]);
+    freeModel(&model);
+
+    // Ridge solution zeroes the gradient of MSE + lambda * ||w||^2
+    makeThreeFeatureData(&X, &y, false);
+    setTrainingData(&model, X, y, LINEAR_REGRESSION);
+    model.config.solver = SOLVER_CLOSED_FORM;
+    model.config.regularization = REG_L2;
+    model.config.lambda = 0.01;
+    setThreadCount(4);
+    int status = trainModel(&model);
+    setThreadCount(0);
+    TEST_ASSERT_EQUAL_INT(0, status);
+    double grad[4] = {0};
+    for (int r = 0; r < X.rows; ++r)
+    {
+        double residual = model.bias->data[0] - y.data[r];
+        for (int j = 0; j < 3; ++j)
+        {
+            residual += X.data[r * 3 + j] * model.weights->data[j];
+        }
+        for (int j = 0; j < 3; ++j)
+        {
+            grad[j] += 2.0 * residual * X.data[r * 3 + j] / X.rows;
+        }
+        grad[3] += 2.0 * residual / X.rows;
+    }
+    for (int j = 0; j < 3; ++j)
+    {
+        TEST_ASSERT_FLOAT_WITHIN(0.000001f, 0.0f, grad[j] + 2.0 * 0.01 * model.weights->data[j]);
+    }
+    TEST_ASSERT_FLOAT_WITHIN(0.000001f, 0.0f, grad[3]);
+    freeModel(&model);
+
+    // Duplicate column makes X^T * X singular, QR still fits the data exactly
+    makeThreeFeatureData(&X, &y, true);
+    setTrainingData(&model, X, y, LINEAR_REGRESSION);
+    model.config.solver = SOLVER_CLOSED_FORM;
+    TEST_ASSERT_EQUAL_INT(0, trainModel(&model));
+    TEST_ASSERT_FLOAT_WITHIN(0.0001f, 3.5f, model.weights->data[0] + model.weights->data[2]);
+    TEST_ASSERT_FLOAT_WITHIN(0.0001f, -2.0f, model.weights->data[1]);
+    TEST_ASSERT_FLOAT_WITHIN(0.0001f, 4.0f, model.bias->data[0]);
+    freeModel(&model);
+}
+
+void test_train_lbfgs_softmax(void)
+{
+    // Three overlapping clusters, L2 keeps the optimum finite
+    int rows = 300;
+    int classes = 3;
+    double centers[3][2] = {{0.0, 1.0}, {1.0, 0.0}, {-1.0, -1.0}};
+    Matrix X = {0};
+    Matrix y = {0};
+    TEST_ASSERT_EQUAL_INT(0, makeMatrixZeros(&X, rows, 2));
+    TEST_ASSERT_EQUAL_INT(0, makeMatrixZeros(&y, rows, 1));
+    for (int r = 0; r < rows; ++r)
+    {
+        int k = r % classes;
+        X.data[r * 2] = centers[k][0] + sin(r * 1.7);
+        X.data[r * 2 + 1] = centers[k][1] + cos(r * 2.3);
+        y.data[r] = k;
+    }
+
+    Model model;
+    setTrainingData(&model, X, y, SOFTMAX_REGRESSION);
+    model.config.epochs = 200;
+    model.config.solver = SOLVER_LBFGS;
+    model.config.history = 5;
+    model.config.tolerance = 1e-8;
+    model.config.regularization = REG_L2;
+    model.config.lambda = 0.01;
+
+    setThreadCount(4);
+    int status = trainModel(&model);
+    setThreadCount(0);
+    TEST_ASSERT_EQUAL_INT(0, status);
+
+    // Cross entropy + lambda * ||W||^2 has zero gradient at the solution
+    double grad_w[2][3] = {{0}};
+    double grad_b[3] = {0};
+    for (int r = 0; r < rows; ++r)
+    {
+        double z[3];
+        double z_max = -INFINITY;
+        for (int k = 0; k < classes; ++k)
+        {
+            z[k] = model.bias->data[k] + X.data[r * 2] * model.weights->data[k] +
+                   X.data[r * 2 + 1] * model.weights->data[classes + k];
+            z_max = fmax(z_max, z[k]);
+        }
+        double sum = 0.0;
+        for (int k = 0; k < classes; ++k)
+        {
+            z[k] = exp(z[k] - z_max);
+            sum += z[k];
+        }
+        for (int k = 0; k < classes; ++k)
+        {
+            double dz = z[k] / sum - ((int)y.data[r] == k ? 1.0 : 0.0);
+            grad_w[0][k] += dz * X.data[r * 2] / rows;
+            grad_w[1][k] += dz * X.data[r * 2 + 1] / rows;
+            grad_b[k] += dz / rows;
+        }
+    }
+    for (int k = 0; k < classes; ++k)
+    {
+        TEST_ASSERT_FLOAT_WITHIN(0.00001f, 0.0f, grad_w[0][k] + 2.0 * 0.01 * model.weights->data[k]);
+        TEST_ASSERT_FLOAT_WITHIN(0.00001f, 0.0f, grad_w[1][k] + 2.0 * 0.01 * model.weights->data[classes + k]);
+        TEST_ASSERT_FLOAT_WITHIN(0.00001f, 0.0f, grad_b[k]);
+    }
+
+    freeModel(&model);
+}
+
+// Three clusters of 300 rows in two features, labelled with class indices
+static void makeClusterData(Matrix *X, Matrix *y)
+{
+    int rows = 300;
+    double centers[3][2] = {{0.0, 1.0}, {1.0, 0.0}, {-1.0, -1.0}};
+    TEST_ASSERT_EQUAL_INT(0, makeMatrixZeros(X, rows, 2));
+    TEST_ASSERT_EQUAL_INT(0, makeMatrixZeros(y, rows, 1));
+    for (int r = 0; r < rows; ++r)
+    {
+        int k = (r * 7) % 3;
+        X->data[r * 2] = centers[k][0] + 0.5 * sin(r * 1.7);
+        X->data[r * 2 + 1] = centers[k][1] + 0.5 * cos(r * 2.3);
+        y->data[r] = k;
+    }
+}
+
+void test_train_softmax_class_indices(void)
+{
+    // Zero weights predict every class with probability 1/3, whatever the true class
+    Matrix X = {0};
+    Matrix y = {0};
+    makeClusterData(&X, &y);
+    Model single;
+    setTrainingData(&single, X, y, SOFTMAX_REGRESSION);
+    single.batch_size = X.rows;
+    single.beta = 0.5;
+    single.config.epochs = 20;
+    single.config.seed = 11;
+    setLearningRate(&single, CONSTANT, 0.5);
+    double loss = 0;
+    TEST_ASSERT_EQUAL_INT(0, makeMatrixZeros(single.weights, 2, 3));
+    TEST_ASSERT_EQUAL_INT(0, makeVectorZeros(single.bias, 3));
+    TEST_ASSERT_EQUAL_INT(0, evaluateLoss(&single, X, y, &loss));
+    TEST_ASSERT_FLOAT_WITHIN(0.0000001f, log(3.0), loss);
+
+    // One shard and four shards scatter the same targets, and the labels stay one column of
+    // class indices
+    Matrix sharded_X = {0};
+    Matrix sharded_y = {0};
+    makeClusterData(&sharded_X, &sharded_y);
+    Model sharded;
+    setTrainingData(&sharded, sharded_X, sharded_y, SOFTMAX_REGRESSION);
+    sharded.batch_size = single.batch_size;
+    sharded.beta = single.beta;
+    sharded.config = single.config;
+    setThreadCount(1);
+    int status = trainModel(&single);
+    setThreadCount(4);
+    status |= trainModel(&sharded);
+    setThreadCount(0);
+    TEST_ASSERT_EQUAL_INT(0, status);
+    for (int i = 0; i < 6; ++i)
+    {
+        TEST_ASSERT_FLOAT_WITHIN(0.000001f, single.weights->data[i], sharded.weights->data[i]);
+    }
+    for (int k = 0; k < 3; ++k)
+    {
+        TEST_ASSERT_FLOAT_WITHIN(0.000001f, single.bias->data[k], sharded.bias->data[k]);
+    }
+    TEST_ASSERT_TRUE(single.splitdata.train_labels.data == y.data && single.splitdata.train_labels.cols == 1);
+    TEST_ASSERT_EQUAL_INT(0, evaluateLoss(&single, X, y, &loss));
+    TEST_ASSERT_TRUE(loss < 0.5);
+
+    // Hogwild updates read the class index of each row too
+    Matrix hogwild_X = {0};
+    Matrix hogwild_y = {0};
+    makeClusterData(&hogwild_X, &hogwild_y);
+    Model hogwild;
+    setTrainingData(&hogwild, hogwild_X, hogwild_y, SOFTMAX_REGRESSION);
+    hogwild.batch_size = single.batch_size;
+    hogwild.config.epochs = 20;
+    hogwild.config.hogwild = true;
+    setLearningRate(&hogwild, CONSTANT, 0.05);
+    TEST_ASSERT_EQUAL_INT(0, trainModel(&hogwild));
+    TEST_ASSERT_EQUAL_INT(0, evaluateLoss(&hogwild, X, y, &loss));
+    TEST_ASSERT_TRUE(loss < 0.5);
+
+    // Labels must be whole class indices below the number of classes
+    y.data[17] = 3;
+    TEST_ASSERT_EQUAL_INT(-1, trainModel(&single));
+    TEST_ASSERT_EQUAL_INT(-1, partialFit(&sharded, X, y, 1, NULL));
+    y.data[17] = 1.5;
+    TEST_ASSERT_EQUAL_INT(-1, evaluateLoss(&sharded, X, y, &loss));
+    y.data[17] = -1;
+    TEST_ASSERT_EQUAL_INT(-1, trainModel(&single));
+
+    freeModel(&hogwild);
+    freeModel(&sharded);
+    freeModel(&single);
+}
+
+void test_train_lbfgs_linear(void)
+{
+    Matrix X = {0};
+    Matrix y = {0};
+    makeThreeFeatureData(&X, &y, false);
+    Model model;
+    setTrainingData(&model, X, y, LINEAR_REGRESSION);
+    model.config.solver = SOLVER_LBFGS;
+    model.config.regularization = REG_L1;
+    TEST_ASSERT_EQUAL_INT(-1, trainModel(&model));
+    freeModel(&model);
+
+    // Least squares is smooth as well, L-BFGS reaches the exact fit
+    makeThreeFeatureData(&X, &y, false);
+    setTrainingData(&model, X, y, LINEAR_REGRESSION);
+    model.config.solver = SOLVER_LBFGS;
+    model.config.epochs = 500;
+    model.config.tolerance = 1e-10;
+    TEST_ASSERT_EQUAL_INT(0, trainModel(&model));
+    TEST_ASSERT_FLOAT_WITHIN(0.0001f, 3.0f, model.weights->data[0]);
+    TEST_ASSERT_FLOAT_WITHIN(0.0001f, -2.0f, model.weights->data[1]);
+    TEST_ASSERT_FLOAT_WITHIN(0.0001f, 0.5f, model.weights->data[2]);
+    TEST_ASSERT_FLOAT_WITHIN(0.0001f, 4.0f, model.bias->data[0]);
+    freeModel(&model);
+}
+
+// 512 rows of binary labels over 16 sparse features, two stored values per row in different
+// columns, y = 1 when the row's weighted sum with w_k = k % 3 - 1 beats a deterministic noise
+static void makeSparseBinaryData(SparseMatrix *X, Matrix *y)
+{
+    int rows = 512;
+    int cols = 16;
+    TEST_ASSERT_EQUAL_INT(0, makeSparseMatrix(X, rows, cols, 2 * rows));
+    TEST_ASSERT_EQUAL_INT(0, makeMatrixZeros(y, rows, 1));
+    for (int r = 0; r < rows; ++r)
+    {
+        int k = 2 * r;
+        X->row_ptr[r + 1] = k + 2;
+        X->col_idx[k] = r % cols;
+        X->col_idx[k + 1] = (7 * r + 3) % cols;
+        X->values[k] = sin(r * 0.37) + 1.0;
+        X->values[k + 1] = cos(r * 1.13);
+
+        double z = 0.0;
+        for (int j = k; j < k + 2; ++j)
+        {
+            z += (X->col_idx[j] % 3 - 1) * X->values[j];
+        }
+        y->data[r] = (z > sin(r * 7.77) * 0.5) ? 1.0 : 0.0;
+    }
+}
+
+void test_train_lbfgs_sparse(void)
+{
+    // CSR features reach the same optimum as their dense copy
+    SparseMatrix X_sparse = makeSparseMatrixEmpty();
+    Matrix y_sparse = {0};
+    makeSparseBinaryData(&X_sparse, &y_sparse);
+    Matrix X = {0};
+    Matrix y = {0};
+    TEST_ASSERT_EQUAL_INT(0, sparseToDense(X_sparse, &X));
+    TEST_ASSERT_EQUAL_INT(0, makeMatrixZeros(&y, y_sparse.rows, 1));
+    memcpy(y.data, y_sparse.data, y.rows * sizeof(double));
+
+    Model dense;
+    setTrainingData(&dense, X, y, LOGISTIC_REGRESSION);
+    dense.config.solver = SOLVER_LBFGS;
+    dense.config.regularization = REG_L2;
+    dense.config.lambda = 0.01;
+    dense.config.tolerance = 1e-9;
+    dense.config.epochs = 200;
+    TEST_ASSERT_EQUAL_INT(0, trainModel(&dense));
+
+    Model sparse;
+    setTrainingData(&sparse, (Matrix){0}, y_sparse, LOGISTIC_REGRESSION);
+    sparse.train_sparse = X_sparse;
+    sparse.config = dense.config;
+    TEST_ASSERT_EQUAL_INT(0, trainModel(&sparse));
+    TEST_ASSERT_EQUAL_INT(16, sparse.weights->rows);
+    for (int j = 0; j < 16; ++j)
+    {
+        TEST_ASSERT_FLOAT_WITHIN(0.0001f, dense.weights->data[j], sparse.weights->data[j]);
+    }
+    TEST_ASSERT_FLOAT_WITHIN(0.0001f, dense.bias->data[0], sparse.bias->data[0]);
+    freeModel(&dense);
+    freeModel(&sparse);
+
+    // Only the L-BFGS objective reads sparse features
+    makeSparseBinaryData(&X_sparse, &y_sparse);
+    setTrainingData(&sparse, (Matrix){0}, y_sparse, LOGISTIC_REGRESSION);
+    sparse.train_sparse = X_sparse;
+    TEST_ASSERT_EQUAL_INT(-1, trainModel(&sparse));
+    freeModel(&sparse);
+}
+
+// 10000 rows of noisy binary labels over three features, y = 1 when 1.5 x0 - x1 + 0.5 > noise
+static void makeNoisyBinaryData(Matrix *X, Matrix *y)
+{
+    int rows = 10000;
+    TEST_ASSERT_EQUAL_INT(0, makeMatrixZeros(X, rows, 3));
+    TEST_ASSERT_EQUAL_INT(0, makeMatrixZeros(y, rows, 1));
+    for (int r = 0; r < rows; ++r)
+    {
+        double *x = &X->data[r * 3];
+        x[0] = sin(r * 0.37);
+        x[1] = cos(r * 1.13);
+        x[2] = sin(r * 2.71) * cos(r * 0.05);
+        y->data[r] = (1.5 * x[0] - x[1] + 0.5 > sin(r * 7.77) * 1.5) ? 1.0 : 0.0;
+    }
+}
+
+void test_train_newton_logistic(void)
+{
+    // Quadratic convergence reaches the tolerance well inside ten iterations
+    Matrix X = {0};
+    Matrix y = {0};
+    makeNoisyBinaryData(&X, &y);
+    Model newton;
+    setTrainingData(&newton, X, y, LOGISTIC_REGRESSION);
+    newton.config.solver = SOLVER_NEWTON;
+    newton.config.regularization = REG_L2;
+    newton.config.lambda = 0.001;
+    newton.config.tolerance = 1e-9;
+    newton.config.epochs = 10;
+    setThreadCount(4);
+    int status = trainModel(&newton);
+    setThreadCount(0);
+    TEST_ASSERT_EQUAL_INT(0, status);
+
+    double grad[4] = {0};
+    for (int r = 0; r < X.rows; ++r)
+    {
+        double z = newton.bias->data[0];
+        for (int j = 0; j < 3; ++j)
+        {
+            z += X.data[r * 3 + j] * newton.weights->data[j];
+        }
+        double residual = 1.0 / (1.0 + exp(-z)) - y.data[r];
+        for (int j = 0; j < 3; ++j)
+        {
+            grad[j] += residual * X.data[r * 3 + j] / X.rows;
+        }
+        grad[3] += residual / X.rows;
+    }
+    for (int j = 0; j < 3; ++j)
+    {
+        TEST_ASSERT_FLOAT_WITHIN(0.000001f, 0.0f, grad[j] + 2.0 * 0.001 * newton.weights->data[j]);
+    }
+    TEST_ASSERT_FLOAT_WITHIN(0.000001f, 0.0f, grad[3]);
+
+    // The regularized loss is strictly convex, so L-BFGS lands on the same optimum
+    Matrix lbfgs_X = {0};
+    Matrix lbfgs_y = {0};
+    makeNoisyBinaryData(&lbfgs_X, &lbfgs_y);
+    Model lbfgs;
+    setTrainingData(&lbfgs, lbfgs_X, lbfgs_y, LOGISTIC_REGRESSION);
+    lbfgs.config = newton.config;
+    lbfgs.config.solver = SOLVER_LBFGS;
+    lbfgs.config.epochs = 200;
+    TEST_ASSERT_EQUAL_INT(0, trainModel(&lbfgs));
+    for (int j = 0; j < 3; ++j)
+    {
+        TEST_ASSERT_FLOAT_WITHIN(0.0001f, newton.weights->data[j], lbfgs.weights->data[j]);
+    }
+    TEST_ASSERT_FLOAT_WITHIN(0.0001f, newton.bias->data[0], lbfgs.bias->data[0]);
+    freeModel(&newton);
+    freeModel(&lbfgs);
+
+    // Only binary logistic regression has this Hessian
+    makeThreeFeatureData(&X, &y, false);
+    Model linear;
+    setTrainingData(&linear, X, y, LINEAR_REGRESSION);
+    linear.config.solver = SOLVER_NEWTON;
+    TEST_ASSERT_EQUAL_INT(-1, trainModel(&linear));
+    freeModel(&linear);
+}
+
+// Hand a linear model 64 rows of centered, badly scaled features, x0 in [-0.5, 0.5) and
+// x1 in [-500, 500), y = 2 x0 + 0.003 x1 + 1
+static void setScaledData(Model *model)
+{
+    int rows = 64;
+    Matrix X = {0};
+    Matrix y = {0};
+    TEST_ASSERT_EQUAL_INT(0, makeMatrixZeros(&X, rows, 2));
+    TEST_ASSERT_EQUAL_INT(0, makeMatrixZeros(&y, rows, 1));
+    for (int r = 0; r < rows; ++r)
+    {
+        X.data[r * 2] = (double)r / rows - 0.5;
+        X.data[r * 2 + 1] = ((double)((r * 29) % rows) / rows - 0.5) * 1000.0;
+        y.data[r] = 2.0 * X.data[r * 2] + 0.003 * X.data[r * 2 + 1] + 1.0;
+    }
+
+    setTrainingData(model, X, y, LINEAR_REGRESSION);
+}
+
+void test_train_optimizers(void)
+{
+    // Adam's first step is lr * sign(gradient) for every weight, whatever the feature scale
+    Model model;
+    setScaledData(&model);
+    model.batch_size = 64;
+    model.config.epochs = 1;
+    model.config.optimizer.type = OPTIMIZER_ADAM;
+    setLearningRate(&model, CONSTANT, 0.1);
+    TEST_ASSERT_EQUAL_INT(0, trainModel(&model));
+    TEST_ASSERT_FLOAT_WITHIN(0.000001f, 0.1f, model.weights->data[0]);
+    TEST_ASSERT_FLOAT_WITHIN(0.000001f, 0.1f, model.weights->data[1]);
+    TEST_ASSERT_FLOAT_WITHIN(0.000001f, 0.1f, model.bias->data[0]);
+    freeModel(&model);
+
+    // Every rule converges despite the 1000x scale gap, on one shard and on four
+    OptimizerType types[] = {OPTIMIZER_ADAM, OPTIMIZER_ADAMW, OPTIMIZER_RMSPROP, OPTIMIZER_ADAGRAD};
+    double rates[] = {0.05, 0.05, 0.01, 0.3};
+    for (int t = 0; t < 4; ++t)
+    {
+        for (int threads = 1; threads <= 4; threads += 3)
+        {
+            setScaledData(&model);
+            model.batch_size = 64;
+            model.config.epochs = 1000;
+            model.config.optimizer.type = types[t];
+            model.config.optimizer.weight_decay = 0.0;
+            setLearningRate(&model, LINEAR_DECAY, rates[t]);
+            setThreadCount(threads);
+            int status = trainModel(&model);
+            setThreadCount(0);
+            TEST_ASSERT_EQUAL_INT(0, status);
+            TEST_ASSERT_FLOAT_WITHIN(0.001f, 2.0f, model.weights->data[0]);
+            TEST_ASSERT_FLOAT_WITHIN(0.00001f, 0.003f, model.weights->data[1]);
+            TEST_ASSERT_FLOAT_WITHIN(0.001f, 1.0f, model.bias->data[0]);
+            freeModel(&model);
+        }
+    }
+
+    // AdamW decays the weights toward zero but leaves the bias alone
+    setScaledData(&model);
+    model.batch_size = 64;
+    model.config.epochs = 1000;
+    model.config.optimizer.type = OPTIMIZER_ADAMW;
+    model.config.optimizer.weight_decay = 0.5;
+    setLearningRate(&model, LINEAR_DECAY, 0.05);
+    TEST_ASSERT_EQUAL_INT(0, trainModel(&model));
+    TEST_ASSERT_TRUE(model.weights->data[0] < 1.9);
+    TEST_ASSERT_FLOAT_WITHIN(0.01f, 1.0f, model.bias->data[0]);
+    freeModel(&model);
+}
+
+// After epoch e the linear decay has been applied for e - 1 epochs
+static int epochsRun(const Model *model)
+{
+    LearningRate lr = model->config.learning_rate;
+    return (int)round((1.0 - lr.curr_learning_rate / lr.init_learning_rate) * model->config.epochs) + 1;
+}
+
+void test_train_early_stopping(void)
+{
+    // Full-batch y = 2x + 1 with a linearly decaying rate, so the rate left after training tells
+    // how many of the epochs ran. Gradient norm threshold ends a converged fit long before the cap.
+    Matrix X = {0};
+    Matrix y = {0};
+    makeLinearData(&X, &y, 64);
+    Model model;
+    setTrainingData(&model, X, y, LINEAR_REGRESSION);
+    model.batch_size = 64;
+    model.beta = 0.5;
+    model.config.epochs = 100000;
+    model.config.grad_norm_tolerance = 0.0001;
+    setLearningRate(&model, LINEAR_DECAY, 0.1);
+    TEST_ASSERT_EQUAL_INT(0, trainModel(&model));
+    TEST_ASSERT_TRUE(epochsRun(&model) < 5000);
+    TEST_ASSERT_FLOAT_WITHIN(0.001f, 2.0f, model.weights->data[0]);
+    TEST_ASSERT_FLOAT_WITHIN(0.001f, 1.0f, model.bias->data[0]);
+    freeModel(&model);
+
+    // Patience on the training loss once there is no validation split to watch
+    makeLinearData(&X, &y, 64);
+    setTrainingData(&model, X, y, LINEAR_REGRESSION);
+    model.batch_size = 64;
+    model.beta = 0.5;
+    model.config.epochs = 100000;
+    model.config.patience = 10;
+    model.config.min_improvement = 0.01;
+    setLearningRate(&model, LINEAR_DECAY, 0.1);
+    TEST_ASSERT_EQUAL_INT(0, trainModel(&model));
+    TEST_ASSERT_TRUE(epochsRun(&model) < 5000);
+    TEST_ASSERT_FLOAT_WITHIN(0.01f, 2.0f, model.weights->data[0]);
+    freeModel(&model);
+
+    // Validation labels are all zero, so the validation loss only grows as the model fits the
+    // training data. The first epoch is the best, and its weights come back after patience runs out.
+    Model first_epoch;
+    makeLinearData(&X, &y, 64);
+    setTrainingData(&first_epoch, X, y, LINEAR_REGRESSION);
+    first_epoch.batch_size = 64;
+    first_epoch.beta = 0.5;
+    first_epoch.config.epochs = 1;
+    setLearningRate(&first_epoch, LINEAR_DECAY, 0.1);
+
+    makeLinearData(&X, &y, 64);
+    setTrainingData(&model, X, y, LINEAR_REGRESSION);
+    model.batch_size = first_epoch.batch_size;
+    model.beta = first_epoch.beta;
+    model.config = first_epoch.config;
+    model.config.epochs = 2000;
+    model.config.patience = 20;
+    TEST_ASSERT_EQUAL_INT(0, trainModel(&first_epoch));
+    Matrix valid_X = {0};
+    Matrix valid_y = {0};
+    TEST_ASSERT_EQUAL_INT(0, makeMatrixZeros(&valid_X, 32, 1));
+    TEST_ASSERT_EQUAL_INT(0, makeMatrixZeros(&valid_y, 32, 1));
+    for (int r = 0; r < 32; ++r)
+    {
+        valid_X.data[r] = (r + 0.5) / 32;
+    }
+    freeMatrix(&model.splitdata.valid_features);
+    freeMatrix(&model.splitdata.valid_labels);
+    model.splitdata.valid_features = valid_X;
+    model.splitdata.valid_labels = valid_y;
+    TEST_ASSERT_EQUAL_INT(0, trainModel(&model));
+    TEST_ASSERT_EQUAL_INT(21, epochsRun(&model));
+    TEST_ASSERT_FLOAT_WITHIN(0.000001f, first_epoch.weights->data[0], model.weights->data[0]);
+    TEST_ASSERT_FLOAT_WITHIN(0.000001f, first_epoch.bias->data[0], model.bias->data[0]);
+    freeModel(&first_epoch);
+    freeModel(&model);
+}
+
+void test_train_seed_reproducible(void)
+{
+    // Mini-batch shuffles come from config.seed, so equal seeds train identical models
+    Model first;
+    Model second;
+    Model third;
+    setScaledData(&first);
+    first.batch_size = 8;
+    first.config.epochs = 50;
+    first.config.optimizer.type = OPTIMIZER_ADAM;
+    first.config.seed = 5;
+    setLearningRate(&first, LINEAR_DECAY, 0.05);
+    setScaledData(&second);
+    second.batch_size = first.batch_size;
+    second.config = first.config;
+    setScaledData(&third);
+    third.batch_size = first.batch_size;
+    third.config = first.config;
+    third.config.seed = 6;
+    TEST_ASSERT_EQUAL_INT(0, trainModel(&first));
+    TEST_ASSERT_EQUAL_INT(0, trainModel(&second));
+    TEST_ASSERT_TRUE(first.weights->data[0] == second.weights->data[0]);
+    TEST_ASSERT_TRUE(first.weights->data[1] == second.weights->data[1]);
+    TEST_ASSERT_TRUE(first.bias->data[0] == second.bias->data[0]);
+
+    TEST_ASSERT_EQUAL_INT(0, trainModel(&third));
+    TEST_ASSERT_TRUE(first.weights->data[0] != third.weights->data[0]);
+    freeModel(&first);
+    freeModel(&second);
+    freeModel(&third);
+}
+
+void test_train_resume_continues(void)
+{
+    // 80 epochs and then 120 more follow the same Adam moments, step count, decay schedule and
+    // shuffles as 200 epochs at once
+    Model whole;
+    Model resumed;
+    Model restarted;
+    setScaledData(&whole);
+    whole.batch_size = 64;
+    whole.config.epochs = 200;
+    whole.config.optimizer.type = OPTIMIZER_ADAM;
+    whole.config.seed = 3;
+    setLearningRate(&whole, LINEAR_DECAY, 0.05);
+    setScaledData(&resumed);
+    resumed.batch_size = whole.batch_size;
+    resumed.config = whole.config;
+    setScaledData(&restarted);
+    restarted.batch_size = whole.batch_size;
+    restarted.config = whole.config;
+    TEST_ASSERT_EQUAL_INT(0, trainModel(&whole));
+    TEST_ASSERT_EQUAL_INT(0, resumeModel(&resumed, 80));
+    TEST_ASSERT_EQUAL_INT(80, resumed.state.epoch);
+    TEST_ASSERT_EQUAL_INT(0, resumeModel(&resumed, 120));
+    TEST_ASSERT_EQUAL_INT(200, resumed.state.epoch);
+    TEST_ASSERT_TRUE(resumed.state.step == 200);
+    TEST_ASSERT_TRUE(whole.weights->data[0] == resumed.weights->data[0]);
+    TEST_ASSERT_TRUE(whole.weights->data[1] == resumed.weights->data[1]);
+    TEST_ASSERT_TRUE(whole.bias->data[0] == resumed.bias->data[0]);
+    TEST_ASSERT_TRUE(whole.config.learning_rate.curr_learning_rate == resumed.config.learning_rate.curr_learning_rate);
+
+    // Restarting the optimizer from zero halfway takes a different path
+    TEST_ASSERT_EQUAL_INT(0, resumeModel(&restarted, 80));
+    int epoch = restarted.state.epoch;
+    freeOptimizerState(&restarted.state);
+    restarted.state.epoch = epoch;
+    TEST_ASSERT_EQUAL_INT(0, resumeModel(&restarted, 120));
+    TEST_ASSERT_TRUE(fabs(restarted.weights->data[0] - whole.weights->data[0]) > 0.0001);
+    freeModel(&restarted);
+
+    // Only mini-batch gradient descent resumes, and only with the optimizer it saved
+    resumed.config.optimizer.type = OPTIMIZER_MOMENTUM;
+    TEST_ASSERT_EQUAL_INT(-1, resumeModel(&resumed, 1));
+    resumed.config.optimizer.type = OPTIMIZER_ADAM;
+    resumed.config.solver = SOLVER_LBFGS;
+    TEST_ASSERT_EQUAL_INT(-1, resumeModel(&resumed, 1));
+    freeModel(&whole);
+    freeModel(&resumed);
+}
+
+void test_partial_fit_streams(void)
+{
+    // Steps on a caller's mini-batch follow the same Adam run as full-batch training, whatever
+    // way the steps are split between calls
+    Model trained;
+    Model streamed;
+    Model split;
+    setScaledData(&trained);
+    trained.batch_size = 64;
+    trained.config.epochs = 50;
+    trained.config.optimizer.type = OPTIMIZER_ADAM;
+    setLearningRate(&trained, CONSTANT, 0.05);
+    setScaledData(&streamed);
+    streamed.batch_size = trained.batch_size;
+    streamed.config = trained.config;
+    setScaledData(&split);
+    split.batch_size = trained.batch_size;
+    split.config = trained.config;
+    TEST_ASSERT_EQUAL_INT(0, trainModel(&trained));
+
+    Matrix X = streamed.splitdata.train_features;
+    Matrix y = streamed.splitdata.train_labels;
+    double loss = -1;
+    TEST_ASSERT_EQUAL_INT(0, partialFit(&streamed, X, y, 50, &loss));
+    TEST_ASSERT_TRUE(streamed.state.step == 50);
+    TEST_ASSERT_TRUE(loss >= 0);
+    TEST_ASSERT_FLOAT_WITHIN(0.000001f, trained.weights->data[0], streamed.weights->data[0]);
+    TEST_ASSERT_FLOAT_WITHIN(0.000001f, trained.weights->data[1], streamed.weights->data[1]);
+    TEST_ASSERT_FLOAT_WITHIN(0.000001f, trained.bias->data[0], streamed.bias->data[0]);
+
+    split.config.preallocate = true;
+    TEST_ASSERT_EQUAL_INT(0, partialFit(&split, X, y, 20, NULL));
+    TEST_ASSERT_EQUAL_INT(0, partialFit(&split, X, y, 30, NULL));
+    TEST_ASSERT_TRUE(split.state.step == 50);
+    TEST_ASSERT_FLOAT_WITHIN(0.0000001f, streamed.weights->data[0], split.weights->data[0]);
+    TEST_ASSERT_FLOAT_WITHIN(0.0000001f, streamed.weights->data[1], split.weights->data[1]);
+    TEST_ASSERT_FLOAT_WITHIN(0.0000001f, streamed.bias->data[0], split.bias->data[0]);
+
+    // Batches that arrive one after another keep lowering the loss of a model that starts empty
+    Model online;
+    TEST_ASSERT_EQUAL_INT(0, initModel(&online));
+    online.type = LINEAR_REGRESSION;
+    online.func = ACT_NONE;
+    online.classes = 1;
+    online.config.optimizer.type = OPTIMIZER_ADAM;
+    online.config.learning_rate.curr_learning_rate = 0.05;
+    double first_loss = 0;
+    for (int call = 0; call < 400; ++call)
+    {
+        int start = (call % 4) * 16;
+        Matrix batch_X = {16, 2, &X.data[start * 2]};
+        Matrix batch_y = {16, 1, &y.data[start]};
+        TEST_ASSERT_EQUAL_INT(0, partialFit(&online, batch_X, batch_y, 1, &loss));
+        first_loss = (call == 0) ? loss : first_loss;
+    }
+    TEST_ASSERT_TRUE(online.state.step == 400);
+    TEST_ASSERT_TRUE(loss < first_loss / 10);
+
+    // Batches must match the weights, and only gradient descent models take steps
+    Matrix narrow = {64, 1, X.data};
+    TEST_ASSERT_EQUAL_INT(-1, partialFit(&online, narrow, y, 1, NULL));
+    TEST_ASSERT_EQUAL_INT(-1, partialFit(&online, X, y, 0, NULL));
+    online.config.optimizer.type = OPTIMIZER_MOMENTUM;
+    TEST_ASSERT_EQUAL_INT(-1, partialFit(&online, X, y, 1, NULL));
+    online.config.optimizer.type = OPTIMIZER_ADAM;
+    online.config.solver = SOLVER_LBFGS;
+    TEST_ASSERT_EQUAL_INT(-1, partialFit(&online, X, y, 1, NULL));
+
+    freeModel(&online);
+    freeModel(&split);
+    freeModel(&streamed);
+    freeModel(&trained);
+}
+
+// Ten features of which only x0, x3 and x7 matter, y = 3 x0 - 2 x3 + 1.5 x7 + 1 plus noise,
+// thresholded at the noise for logistic regression. Rows start at offset so splits differ.
+static void makeSparseRows(Matrix *X, Matrix *y, RegressionType type, int rows, int offset)
+{
+    int cols = 10;
+    TEST_ASSERT_EQUAL_INT(0, makeMatrixZeros(X, rows, cols));
+    TEST_ASSERT_EQUAL_INT(0, makeMatrixZeros(y, rows, 1));
+    for (int r = 0; r < rows; ++r)
+    {
+        double *x = &X->data[r * cols];
+        int i = r + offset;
+        for (int j = 0; j < cols; ++j)
+        {
+            x[j] = sin(i * (0.37 + 0.61 * j) + j);
+        }
+        double noise = sin(i * 7.77) * 0.5;
+        double signal = 3.0 * x[0] - 2.0 * x[3] + 1.5 * x[7] + 1.0;
+        y->data[r] = (type == LINEAR_REGRESSION) ? signal + noise : ((signal > 4.0 * noise + 1.0) ? 1.0 : 0.0);
+    }
+}
+
+// Optimality of l1 * ||w||_1 + l2 * ||w||^2 plus the loss: |g_j| <= l1 where w_j is 0,
+// g_j + l1 * sign(w_j) + 2 * l2 * w_j = 0 elsewhere, and a zero bias gradient
+static void assertElasticNetKKT(const Model *model, double l1, double l2)
+{
+    Matrix X = model->splitdata.train_features;
+    int cols = X.cols;
+    double grad[11] = {0};
+    for (int r = 0; r < X.rows; ++r)
+    {
+        double z = model->bias->data[0];
+        for (int j = 0; j < cols; ++j)
+        {
+            z += X.data[r * cols + j] * model->weights->data[j];
+        }
+        double t = model->splitdata.train_labels.data[r];
+        double residual = (model->type == LINEAR_REGRESSION) ? 2.0 * (z - t) : 1.0 / (1.0 + exp(-z)) - t;
+        for (int j = 0; j < cols; ++j)
+        {
+            grad[j] += residual * X.data[r * cols + j] / X.rows;
+        }
+        grad[cols] += residual / X.rows;
+    }
+    for (int j = 0; j < cols; ++j)
+    {
+        double w = model->weights->data[j];
+        if (w == 0.0)
+        {
+            TEST_ASSERT_TRUE(fabs(grad[j]) <= l1 + 1e-6);
+        }
+        else
+        {
+            TEST_ASSERT_FLOAT_WITHIN(0.000001f, 0.0f, grad[j] + l1 * ((w > 0) ? 1.0 : -1.0) + 2.0 * l2 * w);
+        }
+    }
+    TEST_ASSERT_FLOAT_WITHIN(0.000001f, 0.0f, grad[cols]);
+}
+
+void test_train_coordinate_descent_lasso(void)
+{
+    // Soft-thresholding leaves the irrelevant weights at exactly zero
+    Matrix X = {0};
+    Matrix y = {0};
+    makeSparseRows(&X, &y, LINEAR_REGRESSION, 2000, 0);
+    Model lasso;
+    setTrainingData(&lasso, X, y, LINEAR_REGRESSION);
+    lasso.config.solver = SOLVER_COORDINATE_DESCENT;
+    lasso.config.tolerance = 1e-9;
+    lasso.config.regularization = REG_L1;
+    lasso.config.lambda = 0.1;
+    setThreadCount(4);
+    int status = trainModel(&lasso);
+    setThreadCount(0);
+    TEST_ASSERT_EQUAL_INT(0, status);
+    for (int j = 0; j < 10; ++j)
+    {
+        bool relevant = j == 0 || j == 3 || j == 7;
+        TEST_ASSERT_TRUE(relevant == (lasso.weights->data[j] != 0.0));
+    }
+    assertElasticNetKKT(&lasso, 0.1, 0.0);
+
+    // A random visit order converges to the same optimum
+    makeSparseRows(&X, &y, LINEAR_REGRESSION, 2000, 0);
+    Model shuffled;
+    setTrainingData(&shuffled, X, y, LINEAR_REGRESSION);
+    shuffled.config = lasso.config;
+    shuffled.config.shuffle_coordinates = true;
+    shuffled.config.seed = 3;
+    TEST_ASSERT_EQUAL_INT(0, trainModel(&shuffled));
+    for (int j = 0; j < 10; ++j)
+    {
+        TEST_ASSERT_FLOAT_WITHIN(0.000001f, lasso.weights->data[j], shuffled.weights->data[j]);
+    }
+    TEST_ASSERT_FLOAT_WITHIN(0.000001f, lasso.bias->data[0], shuffled.bias->data[0]);
+    freeModel(&lasso);
+    freeModel(&shuffled);
+
+    // Without an L1 term the covariance updates reach the least squares solution
+    makeThreeFeatureData(&X, &y, false);
+    Model cd;
+    setTrainingData(&cd, X, y, LINEAR_REGRESSION);
+    cd.config.solver = SOLVER_COORDINATE_DESCENT;
+    cd.config.tolerance = 1e-10;
+    TEST_ASSERT_EQUAL_INT(0, trainModel(&cd));
+    TEST_ASSERT_FLOAT_WITHIN(0.0001f, 3.0f, cd.weights->data[0]);
+    TEST_ASSERT_FLOAT_WITHIN(0.0001f, -2.0f, cd.weights->data[1]);
+    TEST_ASSERT_FLOAT_WITHIN(0.0001f, 0.5f, cd.weights->data[2]);
+    TEST_ASSERT_FLOAT_WITHIN(0.0001f, 4.0f, cd.bias->data[0]);
+    freeModel(&cd);
+}
+
+void test_train_coordinate_descent_logistic(void)
+{
+    // Elastic net splits lambda between the L1 and L2 terms
+    Matrix X = {0};
+    Matrix y = {0};
+    makeSparseRows(&X, &y, LOGISTIC_REGRESSION, 2000, 0);
+    Model model;
+    setTrainingData(&model, X, y, LOGISTIC_REGRESSION);
+    model.config.solver = SOLVER_COORDINATE_DESCENT;
+    model.config.tolerance = 1e-9;
+    model.config.regularization = REG_ELASTIC_NET;
+    model.config.lambda = 0.04;
+    model.config.l1_ratio = 0.5;
+    setThreadCount(4);
+    int status = trainModel(&model);
+    setThreadCount(0);
+    TEST_ASSERT_EQUAL_INT(0, status);
+    for (int j = 0; j < 10; ++j)
+    {
+        bool relevant = j == 0 || j == 3 || j == 7;
+        TEST_ASSERT_TRUE(relevant == (model.weights->data[j] != 0.0));
+    }
+    assertElasticNetKKT(&model, 0.02, 0.02);
+    freeModel(&model);
+
+    // The gradient-based solvers cannot handle the nonsmooth L1 term
+    makeSparseRows(&X, &y, LOGISTIC_REGRESSION, 2000, 0);
+    setTrainingData(&model, X, y, LOGISTIC_REGRESSION);
+    model.config.regularization = REG_ELASTIC_NET;
+    model.config.solver = SOLVER_LBFGS;
+    TEST_ASSERT_EQUAL_INT(-1, trainModel(&model));
+    freeModel(&model);
+}
+
+// Hand a model 2000 sparse training rows and a validation split of 500 more
+static void setPathData(Model *model, RegressionType type)
+{
+    Matrix X = {0};
+    Matrix y = {0};
+    makeSparseRows(&X, &y, type, 2000, 0);
+    setTrainingData(model, X, y, type);
+    freeMatrix(&model->splitdata.valid_features);
+    freeMatrix(&model->splitdata.valid_labels);
+    makeSparseRows(&model->splitdata.valid_features, &model->splitdata.valid_labels, type, 500, 2000);
+}
+
+void test_regularization_path(void)
+{
+    // Generated lambdas start where every weight is zero and end min_ratio below it
+    Model model;
+    RegularizationPath path;
+    setPathData(&model, LINEAR_REGRESSION);
+    model.config.solver = SOLVER_COORDINATE_DESCENT;
+    model.config.tolerance = 1e-9;
+    model.config.regularization = REG_L1;
+    setThreadCount(4);
+    int status = computeRegularizationPath(&model, NULL, 20, 1e-3, &path);
+    setThreadCount(0);
+    TEST_ASSERT_EQUAL_INT(0, status);
+    TEST_ASSERT_EQUAL_INT(20, path.count);
+    TEST_ASSERT_EQUAL_INT(0, path.nonzero[0]);
+    TEST_ASSERT_TRUE(path.nonzero[19] >= 3);
+    TEST_ASSERT_FLOAT_WITHIN(1e-9f, 1e-3f, path.lambdas.data[19] / path.lambdas.data[0]);
+    for (int k = 0; k < path.count; ++k)
+    {
+        TEST_ASSERT_TRUE(path.valid_loss.data[path.best] <= path.valid_loss.data[k]);
+        TEST_ASSERT_TRUE(path.valid_score.data[k] <= 1.0);
+    }
+    TEST_ASSERT_TRUE(path.valid_score.data[path.best] > 0.9);
+
+    // The model is left at the best lambda, which satisfies the lasso optimality conditions
+    TEST_ASSERT_TRUE(model.config.lambda == path.lambdas.data[path.best]);
+    for (int j = 0; j < 10; ++j)
+    {
+        TEST_ASSERT_TRUE(model.weights->data[j] == path.weights.data[path.best * 10 + j]);
+    }
+    assertElasticNetKKT(&model, model.config.lambda, 0.0);
+
+    // Warm starts land on the same weights as a fit from scratch
+    int k = 10;
+    Matrix X = {0};
+    Matrix y = {0};
+    makeSparseRows(&X, &y, LINEAR_REGRESSION, 2000, 0);
+    Model single;
+    setTrainingData(&single, X, y, LINEAR_REGRESSION);
+    single.config = model.config;
+    single.config.lambda = path.lambdas.data[k];
+    TEST_ASSERT_EQUAL_INT(0, trainModel(&single));
+    for (int j = 0; j < 10; ++j)
+    {
+        TEST_ASSERT_FLOAT_WITHIN(0.00001f, single.weights->data[j], path.weights.data[k * 10 + j]);
+    }
+    TEST_ASSERT_FLOAT_WITHIN(0.00001f, single.bias->data[0], path.bias.data[k]);
+    freeModel(&single);
+    freeRegularizationPath(&path);
+    freeModel(&model);
+
+    // Given elastic-net lambdas on a logistic model, scored by validation accuracy
+    double lambdas[4] = {0.2, 0.05, 0.01, 0.002};
+    setPathData(&model, LOGISTIC_REGRESSION);
+    model.config.solver = SOLVER_COORDINATE_DESCENT;
+    model.config.tolerance = 1e-9;
+    model.config.regularization = REG_ELASTIC_NET;
+    TEST_ASSERT_EQUAL_INT(0, computeRegularizationPath(&model, lambdas, 4, 0, &path));
+    TEST_ASSERT_TRUE(path.nonzero[0] <= path.nonzero[3]);
+    TEST_ASSERT_TRUE(path.valid_score.data[path.best] > 0.8);
+    assertElasticNetKKT(&model, 0.5 * model.config.lambda, 0.5 * model.config.lambda);
+    freeRegularizationPath(&path);
+    freeModel(&model);
+
+    // Lambdas must decrease
+    double increasing[2] = {0.01, 0.1};
+    setPathData(&model, LINEAR_REGRESSION);
+    model.config.solver = SOLVER_COORDINATE_DESCENT;
+    model.config.regularization = REG_L1;
+    TEST_ASSERT_EQUAL_INT(-1, computeRegularizationPath(&model, increasing, 2, 0, &path));
+    freeModel(&model);
+}
+
+int main(void)
+{
+    UNITY_BEGIN();
+    RUN_TEST(test_prefetch_threaded);
+    RUN_TEST(test_prefetch_inline);
+    RUN_TEST(test_prefetch_stop_early);
+    RUN_TEST(test_train_linear_model);
+    RUN_TEST(test_prefetch_typed_table);
+    RUN_TEST(test_train_linear_model_typed_table);
+    RUN_TEST(test_train_preallocated_steady_state);
+    RUN_TEST(test_train_sharded_model);
+    RUN_TEST(test_train_hogwild_model);
+    RUN_TEST(test_train_hogwild_sparse_logistic);
+    RUN_TEST(test_train_closed_form);
+    RUN_TEST(test_train_lbfgs_softmax);
+    RUN_TEST(test_train_softmax_class_indices);
+    RUN_TEST(test_train_lbfgs_linear);
+    RUN_TEST(test_train_lbfgs_sparse);
+    RUN_TEST(test_train_newton_logistic);
+    RUN_TEST(test_train_optimizers);
+    RUN_TEST(test_train_early_stopping);
+    RUN_TEST(test_train_seed_reproducible);
+    RUN_TEST(test_train_resume_continues);
+    RUN_TEST(test_partial_fit_streams);
+    RUN_TEST(test_train_coordinate_descent_lasso);
+    RUN_TEST(test_train_coordinate_descent_logistic);
+    RUN_TEST(test_regularization_path);
+    return UNITY_END();
+}
@@ -0,0 +1,329 @@
+/*
+ * file: test_sweep.c
+ * description: script to test the in-process hyperparameter sweep and budget schedulers
+ * author: Ryan Wagner
+ * date: October 19, 2026
+ * notes:
+ */
+
+#include "unity.h"
+#include "../header/sweep.h"
+
+void setUp(void)
+{
+    // Optional: initialize stuff before each test
+}
+
+void tearDown(void)
+{
+    // Optional: clean up after each test
+}
+
+// Linear model on y = 2 x0 - x1 + 0.5 with 400 training and 100 validation rows
+static void makeSweepBase(Model *model)
+{
+    int rows = 500;
+    int train = 400;
+    TEST_ASSERT_EQUAL_INT(0, initModel(model));
+    freeSplitData(&model->splitdata);
+    SplitData *split = &model->splitdata;
+    TEST_ASSERT_EQUAL_INT(0, makeMatrixZeros(&split->train_features, train, 2));
+    TEST_ASSERT_EQUAL_INT(0, makeMatrixZeros(&split->train_labels, train, 1));
+    TEST_ASSERT_EQUAL_INT(0, makeMatrixZeros(&split->valid_features, rows - train, 2));
+    TEST_ASSERT_EQUAL_INT(0, makeMatrixZeros(&split->valid_labels, rows - train, 1));
+    TEST_ASSERT_EQUAL_INT(0, makeMatrixZeros(&split->test_features, 1, 2));
+    TEST_ASSERT_EQUAL_INT(0, makeMatrixZeros(&split->test_labels, 1, 1));
+    for (int r = 0; r < rows; ++r)
+    {
+        bool is_train = r < train;
+        Matrix *X = is_train ? &split->train_features : &split->valid_features;
+        Matrix *y = is_train ? &split->train_labels : &split->valid_labels;
+        int row = is_train ? r : r - train;
+        double x0 = sin(r * 0.37);
+        double x1 = cos(r * 1.13);
+        X->data[row * 2] = x0;
+        X->data[row * 2 + 1] = x1;
+        y->data[row] = 2.0 * x0 - x1 + 0.5 + 0.05 * sin(r * 7.77);
+    }
+
+    model->type = LINEAR_REGRESSION;
+    model->func = ACT_NONE;
+    model->classes = 1;
+    model->batch_size = 32;
+    model->beta = 0.9;
+    model->config.epochs = 40;
+    model->config.seed = 7;
+    model->config.learning_rate.decay_type = CONSTANT;
+}
+
+// FNV-1a over the training and validation features and labels
+static unsigned long long hashSplit(const SplitData *split)
+{
+    const Matrix *parts[4] = {&split->train_features, &split->train_labels, &split->valid_features, &split->valid_labels};
+    unsigned long long hash = 14695981039346656037ULL;
+    for (int p = 0; p < 4; ++p)
+    {
+        const unsigned char *bytes = (const unsigned char *)parts[p]->data;
+        for (size_t i = 0; i < parts[p]->rows * parts[p]->cols * sizeof(double); ++i)
+        {
+            hash = (hash ^ bytes[i]) * 1099511628211ULL;
+        }
+    }
+    return hash;
+}
+
+void test_grid_sweep_ranks_trials(void)
+{
+    Model base;
+    makeSweepBase(&base);
+    unsigned long long before = hashSplit(&base.splitdata);
+
+    double learning_rates[3] = {0.0001, 0.01, 0.1};
+    double lambdas[2] = {0.0001, 0.5};
+    int batch_sizes[2] = {16, 64};
+    SweepSpace space = {0};
+    space.learning_rates = learning_rates;
+    space.n_learning_rates = 3;
+    space.lambdas = lambdas;
+    space.n_lambdas = 2;
+    space.batch_sizes = batch_sizes;
+    space.n_batch_sizes = 2;
+    base.config.regularization = REG_L2;
+
+    SweepTrial *trials = NULL;
+    int count = 0;
+    TEST_ASSERT_EQUAL_INT(0, makeGridTrials(&base, &space, &trials, &count));
+    TEST_ASSERT_EQUAL_INT(12, count);
+
+    // The last hyperparameter varies fastest
+    TEST_ASSERT_EQUAL_INT(16, trials[0].batch_size);
+    TEST_ASSERT_EQUAL_INT(64, trials[1].batch_size);
+    TEST_ASSERT_TRUE(trials[2].config.lambda == 0.5);
+    TEST_ASSERT_TRUE(trials[4].config.learning_rate.init_learning_rate == 0.01);
+    TEST_ASSERT_TRUE(trials[4].beta == 0.9);
+
+    // The caller's own thread count is back in place once the sweep returns
+    setThreadCount(4);
+    setLocalThreadCount(3);
+    int status = runSweep(&base, trials, count, 4);
+    TEST_ASSERT_EQUAL_INT(3, getLocalThreadCount());
+    setLocalThreadCount(0);
+    setThreadCount(0);
+    TEST_ASSERT_EQUAL_INT(0, status);
+
+    // Every trial trained, best score first, and the shared dataset is untouched
+    for (int t = 0; t < count; ++t)
+    {
+        TEST_ASSERT_EQUAL_INT(0, trials[t].status);
+        TEST_ASSERT_EQUAL_INT(2, trials[t].weights.rows);
+        TEST_ASSERT_TRUE(t == 0 || trials[t - 1].score >= trials[t].score);
+        TEST_ASSERT_TRUE(trials[t].score == trials[t].metrics.r2score);
+    }
+    TEST_ASSERT_TRUE(before == hashSplit(&base.splitdata));
+
+    // A weakly regularized, fast learner wins, a tiny learning rate barely moves
+    TEST_ASSERT_TRUE(trials[0].score > 0.95);
+    TEST_ASSERT_TRUE(trials[0].config.lambda == 0.0001);
+    TEST_ASSERT_TRUE(trials[0].config.learning_rate.init_learning_rate > 0.0001);
+    TEST_ASSERT_TRUE(trials[count - 1].config.learning_rate.init_learning_rate == 0.0001);
+    TEST_ASSERT_FLOAT_WITHIN(0.05f, 2.0f, trials[0].weights.data[0]);
+    TEST_ASSERT_FLOAT_WITHIN(0.05f, -1.0f, trials[0].weights.data[1]);
+    freeSweepTrials(trials, count);
+    freeModel(&base);
+}
+
+void test_random_sweep_draws(void)
+{
+    Model base;
+    makeSweepBase(&base);
+
+    double learning_rates[2] = {0.001, 0.1};
+    DecayType decay_types[2] = {CONSTANT, LINEAR_DECAY};
+    double betas[2] = {0.5, 0.95};
+    SweepSpace space = {0};
+    space.learning_rates = learning_rates;
+    space.n_learning_rates = 2;
+    space.decay_types = decay_types;
+    space.n_decay_types = 2;
+    space.betas = betas;
+    space.n_betas = 2;
+
+    // Draws stay in range and repeat for a seed
+    SweepTrial *first = NULL;
+    SweepTrial *second = NULL;
+    TEST_ASSERT_EQUAL_INT(0, makeRandomTrials(&base, &space, 16, 11, &first));
+    TEST_ASSERT_EQUAL_INT(0, makeRandomTrials(&base, &space, 16, 11, &second));
+    int below_geometric_mean = 0;
+    for (int t = 0; t < 16; ++t)
+    {
+        double lr = first[t].config.learning_rate.init_learning_rate;
+        TEST_ASSERT_TRUE(lr >= 0.001 && lr <= 0.1);
+        TEST_ASSERT_TRUE(first[t].beta >= 0.5 && first[t].beta <= 0.95);
+        TEST_ASSERT_TRUE(first[t].config.learning_rate.decay_type == CONSTANT || first[t].config.learning_rate.decay_type == LINEAR_DECAY);
+        TEST_ASSERT_TRUE(lr == second[t].config.learning_rate.init_learning_rate);
+        TEST_ASSERT_TRUE(first[t].beta == second[t].beta);
+        TEST_ASSERT_EQUAL_INT(32, first[t].batch_size);
+        below_geometric_mean += lr < 0.01;
+    }
+    // Log-uniform draws put about half of the learning rates below 0.01
+    TEST_ASSERT_INT_WITHIN(6, 8, below_geometric_mean);
+
+    TEST_ASSERT_EQUAL_INT(0, runSweep(&base, first, 16, 0));
+    TEST_ASSERT_EQUAL_INT(0, first[0].status);
+    TEST_ASSERT_TRUE(first[0].score > 0.9);
+    freeSweepTrials(first, 16);
+    freeSweepTrials(second, 16);
+
+    // Trials are ranked on the validation split, so one must exist
+    SweepTrial *trials = NULL;
+    TEST_ASSERT_EQUAL_INT(0, makeRandomTrials(&base, &space, 2, 3, &trials));
+    Matrix valid_X = base.splitdata.valid_features;
+    base.splitdata.valid_features.rows = 1;
+    TEST_ASSERT_EQUAL_INT(-1, runSweep(&base, trials, 2, 2));
+    base.splitdata.valid_features = valid_X;
+    freeSweepTrials(trials, 2);
+    freeModel(&base);
+}
+
+void test_successive_halving_resumes(void)
+{
+    Model base;
+    makeSweepBase(&base);
+    unsigned long long before = hashSplit(&base.splitdata);
+
+    double learning_rates[2] = {0.00001, 0.1};
+    SweepSpace space = {0};
+    space.learning_rates = learning_rates;
+    space.n_learning_rates = 2;
+
+    SweepTrial *trials = NULL;
+    TEST_ASSERT_EQUAL_INT(0, makeRandomTrials(&base, &space, 81, 17, &trials));
+    setThreadCount(4);
+    int status = runSuccessiveHalving(&base, trials, 81, 1, 81, 3, 4);
+    setThreadCount(0);
+    TEST_ASSERT_EQUAL_INT(0, status);
+    TEST_ASSERT_TRUE(before == hashSplit(&base.splitdata));
+
+    // Rounds of 81, 27, 9 and 3 trials at 1, 3, 9 and 27 epochs, then the last one at 81
+    int at_budget[5] = {0};
+    int budgets[5] = {81, 27, 9, 3, 1};
+    long epochs = 0;
+    for (int t = 0; t < 81; ++t)
+    {
+        TEST_ASSERT_EQUAL_INT(0, trials[t].status);
+        TEST_ASSERT_TRUE(t == 0 || trials[t - 1].epochs >= trials[t].epochs);
+        for (int b = 0; b < 5; ++b)
+        {
+            at_budget[b] += trials[t].epochs == budgets[b];
+        }
+        epochs += trials[t].epochs;
+    }
+    TEST_ASSERT_EQUAL_INT(1, at_budget[0]);
+    TEST_ASSERT_EQUAL_INT(2, at_budget[1]);
+    TEST_ASSERT_EQUAL_INT(6, at_budget[2]);
+    TEST_ASSERT_EQUAL_INT(18, at_budget[3]);
+    TEST_ASSERT_EQUAL_INT(54, at_budget[4]);
+
+    // 297 epochs instead of 81 * 81, and the winner resumed rather than restarted: its optimizer
+    // took one step for each of the 13 mini-batches of all 81 epochs
+    TEST_ASSERT_EQUAL_INT(297, epochs);
+    TEST_ASSERT_EQUAL_INT(81, trials[0].state.epoch);
+    TEST_ASSERT_TRUE(trials[0].state.step == 81 * 13);
+    TEST_ASSERT_TRUE(trials[0].loss < 0.01);
+    TEST_ASSERT_TRUE(trials[0].score > 0.99);
+    TEST_ASSERT_TRUE(trials[0].config.learning_rate.init_learning_rate > 0.001);
+    freeSweepTrials(trials, 81);
+
+    // Budgets must grow by at least 2 every round
+    TEST_ASSERT_EQUAL_INT(0, makeRandomTrials(&base, &space, 4, 5, &trials));
+    TEST_ASSERT_EQUAL_INT(-1, runSuccessiveHalving(&base, trials, 4, 1, 9, 1, 2));
+    freeSweepTrials(trials, 4);
+    freeModel(&base);
+}
+
+void test_successive_halving_early_stopping(void)
+{
+    Model base;
+    makeSweepBase(&base);
+    base.config.patience = 2;
+    base.config.min_improvement = 0.05;
+
+    double learning_rates[2] = {0.001, 0.3};
+    SweepSpace space = {0};
+    space.learning_rates = learning_rates;
+    space.n_learning_rates = 2;
+
+    SweepTrial *trials = NULL;
+    TEST_ASSERT_EQUAL_INT(0, makeRandomTrials(&base, &space, 27, 23, &trials));
+    TEST_ASSERT_EQUAL_INT(0, runSuccessiveHalving(&base, trials, 27, 1, 27, 3, 4));
+
+    // Rounds of 27, 9 and 3 trials, each ranked on validation loss alone, however many epochs
+    // early stopping let a trial train
+    int at_budget[4] = {0};
+    int budgets[4] = {27, 9, 3, 1};
+    for (int t = 0; t < 27; ++t)
+    {
+        TEST_ASSERT_EQUAL_INT(0, trials[t].status);
+        TEST_ASSERT_TRUE(trials[t].epochs <= trials[t].budget);
+        TEST_ASSERT_TRUE(t == 0 || trials[t - 1].budget >= trials[t].budget);
+        TEST_ASSERT_TRUE(t == 0 || trials[t - 1].budget > trials[t].budget || trials[t - 1].loss <= trials[t].loss);
+        for (int b = 0; b < 4; ++b)
+        {
+            at_budget[b] += trials[t].budget == budgets[b];
+        }
+    }
+    TEST_ASSERT_EQUAL_INT(1, at_budget[0]);
+    TEST_ASSERT_EQUAL_INT(2, at_budget[1]);
+    TEST_ASSERT_EQUAL_INT(6, at_budget[2]);
+    TEST_ASSERT_EQUAL_INT(18, at_budget[3]);
+
+    // The winner stopped early in the round of 9 epochs and was carried to the end, not resumed
+    TEST_ASSERT_TRUE(trials[0].state.stopped);
+    TEST_ASSERT_TRUE(trials[0].epochs < 9);
+    TEST_ASSERT_EQUAL_INT(trials[0].epochs, trials[0].state.epoch);
+    freeSweepTrials(trials, 27);
+    freeModel(&base);
+}
+
+void test_hyperband_brackets(void)
+{
+    Model base;
+    makeSweepBase(&base);
+
+    double learning_rates[2] = {0.0001, 0.1};
+    double betas[2] = {0.0, 0.9};
+    SweepSpace space = {0};
+    space.learning_rates = learning_rates;
+    space.n_learning_rates = 2;
+    space.betas = betas;
+    space.n_betas = 2;
+
+    // Brackets of 27 trials from 1 epoch, 12 from 3, 6 from 9 and 4 trained for 27 epochs
+    SweepTrial *trials = NULL;
+    int count = 0;
+    TEST_ASSERT_EQUAL_INT(0, runHyperband(&base, &space, 1, 27, 3, 9, 0, &trials, &count));
+    TEST_ASSERT_EQUAL_INT(49, count);
+    int full = 0;
+    for (int t = 0; t < count; ++t)
+    {
+        TEST_ASSERT_EQUAL_INT(0, trials[t].status);
+        full += trials[t].epochs == 27;
+    }
+    TEST_ASSERT_EQUAL_INT(1 + 1 + 2 + 4, full);
+    TEST_ASSERT_EQUAL_INT(27, trials[0].epochs);
+    TEST_ASSERT_TRUE(trials[0].score > 0.99);
+    TEST_ASSERT_FLOAT_WITHIN(0.05f, 2.0f, trials[0].weights.data[0]);
+    freeSweepTrials(trials, count);
+    freeModel(&base);
+}
+
+int main(void)
+{
+    UNITY_BEGIN();
+    RUN_TEST(test_grid_sweep_ranks_trials);
+    RUN_TEST(test_random_sweep_draws);
+    RUN_TEST(test_successive_halving_resumes);
+    RUN_TEST(test_successive_halving_early_stopping);
+    RUN_TEST(test_hyperband_brackets);
+    return UNITY_END();
+}